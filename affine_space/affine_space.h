@@ -39,11 +39,25 @@
  *         points cannot be added, nor multiplied by scalars
  *         in-place versions of these operations are also defined
  *    No assumption is made on whether the space is linear or nonlinear.
- *    All instances are assumed to be represented in the standard basis. Transformations between bases must be implemented by the deriving classes.
+ *    All instances are assumed to be represented in the standard basis. Linear and affine maps between bases are defined in map.h.
  *
  *    If ndim=0, then the space is scalar, and a single element is stored
  *    If ndim>0, then the space is multidimensional, and an array of elements is stored which can be accessed using the array accessor []
  *       note that ndim=1 acts as if multidimensional (has [] operator), so that algorithms can be implemented generically for 1,2,3,... dimensional spaces.
+ *    If ndim=dynamic_extent, then the dimension is set at runtime with resize(n) and returned by the non-static size()
+ *       small dimensions are stored inline and large ones on the heap (see small_vector)
+ *       both operands of a binary operation must have the same dimension
+ *       the free operators reuse the storage of rvalue operands, e.g. std::move(d0)+d1 does not allocate
+ *    num_t may be a floating point, integer or fixed point (see fixed.h) type, and delta_t may use a different num_t than point_t
+ *       e.g. std::size_t points with std::ptrdiff_t deltas, int32_t points with int64_t deltas so that p-p cannot overflow,
+ *       or double points with float deltas, to halve the storage and double the vector width of delta arithmetic
+ *       p-p, p+d and p-d are computed in the common type of both, and converted to the delta or point coordinates
+ *       for exact (integer, fixed point) num_t, deltas can only be scaled by integers or num_t, and d/a divides each coordinate
+ *       (integers truncate towards zero), rather than multiplying by the reciprocal
+ *    The coordinates of fixed extent spaces are stored by the policy storage_traits<point_t>::type, shared by point_t and delta_t
+ *       packed_storage (default)  std::array of ndim coordinates
+ *       homogeneous_storage       ndim coordinates followed by the homogeneous coordinate w, 1 for points and 0 for deltas,
+ *                                 aligned to a power of two so that eg a 3D point of doubles fills one 32 byte vector register
  *
  *    Code example:
  *
@@ -88,22 +102,359 @@
  *
  */
 
+# include <algorithm>
 # include <array>
+# include <bit>
+# include <cassert>
 # include <concepts>
+# include <cstddef>
+# include <initializer_list>
+# include <new>
+# include <span>
 # include <type_traits>
+# include <utility>
 
 namespace affine
 {
 
+/*
+ * customisation point for types acceptable as underlying precision
+ *    floating point and integer types are enabled by default
+ *    other types with the appropriate arithmetic operator overloads can be enabled by specialising numeric_traits
+ *       e.g. complex, rational or fixed precision numbers (see fixed.h), or simd wrapper types (see simd.h)
+ *    exact types (integers, fixed point) have different scaling and division rules, see scale_factor and delta_base::operator/=
+ *
+ *       template<>
+ *       struct affine::numeric_traits<my_number> { constexpr static bool enabled = true; constexpr static bool exact = false; };
+ */
+   template<typename T>
+   struct numeric_traits
+  {
+      constexpr static bool enabled = std::floating_point<T> || ( std::integral<T> && !std::same_as<T,bool> );
+      constexpr static bool exact = std::integral<T>;
+  };
+
+/*
+ * arithmetic on T is exact, so must not be mixed implicitly with floating point factors
+ */
+   template<typename T>
+   concept exact_numeric = requires { requires bool( numeric_traits<T>::exact ); };
+
 /*
  * type acceptable as underlying precision
- *    currently alias for floating_point
- *    could be extended to include types with appropriate arithmetic operator overloads
- *       e.g. complex, rational or fixed precision numbers, or simd wrapper types
+ *    must be enabled by numeric_traits, and closed under the arithmetic operations used by point_base and delta_base
  */
    template<typename T>
    concept numeric =
-      std::floating_point<T>;
+      numeric_traits<T>::enabled
+   && std::copyable<T>
+   && std::constructible_from<T,int>
+   && requires( T a, const T b )
+     {
+         { a+b } -> std::convertible_to<T>;
+         { a-b } -> std::convertible_to<T>;
+         { a*b } -> std::convertible_to<T>;
+         { a/b } -> std::convertible_to<T>;
+         {  -b } -> std::convertible_to<T>;
+         a+=b;
+         a-=b;
+         a*=b;
+         a/=b;
+     };
+
+/*
+ * type of a factor that deltas with num_t coordinates can be scaled by
+ *    any type convertible to num_t, unless num_t is exact, when only integers and num_t itself are accepted,
+ *    so that eg 0.5*d does not silently truncate to 0*d for integer coordinates
+ */
+   template<typename T, typename num_t>
+   concept scale_factor =
+      std::convertible_to<T,num_t>
+   && ( !exact_numeric<num_t> || std::integral<T> || std::same_as<std::remove_cvref_t<T>,num_t> );
+
+namespace detail
+{
+/*
+ * result_t with coordinate i equal to f(i)
+ *    the result is aggregate initialised in place, rather than default constructed then assigned in a loop,
+ *    so the compiler does not need to copy it into the destination of the operator
+ *    f(i) is converted to the value_type of result_t, eg integer promotions of narrow integer coordinates are narrowed back
+ */
+   template<typename result_t, std::size_t ndim, typename f_t>
+   [[nodiscard]]
+   constexpr result_t elementwise( f_t&& f )
+  {
+      using value_t = typename result_t::value_type;
+      return [&]<std::size_t... i>( std::index_sequence<i...> ){ return result_t{{{{static_cast<value_t>(f(i))...}}}}; }( std::make_index_sequence<ndim>{} );
+  }
+
+/*
+ * dynamic extent result_t of dimension n with coordinate i equal to f(i)
+ */
+   template<typename result_t, typename f_t>
+   [[nodiscard]]
+   constexpr result_t elementwise( const std::size_t n, f_t&& f )
+  {
+      result_t result;
+      result.resize(n);
+      for( std::size_t i=0; i<n; ++i ){ result[i]=static_cast<typename result_t::value_type>(f(i)); }
+      return result;
+  }
+}
+
+// --------------- dynamic extent storage ---------------
+
+/*
+ * ndim of point_base/delta_base types whose dimension is only known at runtime
+ */
+   constexpr std::size_t dynamic_extent = std::dynamic_extent;
+
+/*
+ * number of coordinates of a dynamic extent point/delta stored inline, beyond which they are stored on the heap
+ *    can be specialised for other num_t
+ */
+   template<typename num_t>
+   constexpr std::size_t dynamic_inline_capacity = std::max<std::size_t>( 128/sizeof(num_t), 1 );
+
+/*
+ * contiguous coordinates of a dynamic extent point/delta
+ *    up to inline_capacity coordinates are stored in the object itself, more are stored in a heap buffer
+ *    copies reuse the capacity of the destination, and moves steal the heap buffer of the source
+ */
+   template<typename num_t,
+            std::size_t inline_capacity>
+   class small_vector
+  {
+      static_assert( std::is_trivially_copyable_v<num_t>, "small_vector requires a trivially copyable num_t" );
+
+      public:
+
+      using value_type     = num_t;
+      using iterator       = num_t*;
+      using const_iterator = const num_t*;
+
+      // alignment of the heap buffer
+      constexpr static std::size_t heap_alignment = std::max<std::size_t>( 64, alignof(num_t) );
+
+      small_vector() noexcept = default;
+
+      // n value initialised coordinates
+      explicit small_vector( const std::size_t n ){ resize(n); }
+
+      small_vector( const std::initializer_list<num_t> values ){ assign( values.begin(), values.size() ); }
+
+      small_vector( const small_vector& other ){ assign( other.data(), other.size() ); }
+
+      small_vector( small_vector&& other ) noexcept { steal(other); }
+
+      small_vector& operator=( const small_vector& other )
+     {
+         if( this!=&other ){ assign( other.data(), other.size() ); }
+         return *this;
+     }
+
+      small_vector& operator=( small_vector&& other ) noexcept
+     {
+         if( this!=&other ){ release(); steal(other); }
+         return *this;
+     }
+
+     ~small_vector(){ release(); }
+
+      [[nodiscard]] std::size_t size()     const noexcept { return length; }
+      [[nodiscard]] std::size_t capacity() const noexcept { return room; }
+      [[nodiscard]] bool        empty()    const noexcept { return length==0; }
+      [[nodiscard]] bool        on_heap()  const noexcept { return heap!=nullptr; }
+
+      [[nodiscard]]       num_t* data()       noexcept { return heap ? heap : local.data(); }
+      [[nodiscard]] const num_t* data() const noexcept { return heap ? heap : local.data(); }
+
+      [[nodiscard]]       num_t& operator[]( const std::size_t i )       noexcept { return data()[i]; }
+      [[nodiscard]] const num_t& operator[]( const std::size_t i ) const noexcept { return data()[i]; }
+
+      [[nodiscard]] iterator       begin()       noexcept { return data(); }
+      [[nodiscard]] iterator       end()         noexcept { return data()+length; }
+      [[nodiscard]] const_iterator begin() const noexcept { return data(); }
+      [[nodiscard]] const_iterator end()   const noexcept { return data()+length; }
+
+      void reserve( const std::size_t n )
+     {
+         if( n<=room ){ return; }
+
+         num_t* buffer = static_cast<num_t*>( ::operator new( n*sizeof(num_t), std::align_val_t{heap_alignment} ) );
+         std::copy_n( data(), length, buffer );
+
+         const std::size_t n_old = length;
+         release();
+         heap=buffer;
+         room=n;
+         length=n_old;
+     }
+
+      // new coordinates are value initialised
+      void resize( const std::size_t n )
+     {
+         reserve(n);
+         if( n>length ){ std::fill( data()+length, data()+n, num_t{} ); }
+         length=n;
+     }
+
+      void clear() noexcept { length=0; }
+
+      private:
+
+      void assign( const num_t* values, const std::size_t n )
+     {
+         length=0;
+         reserve(n);
+         std::copy_n( values, n, data() );
+         length=n;
+     }
+
+      void steal( small_vector& other ) noexcept
+     {
+         if( other.heap )
+        {
+            heap=std::exchange( other.heap, nullptr );
+            room=std::exchange( other.room, inline_capacity );
+        }
+         else
+        {
+            // other.length<=inline_capacity here, the min only lets the compiler see it
+            std::copy_n( other.local.data(), std::min( other.length, inline_capacity ), local.data() );
+        }
+         length=std::exchange( other.length, 0 );
+     }
+
+      void release() noexcept
+     {
+         if( heap ){ ::operator delete( heap, std::align_val_t{heap_alignment} ); }
+         heap=nullptr;
+         room=inline_capacity;
+         length=0;
+     }
+
+      num_t*      heap=nullptr;
+      std::size_t length=0;
+      std::size_t room=inline_capacity;
+      std::array<num_t,inline_capacity> local;
+  };
+
+// --------------- coordinate arithmetic ---------------
+
+namespace detail
+{
+/*
+ * coordinate of p+d or p-d, computed in the common type of the point and delta coordinates and converted to the point coordinates
+ */
+   template<typename num_t, typename dnum_t>
+   [[nodiscard]]
+   constexpr num_t offset_coordinate( const num_t& p, const dnum_t& d )
+  {
+      using common_t = std::common_type_t<num_t,dnum_t>;
+      return static_cast<num_t>( static_cast<common_t>(p)+static_cast<common_t>(d) );
+  }
+
+   template<typename num_t, typename dnum_t>
+   [[nodiscard]]
+   constexpr num_t negative_offset_coordinate( const num_t& p, const dnum_t& d )
+  {
+      using common_t = std::common_type_t<num_t,dnum_t>;
+      return static_cast<num_t>( static_cast<common_t>(p)-static_cast<common_t>(d) );
+  }
+
+/*
+ * coordinate of p-q, computed in the common type of the point and delta coordinates and converted to the delta coordinates
+ *    a wider delta type cannot overflow, and a narrower one (eg double points, float deltas) only rounds the difference
+ */
+   template<typename dnum_t, typename num_t>
+   [[nodiscard]]
+   constexpr dnum_t difference_coordinate( const num_t& p, const num_t& q )
+  {
+      using common_t = std::common_type_t<num_t,dnum_t>;
+      return static_cast<dnum_t>( static_cast<common_t>(p)-static_cast<common_t>(q) );
+  }
+
+/*
+ * floor(sqrt(n)) of a non-negative integer, exact for any width, and 0 for n<=0
+ *    computed one bit of the root at a time, so it needs no floating point and is identical on every platform
+ */
+   template<typename int_t>
+   [[nodiscard]]
+   constexpr int_t integer_sqrt( int_t n )
+  {
+      int_t root = 0;
+      if( n<=0 ){ return root; }
+      int_t bit = int_t(1)<<(8*sizeof(int_t)-2);
+      while( bit>n ){ bit>>=2; }
+      for( ; bit!=0; bit>>=2 )
+     {
+         if( n>=root+bit ){ n-=root+bit; root=(root>>1)+bit; }
+         else{ root>>=1; }
+     }
+      return root;
+  }
+}
+
+// --------------- fixed extent storage ---------------
+
+/*
+ * ndim coordinates followed by the homogeneous coordinate w, which is 1 for points and 0 for deltas
+ *    w is never changed by the arithmetic operators, so a single (ndim+1)x(ndim+1) matrix [L t; 0 1] maps both points and deltas
+ *    the alignment is the size rounded up to a power of two, so 3 coordinates and w fill a vector register and are never split by a cache line
+ */
+   template<typename num_t,
+            std::size_t ndim,
+            bool is_point>
+   struct alignas(std::bit_ceil((ndim+1)*sizeof(num_t))) homogeneous_array
+  {
+      std::array<num_t,ndim> coordinates;
+      num_t w = is_point ? num_t(1) : num_t(0);
+
+      [[nodiscard]] constexpr static std::size_t size() noexcept { return ndim; }
+
+      [[nodiscard]] constexpr       num_t& operator[]( const std::size_t i )       { return coordinates[i]; }
+      [[nodiscard]] constexpr const num_t& operator[]( const std::size_t i ) const { return coordinates[i]; }
+
+      [[nodiscard]] constexpr       num_t* data()       noexcept { return coordinates.data(); }
+      [[nodiscard]] constexpr const num_t* data() const noexcept { return coordinates.data(); }
+
+      [[nodiscard]] constexpr       num_t* begin()       noexcept { return coordinates.data(); }
+      [[nodiscard]] constexpr const num_t* begin() const noexcept { return coordinates.data(); }
+      [[nodiscard]] constexpr       num_t* end()         noexcept { return coordinates.data()+ndim; }
+      [[nodiscard]] constexpr const num_t* end()   const noexcept { return coordinates.data()+ndim; }
+  };
+
+/*
+ * storage policies, element_type<num_t,ndim,is_point> is the type storing the coordinates of a point (is_point) or delta
+ */
+   struct packed_storage
+  {
+      template<typename num_t, std::size_t ndim, bool is_point>
+      using element_type = std::array<num_t,ndim>;
+  };
+
+   struct homogeneous_storage
+  {
+      template<typename num_t, std::size_t ndim, bool is_point>
+      using element_type = homogeneous_array<num_t,ndim,is_point>;
+  };
+
+/*
+ * customisation point for the storage of fixed extent point_t and its delta_t
+ *    must be specialised before point_t and delta_t are defined
+ *
+ *       template<>
+ *       struct affine::storage_traits<my_point> { using type = affine::homogeneous_storage; };
+ */
+   template<typename point_t>
+   struct storage_traits
+  {
+      using type = packed_storage;
+  };
+
+   template<typename point_t, typename num_t, std::size_t ndim, bool is_point>
+   using storage_element_t = typename storage_traits<point_t>::type::template element_type<num_t,ndim,is_point>;
 
 // --------------- forward declarations ---------------
 
@@ -132,12 +483,16 @@ namespace affine
    struct point_base
   {
       constexpr static bool vector_valued = (ndim>0);
+      constexpr static bool dynamic = (ndim==dynamic_extent);
 
       using element_type =
+         std::conditional_t<
+            dynamic,
+            small_vector<num_t,dynamic_inline_capacity<num_t>>,
          std::conditional_t<
             vector_valued,
-            std::array<num_t,ndim>,
-            num_t>;
+            storage_element_t<point_t,num_t,ndim,true>,
+            num_t>>;
 
       using value_type = num_t;
       using point_type = point_t;
@@ -145,35 +500,51 @@ namespace affine
       element_type element;
 
       [[nodiscard]]
-      constexpr static std::size_t size() requires vector_valued { return ndim; }
+      constexpr static std::size_t size() requires (vector_valued && !dynamic) { return ndim; }
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires dynamic { return element.size(); }
+
+      // set the dimension of a dynamic extent space, new coordinates are zero
+      constexpr void resize( const std::size_t n ) requires dynamic { element.resize(n); }
 
    // accessors
       [[nodiscard]] constexpr       value_type& operator[]( const std::size_t i )       requires vector_valued { return element[i]; }
       [[nodiscard]] constexpr const value_type& operator[]( const std::size_t i ) const requires vector_valued { return element[i]; }
 
-   // in-place arithmetic
+   // in-place arithmetic, computed in the common type of the point and delta coordinates
       constexpr point_type& operator+=( const delta_type& d )
      {
-         if constexpr( vector_valued )
+         if constexpr( dynamic )
         {
-            for( std::size_t i=0; i<ndim; ++i ){ element[i]+=d[i]; }
+            assert( size()==d.size() );
+            for( std::size_t i=0; i<size(); ++i ){ element[i]=detail::offset_coordinate(element[i],d[i]); }
+        }
+         else if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ndim; ++i ){ element[i]=detail::offset_coordinate(element[i],d[i]); }
         }
          else
         {
-            element+=d.element;
+            element=detail::offset_coordinate(element,d.element);
         }
          return static_cast<point_type&>(*this);
      }
 
       constexpr point_type& operator-=( const delta_type& d )
      {
-         if constexpr( vector_valued )
+         if constexpr( dynamic )
         {
-            for( std::size_t i=0; i<ndim; ++i ){ element[i]-=d[i]; }
+            assert( size()==d.size() );
+            for( std::size_t i=0; i<size(); ++i ){ element[i]=detail::negative_offset_coordinate(element[i],d[i]); }
+        }
+         else if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ndim; ++i ){ element[i]=detail::negative_offset_coordinate(element[i],d[i]); }
         }
          else
         {
-            element-=d.element;
+            element=detail::negative_offset_coordinate(element,d.element);
         }
          return static_cast<point_type&>(*this);
      }
@@ -190,12 +561,16 @@ namespace affine
    struct delta_base
   {
       constexpr static bool vector_valued = (ndim>0);
+      constexpr static bool dynamic = (ndim==dynamic_extent);
 
       using element_type =
+         std::conditional_t<
+            dynamic,
+            small_vector<num_t,dynamic_inline_capacity<num_t>>,
          std::conditional_t<
             vector_valued,
-            std::array<num_t,ndim>,
-            num_t>;
+            storage_element_t<point_t,num_t,ndim,false>,
+            num_t>>;
 
       using value_type = num_t;
       using point_type = point_t;
@@ -203,7 +578,13 @@ namespace affine
       element_type element;
 
       [[nodiscard]]
-      constexpr static std::size_t size() requires vector_valued { return ndim; }
+      constexpr static std::size_t size() requires (vector_valued && !dynamic) { return ndim; }
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires dynamic { return element.size(); }
+
+      // set the dimension of a dynamic extent space, new coordinates are zero
+      constexpr void resize( const std::size_t n ) requires dynamic { element.resize(n); }
 
    // accessors
       [[nodiscard]] constexpr       value_type& operator[]( const std::size_t i )       requires vector_valued { return element[i]; }
@@ -212,7 +593,12 @@ namespace affine
    // in-place arithmetic
       constexpr delta_type& operator+=( const delta_type& d )
      {
-         if constexpr( vector_valued )
+         if constexpr( dynamic )
+        {
+            assert( size()==d.size() );
+            for( std::size_t i=0; i<size(); ++i ){ element[i]+=d[i]; }
+        }
+         else if constexpr( vector_valued )
         {
             for( std::size_t i=0; i<ndim; ++i ){ element[i]+=d[i]; }
         }
@@ -225,7 +611,12 @@ namespace affine
 
       constexpr delta_type& operator-=( const delta_type& d )
      {
-         if constexpr( vector_valued )
+         if constexpr( dynamic )
+        {
+            assert( size()==d.size() );
+            for( std::size_t i=0; i<size(); ++i ){ element[i]-=d[i]; }
+        }
+         else if constexpr( vector_valued )
         {
             for( std::size_t i=0; i<ndim; ++i ){ element[i]-=d[i]; }
         }
@@ -236,38 +627,72 @@ namespace affine
          return static_cast<delta_type&>(*this);
      }
 
-      constexpr delta_type& operator*=( const std::convertible_to<num_t> auto a )
+      constexpr delta_type& operator*=( const scale_factor<num_t> auto a )
      {
-         if constexpr( vector_valued )
+         const num_t s = static_cast<num_t>(a);
+         if constexpr( dynamic )
         {
-            for( auto& w : element ){ w*=a; }
+            for( std::size_t i=0; i<size(); ++i ){ element[i]*=s; }
+        }
+         else if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ndim; ++i ){ element[i]*=s; }
         }
          else
         {
-            element*=a;
+            element*=s;
         }
          return static_cast<delta_type&>(*this);
      }
 
-      constexpr delta_type& operator/=( const std::convertible_to<num_t> auto a )
+      // exact num_t divide each coordinate (integers truncate towards zero), others multiply by the reciprocal
+      constexpr delta_type& operator/=( const scale_factor<num_t> auto a )
      {
-         return static_cast<delta_type&>(*this)*=num_t(1)/a;
+         if constexpr( exact_numeric<num_t> )
+        {
+            const num_t s = static_cast<num_t>(a);
+            if constexpr( vector_valued )
+           {
+               for( std::size_t i=0; i<size(); ++i ){ element[i]/=s; }
+           }
+            else
+           {
+               element/=s;
+           }
+            return static_cast<delta_type&>(*this);
+        }
+         else
+        {
+            return static_cast<delta_type&>(*this)*=num_t(1)/a;
+        }
      }
 
       [[nodiscard]]
-      constexpr delta_type operator-()
+      constexpr delta_type operator-() const&
      {
-         if constexpr( vector_valued )
+         if constexpr( dynamic )
         {
             delta_t result(static_cast<const delta_t&>(*this));
             for( auto& x : result.element ){ x=-x; }
             return result;
+        }
+         else if constexpr( vector_valued )
+        {
+            return detail::elementwise<delta_t,ndim>( [&]( const std::size_t i ){ return -element[i]; } );
         }
          else
         {
-            return {{-element}};
+            return {{static_cast<num_t>(-element)}};
         }
      }
+
+      // reuses the storage of a dynamic extent rvalue
+      [[nodiscard]]
+      constexpr delta_type operator-() && requires dynamic
+     {
+         for( auto& x : element ){ x=-x; }
+         return std::move(static_cast<delta_t&>(*this));
+     }
   };
 
 /*
@@ -303,15 +728,19 @@ namespace affine
    constexpr delta_t operator-( const point_base<ndim,point_t,delta_t,num_t>& lhs,
                                 const point_base<ndim,point_t,delta_t,num_t>& rhs )
   {
-      if constexpr( std::remove_reference_t<decltype(lhs)>::vector_valued )
+      using dnum_t = typename delta_t::value_type;
+      if constexpr( std::remove_reference_t<decltype(lhs)>::dynamic )
      {
-         delta_t del{};
-         for( std::size_t i=0; i<ndim; ++i ){ del[i]=lhs[i]-rhs[i]; }
-         return del;
+         assert( lhs.size()==rhs.size() );
+         return detail::elementwise<delta_t>( lhs.size(), [&]( const std::size_t i ){ return detail::difference_coordinate<dnum_t>(lhs[i],rhs[i]); } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(lhs)>::vector_valued )
+     {
+         return detail::elementwise<delta_t,ndim>( [&]( const std::size_t i ){ return detail::difference_coordinate<dnum_t>(lhs[i],rhs[i]); } );
      }
       else
      {
-         return {{lhs.element-rhs.element}};
+         return {{detail::difference_coordinate<dnum_t>(lhs.element,rhs.element)}};
      }
   }
 
@@ -319,28 +748,50 @@ namespace affine
    template<std::size_t ndim,
             typename point_t,
             typename delta_t,
-            numeric    num_t>
+            numeric    num_t,
+            numeric    dnum_t>
    [[nodiscard]]
    constexpr point_t operator+( const point_base<ndim,point_t,delta_t,num_t>& p,
-                                const delta_base<ndim,point_t,delta_t,num_t>& d )
+                                const delta_base<ndim,point_t,delta_t,dnum_t>& d )
   {
-      point_t result(static_cast<const point_t&>(p));
-      result+=static_cast<const delta_t&>(d);
-      return result;
+      if constexpr( std::remove_reference_t<decltype(p)>::dynamic )
+     {
+         assert( p.size()==d.size() );
+         return detail::elementwise<point_t>( p.size(), [&]( const std::size_t i ){ return detail::offset_coordinate(p[i],d[i]); } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(p)>::vector_valued )
+     {
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t i ){ return detail::offset_coordinate(p[i],d[i]); } );
+     }
+      else
+     {
+         return {{detail::offset_coordinate(p.element,d.element)}};
+     }
   }
 
    // p = p-d
    template<std::size_t ndim,
             typename point_t,
             typename delta_t,
-            numeric    num_t>
+            numeric    num_t,
+            numeric    dnum_t>
    [[nodiscard]]
    constexpr point_t operator-( const point_base<ndim,point_t,delta_t,num_t>& p,
-                                const delta_base<ndim,point_t,delta_t,num_t>& d )
+                                const delta_base<ndim,point_t,delta_t,dnum_t>& d )
   {
-      point_t result(static_cast<const point_t&>(p));
-      result-=static_cast<const delta_t&>(d);
-      return result;
+      if constexpr( std::remove_reference_t<decltype(p)>::dynamic )
+     {
+         assert( p.size()==d.size() );
+         return detail::elementwise<point_t>( p.size(), [&]( const std::size_t i ){ return detail::negative_offset_coordinate(p[i],d[i]); } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(p)>::vector_valued )
+     {
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t i ){ return detail::negative_offset_coordinate(p[i],d[i]); } );
+     }
+      else
+     {
+         return {{detail::negative_offset_coordinate(p.element,d.element)}};
+     }
   }
 
 
@@ -355,9 +806,19 @@ namespace affine
    constexpr delta_t operator+( const delta_base<ndim,point_t,delta_t,num_t>& lhs,
                                 const delta_base<ndim,point_t,delta_t,num_t>& rhs )
   {
-      delta_t result(static_cast<const delta_t&>(lhs));
-      result+=static_cast<const delta_t&>(rhs);
-      return result;
+      if constexpr( std::remove_reference_t<decltype(lhs)>::dynamic )
+     {
+         assert( lhs.size()==rhs.size() );
+         return detail::elementwise<delta_t>( lhs.size(), [&]( const std::size_t i ){ return lhs[i]+rhs[i]; } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(lhs)>::vector_valued )
+     {
+         return detail::elementwise<delta_t,ndim>( [&]( const std::size_t i ){ return lhs[i]+rhs[i]; } );
+     }
+      else
+     {
+         return {{static_cast<num_t>(lhs.element+rhs.element)}};
+     }
   }
 
    // d = d-d
@@ -369,9 +830,19 @@ namespace affine
    constexpr delta_t operator-( const delta_base<ndim,point_t,delta_t,num_t>& lhs,
                                 const delta_base<ndim,point_t,delta_t,num_t>& rhs )
   {
-      delta_t result(static_cast<const delta_t&>(lhs));
-      result-=static_cast<const delta_t&>(rhs);
-      return result;
+      if constexpr( std::remove_reference_t<decltype(lhs)>::dynamic )
+     {
+         assert( lhs.size()==rhs.size() );
+         return detail::elementwise<delta_t>( lhs.size(), [&]( const std::size_t i ){ return lhs[i]-rhs[i]; } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(lhs)>::vector_valued )
+     {
+         return detail::elementwise<delta_t,ndim>( [&]( const std::size_t i ){ return lhs[i]-rhs[i]; } );
+     }
+      else
+     {
+         return {{static_cast<num_t>(lhs.element-rhs.element)}};
+     }
   }
 
    // d = a*d
@@ -380,12 +851,22 @@ namespace affine
             typename delta_t,
             numeric    num_t>
    [[nodiscard]]
-   constexpr delta_t operator*( const std::convertible_to<num_t> auto a,
+   constexpr delta_t operator*( const scale_factor<num_t> auto a,
                                 const delta_base<ndim,point_t,delta_t,num_t>& d )
   {
-      delta_t result(static_cast<const delta_t&>(d));
-      result*=a;
-      return result;
+      const num_t s = static_cast<num_t>(a);
+      if constexpr( std::remove_reference_t<decltype(d)>::dynamic )
+     {
+         return detail::elementwise<delta_t>( d.size(), [&]( const std::size_t i ){ return s*d[i]; } );
+     }
+      else if constexpr( std::remove_reference_t<decltype(d)>::vector_valued )
+     {
+         return detail::elementwise<delta_t,ndim>( [&]( const std::size_t i ){ return s*d[i]; } );
+     }
+      else
+     {
+         return {{static_cast<num_t>(s*d.element)}};
+     }
   }
 
    // d = d*a
@@ -395,7 +876,7 @@ namespace affine
             numeric    num_t>
    [[nodiscard]]
    constexpr delta_t operator*( const delta_base<ndim,point_t,delta_t,num_t>& d,
-                                const std::convertible_to<num_t> auto a )
+                                const scale_factor<num_t> auto a )
   {
       return a*d;
   }
@@ -407,12 +888,265 @@ namespace affine
             numeric    num_t>
    [[nodiscard]]
    constexpr delta_t operator/( const delta_base<ndim,point_t,delta_t,num_t>& d,
-                                const std::convertible_to<num_t> auto a )
+                                const scale_factor<num_t> auto a )
   {
       delta_t result(static_cast<const delta_t&>(d));
       result/=a;
       return result;
   }
 
-}
 
+// --------------- rvalue arithmetic ---------------
+
+/*
+ * dynamic extent overloads which reuse the storage of an rvalue operand for the result
+ *    e.g. std::move(d0)+d1 adds d1 into the buffer of d0, so a chain d0+d1+d2+... allocates at most once
+ *    the result of p-p reuses a point buffer for a delta, and p+d reuses a delta buffer for a point, when both store the same element_type
+ */
+
+   // d = p-p
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent) && std::same_as<num_t,typename delta_t::value_type>
+   [[nodiscard]]
+   constexpr delta_t operator-( point_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                const point_base<ndim,point_t,delta_t,num_t>& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      delta_t result{{std::move(lhs.element)}};
+      for( std::size_t i=0; i<result.size(); ++i ){ result[i]-=rhs[i]; }
+      return result;
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent) && std::same_as<num_t,typename delta_t::value_type>
+   [[nodiscard]]
+   constexpr delta_t operator-( const point_base<ndim,point_t,delta_t,num_t>& lhs,
+                                point_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      delta_t result{{std::move(rhs.element)}};
+      for( std::size_t i=0; i<result.size(); ++i ){ result[i]=lhs[i]-result[i]; }
+      return result;
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent) && std::same_as<num_t,typename delta_t::value_type>
+   [[nodiscard]]
+   constexpr delta_t operator-( point_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                point_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      return std::move(lhs)-static_cast<const point_base<ndim,point_t,delta_t,num_t>&>(rhs);
+  }
+
+   // p = p+d
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator+( point_base<ndim,point_t,delta_t,num_t>&& p,
+                                const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      p+=static_cast<const delta_t&>(d);
+      return std::move(static_cast<point_t&>(p));
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator+( const point_base<ndim,point_t,delta_t,num_t>& p,
+                                delta_base<ndim,point_t,delta_t,num_t>&& d )
+  {
+      assert( p.size()==d.size() );
+      point_t result{{std::move(d.element)}};
+      for( std::size_t i=0; i<result.size(); ++i ){ result[i]=p[i]+result[i]; }
+      return result;
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator+( point_base<ndim,point_t,delta_t,num_t>&& p,
+                                delta_base<ndim,point_t,delta_t,num_t>&& d )
+  {
+      return std::move(p)+static_cast<const delta_base<ndim,point_t,delta_t,num_t>&>(d);
+  }
+
+   // p = p-d
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator-( point_base<ndim,point_t,delta_t,num_t>&& p,
+                                const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      p-=static_cast<const delta_t&>(d);
+      return std::move(static_cast<point_t&>(p));
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator-( const point_base<ndim,point_t,delta_t,num_t>& p,
+                                delta_base<ndim,point_t,delta_t,num_t>&& d )
+  {
+      assert( p.size()==d.size() );
+      point_t result{{std::move(d.element)}};
+      for( std::size_t i=0; i<result.size(); ++i ){ result[i]=p[i]-result[i]; }
+      return result;
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr point_t operator-( point_base<ndim,point_t,delta_t,num_t>&& p,
+                                delta_base<ndim,point_t,delta_t,num_t>&& d )
+  {
+      return std::move(p)-static_cast<const delta_base<ndim,point_t,delta_t,num_t>&>(d);
+  }
+
+   // d = d+d
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator+( delta_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                const delta_base<ndim,point_t,delta_t,num_t>& rhs )
+  {
+      lhs+=static_cast<const delta_t&>(rhs);
+      return std::move(static_cast<delta_t&>(lhs));
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator+( const delta_base<ndim,point_t,delta_t,num_t>& lhs,
+                                delta_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      return std::move(rhs)+lhs;
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator+( delta_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                delta_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      return std::move(lhs)+static_cast<const delta_base<ndim,point_t,delta_t,num_t>&>(rhs);
+  }
+
+   // d = d-d
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator-( delta_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                const delta_base<ndim,point_t,delta_t,num_t>& rhs )
+  {
+      lhs-=static_cast<const delta_t&>(rhs);
+      return std::move(static_cast<delta_t&>(lhs));
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator-( const delta_base<ndim,point_t,delta_t,num_t>& lhs,
+                                delta_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      for( std::size_t i=0; i<rhs.size(); ++i ){ rhs[i]=lhs[i]-rhs[i]; }
+      return std::move(static_cast<delta_t&>(rhs));
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator-( delta_base<ndim,point_t,delta_t,num_t>&& lhs,
+                                delta_base<ndim,point_t,delta_t,num_t>&& rhs )
+  {
+      return std::move(lhs)-static_cast<const delta_base<ndim,point_t,delta_t,num_t>&>(rhs);
+  }
+
+   // d = a*d
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator*( const scale_factor<num_t> auto a,
+                                delta_base<ndim,point_t,delta_t,num_t>&& d )
+  {
+      d*=a;
+      return std::move(static_cast<delta_t&>(d));
+  }
+
+   // d = d*a
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator*( delta_base<ndim,point_t,delta_t,num_t>&& d,
+                                const scale_factor<num_t> auto a )
+  {
+      d*=a;
+      return std::move(static_cast<delta_t&>(d));
+  }
+
+   // d = d/a
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+      requires (ndim==dynamic_extent)
+   [[nodiscard]]
+   constexpr delta_t operator/( delta_base<ndim,point_t,delta_t,num_t>&& d,
+                                const scale_factor<num_t> auto a )
+  {
+      d/=a;
+      return std::move(static_cast<delta_t&>(d));
+  }
+
+}
@@ -0,0 +1,436 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines floating origin (anchored) points, which store large coordinates as an anchor plus a compact local offset.
+ *
+ *    anchored_point<point_t,local_t> is an anchor point_t plus a local_point with local_t coordinates (float by default), the offset from the anchor.
+ *    Far from the origin a float cannot resolve small distances, but the offset from a nearby anchor can, so only the anchors need num_t.
+ *       p.value()            position as a point_t, anchor+local rounded once
+ *       p-q                  delta_t, the anchors and the local coordinates are subtracted separately, then added and rounded once
+ *       p+d, p-d, p+=d       move the local coordinates, the anchor is unchanged
+ *       p.reanchor(a)        move the anchor to a, the position is unchanged up to rounding of the local coordinates
+ *    point_t must have a fixed ndim and floating point coordinates. Arithmetic is done in the common type of the point and delta coordinates.
+ *
+ *    anchored_array<point_t,local_t> stores consecutive tiles of tile_size points which share one anchor,
+ *    and the local coordinates of all points in a point_array (SoA) of local_point.
+ *    The anchors lie on a grid whose spacing is a power of two, so the difference of two anchors is exact, and p-q is rounded once across tiles.
+ *       a.push_back(p)       append p, a new tile is anchored at p rounded to the grid
+ *       a[i]                 anchored_point i, a.value(i) its position
+ *       a.reanchor()         move the anchor of every tile to the centre of its bounding box, eg after the points have moved away from it
+ *       a.locals()           local coordinates, for the batched kernels of kernels.h in local_t
+ *    advance(a,dt,v) moves the points by local_delta v with the local_t kernels of kernels.h,
+ *    and difference(p,q,d) subtracts the anchors once per tile and the local coordinates in one pass over each column.
+ *
+ *    Code example:
+ *
+ *       using world = affine::anchored_array<cartesian_point_t<3>>;      // 12 bytes per point, plus one 24 byte anchor per tile
+ *
+ *       world x(1024);
+ *       for( const auto& p : positions ){ x.push_back(p); }
+ *
+ *       affine::delta_array<world::local_delta_type> v(x.size());
+ *       affine::advance( x, dt, v );                                     // float kernels, 16 lanes with avx512
+ *       x.reanchor();
+ *
+ *       cartesian_delta_t<3> d = x[i]-x[j];                              // exact difference of the anchors
+ */
+
+# include "affine_space.h"
+# include "kernels.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <cassert>
+# include <cmath>
+# include <concepts>
+# include <cstddef>
+# include <span>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+// --------------- local frame ---------------
+
+   template<std::size_t ndim, typename local_t> struct local_point;
+   template<std::size_t ndim, typename local_t> struct local_delta;
+
+/*
+ * coordinates relative to an anchor, in the compact number type local_t
+ *    the local frame is an affine space of its own, so point_array, delta_array and the kernels of kernels.h apply to it
+ */
+   template<std::size_t ndim, typename local_t>
+   struct local_point : point_base<ndim,local_point<ndim,local_t>,local_delta<ndim,local_t>,local_t> {};
+
+   template<std::size_t ndim, typename local_t>
+   struct local_delta : delta_base<ndim,local_point<ndim,local_t>,local_delta<ndim,local_t>,local_t> {};
+
+/*
+ * point types which can be anchored
+ */
+   template<typename point_t>
+   concept anchorable =
+      point_t::vector_valued && !point_t::dynamic
+   && std::floating_point<typename point_t::value_type>
+   && std::floating_point<typename point_t::delta_type::value_type>;
+
+// --------------- anchored points ---------------
+
+/*
+ * point_t stored as an anchor and the local coordinates of the point relative to it
+ */
+   template<anchorable point_t,
+            typename local_t = float>
+   struct anchored_point
+  {
+      constexpr static std::size_t ndim = point_t::size();
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      using local_point_type = local_point<ndim,local_t>;
+      using local_delta_type = local_delta<ndim,local_t>;
+
+      // anchors and local coordinates are combined in compute_type
+      using compute_type = std::common_type_t<value_type,typename delta_type::value_type>;
+
+      point_t anchor;
+      local_point_type local;
+
+      // anchor+local, rounded once
+      [[nodiscard]]
+      constexpr point_t value() const
+     {
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t i )
+        {
+            return static_cast<compute_type>(anchor[i])+static_cast<compute_type>(local[i]);
+        } );
+     }
+
+      // move the anchor to a, the local coordinates are rounded once
+      constexpr void reanchor( const point_t& a )
+     {
+         for( std::size_t i=0; i<ndim; ++i )
+        {
+            const compute_type shift = static_cast<compute_type>(anchor[i])-static_cast<compute_type>(a[i]);
+            local[i] = static_cast<local_t>( static_cast<compute_type>(local[i])+shift );
+        }
+         anchor=a;
+     }
+
+      constexpr anchored_point& operator+=( const delta_type& d )
+     {
+         for( std::size_t i=0; i<ndim; ++i )
+        {
+            local[i] = static_cast<local_t>( static_cast<compute_type>(local[i])+static_cast<compute_type>(d[i]) );
+        }
+         return *this;
+     }
+
+      constexpr anchored_point& operator-=( const delta_type& d )
+     {
+         for( std::size_t i=0; i<ndim; ++i )
+        {
+            local[i] = static_cast<local_t>( static_cast<compute_type>(local[i])-static_cast<compute_type>(d[i]) );
+        }
+         return *this;
+     }
+  };
+
+   // d = p-q, the difference of the anchors is exact if they lie on the same power of two grid
+   template<typename point_t, typename local_t>
+   [[nodiscard]]
+   constexpr typename point_t::delta_type operator-( const anchored_point<point_t,local_t>& p,
+                                                     const anchored_point<point_t,local_t>& q )
+  {
+      using compute_t = typename anchored_point<point_t,local_t>::compute_type;
+      return detail::elementwise<typename point_t::delta_type,point_t::size()>( [&]( const std::size_t i )
+     {
+         const compute_t anchors = static_cast<compute_t>(p.anchor[i])-static_cast<compute_t>(q.anchor[i]);
+         const compute_t locals  = static_cast<compute_t>(p.local[i])-static_cast<compute_t>(q.local[i]);
+         return anchors+locals;
+     } );
+  }
+
+   // d = p-q
+   template<typename point_t, typename local_t>
+   [[nodiscard]]
+   constexpr typename point_t::delta_type operator-( const anchored_point<point_t,local_t>& p,
+                                                     const point_t& q )
+  {
+      using compute_t = typename anchored_point<point_t,local_t>::compute_type;
+      return detail::elementwise<typename point_t::delta_type,point_t::size()>( [&]( const std::size_t i )
+     {
+         return (static_cast<compute_t>(p.anchor[i])-static_cast<compute_t>(q[i]))+static_cast<compute_t>(p.local[i]);
+     } );
+  }
+
+   // d = p-q
+   template<typename point_t, typename local_t>
+   [[nodiscard]]
+   constexpr typename point_t::delta_type operator-( const point_t& p,
+                                                     const anchored_point<point_t,local_t>& q )
+  {
+      using compute_t = typename anchored_point<point_t,local_t>::compute_type;
+      return detail::elementwise<typename point_t::delta_type,point_t::size()>( [&]( const std::size_t i )
+     {
+         return (static_cast<compute_t>(p[i])-static_cast<compute_t>(q.anchor[i]))-static_cast<compute_t>(q.local[i]);
+     } );
+  }
+
+   // p+d, with the anchor of p
+   template<typename point_t, typename local_t>
+   [[nodiscard]]
+   constexpr anchored_point<point_t,local_t> operator+( anchored_point<point_t,local_t> p,
+                                                        const typename point_t::delta_type& d )
+  {
+      return p+=d;
+  }
+
+   // p-d, with the anchor of p
+   template<typename point_t, typename local_t>
+   [[nodiscard]]
+   constexpr anchored_point<point_t,local_t> operator-( anchored_point<point_t,local_t> p,
+                                                        const typename point_t::delta_type& d )
+  {
+      return p-=d;
+  }
+
+// --------------- anchored array ---------------
+
+   // default number of points sharing one anchor in an anchored_array
+   constexpr std::size_t anchor_tile = 1024;
+
+/*
+ * container of anchored points, in tiles of tile_size consecutive points with one anchor each
+ *    the local coordinates are stored in columns (point_array), so the kernels of kernels.h can be applied to them
+ */
+   template<anchorable point_t,
+            typename local_t = float>
+   class anchored_array
+  {
+      public:
+
+      using anchored_type = anchored_point<point_t,local_t>;
+
+      constexpr static std::size_t ndim = anchored_type::ndim;
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      using local_point_type = typename anchored_type::local_point_type;
+      using local_delta_type = typename anchored_type::local_delta_type;
+      using compute_type     = typename anchored_type::compute_type;
+
+      // spacing must be a power of two, so that differences of the anchors are exact
+      explicit anchored_array( const std::size_t tile_size=anchor_tile,
+                               const value_type spacing=1 )
+        : tile_length(tile_size),
+          grid(spacing)
+     {
+         assert( tile_size>0 );
+         assert( spacing>0 );
+         assert( std::exp2(std::ilogb(spacing))==spacing );
+     }
+
+      // the tiles are anchored at the centre of their bounding boxes
+      explicit anchored_array( const std::span<const point_t> points,
+                               const std::size_t tile_size=anchor_tile,
+                               const value_type spacing=1 )
+        : anchored_array(tile_size,spacing)
+     {
+         reserve( points.size() );
+         for( const point_t& p : points ){ push_back(p); }
+         reanchor();
+     }
+
+      [[nodiscard]] std::size_t size()      const noexcept { return local_points.size(); }
+      [[nodiscard]] bool        empty()     const noexcept { return local_points.empty(); }
+      [[nodiscard]] std::size_t tiles()     const noexcept { return anchor_points.size(); }
+      [[nodiscard]] std::size_t tile_size() const noexcept { return tile_length; }
+      [[nodiscard]] value_type  spacing()   const noexcept { return grid; }
+
+      // tile of point i, and the range of points [begin,end) in tile t
+      [[nodiscard]] std::size_t tile( const std::size_t i )       const noexcept { return i/tile_length; }
+      [[nodiscard]] std::size_t tile_begin( const std::size_t t ) const noexcept { return t*tile_length; }
+      [[nodiscard]] std::size_t tile_end( const std::size_t t )   const noexcept { return std::min( (t+1)*tile_length, size() ); }
+
+      [[nodiscard]] const point_t& anchor( const std::size_t t ) const { return anchor_points[t]; }
+
+      // local coordinates of every point, relative to the anchor of its tile
+      [[nodiscard]]       point_array<local_point_type>& locals()       noexcept { return local_points; }
+      [[nodiscard]] const point_array<local_point_type>& locals() const noexcept { return local_points; }
+
+      [[nodiscard]]
+      anchored_type operator[]( const std::size_t i ) const
+     {
+         return anchored_type{ anchor_points[tile(i)], local_points[i].value() };
+     }
+
+      [[nodiscard]] point_t value( const std::size_t i ) const { return (*this)[i].value(); }
+
+      // set point i to p, relative to the anchor of its tile
+      void assign( const std::size_t i, const point_t& p )
+     {
+         const point_t& a = anchor_points[tile(i)];
+         local_points[i] = detail::elementwise<local_point_type,ndim>( [&]( const std::size_t c )
+        {
+            return static_cast<compute_type>(p[c])-static_cast<compute_type>(a[c]);
+        } );
+     }
+
+      void reserve( const std::size_t n )
+     {
+         local_points.reserve(n);
+         anchor_points.reserve( (n+tile_length-1)/tile_length );
+     }
+
+      void clear() noexcept
+     {
+         local_points.clear();
+         anchor_points.clear();
+     }
+
+      void push_back( const point_t& p )
+     {
+         if( size()==tiles()*tile_length ){ anchor_points.push_back( snap(p) ); }
+         local_points.push_back( local_point_type{} );
+         assign( size()-1, p );
+     }
+
+   // bulk re-anchoring
+
+      // anchor every tile at the centre of the bounding box of its points, rounded to the grid
+      void reanchor()
+     {
+         for( std::size_t t=0; t<tiles(); ++t ){ reanchor( t, snap(centre(t)) ); }
+     }
+
+      // anchor tile t at a, the local coordinates of its points are shifted and rounded once
+      void reanchor( const std::size_t t,
+                     const point_t& a )
+     {
+         const std::size_t first = tile_begin(t);
+         const std::size_t last  = tile_end(t);
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const compute_type shift = static_cast<compute_type>(anchor_points[t][c])-static_cast<compute_type>(a[c]);
+            local_t* x = local_points.data(c);
+            for( std::size_t i=first; i<last; ++i ){ x[i] = static_cast<local_t>( static_cast<compute_type>(x[i])+shift ); }
+        }
+         anchor_points[t]=a;
+     }
+
+      private:
+
+      // nearest point on the anchor grid
+      [[nodiscard]]
+      point_t snap( const point_t& p ) const
+     {
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t c ){ return grid*std::round(p[c]/grid); } );
+     }
+
+      // centre of the bounding box of the points in tile t
+      [[nodiscard]]
+      point_t centre( const std::size_t t ) const
+     {
+         const std::size_t first = tile_begin(t);
+         const std::size_t last  = tile_end(t);
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t c )
+        {
+            const local_t* x = local_points.data(c);
+            compute_type lo = static_cast<compute_type>(x[first]);
+            compute_type hi = lo;
+            for( std::size_t i=first+1; i<last; ++i )
+           {
+               lo = std::min( lo, static_cast<compute_type>(x[i]) );
+               hi = std::max( hi, static_cast<compute_type>(x[i]) );
+           }
+            return static_cast<compute_type>(anchor_points[t][c])+(lo+hi)/2;
+        } );
+     }
+
+      std::size_t tile_length;
+      value_type grid;
+      std::vector<point_t> anchor_points;
+      point_array<local_point_type> local_points;
+  };
+
+// --------------- anchored array kernels ---------------
+
+   // p += a*d, in the local frame with the kernels of kernels.h
+   template<typename point_t, typename local_t>
+   void advance( anchored_array<point_t,local_t>& points,
+                 const scale_factor<local_t> auto a,
+                 const delta_array<typename anchored_array<point_t,local_t>::local_delta_type>& deltas )
+  {
+      advance( points.locals(), a, deltas );
+  }
+
+   // d = p-q, the anchors are subtracted once per pair of tiles, and the local coordinates in compute_type
+   template<typename point_t, typename local_t>
+   void difference( const anchored_array<point_t,local_t>& points_a,
+                    const anchored_array<point_t,local_t>& points_b,
+                    delta_array<typename point_t::delta_type>& deltas )
+  {
+      assert( points_a.size()==points_b.size() );
+      using compute_t = typename anchored_array<point_t,local_t>::compute_type;
+      using dnum_t = typename point_t::delta_type::value_type;
+
+      const std::size_t n = points_a.size();
+      deltas.resize(n);
+
+      // ranges of points which are in the same tile of both arrays
+      for( std::size_t first=0; first<n; )
+     {
+         const std::size_t ta = points_a.tile(first);
+         const std::size_t tb = points_b.tile(first);
+         const std::size_t last = std::min( points_a.tile_end(ta), points_b.tile_end(tb) );
+
+         for( std::size_t c=0; c<point_t::size(); ++c )
+        {
+            const compute_t shift = static_cast<compute_t>(points_a.anchor(ta)[c])-static_cast<compute_t>(points_b.anchor(tb)[c]);
+            const local_t* x = points_a.locals().data(c);
+            const local_t* y = points_b.locals().data(c);
+            dnum_t* z = deltas.data(c);
+            for( std::size_t i=first; i<last; ++i )
+           {
+               z[i] = static_cast<dnum_t>( shift+(static_cast<compute_t>(x[i])-static_cast<compute_t>(y[i])) );
+           }
+        }
+         first=last;
+     }
+  }
+
+}
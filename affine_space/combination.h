@@ -0,0 +1,222 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines affine combinations and centroids of ranges of points.
+ *
+ *    p+p and a*p are not defined, but an affine combination Σ w_i p_i with Σ w_i = 1 is a point. It is computed as:
+ *
+ *       combine(w,p) = p_0 + Σ w_i*(p_i-p_0)
+ *       centroid(p)  = p_0 + Σ (p_i-p_0)/n
+ *
+ *    so only the affine space operations are used. If the weights do not sum to 1 the result is the combination "relative to p_0".
+ *
+ *    The weights and the division by n are applied to the deltas, in the delta coordinates. For exact number types (integers, fixed point)
+ *    the weights must be scale factors of the deltas (integers or the delta type itself), and the division by n truncates towards zero,
+ *    so the centroid of integer points is rounded towards p_0.
+ *
+ *    The points can be any sized random access range of points, eg std::vector<point_t>, std::span<point_t> or point_array<point_t>.
+ *    An optional execution policy runs the reduction in parallel chunks (see parallel.h). The unsequenced policies also
+ *    use several independent accumulators within each chunk. The partial sums are combined with a tree reduction.
+ *
+ *    Code example:
+ *
+ *       std::vector<cartesian_point_t<3>> cloud = ...;
+ *
+ *       const cartesian_point_t<3> c = centroid( affine::execution::par_unseq, cloud );
+ *
+ *       const std::array<double,3> w{0.2,0.3,0.5};
+ *       const cartesian_point_t<3> p = combine( w, std::array{p0,p1,p2} );
+ */
+
+# include "affine_space.h"
+# include "parallel.h"
+
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <iterator>
+# include <ranges>
+# include <span>
+
+namespace affine
+{
+
+   template<typename range_t>
+   concept point_range =
+      std::ranges::random_access_range<range_t>
+   && std::ranges::sized_range<range_t>
+   && std::same_as<std::ranges::range_value_t<range_t>,
+                   typename std::ranges::range_value_t<range_t>::point_type>;
+
+   template<typename range_t>
+   concept delta_range =
+      std::ranges::random_access_range<range_t>
+   && std::ranges::sized_range<range_t>
+   && std::same_as<std::ranges::range_value_t<range_t>,
+                   typename std::ranges::range_value_t<range_t>::delta_type>;
+
+   // weights that deltas with num_t coordinates can be scaled by, see scale_factor
+   template<typename range_t, typename num_t>
+   concept weight_range =
+      std::ranges::random_access_range<range_t>
+   && std::ranges::sized_range<range_t>
+   && scale_factor<std::ranges::range_value_t<range_t>,num_t>;
+
+namespace detail
+{
+   // independent accumulators per chunk for unsequenced policies
+   constexpr std::size_t reduction_lanes = 4;
+
+   // zero delta with the dimension of p
+   template<typename point_t>
+   [[nodiscard]]
+   typename point_t::delta_type zero_delta( [[maybe_unused]] const point_t& p )
+  {
+      typename point_t::delta_type zero{};
+      if constexpr( point_t::dynamic ){ zero.resize( p.size() ); }
+      return zero;
+  }
+
+/*
+ * Σ f(i) for i in [b,e) as a delta_t
+ *    zero is the zero delta, which has the dimension of the result for dynamic extent spaces
+ *    unsequenced policies interleave the sum over reduction_lanes accumulators
+ */
+   template<typename policy_t, typename delta_t, typename term_t>
+   [[nodiscard]]
+   delta_t chunk_sum( const std::size_t b, const std::size_t e, const delta_t& zero, term_t&& term )
+  {
+      if constexpr( is_unsequenced_policy<policy_t> )
+     {
+         std::array<delta_t,reduction_lanes> acc;
+         acc.fill(zero);
+         std::size_t i=b;
+         for( ; i+reduction_lanes<=e; i+=reduction_lanes )
+        {
+            for( std::size_t l=0; l<reduction_lanes; ++l ){ acc[l]+=term(i+l); }
+        }
+         for( ; i<e; ++i ){ acc[0]+=term(i); }
+
+         return tree_reduce( std::span<delta_t>(acc), std::plus{} );
+     }
+      else
+     {
+         delta_t acc(zero);
+         for( std::size_t i=b; i<e; ++i ){ acc+=term(i); }
+         return acc;
+     }
+  }
+}
+
+// --------------- combine ---------------
+
+   // p_0 + Σ w_i*(p_i-p_0)
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto combine( policy_t&& policy,
+                 const weight_range<typename std::ranges::range_value_t<points_t>::delta_type::value_type> auto& weights,
+                 const points_t& points )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      using delta_t = typename point_t::delta_type;
+      using num_t = typename delta_t::value_type;
+
+      const std::size_t n = std::ranges::size(points);
+      assert( n>0 );
+      assert( std::ranges::size(weights)==n );
+
+      const auto p = std::ranges::begin(points);
+      const auto w = std::ranges::begin(weights);
+      const point_t p0 = p[0];
+      const delta_t zero = detail::zero_delta(p0);
+
+      const delta_t sum =
+         detail::parallel_reduce( policy, n, zero,
+                                  [&]( const std::size_t b, const std::size_t e )
+                                 {
+                                     return detail::chunk_sum<policy_t,delta_t>( b, e, zero,
+                                        [&]( const std::size_t i ){ return static_cast<num_t>(w[i])*(p[i]-p0); } );
+                                 },
+                                  std::plus{} );
+      return p0+sum;
+  }
+
+   template<typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto combine( const weight_range<typename std::ranges::range_value_t<points_t>::delta_type::value_type> auto& weights,
+                 const points_t& points )
+  {
+      return combine( execution::seq, weights, points );
+  }
+
+// --------------- centroid ---------------
+
+   // p_0 + Σ (p_i-p_0)/n
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto centroid( policy_t&& policy, const points_t& points )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      using delta_t = typename point_t::delta_type;
+      using num_t = typename delta_t::value_type;
+
+      const std::size_t n = std::ranges::size(points);
+      assert( n>0 );
+
+      const auto p = std::ranges::begin(points);
+      const point_t p0 = p[0];
+      const delta_t zero = detail::zero_delta(p0);
+
+      const delta_t sum =
+         detail::parallel_reduce( policy, n, zero,
+                                  [&]( const std::size_t b, const std::size_t e )
+                                 {
+                                     return detail::chunk_sum<policy_t,delta_t>( b, e, zero,
+                                        [&]( const std::size_t i ){ return p[i]-p0; } );
+                                 },
+                                  std::plus{} );
+      return p0+sum/static_cast<num_t>(n);
+  }
+
+   template<typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto centroid( const points_t& points )
+  {
+      return centroid( execution::seq, points );
+  }
+
+}
+
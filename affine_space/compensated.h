@@ -0,0 +1,458 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines points which accumulate long chains of small deltas without losing precision, and compensated sums and centroids.
+ *
+ *    p+=d rounds every coordinate to the point coordinates, so after n steps the error grows like n ulp of |p|,
+ *    and deltas smaller than half an ulp of p are lost entirely. compensated_point<point_t> carries a second number per coordinate,
+ *    the sum of the rounding errors (Neumaier summation), so value() = sum+error is within about 1 ulp of the exact sum for any n,
+ *    at about 4 times the cost of p+=d, and without a wider type.
+ *
+ *       compensated_point<point_t> x{p0};
+ *       x+=d, x-=d                   accumulate a delta, x+d and x-d
+ *       x.value()                    the point sum+error, rounded once
+ *       x-y, x-p, p-x                differences, computed from the sums and errors separately
+ *       x.renormalize()              fold the part of the error which the sum can represent into the sum
+ *
+ *    compensated_array<point_t> stores the sums in a point_array and the errors in a second set of columns,
+ *    and advance(x,a,d) is x[i]+=a*d[i] with vector kernels (flat_compensated_axpy in kernels.h),
+ *    which also compensate the rounding of the product with fma. The result is identical for every instruction set.
+ *
+ *    compensated_sum(deltas) and compensated_centroid(points) are the compensated versions of the reductions of combination.h,
+ *    over any sized random access range, with an optional execution policy (see parallel.h).
+ *    The partial sums of the chunks are combined with their errors. point_array and delta_array use the vector kernel flat_compensated_sum per column.
+ *    point_t must have a fixed ndim and floating point coordinates.
+ *
+ *    Code example:
+ *
+ *       affine::compensated_array<cartesian_point_t<3>> x( std::span<const cartesian_point_t<3>>(positions) );
+ *       for( std::size_t step=0; step<1000000; ++step ){ affine::advance( x, dt, velocities ); }
+ *
+ *       const cartesian_point_t<3> c = affine::compensated_centroid( affine::execution::par, positions );
+ */
+
+# include "affine_space.h"
+# include "combination.h"
+# include "kernels.h"
+# include "parallel.h"
+# include "point_array.h"
+
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <iterator>
+# include <ranges>
+# include <span>
+
+namespace affine
+{
+
+/*
+ * points which can be compensated
+ */
+   template<typename point_t>
+   concept compensable =
+      point_t::vector_valued && !point_t::dynamic
+   && std::floating_point<typename point_t::value_type>;
+
+// --------------- compensated point ---------------
+
+/*
+ * point_t accumulated as sum+error, with the rounding errors of the sum in error
+ */
+   template<compensable point_t>
+   struct compensated_point
+  {
+      constexpr static std::size_t ndim = point_t::size();
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      point_t sum{};
+      std::array<value_type,ndim> error{};
+
+      // sum+error, rounded once
+      [[nodiscard]]
+      point_t value() const
+     {
+         return detail::elementwise<point_t,ndim>( [&]( const std::size_t c ){ return sum[c]+error[c]; } );
+     }
+
+      compensated_point& operator+=( const delta_type& d )
+     {
+         for( std::size_t c=0; c<ndim; ++c ){ detail::neumaier_add( sum[c], error[c], static_cast<value_type>(d[c]) ); }
+         return *this;
+     }
+
+      compensated_point& operator-=( const delta_type& d )
+     {
+         for( std::size_t c=0; c<ndim; ++c ){ detail::neumaier_add( sum[c], error[c], -static_cast<value_type>(d[c]) ); }
+         return *this;
+     }
+
+      // sum+error is unchanged, and |error| is at most half an ulp of sum
+      void renormalize()
+     {
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const value_type t = sum[c]+error[c];
+            error[c] = error[c]-(t-sum[c]);
+            sum[c] = t;
+        }
+     }
+  };
+
+   template<compensable point_t>
+   [[nodiscard]]
+   compensated_point<point_t> operator+( compensated_point<point_t> x, const typename point_t::delta_type& d )
+  {
+      return x+=d;
+  }
+
+   template<compensable point_t>
+   [[nodiscard]]
+   compensated_point<point_t> operator-( compensated_point<point_t> x, const typename point_t::delta_type& d )
+  {
+      return x-=d;
+  }
+
+   // the sums and the errors are subtracted separately, so nearby points differ by much less than an ulp of either
+   template<compensable point_t>
+   [[nodiscard]]
+   typename point_t::delta_type operator-( const compensated_point<point_t>& x, const compensated_point<point_t>& y )
+  {
+      using delta_t = typename point_t::delta_type;
+      return detail::elementwise<delta_t,point_t::size()>( [&]( const std::size_t c ){ return (x.sum[c]-y.sum[c])+(x.error[c]-y.error[c]); } );
+  }
+
+   template<compensable point_t>
+   [[nodiscard]]
+   typename point_t::delta_type operator-( const compensated_point<point_t>& x, const point_t& p )
+  {
+      using delta_t = typename point_t::delta_type;
+      return detail::elementwise<delta_t,point_t::size()>( [&]( const std::size_t c ){ return (x.sum[c]-p[c])+x.error[c]; } );
+  }
+
+   template<compensable point_t>
+   [[nodiscard]]
+   typename point_t::delta_type operator-( const point_t& p, const compensated_point<point_t>& x )
+  {
+      return -(x-p);
+  }
+
+// --------------- compensated array ---------------
+
+/*
+ * SoA container of compensated points, the sums in a point_array and the errors in the same layout
+ */
+   template<compensable point_t>
+   class compensated_array
+  {
+      public:
+
+      constexpr static std::size_t ndim = point_t::size();
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+      using compensated_type = compensated_point<point_t>;
+
+      compensated_array() = default;
+
+      explicit compensated_array( const std::span<const point_t> points )
+        : sum_columns(points), error_columns(points.size()) {}
+
+      explicit compensated_array( const point_array<point_t>& points )
+        : sum_columns(points), error_columns(points.size()) {}
+
+      [[nodiscard]] std::size_t size()  const noexcept { return sum_columns.size(); }
+      [[nodiscard]] bool        empty() const noexcept { return sum_columns.empty(); }
+
+      // sums of each point, for the kernels of kernels.h
+      [[nodiscard]]       point_array<point_t>& sums()       noexcept { return sum_columns; }
+      [[nodiscard]] const point_array<point_t>& sums() const noexcept { return sum_columns; }
+
+      // contiguous, aligned errors for one coordinate of every point
+      [[nodiscard]] std::span<const value_type> error( const std::size_t c ) const { return error_columns.column(c); }
+
+      [[nodiscard]]       value_type* error_data( const std::size_t c )       noexcept { return error_columns.data(c); }
+      [[nodiscard]] const value_type* error_data( const std::size_t c ) const noexcept { return error_columns.data(c); }
+
+      [[nodiscard]]
+      compensated_type operator[]( const std::size_t i ) const
+     {
+         compensated_type x{ sum_columns[i].value() };
+         for( std::size_t c=0; c<ndim; ++c ){ x.error[c]=error_columns.data(c)[i]; }
+         return x;
+     }
+
+      // point i, rounded once
+      [[nodiscard]] point_t value( const std::size_t i ) const { return (*this)[i].value(); }
+
+      void assign( const std::size_t i, const compensated_type& x )
+     {
+         sum_columns[i] = x.sum;
+         for( std::size_t c=0; c<ndim; ++c ){ error_columns.data(c)[i]=x.error[c]; }
+     }
+
+      void push_back( const point_t& p )
+     {
+         sum_columns.push_back(p);
+         error_columns.resize( sum_columns.size() );
+     }
+
+      void reserve( const std::size_t n )
+     {
+         sum_columns.reserve(n);
+         error_columns.reserve(n);
+     }
+
+      void clear()
+     {
+         sum_columns.clear();
+         error_columns.clear();
+     }
+
+      // every point rounded once
+      void values( point_array<point_t>& points ) const
+     {
+         points.resize( size() );
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const value_type* s = sum_columns.data(c);
+            const value_type* e = error_columns.data(c);
+            value_type* x = points.data(c);
+            for( std::size_t i=0; i<size(); ++i ){ x[i]=s[i]+e[i]; }
+        }
+     }
+
+      // as compensated_point::renormalize, for every point
+      void renormalize()
+     {
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            value_type* s = sum_columns.data(c);
+            value_type* e = error_columns.data(c);
+            for( std::size_t i=0; i<size(); ++i )
+           {
+               const value_type t = s[i]+e[i];
+               e[i] = e[i]-(t-s[i]);
+               s[i] = t;
+           }
+        }
+     }
+
+      private:
+
+      point_array<point_t> sum_columns;
+      detail::column_storage<value_type,ndim> error_columns;
+  };
+
+// --------------- advance ---------------
+
+   // points[i] += a*deltas[i], with the rounding of the product and the sum compensated
+   template<compensable point_t, typename delta_t>
+      requires std::same_as<delta_t,typename point_t::delta_type>
+   void advance( const std::span<compensated_point<point_t>> points,
+                 const scale_factor<typename delta_t::value_type> auto a,
+                 const std::span<const delta_t> deltas )
+  {
+      using num_t = typename point_t::value_type;
+      assert( points.size()==deltas.size() );
+      for( std::size_t i=0; i<points.size(); ++i )
+     {
+         for( std::size_t c=0; c<point_t::size(); ++c )
+        {
+            detail::scalar::compensated_axpy( 1, static_cast<num_t>(a), &deltas[i][c], &points[i].sum[c], &points[i].error[c] );
+        }
+     }
+  }
+
+   template<compensable point_t, typename delta_t>
+      requires std::same_as<delta_t,typename point_t::delta_type>
+   void advance( compensated_array<point_t>& points,
+                 const scale_factor<typename delta_t::value_type> auto a,
+                 const delta_array<delta_t>& deltas )
+  {
+      using num_t = typename point_t::value_type;
+      assert( points.size()==deltas.size() );
+      for( std::size_t c=0; c<point_t::size(); ++c )
+     {
+         detail::flat_compensated_axpy( points.size(), static_cast<num_t>(a), deltas.data(c), points.sums().data(c), points.error_data(c) );
+     }
+  }
+
+// --------------- compensated reductions ---------------
+
+namespace detail
+{
+/*
+ * sums and errors of each coordinate, combined with their errors by the tree reduction of parallel_reduce
+ */
+   template<typename num_t, std::size_t ndim>
+   struct compensated_sums
+  {
+      std::array<num_t,ndim> sum{};
+      std::array<num_t,ndim> error{};
+
+      [[nodiscard]]
+      friend compensated_sums operator+( compensated_sums a, const compensated_sums& b )
+     {
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            neumaier_add( a.sum[c], a.error[c], b.sum[c] );
+            a.error[c] = a.error[c]+b.error[c];
+        }
+         return a;
+     }
+
+      // += x-origin, with the rounding of the difference compensated
+      void add( const std::size_t c, const num_t x, const num_t origin )
+     {
+         num_t d = x;
+         num_t e = 0;
+         neumaier_add( d, e, -origin );
+         neumaier_add( sum[c], error[c], d );
+         error[c] = error[c]+e;
+     }
+
+      [[nodiscard]] num_t total( const std::size_t c ) const { return sum[c]+error[c]; }
+  };
+
+/*
+ * Σ (x_i-origin) over a range of points or deltas
+ */
+   template<typename range_t, typename num_t, std::size_t ndim, typename policy_t>
+   [[nodiscard]]
+   compensated_sums<num_t,ndim> compensated_reduce( policy_t&& policy, const range_t& range, const std::array<num_t,ndim>& origin )
+  {
+      using sums_t = compensated_sums<num_t,ndim>;
+      const auto x = std::ranges::begin(range);
+
+      return parallel_reduce( policy, std::ranges::size(range), sums_t{},
+                              [&]( const std::size_t b, const std::size_t e )
+                             {
+                                 sums_t acc;
+                                 for( std::size_t i=b; i<e; ++i )
+                                {
+                                    for( std::size_t c=0; c<ndim; ++c ){ acc.add( c, static_cast<num_t>(x[i][c]), origin[c] ); }
+                                }
+                                 return acc;
+                             },
+                              std::plus{} );
+  }
+
+   // SoA containers, with a vector kernel per column
+   template<typename array_t, typename num_t, std::size_t ndim, typename policy_t>
+   [[nodiscard]]
+   compensated_sums<num_t,ndim> compensated_reduce_columns( policy_t&& policy, const array_t& range, const std::array<num_t,ndim>& origin )
+  {
+      using sums_t = compensated_sums<num_t,ndim>;
+
+      return parallel_reduce( policy, range.size(), sums_t{},
+                              [&]( const std::size_t b, const std::size_t e )
+                             {
+                                 sums_t acc;
+                                 for( std::size_t c=0; c<ndim; ++c )
+                                {
+                                    flat_compensated_sum( e-b, origin[c], range.data(c)+b, &acc.sum[c], &acc.error[c] );
+                                }
+                                 return acc;
+                             },
+                              std::plus{} );
+  }
+}
+
+// --------------- compensated_sum ---------------
+
+   // Σ d_i
+   template<execution_policy policy_t, typename deltas_t>
+      requires delta_range<deltas_t> && compensable<typename std::ranges::range_value_t<deltas_t>::point_type>
+   [[nodiscard]]
+   auto compensated_sum( policy_t&& policy, const deltas_t& deltas )
+  {
+      using delta_t = std::ranges::range_value_t<deltas_t>;
+      using num_t = typename delta_t::value_type;
+      constexpr std::size_t ndim = delta_t::size();
+
+      const std::array<num_t,ndim> origin{};
+      detail::compensated_sums<num_t,ndim> sums;
+      if constexpr( std::same_as<deltas_t,delta_array<delta_t>> ){ sums = detail::compensated_reduce_columns( policy, deltas, origin ); }
+      else                                                          { sums = detail::compensated_reduce( policy, deltas, origin ); }
+
+      return detail::elementwise<delta_t,ndim>( [&]( const std::size_t c ){ return sums.total(c); } );
+  }
+
+   template<typename deltas_t>
+      requires delta_range<deltas_t> && compensable<typename std::ranges::range_value_t<deltas_t>::point_type>
+   [[nodiscard]]
+   auto compensated_sum( const deltas_t& deltas )
+  {
+      return compensated_sum( execution::seq, deltas );
+  }
+
+// --------------- compensated_centroid ---------------
+
+   // p_0 + Σ (p_i-p_0)/n
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t> && compensable<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   auto compensated_centroid( policy_t&& policy, const points_t& points )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      using num_t = typename point_t::value_type;
+      constexpr std::size_t ndim = point_t::size();
+
+      const std::size_t n = std::ranges::size(points);
+      assert( n>0 );
+
+      const point_t p0 = std::ranges::begin(points)[0];
+      std::array<num_t,ndim> origin;
+      for( std::size_t c=0; c<ndim; ++c ){ origin[c]=p0[c]; }
+
+      detail::compensated_sums<num_t,ndim> sums;
+      if constexpr( std::same_as<points_t,point_array<point_t>> ){ sums = detail::compensated_reduce_columns( policy, points, origin ); }
+      else                                                          { sums = detail::compensated_reduce( policy, points, origin ); }
+
+      return detail::elementwise<point_t,ndim>( [&]( const std::size_t c ){ return origin[c]+sums.total(c)/static_cast<num_t>(n); } );
+  }
+
+   template<typename points_t>
+      requires point_range<points_t> && compensable<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   auto compensated_centroid( const points_t& points )
+  {
+      return compensated_centroid( execution::seq, points );
+  }
+
+}
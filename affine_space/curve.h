@@ -0,0 +1,544 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines Morton and Hilbert space filling curve keys of 2D and 3D points, and sorts point containers along them.
+ *
+ *    Points close in space are mostly close on the curves, so sorting a container by its keys makes neighbour loops,
+ *    index builds and stencils cache friendly. The keys interleave the bits of the cell of each point in a grid of
+ *    2^(64/ndim) cells per coordinate over a bounding box, 32 bits per coordinate in 2D and 21 in 3D, into one 64 bit key.
+ *       bounds(points)                       the bounding box of the points
+ *       curve_keys(c,points,box,keys)        the key of each point on the curve c, curve::morton or curve::hilbert
+ *       key_order(keys)                      the indices which sort the keys, a stable parallel radix sort
+ *       permute(order,range)                 range[i] = range[order[i]] for every i, for any sized random access range
+ *       curve_sort(c,points,columns...)      sort the points along the curve, and each of the columns (eg velocities, masses) with them
+ *    Each takes an optional execution policy (see parallel.h). The keys and the order do not depend on the policy.
+ *
+ *    The Hilbert keys walk a small table of the states of the curve (detail::hilbert_table) over the levels of the Morton keys.
+ *    The interleaving uses the BMI2 pdep instruction when the cpu has it and kernel_isa() is at least avx2 (see kernels.h),
+ *    so set_kernel_isa(isa::scalar) selects the portable shifts and masks, eg on cpus with a slow microcoded pdep.
+ *    The radix sort skips the digits which are the same for every key, so keys with a small range cost fewer passes.
+ *
+ *    Code example:
+ *
+ *       std::vector<cartesian_point_t<3>> x = ...;
+ *       std::vector<cartesian_delta_t<3>> v = ...;
+ *       std::vector<double> mass = ...;
+ *
+ *       const auto order = affine::curve_sort( affine::execution::par, affine::curve::hilbert, x, v, mass );
+ *       affine::permute( affine::execution::par, order, ids );        // any other array, in the same order
+ */
+
+# include "affine_space.h"
+# include "combination.h"
+# include "kernels.h"
+# include "parallel.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <cstdint>
+# include <ranges>
+# include <span>
+# include <utility>
+# include <vector>
+
+namespace affine
+{
+
+   template<typename point_t>
+   concept curve_point = point_t::vector_valued && !point_t::dynamic && ( point_t::size()==2 || point_t::size()==3 );
+
+   enum class curve { morton, hilbert };
+
+   template<typename point_t>
+   struct bounding_box
+  {
+      point_t lo;
+      point_t hi;
+  };
+
+namespace detail
+{
+   // bits per coordinate of a key
+   template<std::size_t ndim>
+   constexpr unsigned curve_bits = 64/ndim;
+
+   // bits of a key sorted by each radix sort pass
+   constexpr unsigned radix_bits = 11;
+   constexpr std::size_t radix_buckets = std::size_t(1)<<radix_bits;
+
+   // bit deposit masks of one coordinate, every ndim-th bit
+   template<std::size_t ndim>
+   constexpr std::uint64_t spread_mask = ndim==2 ? 0x5555555555555555 : 0x1249249249249249;
+
+/*
+ * cell of a point in the grid of 2^bits cells per coordinate over a box, points outside the box are clamped to it
+ */
+   template<typename point_t>
+   struct curve_grid
+  {
+      constexpr static std::size_t ndim = point_t::size();
+
+      point_t lo;
+      std::array<double,ndim> scale{};
+
+      curve_grid( const bounding_box<point_t>& box, const unsigned bits ) : lo(box.lo)
+     {
+         const auto extent = box.hi-box.lo;
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const auto x = static_cast<double>(extent[c]);
+            scale[c] = x>0 ? static_cast<double>(std::uint64_t(1)<<bits)/x : 0;
+        }
+         last = static_cast<double>( (std::uint64_t(1)<<bits)-1 );
+     }
+
+      [[nodiscard]]
+      std::array<std::uint32_t,ndim> operator()( const point_t& p ) const
+     {
+         const auto d = p-lo;
+         std::array<std::uint32_t,ndim> cell;
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const double x = static_cast<double>(d[c])*scale[c];
+            cell[c] = x>0 ? static_cast<std::uint32_t>( std::min(x,last) ) : 0;
+        }
+         return cell;
+     }
+
+      private:
+
+      double last;
+  };
+
+/*
+ * Hilbert curve as a state machine over the levels of a Morton key, from the top level down (C. Hamilton, Compact Hilbert indices, 2006)
+ *    the state is the entry corner e and direction d of the current sub-cube, state e*ndim+d, starting at 0
+ *    hilbert_table<ndim>[state<<ndim|l] for the ndim bits l of a level of the Morton key is the Hilbert digit w, and the next state above bit ndim
+ */
+   template<std::size_t ndim>
+   constexpr auto make_hilbert_table()
+  {
+      constexpr std::uint32_t n = static_cast<std::uint32_t>(ndim);
+      constexpr std::uint32_t corners = 1u<<n;
+      constexpr std::uint32_t mask = corners-1;
+
+      const auto rotate_right = []( const std::uint32_t b, const std::uint32_t r ){ return r%n==0 ? b : ((b>>(r%n))|(b<<(n-r%n)))&mask; };
+      const auto rotate_left  = []( const std::uint32_t b, const std::uint32_t r ){ return r%n==0 ? b : ((b<<(r%n))|(b>>(n-r%n)))&mask; };
+      const auto gray = []( const std::uint32_t i ){ return i^(i>>1); };
+      const auto gray_inverse = []( std::uint32_t g ){ for( std::uint32_t s=g>>1; s!=0; s>>=1 ){ g^=s; } return g; };
+      const auto trailing_ones = []( std::uint32_t i ){ std::uint32_t c=0; for( ; i&1; i>>=1 ){ ++c; } return c; };
+
+      // entry corner and direction of sub-cube w
+      const auto entry = [&]( const std::uint32_t w ){ return w==0 ? 0 : gray( 2*((w-1)/2) ); };
+      const auto direction = [&]( const std::uint32_t w ){ return w==0 ? 0 : ( w%2==0 ? trailing_ones(w-1) : trailing_ones(w) )%n; };
+
+      std::array<std::uint8_t,corners*ndim*corners> table{};
+      for( std::uint32_t e=0; e<corners; ++e )
+     {
+         for( std::uint32_t d=0; d<n; ++d )
+        {
+            for( std::uint32_t l=0; l<corners; ++l )
+           {
+               const std::uint32_t w = gray_inverse( rotate_right( l^e, d+1 ) );
+               const std::uint32_t next_e = e^rotate_left( entry(w), d+1 );
+               const std::uint32_t next_d = (d+direction(w)+1)%n;
+               table[((e*n+d)<<n)|l] = static_cast<std::uint8_t>( w|((next_e*n+next_d)<<n) );
+           }
+        }
+     }
+      return table;
+  }
+
+   template<std::size_t ndim>
+   constexpr auto hilbert_table = make_hilbert_table<ndim>();
+
+   // Hilbert index of the cell with the Morton key m, of levels of ndim bits
+   template<std::size_t ndim>
+   [[nodiscard]]
+   constexpr std::uint64_t hilbert_index( const std::uint64_t m, const unsigned levels=curve_bits<ndim> )
+  {
+      constexpr std::uint64_t mask = (1u<<ndim)-1;
+
+      std::uint64_t h = 0;
+      std::uint32_t state = 0;
+      for( unsigned level=levels; level-->0; )
+     {
+         const std::uint32_t next = hilbert_table<ndim>[ (state<<ndim)|((m>>(ndim*level))&mask) ];
+         h = (h<<ndim)|(next&mask);
+         state = next>>ndim;
+     }
+      return h;
+  }
+
+namespace scalar
+{
+   // the low 64/ndim bits of x moved to every ndim-th bit
+   template<std::size_t ndim>
+   [[nodiscard]]
+   constexpr std::uint64_t spread_bits( const std::uint32_t x )
+  {
+      std::uint64_t y = x;
+      if constexpr( ndim==2 )
+     {
+         y = (y|(y<<16))&0x0000ffff0000ffff;
+         y = (y|(y<<8)) &0x00ff00ff00ff00ff;
+         y = (y|(y<<4)) &0x0f0f0f0f0f0f0f0f;
+         y = (y|(y<<2)) &0x3333333333333333;
+         y = (y|(y<<1)) &0x5555555555555555;
+     }
+      else
+     {
+         y &= 0x1fffff;
+         y = (y|(y<<32))&0x001f00000000ffff;
+         y = (y|(y<<16))&0x001f0000ff0000ff;
+         y = (y|(y<<8)) &0x100f00f00f00f00f;
+         y = (y|(y<<4)) &0x10c30c30c30c30c3;
+         y = (y|(y<<2)) &0x1249249249249249;
+     }
+      return y;
+  }
+
+   // keys[i] = bits of cell(i) interleaved, coordinate 0 the most significant of each group of ndim bits
+   template<std::size_t ndim, typename cell_t>
+   void interleave( const std::size_t b, const std::size_t e, cell_t&& cell, std::uint64_t* keys )
+  {
+      for( std::size_t i=b; i<e; ++i )
+     {
+         const std::array<std::uint32_t,ndim> x = cell(i);
+         std::uint64_t key = 0;
+         for( std::size_t c=0; c<ndim; ++c ){ key |= spread_bits<ndim>(x[c])<<(ndim-1-c); }
+         keys[i] = key;
+     }
+  }
+}
+
+# if defined(AFFINE_X86_DISPATCH)
+namespace bmi2
+{
+   template<std::size_t ndim, typename cell_t>
+   AFFINE_TARGET_BMI2
+   void interleave( const std::size_t b, const std::size_t e, cell_t&& cell, std::uint64_t* keys )
+  {
+      for( std::size_t i=b; i<e; ++i )
+     {
+         const std::array<std::uint32_t,ndim> x = cell(i);
+         std::uint64_t key = 0;
+         for( std::size_t c=0; c<ndim; ++c ){ key |= _pdep_u64( x[c], spread_mask<ndim> )<<(ndim-1-c); }
+         keys[i] = key;
+     }
+  }
+}
+# endif
+
+   // whether this cpu has the BMI2 bit deposit instruction, detected once
+   [[nodiscard]]
+   inline bool has_bmi2()
+  {
+# if defined(AFFINE_X86_DISPATCH)
+      static const bool supported = ( __builtin_cpu_init(), __builtin_cpu_supports("bmi2") );
+      return supported;
+# else
+      return false;
+# endif
+  }
+
+   template<std::size_t ndim, typename cell_t>
+   void flat_interleave( const std::size_t b, const std::size_t e, cell_t&& cell, std::uint64_t* keys )
+  {
+# if defined(AFFINE_X86_DISPATCH)
+      if( kernel_isa()>=isa::avx2 && has_bmi2() ){ bmi2::interleave<ndim>( b, e, cell, keys ); return; }
+# endif
+      scalar::interleave<ndim>( b, e, cell, keys );
+  }
+
+   // point_array and delta_array, whose coordinates can be permuted one column at a time
+   template<typename range_t>
+   concept column_range = requires( range_t& r, const std::size_t c ){ { range_t::columns() } -> std::same_as<std::size_t>; r.data(c); };
+}
+
+// --------------- bounds ---------------
+
+   // smallest box containing every point
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   auto bounds( policy_t&& policy, const points_t& points )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      using box_t = bounding_box<point_t>;
+      constexpr std::size_t ndim = point_t::size();
+
+      assert( std::ranges::size(points)>0 );
+      const auto p = std::ranges::begin(points);
+      const point_t p0 = p[0];
+
+      const auto merge = []( const box_t& a, const box_t& b )
+     {
+         return box_t{ detail::elementwise<point_t,ndim>( [&]( const std::size_t c ){ return std::min(a.lo[c],b.lo[c]); } ),
+                       detail::elementwise<point_t,ndim>( [&]( const std::size_t c ){ return std::max(a.hi[c],b.hi[c]); } ) };
+     };
+
+      return detail::parallel_reduce( policy, std::ranges::size(points), box_t{p0,p0},
+                                      [&]( const std::size_t b, const std::size_t e )
+                                     {
+                                         box_t box{p0,p0};
+                                         for( std::size_t i=b; i<e; ++i ){ const point_t q = p[i]; box = merge( box, box_t{q,q} ); }
+                                         return box;
+                                     },
+                                      merge );
+  }
+
+   template<typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   auto bounds( const points_t& points )
+  {
+      return bounds( execution::seq, points );
+  }
+
+// --------------- curve_keys ---------------
+
+   // key of each point on the curve through the grid over box
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   void curve_keys( policy_t&& policy, const curve c, const points_t& points,
+                    const bounding_box<std::ranges::range_value_t<points_t>>& box, const std::span<std::uint64_t> keys )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      constexpr std::size_t ndim = point_t::size();
+      constexpr unsigned bits = detail::curve_bits<ndim>;
+
+      const std::size_t n = std::ranges::size(points);
+      assert( keys.size()==n );
+
+      const auto p = std::ranges::begin(points);
+      const detail::curve_grid<point_t> grid( box, bits );
+
+      detail::parallel_for( policy, n,
+                            [&]( const std::size_t b, const std::size_t e )
+                           {
+                               detail::flat_interleave<ndim>( b, e, [&]( const std::size_t i ){ return grid( p[i] ); }, keys.data() );
+                               if( c==curve::hilbert )
+                              {
+                                  for( std::size_t i=b; i<e; ++i ){ keys[i] = detail::hilbert_index<ndim>( keys[i] ); }
+                              }
+                           } );
+  }
+
+   template<typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   void curve_keys( const curve c, const points_t& points,
+                    const bounding_box<std::ranges::range_value_t<points_t>>& box, const std::span<std::uint64_t> keys )
+  {
+      curve_keys( execution::seq, c, points, box, keys );
+  }
+
+   // keys over the bounding box of the points
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   std::vector<std::uint64_t> curve_keys( policy_t&& policy, const curve c, const points_t& points )
+  {
+      std::vector<std::uint64_t> keys( std::ranges::size(points) );
+      if( !keys.empty() ){ curve_keys( policy, c, points, bounds(policy,points), std::span(keys) ); }
+      return keys;
+  }
+
+   template<typename points_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   [[nodiscard]]
+   std::vector<std::uint64_t> curve_keys( const curve c, const points_t& points )
+  {
+      return curve_keys( execution::seq, c, points );
+  }
+
+// --------------- key_order ---------------
+
+/*
+ * indices of the keys in increasing order, equal keys in their original order
+ *    least significant digit first radix sort of radix_bits per pass, each pass counts and scatters the chunks in parallel
+ */
+   template<execution_policy policy_t>
+   [[nodiscard]]
+   std::vector<std::size_t> key_order( policy_t&& policy, const std::span<const std::uint64_t> keys )
+  {
+      using counts_t = std::array<std::size_t,detail::radix_buckets>;
+
+      const std::size_t n = keys.size();
+
+      // bits which differ between keys, the other digits do not need a pass
+      const std::array<std::uint64_t,2> any_all =
+         detail::parallel_reduce( policy, n, std::array<std::uint64_t,2>{0,~std::uint64_t(0)},
+                                  [&]( const std::size_t b, const std::size_t e )
+                                 {
+                                     std::array<std::uint64_t,2> acc{0,~std::uint64_t(0)};
+                                     for( std::size_t i=b; i<e; ++i ){ acc[0]|=keys[i]; acc[1]&=keys[i]; }
+                                     return acc;
+                                 },
+                                  []( const std::array<std::uint64_t,2>& a, const std::array<std::uint64_t,2>& b )
+                                 {
+                                     return std::array<std::uint64_t,2>{ a[0]|b[0], a[1]&b[1] };
+                                 } );
+      const std::uint64_t varying = any_all[0]&~any_all[1];
+
+      // keys move with their index, so each pass writes one stream per digit
+      struct entry
+     {
+         std::uint64_t key;
+         std::size_t index;
+     };
+      std::vector<entry> sorted(n), scratch;
+      detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ sorted[i] = entry{keys[i],i}; } } );
+      if( varying!=0 ){ scratch.resize(n); }
+
+      const std::size_t k = detail::chunk_count<policy_t>(n);
+      std::vector<counts_t> offsets(k);
+
+      for( unsigned shift=0; shift<64; shift+=detail::radix_bits )
+     {
+         if( ((varying>>shift)&(detail::radix_buckets-1))==0 ){ continue; }
+
+         const auto digit = [shift]( const entry& x ){ return static_cast<std::size_t>( (x.key>>shift)&(detail::radix_buckets-1) ); };
+
+         detail::parallel_for( policy, k,
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t j=b; j<e; ++j )
+                                 {
+                                     counts_t& count = offsets[j];
+                                     count.fill(0);
+                                     const std::size_t end = detail::chunk_begin(n,k,j+1);
+                                     for( std::size_t i=detail::chunk_begin(n,k,j); i<end; ++i ){ ++count[digit(sorted[i])]; }
+                                 }
+                              },
+                               1 );
+
+         // each chunk scatters a digit after the same digit of the chunks before it, so the sort is stable
+         std::size_t total = 0;
+         for( std::size_t d=0; d<detail::radix_buckets; ++d )
+        {
+            for( std::size_t j=0; j<k; ++j )
+           {
+               const std::size_t count = offsets[j][d];
+               offsets[j][d] = total;
+               total += count;
+           }
+        }
+
+         detail::parallel_for( policy, k,
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t j=b; j<e; ++j )
+                                 {
+                                     counts_t& offset = offsets[j];
+                                     const std::size_t end = detail::chunk_begin(n,k,j+1);
+                                     for( std::size_t i=detail::chunk_begin(n,k,j); i<end; ++i ){ scratch[offset[digit(sorted[i])]++] = sorted[i]; }
+                                 }
+                              },
+                               1 );
+
+         std::swap( sorted, scratch );
+     }
+
+      std::vector<std::size_t> order(n);
+      detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ order[i] = sorted[i].index; } } );
+      return order;
+  }
+
+   [[nodiscard]]
+   inline std::vector<std::size_t> key_order( const std::span<const std::uint64_t> keys )
+  {
+      return key_order( execution::seq, keys );
+  }
+
+// --------------- permute ---------------
+
+   // range[i] = range[order[i]] for every i, order is a permutation of [0,size)
+   template<execution_policy policy_t, typename range_t>
+      requires std::ranges::random_access_range<range_t> && std::ranges::sized_range<range_t>
+   void permute( policy_t&& policy, const std::span<const std::size_t> order, range_t& range )
+  {
+      const std::size_t n = std::ranges::size(range);
+      assert( order.size()==n );
+
+      if constexpr( detail::column_range<range_t> )
+     {
+         using num_t = std::remove_cvref_t<decltype(*range.data(0))>;
+         std::vector<num_t> copy(n);
+         for( std::size_t c=0; c<range_t::columns(); ++c )
+        {
+            num_t* x = range.data(c);
+            detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ copy[i]=x[order[i]]; } } );
+            std::copy( copy.begin(), copy.end(), x );
+        }
+     }
+      else
+     {
+         const auto x = std::ranges::begin(range);
+         std::vector<std::ranges::range_value_t<range_t>> copy(n);
+         detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ copy[i]=x[order[i]]; } } );
+         detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ x[i]=std::move(copy[i]); } } );
+     }
+  }
+
+   template<typename range_t>
+      requires std::ranges::random_access_range<range_t> && std::ranges::sized_range<range_t>
+   void permute( const std::span<const std::size_t> order, range_t& range )
+  {
+      permute( execution::seq, order, range );
+  }
+
+// --------------- curve_sort ---------------
+
+   // sort the points along the curve, and the columns in the same order, returns the order: new point i was point order[i]
+   template<execution_policy policy_t, typename points_t, typename... columns_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   std::vector<std::size_t> curve_sort( policy_t&& policy, const curve c, points_t& points, columns_t&... columns )
+  {
+      const std::vector<std::uint64_t> keys = curve_keys( policy, c, points );
+      std::vector<std::size_t> order = key_order( policy, std::span<const std::uint64_t>(keys) );
+
+      permute( policy, std::span<const std::size_t>(order), points );
+      ( permute( policy, std::span<const std::size_t>(order), columns ), ... );
+      return order;
+  }
+
+   template<typename points_t, typename... columns_t>
+      requires point_range<points_t> && curve_point<std::ranges::range_value_t<points_t>>
+   std::vector<std::size_t> curve_sort( const curve c, points_t& points, columns_t&... columns )
+  {
+      return curve_sort( execution::seq, c, points, columns... );
+  }
+
+}
@@ -0,0 +1,557 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines an opt-in expression template layer for the point and delta types of an affine space.
+ *
+ *    The free operators in affine_space.h are eager: every binary operation returns a new point_t/delta_t, so a long expression creates one temporary and one loop per operation.
+ *    Wrapping an operand with lazy(...) instead builds an expression tree, which is evaluated in a single loop over the components when it is assigned.
+ *    Additions/subtractions of a scaled delta are evaluated with a fused multiply-add when the target has hardware fma.
+ *    Point and delta coordinates are combined with the same promotions as the eager operators, so p-q is evaluated in the (possibly wider) delta coordinates.
+ *
+ *    The same type rules are checked when the tree is built,
+ *    i.e. a point-point expression is a delta, a point+/-delta expression is a point, etc,
+ *         and expressions which add points or multiply them by scalars do not compile.
+ *
+ *    Operands can be single point_t/delta_t, or point_array/delta_array containers.
+ *    If any operand is a container, the expression is evaluated elementwise over the container, and single point_t/delta_t operands are broadcast to every element.
+ *
+ *    Only operations with at least one expression operand are lazy, so scalar multiplications must also start from lazy(...), e.g. a*lazy(d) rather than a*d.
+ *    Leaves created by lazy(...) refer to their operand, so expressions should be evaluated in the same statement they are created in.
+ *    Plain operands that are temporaries are stored by value.
+ *
+ *    Code example:
+ *
+ *       cartesian_point_t<3> x0,x1,q,r;
+ *       cartesian_delta_t<3> d;
+ *       const double a=..., b=...;
+ *
+ *       x1 = lazy(x0) + a*(lazy(q)-r) + b*lazy(d);     // one loop, no temporaries
+ *
+ *       point_array<cartesian_point_t<3>> xs(n),ys(n);
+ *       delta_array<cartesian_delta_t<3>> vs(n);
+ *
+ *       ys = lazy(xs) + a*lazy(vs) + b*lazy(d);        // one pass over each column
+ *       assign( xs, lazy(xs) + a*lazy(vs) );           // in-place update
+ *
+ *       // lazy(x0) + x1;    // will not compile!
+ */
+
+# include "affine_space.h"
+# include "point_array.h"
+
+# include <cmath>
+# include <concepts>
+# include <cstddef>
+# include <type_traits>
+# include <utility>
+
+namespace affine
+{
+
+namespace detail
+{
+   enum class expression_kind { point, delta };
+
+   template<typename T> struct is_point_array : std::false_type {};
+   template<typename T> struct is_point_array<point_array<T>> : std::true_type {};
+
+   template<typename T> struct is_delta_array : std::false_type {};
+   template<typename T> struct is_delta_array<delta_array<T>> : std::true_type {};
+
+   // plain (non-expression) operands which can be used as leaves
+   template<typename T>
+   concept point_leaf =
+      is_point_array<T>::value || ( requires { typename T::point_type; } && std::same_as<T,typename T::point_type> );
+
+   template<typename T>
+   concept delta_leaf =
+      is_delta_array<T>::value || ( requires { typename T::delta_type; } && std::same_as<T,typename T::delta_type> );
+
+   template<typename T>
+   concept bulk_leaf =
+      is_point_array<T>::value || is_delta_array<T>::value;
+
+   template<typename T>
+   struct is_expression : std::false_type {};
+
+   template<typename T>
+   concept expression_node =
+      is_expression<std::remove_cvref_t<T>>::value;
+
+   template<typename T>
+   concept expression_operand =
+      expression_node<T> || point_leaf<std::remove_cvref_t<T>> || delta_leaf<std::remove_cvref_t<T>>;
+
+   // at least one operand must already be an expression, otherwise the eager operators apply
+   template<typename lhs_t, typename rhs_t>
+   concept lazy_operands =
+      ( expression_node<lhs_t> || expression_node<rhs_t> )
+   && expression_operand<lhs_t> && expression_operand<rhs_t>;
+
+/*
+ * a*b+c in the common type of a, b and c, using fma only if it is as fast as a multiply and an add
+ *    c is a point coordinate when a scaled delta is added to a point, which may be wider or narrower than the delta coordinates
+ */
+   template<typename a_t, typename b_t, typename c_t>
+   [[nodiscard]]
+   constexpr std::common_type_t<a_t,b_t,c_t> multiply_add( const a_t a, const b_t b, const c_t c )
+  {
+      using num_t = std::common_type_t<a_t,b_t,c_t>;
+# if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+      if constexpr( std::floating_point<num_t> )
+     {
+         if( !std::is_constant_evaluated() ){ return std::fma( num_t(a), num_t(b), num_t(c) ); }
+     }
+# endif
+      return static_cast<num_t>( num_t(a)*num_t(b)+num_t(c) );
+  }
+
+/*
+ * result of evaluating an expression
+ */
+   template<expression_kind kind,
+            bool bulk,
+            typename point_t,
+            typename delta_t>
+   using expression_result =
+      std::conditional_t<kind==expression_kind::point,
+         std::conditional_t<bulk, point_array<point_t>, point_t>,
+         std::conditional_t<bulk, delta_array<delta_t>, delta_t>>;
+
+/*
+ * number type of the components of an expression
+ *    delta expressions are evaluated in the delta coordinates, which may be wider than the point coordinates (eg int32 points, int64 deltas)
+ */
+   template<expression_kind kind,
+            typename point_t,
+            typename delta_t>
+   using expression_value =
+      std::conditional_t<kind==expression_kind::point, typename point_t::value_type, typename delta_t::value_type>;
+}
+
+// --------------- expression nodes ---------------
+
+   template<typename expression_t>
+      requires detail::expression_node<expression_t>
+   [[nodiscard]]
+   constexpr typename expression_t::result_type eval( const expression_t& e );
+
+/*
+ * base CRTP type for an expression node
+ *    the node converts implicitly to the type of its result
+ */
+   template<typename derived_t>
+   struct expression
+  {
+      template<typename result_t>
+         requires std::same_as<result_t,typename derived_t::result_type>
+      constexpr operator result_t() const
+     {
+         return affine::eval( static_cast<const derived_t&>(*this) );
+     }
+  };
+
+/*
+ * leaf node referring to (or holding) a point_t, delta_t, point_array or delta_array
+ */
+   template<typename operand_t>
+   struct leaf_expression : expression<leaf_expression<operand_t>>
+  {
+      using operand_type = std::remove_cvref_t<operand_t>;
+      using point_type   = typename operand_type::point_type;
+      using delta_type   = typename operand_type::delta_type;
+      using value_type   = typename operand_type::value_type;
+
+      constexpr static detail::expression_kind kind =
+         detail::point_leaf<operand_type> ? detail::expression_kind::point
+                                          : detail::expression_kind::delta;
+
+      constexpr static bool bulk = detail::bulk_leaf<operand_type>;
+      constexpr static bool vector_valued = point_type::vector_valued;
+      constexpr static std::size_t ncols = detail::column_count<point_type>();
+
+      using result_type = detail::expression_result<kind,bulk,point_type,delta_type>;
+
+      operand_t operand;
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires bulk { return operand.size(); }
+
+      // component c of element j
+      [[nodiscard]]
+      constexpr value_type operator()( const std::size_t c, [[maybe_unused]] const std::size_t j ) const
+     {
+         if constexpr( bulk ){ return operand.data(c)[j]; }
+         else if constexpr( vector_valued ){ return operand[c]; }
+         else{ return operand.element; }
+     }
+  };
+
+/*
+ * node for the sum of two expressions
+ */
+   template<typename lhs_t,
+            typename rhs_t>
+   struct sum_expression : expression<sum_expression<lhs_t,rhs_t>>
+  {
+      using point_type = typename lhs_t::point_type;
+      using delta_type = typename lhs_t::delta_type;
+
+      constexpr static detail::expression_kind kind = lhs_t::kind;
+
+      using value_type = detail::expression_value<kind,point_type,delta_type>;
+
+      constexpr static bool bulk = lhs_t::bulk || rhs_t::bulk;
+      constexpr static std::size_t ncols = lhs_t::ncols;
+
+      using result_type = detail::expression_result<kind,bulk,point_type,delta_type>;
+
+      lhs_t lhs;
+      rhs_t rhs;
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires bulk
+     {
+         if constexpr( lhs_t::bulk ){ return lhs.size(); }
+         else{ return rhs.size(); }
+     }
+
+      [[nodiscard]]
+      constexpr value_type operator()( const std::size_t c, const std::size_t j ) const;
+  };
+
+/*
+ * node for the difference of two expressions
+ */
+   template<typename lhs_t,
+            typename rhs_t>
+   struct difference_expression : expression<difference_expression<lhs_t,rhs_t>>
+  {
+      using point_type = typename lhs_t::point_type;
+      using delta_type = typename lhs_t::delta_type;
+
+      // p-p is a delta, p-d is a point, d-d is a delta
+      constexpr static detail::expression_kind kind =
+         ( lhs_t::kind==detail::expression_kind::point && rhs_t::kind==detail::expression_kind::delta )
+         ? detail::expression_kind::point
+         : detail::expression_kind::delta;
+
+      using value_type = detail::expression_value<kind,point_type,delta_type>;
+
+      constexpr static bool bulk = lhs_t::bulk || rhs_t::bulk;
+      constexpr static std::size_t ncols = lhs_t::ncols;
+
+      using result_type = detail::expression_result<kind,bulk,point_type,delta_type>;
+
+      lhs_t lhs;
+      rhs_t rhs;
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires bulk
+     {
+         if constexpr( lhs_t::bulk ){ return lhs.size(); }
+         else{ return rhs.size(); }
+     }
+
+      [[nodiscard]]
+      constexpr value_type operator()( const std::size_t c, const std::size_t j ) const;
+  };
+
+/*
+ * node for a delta expression multiplied by a scalar
+ */
+   template<typename arg_t>
+   struct scaled_expression : expression<scaled_expression<arg_t>>
+  {
+      using point_type = typename arg_t::point_type;
+      using delta_type = typename arg_t::delta_type;
+      using value_type = typename arg_t::value_type;
+
+      constexpr static detail::expression_kind kind = detail::expression_kind::delta;
+
+      constexpr static bool bulk = arg_t::bulk;
+      constexpr static std::size_t ncols = arg_t::ncols;
+
+      using result_type = detail::expression_result<kind,bulk,point_type,delta_type>;
+
+      value_type coeff;
+      arg_t      arg;
+
+      [[nodiscard]]
+      constexpr std::size_t size() const requires bulk { return arg.size(); }
+
+      [[nodiscard]]
+      constexpr value_type operator()( const std::size_t c, const std::size_t j ) const
+     {
+         return coeff*arg(c,j);
+     }
+  };
+
+namespace detail
+{
+   template<typename operand_t>
+   struct is_expression<leaf_expression<operand_t>> : std::true_type {};
+
+   template<typename lhs_t, typename rhs_t>
+   struct is_expression<sum_expression<lhs_t,rhs_t>> : std::true_type {};
+
+   template<typename lhs_t, typename rhs_t>
+   struct is_expression<difference_expression<lhs_t,rhs_t>> : std::true_type {};
+
+   template<typename arg_t>
+   struct is_expression<scaled_expression<arg_t>> : std::true_type {};
+
+   template<typename T>
+   struct is_scaled_expression : std::false_type {};
+
+   template<typename arg_t>
+   struct is_scaled_expression<scaled_expression<arg_t>> : std::true_type {};
+
+   // plain operands become leaves, temporaries are moved into the leaf
+   template<typename T>
+   [[nodiscard]]
+   constexpr auto as_expression( T&& x )
+  {
+      if constexpr( expression_node<T> ){ return std::remove_cvref_t<T>(std::forward<T>(x)); }
+      else if constexpr( std::is_lvalue_reference_v<T> ){ return leaf_expression<const std::remove_cvref_t<T>&>{{},x}; }
+      else{ return leaf_expression<std::remove_cvref_t<T>>{{},std::move(x)}; }
+  }
+
+   template<typename T>
+   using expression_of = decltype(as_expression(std::declval<T>()));
+
+   template<typename lhs_t, typename rhs_t>
+   concept same_space =
+      std::same_as<typename lhs_t::point_type,typename rhs_t::point_type>
+   && std::same_as<typename lhs_t::delta_type,typename rhs_t::delta_type>;
+
+   // p+d and d+d are allowed
+   template<typename lhs_t, typename rhs_t>
+   concept summable =
+      same_space<lhs_t,rhs_t> && rhs_t::kind==expression_kind::delta;
+
+   // p-p, p-d and d-d are allowed
+   template<typename lhs_t, typename rhs_t>
+   concept subtractable =
+      same_space<lhs_t,rhs_t> && !( lhs_t::kind==expression_kind::delta && rhs_t::kind==expression_kind::point );
+}
+
+   template<typename lhs_t,
+            typename rhs_t>
+   constexpr typename sum_expression<lhs_t,rhs_t>::value_type
+      sum_expression<lhs_t,rhs_t>::operator()( const std::size_t c, const std::size_t j ) const
+  {
+      if constexpr( detail::is_scaled_expression<rhs_t>::value )
+     {
+         return static_cast<value_type>( detail::multiply_add( rhs.coeff, rhs.arg(c,j), lhs(c,j) ) );
+     }
+      else if constexpr( detail::is_scaled_expression<lhs_t>::value )
+     {
+         return static_cast<value_type>( detail::multiply_add( lhs.coeff, lhs.arg(c,j), rhs(c,j) ) );
+     }
+      else if constexpr( kind==detail::expression_kind::point )
+     {
+         return detail::offset_coordinate( lhs(c,j), rhs(c,j) );
+     }
+      else
+     {
+         return static_cast<value_type>( lhs(c,j)+rhs(c,j) );
+     }
+  }
+
+   template<typename lhs_t,
+            typename rhs_t>
+   constexpr typename difference_expression<lhs_t,rhs_t>::value_type
+      difference_expression<lhs_t,rhs_t>::operator()( const std::size_t c, const std::size_t j ) const
+  {
+      if constexpr( detail::is_scaled_expression<rhs_t>::value )
+     {
+         return static_cast<value_type>( detail::multiply_add( -rhs.coeff, rhs.arg(c,j), lhs(c,j) ) );
+     }
+      else if constexpr( detail::is_scaled_expression<lhs_t>::value )
+     {
+         return static_cast<value_type>( detail::multiply_add( lhs.coeff, lhs.arg(c,j), -rhs(c,j) ) );
+     }
+      else if constexpr( kind==detail::expression_kind::point )
+     {
+         return detail::negative_offset_coordinate( lhs(c,j), rhs(c,j) );
+     }
+      else if constexpr( lhs_t::kind==detail::expression_kind::point )
+     {
+         return detail::difference_coordinate<value_type>( lhs(c,j), rhs(c,j) );
+     }
+      else
+     {
+         return static_cast<value_type>( lhs(c,j)-rhs(c,j) );
+     }
+  }
+
+// --------------- building expressions ---------------
+
+   // start an expression from a point_t, delta_t, point_array or delta_array
+   template<typename operand_t>
+      requires detail::point_leaf<std::remove_cvref_t<operand_t>>
+            || detail::delta_leaf<std::remove_cvref_t<operand_t>>
+   [[nodiscard]]
+   constexpr auto lazy( operand_t&& x )
+  {
+      return detail::as_expression( std::forward<operand_t>(x) );
+  }
+
+   // e+e
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::lazy_operands<lhs_t,rhs_t>
+            && detail::summable<detail::expression_of<lhs_t>,detail::expression_of<rhs_t>>
+   [[nodiscard]]
+   constexpr auto operator+( lhs_t&& lhs, rhs_t&& rhs )
+  {
+      using lhs_e = detail::expression_of<lhs_t>;
+      using rhs_e = detail::expression_of<rhs_t>;
+      return sum_expression<lhs_e,rhs_e>{{},
+                                         detail::as_expression(std::forward<lhs_t>(lhs)),
+                                         detail::as_expression(std::forward<rhs_t>(rhs))};
+  }
+
+   // e-e
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::lazy_operands<lhs_t,rhs_t>
+            && detail::subtractable<detail::expression_of<lhs_t>,detail::expression_of<rhs_t>>
+   [[nodiscard]]
+   constexpr auto operator-( lhs_t&& lhs, rhs_t&& rhs )
+  {
+      using lhs_e = detail::expression_of<lhs_t>;
+      using rhs_e = detail::expression_of<rhs_t>;
+      return difference_expression<lhs_e,rhs_e>{{},
+                                                detail::as_expression(std::forward<lhs_t>(lhs)),
+                                                detail::as_expression(std::forward<rhs_t>(rhs))};
+  }
+
+   // a*e
+   template<typename arg_t>
+      requires detail::expression_node<arg_t>
+            && ( std::remove_cvref_t<arg_t>::kind==detail::expression_kind::delta )
+   [[nodiscard]]
+   constexpr auto operator*( const scale_factor<typename std::remove_cvref_t<arg_t>::value_type> auto a,
+                             arg_t&& arg )
+  {
+      using arg_e = std::remove_cvref_t<arg_t>;
+      using num_t = typename arg_e::value_type;
+      return scaled_expression<arg_e>{{},num_t(a),std::forward<arg_t>(arg)};
+  }
+
+   // e*a
+   template<typename arg_t>
+      requires detail::expression_node<arg_t>
+            && ( std::remove_cvref_t<arg_t>::kind==detail::expression_kind::delta )
+   [[nodiscard]]
+   constexpr auto operator*( arg_t&& arg,
+                             const scale_factor<typename std::remove_cvref_t<arg_t>::value_type> auto a )
+  {
+      return a*std::forward<arg_t>(arg);
+  }
+
+   // e/a, multiplies by 1/a so exact number types must evaluate before dividing
+   template<typename arg_t>
+      requires detail::expression_node<arg_t>
+            && ( std::remove_cvref_t<arg_t>::kind==detail::expression_kind::delta )
+            && ( !exact_numeric<typename std::remove_cvref_t<arg_t>::value_type> )
+   [[nodiscard]]
+   constexpr auto operator/( arg_t&& arg,
+                             const scale_factor<typename std::remove_cvref_t<arg_t>::value_type> auto a )
+  {
+      using num_t = typename std::remove_cvref_t<arg_t>::value_type;
+      return (num_t(1)/a)*std::forward<arg_t>(arg);
+  }
+
+   // -e
+   template<typename arg_t>
+      requires detail::expression_node<arg_t>
+            && ( std::remove_cvref_t<arg_t>::kind==detail::expression_kind::delta )
+   [[nodiscard]]
+   constexpr auto operator-( arg_t&& arg )
+  {
+      using num_t = typename std::remove_cvref_t<arg_t>::value_type;
+      return num_t(-1)*std::forward<arg_t>(arg);
+  }
+
+// --------------- evaluating expressions ---------------
+
+   // dest = e for a single point_t/delta_t
+   template<typename dest_t,
+            typename expression_t>
+      requires detail::expression_node<expression_t>
+            && ( !expression_t::bulk )
+            && std::same_as<dest_t,typename expression_t::result_type>
+   constexpr dest_t& assign( dest_t& dest, const expression_t& e )
+  {
+      if constexpr( dest_t::vector_valued )
+     {
+         for( std::size_t c=0; c<expression_t::ncols; ++c ){ dest[c]=e(c,0); }
+     }
+      else
+     {
+         dest.element=e(0,0);
+     }
+      return dest;
+  }
+
+   // dest = e for a point_array/delta_array, evaluated in one pass over each column
+   //    dest may also appear as an operand of e
+   template<typename dest_t,
+            typename expression_t>
+      requires detail::expression_node<expression_t>
+            && expression_t::bulk
+            && std::same_as<dest_t,typename expression_t::result_type>
+   dest_t& assign( dest_t& dest, const expression_t& e )
+  {
+      const std::size_t n = e.size();
+      dest.resize(n);
+      for( std::size_t c=0; c<expression_t::ncols; ++c )
+     {
+         auto* out = dest.data(c);
+         for( std::size_t j=0; j<n; ++j ){ out[j]=e(c,j); }
+     }
+      return dest;
+  }
+
+   template<typename expression_t>
+      requires detail::expression_node<expression_t>
+   constexpr typename expression_t::result_type eval( const expression_t& e )
+  {
+      typename expression_t::result_type result{};
+      assign( result, e );
+      return result;
+  }
+
+}
+
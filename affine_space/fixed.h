@@ -0,0 +1,166 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines a fixed point number type, for exact and deterministic coordinates.
+ *
+ *    fixed<int_t,fraction_bits> stores x*2^fraction_bits as a signed integer int_t
+ *       + and -   exact, and wrap on overflow, so results are bit identical on every platform and compiler
+ *       *         rounds to nearest, ties upwards, computed in an integer twice as wide
+ *       /         truncates towards zero, computed in an integer twice as wide
+ *       sqrt      truncates towards zero, computed bitwise in an integer twice as wide, so norm and normalize work on fixed deltas
+ *       conversions from integers are implicit (and exact unless they overflow), from floating point explicit and rounded to nearest
+ *       conversions to a wider int_t with the same fraction_bits are implicit, to narrower ones explicit
+ *
+ *    fixed is enabled as an exact numeric type, so point_base/delta_base can use it as num_t, and deltas can only be scaled by integers or fixed.
+ *    std::common_type of two fixed types with the same fraction_bits is the wider one, so points can be offset by wider deltas.
+ *
+ *    Code example:
+ *
+ *       using coordinate = affine::fixed<std::int32_t,16>;   // range ±32768, resolution 2^-16
+ *       using offset     = affine::fixed<std::int64_t,16>;   // differences of any two coordinates
+ *
+ *       struct lattice_point : affine::point_base<2,lattice_point,lattice_delta,coordinate> {};
+ *       struct lattice_delta : affine::delta_base<2,lattice_point,lattice_delta,offset> {};
+ *
+ *       const lattice_delta d = p-q;        // cannot overflow
+ *       const lattice_point r = q+d/2;      // midpoint, identical on every platform
+ */
+
+# include "affine_space.h"
+
+# include <compare>
+# include <concepts>
+# include <cstdint>
+# include <type_traits>
+
+namespace affine
+{
+
+namespace detail
+{
+   // signed integer with twice as many bits
+   template<typename int_t> struct wider_integer;
+   template<> struct wider_integer<std::int8_t>  { using type = std::int16_t; };
+   template<> struct wider_integer<std::int16_t> { using type = std::int32_t; };
+   template<> struct wider_integer<std::int32_t> { using type = std::int64_t; };
+   template<> struct wider_integer<std::int64_t> { __extension__ using type = __int128; };
+
+   template<typename int_t>
+   using wider_integer_t = typename wider_integer<int_t>::type;
+}
+
+   template<std::signed_integral int_t, int fraction_bits>
+   class fixed
+  {
+      static_assert( 0<fraction_bits && fraction_bits<int(8*sizeof(int_t))-1, "fixed needs at least one integer and one fraction bit" );
+
+      using wide_t = detail::wider_integer_t<int_t>;
+
+      constexpr static wide_t one = wide_t(1)<<fraction_bits;
+
+      int_t bits;
+
+      template<std::signed_integral, int> friend class fixed;
+
+      // wrap to int_t, conversion to a narrower signed integer is modular since C++20
+      [[nodiscard]] constexpr static fixed wrap( const wide_t b ){ return from_bits( static_cast<int_t>(b) ); }
+
+   public:
+
+      using representation = int_t;
+      constexpr static int fraction_digits = fraction_bits;
+
+      constexpr fixed() = default;
+
+      constexpr fixed( const std::integral auto i ) : bits( static_cast<int_t>( static_cast<wide_t>(i)*one ) ) {}
+
+      constexpr explicit fixed( const std::floating_point auto x )
+         : bits( static_cast<int_t>( x<0 ? x*one-0.5 : x*one+0.5 ) ) {}
+
+      template<std::signed_integral other_t>
+      constexpr explicit( sizeof(other_t)>sizeof(int_t) ) fixed( const fixed<other_t,fraction_bits> f )
+         : bits( static_cast<int_t>(f.bits) ) {}
+
+      [[nodiscard]] constexpr static fixed from_bits( const int_t b ){ fixed f; f.bits=b; return f; }
+
+      [[nodiscard]] constexpr int_t to_bits() const noexcept { return bits; }
+
+      template<std::floating_point T>
+      [[nodiscard]] constexpr explicit operator T() const { return static_cast<T>(bits)/static_cast<T>(one); }
+
+      // truncates towards zero
+      template<std::integral T>
+      [[nodiscard]] constexpr explicit operator T() const { return static_cast<T>( bits/one ); }
+
+   // arithmetic
+      [[nodiscard]] constexpr fixed operator-() const { return wrap( -static_cast<wide_t>(bits) ); }
+
+      [[nodiscard]] friend constexpr fixed operator+( const fixed a, const fixed b ){ return wrap( static_cast<wide_t>(a.bits)+b.bits ); }
+      [[nodiscard]] friend constexpr fixed operator-( const fixed a, const fixed b ){ return wrap( static_cast<wide_t>(a.bits)-b.bits ); }
+
+      [[nodiscard]] friend constexpr fixed operator*( const fixed a, const fixed b )
+     {
+         return wrap( ( static_cast<wide_t>(a.bits)*b.bits + (one>>1) )>>fraction_bits );
+     }
+
+      [[nodiscard]] friend constexpr fixed operator/( const fixed a, const fixed b )
+     {
+         return wrap( static_cast<wide_t>(a.bits)*one/b.bits );
+     }
+
+      // truncates towards zero, 0 for negative arguments
+      [[nodiscard]] friend constexpr fixed sqrt( const fixed a )
+     {
+         return wrap( detail::integer_sqrt( static_cast<wide_t>(a.bits)<<fraction_bits ) );
+     }
+
+      constexpr fixed& operator+=( const fixed b ){ return *this=*this+b; }
+      constexpr fixed& operator-=( const fixed b ){ return *this=*this-b; }
+      constexpr fixed& operator*=( const fixed b ){ return *this=*this*b; }
+      constexpr fixed& operator/=( const fixed b ){ return *this=*this/b; }
+
+      [[nodiscard]] friend constexpr bool operator==( const fixed, const fixed ) = default;
+      [[nodiscard]] friend constexpr auto operator<=>( const fixed, const fixed ) = default;
+  };
+
+   template<std::signed_integral int_t, int fraction_bits>
+   struct numeric_traits<fixed<int_t,fraction_bits>>
+  {
+      constexpr static bool enabled = true;
+      constexpr static bool exact = true;
+  };
+}
+
+   template<std::signed_integral int_a, std::signed_integral int_b, int fraction_bits>
+   struct std::common_type<affine::fixed<int_a,fraction_bits>,affine::fixed<int_b,fraction_bits>>
+  {
+      using type = affine::fixed<std::conditional_t<(sizeof(int_a)>=sizeof(int_b)),int_a,int_b>,fraction_bits>;
+  };
@@ -0,0 +1,263 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines 16 bit floating point storage types, to halve the memory traffic of large sets of float coordinates.
+ *
+ *    compressed_float<format_t> stores a float in 16 bits, and converts to float for all arithmetic
+ *       float16    IEEE 754 binary16, 11 significant bits and range ±65504
+ *       bfloat16   the top half of a float, 8 significant bits and the same range as float
+ *       conversions from float, double and integers are implicit and round to nearest even, once (doubles are not rounded twice through float)
+ *       conversion to float is implicit and exact, so any arithmetic expression is evaluated in float and only rounded when stored
+ *
+ *    Both are enabled as (inexact) numeric types, so point_base/delta_base can use them as num_t.
+ *    The operators of point_base/delta_base then round each coordinate once per operation.
+ *    The batched kernels in kernels.h load 8 or 16 coordinates at a time, convert them to float (F16C for float16, shifts for bfloat16),
+ *    and round once per kernel, e.g. axpy computes y+a*x in float with a kept in float.
+ *
+ *    Code example:
+ *
+ *       struct cloud_point : affine::point_base<3,cloud_point,cloud_delta,affine::float16> {};   // 6 bytes, rather than 24 for double
+ *       struct cloud_delta : affine::delta_base<3,cloud_point,cloud_delta,affine::float16> {};
+ *
+ *       const float x = p[0];            // exact
+ *       advance( std::span(ps), dt, std::span(vs) );   // ps[i]+=dt*vs[i] in float, rounded once
+ */
+
+# include "affine_space.h"
+
+# include <bit>
+# include <concepts>
+# include <cstdint>
+# include <limits>
+# include <type_traits>
+
+namespace affine
+{
+
+namespace detail
+{
+/*
+ * double to float, rounding to odd
+ *    a double rounded to odd then to a format with at most 22 significant bits is rounded correctly, which double to float to half is not
+ */
+   [[nodiscard]]
+   constexpr float round_to_odd( const double x )
+  {
+      const float f = static_cast<float>(x);
+      if( x!=x || static_cast<double>(f)==x ){ return f; }
+
+      std::uint32_t u = std::bit_cast<std::uint32_t>(f);
+      const bool rounded_away = ( x<0 ? static_cast<double>(f)<x : static_cast<double>(f)>x );
+      if( rounded_away ){ u-=1; }
+      return std::bit_cast<float>( u|1u );
+  }
+
+/*
+ * IEEE 754 binary16
+ *    after F. Giesen, https://gist.github.com/rygorous/2156668
+ */
+   struct binary16_format
+  {
+      constexpr static int digits = 11;
+
+      constexpr static std::uint16_t max_bits        = 0x7bff;
+      constexpr static std::uint16_t min_bits        = 0x0400;
+      constexpr static std::uint16_t epsilon_bits    = 0x1400;
+      constexpr static std::uint16_t infinity_bits   = 0x7c00;
+      constexpr static std::uint16_t nan_bits        = 0x7e00;
+      constexpr static std::uint16_t denorm_min_bits = 0x0001;
+
+      [[nodiscard]]
+      constexpr static std::uint16_t encode( const float x )
+     {
+         std::uint32_t u = std::bit_cast<std::uint32_t>(x);
+         const std::uint32_t sign = u&0x80000000u;
+         u ^= sign;
+
+         std::uint32_t h;
+         if( u>=0x47800000u )            // 2^16, beyond the largest finite value after rounding: inf or nan
+        {
+            h = u>0x7f800000u ? 0x7e00u : 0x7c00u;
+        }
+         else if( u<0x38800000u )        // 2^-14, subnormal or zero: the float addition rounds the 10 mantissa bits into place
+        {
+            constexpr std::uint32_t magic = 126u<<23;
+            h = std::bit_cast<std::uint32_t>( std::bit_cast<float>(u)+std::bit_cast<float>(magic) )-magic;
+        }
+         else                            // rebias the exponent and round the mantissa to nearest even
+        {
+            h = ( u + 0xc8000fffu + ((u>>13)&1u) )>>13;
+        }
+         return static_cast<std::uint16_t>( h|(sign>>16) );
+     }
+
+      [[nodiscard]]
+      constexpr static float decode( const std::uint16_t h )
+     {
+         std::uint32_t u = (std::uint32_t(h)&0x7fffu)<<13;
+         const std::uint32_t exponent = u&0x0f800000u;
+         u += (127u-15u)<<23;
+         if( exponent==0x0f800000u )     // inf or nan
+        {
+            u += (128u-16u)<<23;
+        }
+         else if( exponent==0 )          // subnormal or zero, renormalised by the float subtraction
+        {
+            u += 1u<<23;
+            u = std::bit_cast<std::uint32_t>( std::bit_cast<float>(u)-std::bit_cast<float>(113u<<23) );
+        }
+         return std::bit_cast<float>( u|((std::uint32_t(h)&0x8000u)<<16) );
+     }
+  };
+
+/*
+ * bfloat16, the 16 most significant bits of a float
+ */
+   struct bfloat16_format
+  {
+      constexpr static int digits = 8;
+
+      constexpr static std::uint16_t max_bits        = 0x7f7f;
+      constexpr static std::uint16_t min_bits        = 0x0080;
+      constexpr static std::uint16_t epsilon_bits    = 0x3c00;
+      constexpr static std::uint16_t infinity_bits   = 0x7f80;
+      constexpr static std::uint16_t nan_bits        = 0x7fc0;
+      constexpr static std::uint16_t denorm_min_bits = 0x0001;
+
+      [[nodiscard]]
+      constexpr static std::uint16_t encode( const float x )
+     {
+         const std::uint32_t u = std::bit_cast<std::uint32_t>(x);
+         if( x!=x ){ return static_cast<std::uint16_t>( (u>>16)|0x40u ); }   // keep nans quiet
+         return static_cast<std::uint16_t>( ( u + 0x7fffu + ((u>>16)&1u) )>>16 );
+     }
+
+      [[nodiscard]]
+      constexpr static float decode( const std::uint16_t h )
+     {
+         return std::bit_cast<float>( std::uint32_t(h)<<16 );
+     }
+  };
+}
+
+/*
+ * a float stored in 16 bits, see format_t for the layout
+ */
+   template<typename format_t>
+   class compressed_float
+  {
+      std::uint16_t bits;
+
+   public:
+
+      using format = format_t;
+      using compute_type = float;
+
+      constexpr compressed_float() = default;
+
+      constexpr compressed_float( const float x ) : bits( format_t::encode(x) ) {}
+      constexpr compressed_float( const double x ) : bits( format_t::encode( detail::round_to_odd(x) ) ) {}
+      constexpr compressed_float( const std::integral auto i ) : compressed_float( static_cast<double>(i) ) {}
+
+      [[nodiscard]] constexpr static compressed_float from_bits( const std::uint16_t b ){ compressed_float f; f.bits=b; return f; }
+
+      [[nodiscard]] constexpr std::uint16_t to_bits() const noexcept { return bits; }
+
+      [[nodiscard]] constexpr operator float() const { return format_t::decode(bits); }
+
+   // arithmetic is on float, and rounded once when stored
+      constexpr compressed_float& operator+=( const float b ){ return *this=float(*this)+b; }
+      constexpr compressed_float& operator-=( const float b ){ return *this=float(*this)-b; }
+      constexpr compressed_float& operator*=( const float b ){ return *this=float(*this)*b; }
+      constexpr compressed_float& operator/=( const float b ){ return *this=float(*this)/b; }
+  };
+
+   using float16  = compressed_float<detail::binary16_format>;
+   using bfloat16 = compressed_float<detail::bfloat16_format>;
+
+   template<typename format_t>
+   struct numeric_traits<compressed_float<format_t>>
+  {
+      constexpr static bool enabled = true;
+      constexpr static bool exact = false;
+  };
+
+namespace detail
+{
+   template<typename T>
+   struct is_compressed_float : std::false_type {};
+
+   template<typename format_t>
+   struct is_compressed_float<compressed_float<format_t>> : std::true_type {};
+}
+
+/*
+ * T is stored in 16 bits and computed in float
+ */
+   template<typename T>
+   concept compressed_floating_point = detail::is_compressed_float<T>::value;
+}
+
+   template<typename format_t>
+   class std::numeric_limits<affine::compressed_float<format_t>>
+  {
+      using T = affine::compressed_float<format_t>;
+
+   public:
+      constexpr static bool is_specialized = true;
+      constexpr static bool is_signed = true;
+      constexpr static bool is_integer = false;
+      constexpr static bool is_exact = false;
+      constexpr static bool has_infinity = true;
+      constexpr static bool has_quiet_NaN = true;
+      constexpr static int radix = 2;
+      constexpr static int digits = format_t::digits;
+
+      [[nodiscard]] constexpr static T min() noexcept        { return T::from_bits( format_t::min_bits ); }
+      [[nodiscard]] constexpr static T max() noexcept        { return T::from_bits( format_t::max_bits ); }
+      [[nodiscard]] constexpr static T lowest() noexcept     { return T::from_bits( format_t::max_bits|0x8000u ); }
+      [[nodiscard]] constexpr static T epsilon() noexcept    { return T::from_bits( format_t::epsilon_bits ); }
+      [[nodiscard]] constexpr static T infinity() noexcept   { return T::from_bits( format_t::infinity_bits ); }
+      [[nodiscard]] constexpr static T quiet_NaN() noexcept  { return T::from_bits( format_t::nan_bits ); }
+      [[nodiscard]] constexpr static T denorm_min() noexcept { return T::from_bits( format_t::denorm_min_bits ); }
+  };
+
+/*
+ * arithmetic with a compressed float is evaluated in float, or in a wider floating point type,
+ * so eg float points can be offset by float16 deltas
+ */
+   template<typename format_t, typename T>
+      requires std::is_arithmetic_v<T>
+   struct std::common_type<affine::compressed_float<format_t>,T> { using type = std::common_type_t<float,T>; };
+
+   template<typename T, typename format_t>
+      requires std::is_arithmetic_v<T>
+   struct std::common_type<T,affine::compressed_float<format_t>> { using type = std::common_type_t<T,float>; };
@@ -0,0 +1,418 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines a uniform grid of hashed cells for fixed radius neighbour queries and cell lists.
+ *
+ *    hash_grid<point_t> divides space into cubic cells of a given size, relative to the first point, and hashes each cell
+ *    to one of a power of two number of buckets, at least the number of points. Only the buckets are stored, in compressed
+ *    sparse row form: the points of bucket b are the slots [bucket_begin(b),bucket_end(b)) of a point_array (SoA) copy of the points,
+ *    with the input index of each slot. Cells which hash to the same bucket share it, the queries filter by distance.
+ *    Building is a parallel counting sort of the points by bucket, a few flat arrays and no allocation per cell,
+ *    and the slots do not depend on the policy.
+ *
+ *    The queries are fastest with a radius of at most the cell size, so the ball around q only touches (at most 3 per coordinate) cells
+ *    around the cell of q. Larger radii visit every bucket of the larger box of cells, or every point once the box has as many cells as there are buckets,
+ *    and negative or NaN radii find nothing. Queries pass neighbours: the index of the point, its offset point-q as a delta_t, and its squared length.
+ *       for_each_neighbour(q,r,f)       f(neighbour) for every point with |p-q|<=r, in no particular order
+ *       within_radius(q,r)              the same neighbours in a vector, and a batch version over a range of queries
+ *       for_each_pair(r,f)              f(i,j,p_j-p_i) once for every pair of points within r, in parallel with a policy
+ *    The grid uses the euclidean metric, whatever the default metric of delta_t.
+ *
+ *    update(points) moves the grid to new positions of the same points. Only the buckets are recomputed if no point changed bucket,
+ *    otherwise the counting sort runs again, reading the points in the current slot order, which is nearly sorted
+ *    if the points move less than a cell per step. It returns whether the slots changed.
+ *
+ *    Code example:
+ *
+ *       affine::hash_grid<cartesian_point_t<3>> grid( affine::execution::par, positions, cutoff );
+ *
+ *       grid.for_each_pair( affine::execution::par, cutoff,
+ *                           [&]( std::size_t i, std::size_t j, const cartesian_delta_t<3>& r ){ ... force between i and j ... } );
+ *
+ *       for( step ... ){ ... move positions ...; grid.update( affine::execution::par, positions ); }
+ */
+
+# include "affine_space.h"
+# include "combination.h"
+# include "metric.h"
+# include "parallel.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <array>
+# include <bit>
+# include <cassert>
+# include <cmath>
+# include <concepts>
+# include <cstddef>
+# include <cstdint>
+# include <ranges>
+# include <utility>
+# include <vector>
+
+namespace affine
+{
+
+/*
+ * uniform grid of hashed cells over a copy of a set of points
+ */
+   template<typename point_t>
+   class hash_grid
+  {
+      static_assert( point_t::vector_valued && !point_t::dynamic, "hash_grid requires a fixed, non-zero ndim" );
+      static_assert( std::floating_point<typename point_t::value_type>, "hash_grid requires floating point coordinates" );
+
+      public:
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      constexpr static std::size_t ndim = point_t::size();
+
+      // most cells touched by a ball of radius at most the cell size, 3 per coordinate, and one more for the rounding of q±radius
+      constexpr static std::size_t neighbour_cells = []{ std::size_t c=1; for( std::size_t i=0; i<ndim; ++i ){ c*=4; } return c; }();
+
+      // integer coordinates of a cell
+      using cell_type = std::array<std::int64_t,ndim>;
+
+      struct neighbour
+     {
+         std::size_t index;
+         delta_type  offset;
+         value_type  distance2;
+     };
+
+      hash_grid() = default;
+
+      template<execution_policy policy_t, typename points_t>
+         requires point_range<points_t>
+      hash_grid( policy_t&& policy, const points_t& points, const value_type cell_size );
+
+      template<typename points_t>
+         requires point_range<points_t>
+      hash_grid( const points_t& points, const value_type cell_size ) : hash_grid( execution::seq, points, cell_size ) {}
+
+      [[nodiscard]] std::size_t size()  const noexcept { return order.size(); }
+      [[nodiscard]] bool        empty() const noexcept { return order.empty(); }
+
+      [[nodiscard]] value_type cell_size() const noexcept { return cell; }
+
+      // the points in slot order, slot s is input point index(s)
+      [[nodiscard]] const point_array<point_type>& points() const noexcept { return nodes; }
+      [[nodiscard]] std::size_t index( const std::size_t s ) const { return order[s]; }
+
+      // buckets, and the slots of each
+      [[nodiscard]] std::size_t buckets() const noexcept { return starts.size()-1; }
+      [[nodiscard]] std::size_t bucket_begin( const std::size_t b ) const { return starts[b]; }
+      [[nodiscard]] std::size_t bucket_end(   const std::size_t b ) const { return starts[b+1]; }
+
+      [[nodiscard]] cell_type cell_of( const point_type& p ) const
+     {
+         const delta_type d = p-origin;
+         cell_type x;
+         for( std::size_t c=0; c<ndim; ++c ){ x[c] = static_cast<std::int64_t>( std::floor( d[c]/cell ) ); }
+         return x;
+     }
+
+      [[nodiscard]] std::size_t bucket_of( const cell_type& x ) const
+     {
+         // multiplicative hash, the top bits of the product are the best mixed
+         constexpr std::array<std::uint64_t,3> primes{ 0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9 };
+         std::uint64_t h = 0;
+         for( std::size_t c=0; c<ndim; ++c ){ h = (h^static_cast<std::uint64_t>(x[c]))*primes[c%primes.size()]; }
+         return bits==0 ? 0 : static_cast<std::size_t>( h>>(64-bits) );
+     }
+
+      [[nodiscard]] std::size_t bucket_of( const point_type& p ) const { return bucket_of( cell_of(p) ); }
+
+   // single queries
+      template<typename f_t>
+      void for_each_neighbour( const point_type& q, const value_type radius, f_t&& f ) const
+     {
+         const value_type radius2 = radius*radius;
+         visit( q, radius,
+                [&]( const std::size_t s )
+               {
+                   const delta_type offset = nodes[s]-q;
+                   const value_type distance2 = norm2( euclidean_metric{}, offset );
+                   if( distance2<=radius2 ){ f( neighbour{ order[s], offset, distance2 } ); }
+               } );
+     }
+
+      [[nodiscard]] std::vector<neighbour> within_radius( const point_type& q, const value_type radius ) const
+     {
+         std::vector<neighbour> found;
+         for_each_neighbour( q, radius, [&]( const neighbour& x ){ found.push_back(x); } );
+         return found;
+     }
+
+   // batch queries
+      template<execution_policy policy_t, typename queries_t>
+         requires point_range<queries_t>
+      [[nodiscard]] std::vector<std::vector<neighbour>> within_radius( policy_t&& policy, const queries_t& queries, const value_type radius ) const
+     {
+         const std::size_t n = std::ranges::size(queries);
+         const auto q = std::ranges::begin(queries);
+
+         std::vector<std::vector<neighbour>> results(n);
+         detail::parallel_for( policy, n,
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t j=b; j<e; ++j ){ results[j]=within_radius( static_cast<point_type>(q[j]), radius ); }
+                              },
+                               detail::query_grain );
+         return results;
+     }
+
+   // cell lists
+      // f(i,j,p_j-p_i) once for each pair of points i!=j with |p_j-p_i|<=radius, concurrently for the parallel policies
+      template<execution_policy policy_t, typename f_t>
+      void for_each_pair( policy_t&& policy, const value_type radius, f_t&& f ) const
+     {
+         const value_type radius2 = radius*radius;
+         detail::parallel_for( policy, size(),
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t s=b; s<e; ++s )
+                                 {
+                                     const point_type p = nodes[s];
+                                     visit( p, radius,
+                                            [&]( const std::size_t t )
+                                           {
+                                               if( t<=s ){ return; }
+                                               const delta_type offset = nodes[t]-p;
+                                               if( norm2( euclidean_metric{}, offset )<=radius2 ){ f( order[s], order[t], offset ); }
+                                           } );
+                                 }
+                              },
+                               detail::query_grain );
+     }
+
+      template<typename f_t>
+      void for_each_pair( const value_type radius, f_t&& f ) const
+     {
+         for_each_pair( execution::seq, radius, f );
+     }
+
+   // moving points
+      template<execution_policy policy_t, typename points_t>
+         requires point_range<points_t>
+      bool update( policy_t&& policy, const points_t& points );
+
+      template<typename points_t>
+         requires point_range<points_t>
+      bool update( const points_t& points )
+     {
+         return update( execution::seq, points );
+     }
+
+      private:
+
+      // visit(s) for every slot in the buckets of the cells touched by the ball of radius around q, each bucket once
+      template<typename visit_t>
+      void visit( const point_type& q, const value_type radius, visit_t&& visit_slot ) const
+     {
+         // no point is within a negative or NaN radius
+         if( empty() || !(radius>=0) ){ return; }
+
+         // a ball wider than 2*buckets() cells (or infinite) touches at least as many cells as there are buckets
+         if( radius>=cell*static_cast<value_type>(buckets()) ){ for( std::size_t s=0; s<size(); ++s ){ visit_slot(s); } return; }
+
+         const delta_type r = detail::elementwise<delta_type,ndim>( [radius]( std::size_t ){ return radius; } );
+         const cell_type lo = cell_of(q-r);
+         const cell_type hi = cell_of(q+r);
+
+         // cells of the box [lo,hi], at most neighbour_cells unless the radius is larger than the cell size
+         std::size_t box = 1;
+         for( std::size_t c=0; c<ndim && box<buckets(); ++c )
+        {
+            const auto extent = static_cast<std::size_t>(hi[c]-lo[c])+1;
+            box = box>buckets()/extent ? buckets() : box*extent;
+        }
+         if( box>=buckets() ){ for( std::size_t s=0; s<size(); ++s ){ visit_slot(s); } return; }
+
+         std::array<std::size_t,neighbour_cells> local;
+         std::vector<std::size_t> wide( box>neighbour_cells ? box : 0 );
+         std::size_t* visited = box>neighbour_cells ? wide.data() : local.data();
+         std::size_t n_visited = 0;
+
+         cell_type x = lo;
+         while( true )
+        {
+            const std::size_t b = bucket_of(x);
+            if( std::find( visited, visited+n_visited, b )==visited+n_visited )
+           {
+               visited[n_visited++] = b;
+               for( std::size_t s=starts[b]; s<starts[b+1]; ++s ){ visit_slot(s); }
+           }
+
+            // next cell of the box [lo,hi], coordinate 0 fastest
+            std::size_t c=0;
+            for( ; c<ndim && x[c]==hi[c]; ++c ){ x[c]=lo[c]; }
+            if( c==ndim ){ return; }
+            ++x[c];
+        }
+     }
+
+      // counting sort of the points source(i) with buckets keys[i] into the slots, stable in i
+      template<typename policy_t, typename source_t>
+      void fill( policy_t&& policy, const std::vector<std::size_t>& keys, source_t&& source );
+
+      value_type cell = 1;
+      point_type origin{};
+      unsigned bits = 0;
+
+      // compressed sparse row buckets: the slots of bucket b are [starts[b],starts[b+1])
+      std::vector<std::size_t>  starts{0};
+      std::vector<std::size_t>  order;
+      point_array<point_type>   nodes;
+  };
+
+// --------------- construction ---------------
+
+   template<typename point_t>
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   hash_grid<point_t>::hash_grid( policy_t&& policy, const points_t& points, const value_type cell_size ) : cell(cell_size)
+  {
+      assert( cell_size>0 );
+
+      const std::size_t n = std::ranges::size(points);
+      const auto p = std::ranges::begin(points);
+      if( n>0 ){ origin = p[0]; }
+
+      // at least as many buckets as points, so most buckets hold the points of a single cell
+      const std::size_t nb = std::bit_ceil( std::max<std::size_t>(n,1) );
+      bits = static_cast<unsigned>( std::countr_zero(nb) );
+      starts.assign( nb+1, 0 );
+
+      std::vector<std::size_t> keys(n);
+      detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t i=b; i<e; ++i ){ keys[i]=bucket_of( static_cast<point_type>(p[i]) ); } } );
+
+      fill( policy, keys, [&]( const std::size_t i ){ return std::pair<std::size_t,point_type>( i, p[i] ); } );
+  }
+
+   template<typename point_t>
+   template<typename policy_t, typename source_t>
+   void hash_grid<point_t>::fill( policy_t&& policy, const std::vector<std::size_t>& keys, source_t&& source )
+  {
+      const std::size_t n = keys.size();
+      const std::size_t nb = buckets();
+      const std::size_t k = detail::chunk_count<policy_t>(n);
+
+      // points of each bucket in each chunk, then the first slot of each, bucket major so that the sort is stable
+      std::vector<std::size_t> offsets(k*nb,0);
+      detail::parallel_for( policy, k,
+                            [&]( const std::size_t b, const std::size_t e )
+                           {
+                               for( std::size_t j=b; j<e; ++j )
+                              {
+                                  const std::size_t end = detail::chunk_begin(n,k,j+1);
+                                  for( std::size_t i=detail::chunk_begin(n,k,j); i<end; ++i ){ ++offsets[j*nb+keys[i]]; }
+                              }
+                           },
+                            1 );
+
+      std::size_t total = 0;
+      for( std::size_t b=0; b<nb; ++b )
+     {
+         starts[b] = total;
+         for( std::size_t j=0; j<k; ++j )
+        {
+            const std::size_t count = offsets[j*nb+b];
+            offsets[j*nb+b] = total;
+            total += count;
+        }
+     }
+      starts[nb] = total;
+
+      std::vector<std::size_t> slots(n);
+      point_array<point_type> copy(n);
+      detail::parallel_for( policy, k,
+                            [&]( const std::size_t b, const std::size_t e )
+                           {
+                               for( std::size_t j=b; j<e; ++j )
+                              {
+                                  const std::size_t end = detail::chunk_begin(n,k,j+1);
+                                  for( std::size_t i=detail::chunk_begin(n,k,j); i<end; ++i )
+                                 {
+                                     const std::size_t s = offsets[j*nb+keys[i]]++;
+                                     const auto [index,p] = source(i);
+                                     slots[s] = index;
+                                     copy[s] = p;
+                                 }
+                              }
+                           },
+                            1 );
+
+      order = std::move(slots);
+      nodes = std::move(copy);
+  }
+
+// --------------- update ---------------
+
+   template<typename point_t>
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   bool hash_grid<point_t>::update( policy_t&& policy, const points_t& points )
+  {
+      const std::size_t n = size();
+      assert( std::ranges::size(points)==n );
+      const auto p = std::ranges::begin(points);
+
+      // the bucket of each slot at the new positions, and whether any slot left its bucket
+      std::vector<std::size_t> keys(n);
+      const std::size_t moved =
+         detail::parallel_reduce( policy, n, std::size_t(0),
+                                  [&]( const std::size_t b, const std::size_t e )
+                                 {
+                                     std::size_t count = 0;
+                                     for( std::size_t s=b; s<e; ++s )
+                                    {
+                                        keys[s] = bucket_of( static_cast<point_type>(p[order[s]]) );
+                                        count += s<starts[keys[s]] || s>=starts[keys[s]+1];
+                                    }
+                                     return count;
+                                 },
+                                  std::plus{} );
+
+      if( moved==0 )
+     {
+         detail::parallel_for( policy, n, [&]( const std::size_t b, const std::size_t e ){ for( std::size_t s=b; s<e; ++s ){ nodes[s]=static_cast<point_type>(p[order[s]]); } } );
+         return false;
+     }
+
+      fill( policy, keys, [&]( const std::size_t s ){ return std::pair<std::size_t,point_type>( order[s], p[order[s]] ); } );
+      return true;
+  }
+
+}
@@ -0,0 +1,368 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines a k-d tree for nearest neighbour, radius and box queries over a set of points.
+ *
+ *    kdtree<point_t> copies the points into a point_array (SoA), then orders them so that the tree is implicit in the array:
+ *       the node of the range [lo,hi) is the median at mid=lo+(hi-lo)/2, with children [lo,mid) and [mid+1,hi)
+ *       ranges of at most leaf_size points are leaves, and are scanned linearly
+ *    Each node splits along the coordinate with the largest spread of its range, the only per node data is that coordinate.
+ *    Building partitions all the nodes of one level in parallel with nth_element, so the tree does not depend on the policy.
+ *
+ *    Queries return neighbours: the index of the point in the input range, the offset point-query as a delta_t, and its squared length.
+ *    Offsets and distances are always computed as point-point -> delta, so a query point of the wrong space does not compile.
+ *    The tree uses the euclidean metric, whatever the default metric of delta_t.
+ *       nearest(q,k)              the k nearest points, nearest first
+ *       within_radius(q,r)        all points with |p-q|<=r, in no particular order
+ *       within_box(q,h)           all points with |(p-q)[i]|<=h[i] for every coordinate i, in no particular order
+ *    Each query has a batch version taking an execution policy and a range of query points, which runs the queries across threads.
+ *
+ *    Code example:
+ *
+ *       std::vector<cartesian_point_t<3>> cloud = ...;
+ *       const kdtree<cartesian_point_t<3>> tree( affine::execution::par, cloud );
+ *
+ *       for( const auto& [index,offset,distance2] : tree.nearest( q, 8 ) ){ ... cloud[index] == q+offset ... }
+ *
+ *       const auto neighbours = tree.within_radius( affine::execution::par, queries, 0.1 );   // neighbours[j] are those of queries[j]
+ */
+
+# include "affine_space.h"
+# include "parallel.h"
+# include "point_array.h"
+# include "combination.h"
+# include "metric.h"
+
+# include <algorithm>
+# include <cassert>
+# include <cstddef>
+# include <cstdint>
+# include <iterator>
+# include <ranges>
+# include <span>
+# include <utility>
+# include <vector>
+
+namespace affine
+{
+
+/*
+ * static k-d tree over a copy of a set of points
+ */
+   template<typename point_t>
+   class kdtree
+  {
+      static_assert( point_t::vector_valued && !point_t::dynamic, "kdtree requires a fixed, non-zero ndim" );
+      static_assert( point_t::size()<=UINT8_MAX, "the splitting coordinate is stored in 8 bits" );
+
+      public:
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      constexpr static std::size_t ndim = point_t::size();
+
+      // ranges of at most leaf_size points are not split further
+      constexpr static std::size_t leaf_size = 16;
+
+      struct neighbour
+     {
+         std::size_t index;
+         delta_type  offset;
+         value_type  distance2;
+     };
+
+      kdtree() = default;
+
+      template<execution_policy policy_t, typename points_t>
+         requires point_range<points_t>
+      kdtree( policy_t&& policy, const points_t& points );
+
+      template<typename points_t>
+         requires point_range<points_t>
+      explicit kdtree( const points_t& points ) : kdtree( execution::seq, points ) {}
+
+      [[nodiscard]] std::size_t size()  const noexcept { return order.size(); }
+      [[nodiscard]] bool        empty() const noexcept { return order.empty(); }
+
+      // the points in tree order, point i is input point index(i)
+      [[nodiscard]] const point_array<point_type>& points() const noexcept { return nodes; }
+      [[nodiscard]] std::size_t index( const std::size_t i ) const { return order[i]; }
+
+   // single queries
+      [[nodiscard]] std::vector<neighbour> nearest( const point_type& q, const std::size_t k ) const
+     {
+         std::vector<neighbour> heap;
+         heap.reserve( std::min(k,size()) );
+         if( k>0 ){ search_nearest( 0, size(), q, k, heap ); }
+         std::sort_heap( heap.begin(), heap.end(), closer );
+         return heap;
+     }
+
+      [[nodiscard]] std::vector<neighbour> within_radius( const point_type& q, const value_type radius ) const
+     {
+         std::vector<neighbour> found;
+         search_radius( 0, size(), q, radius*radius, found );
+         return found;
+     }
+
+      [[nodiscard]] std::vector<neighbour> within_box( const point_type& q, const delta_type& half_width ) const
+     {
+         std::vector<neighbour> found;
+         search_box( 0, size(), q, half_width, found );
+         return found;
+     }
+
+   // batch queries, result j belongs to query point j
+      template<execution_policy policy_t, typename queries_t>
+         requires point_range<queries_t>
+      [[nodiscard]] std::vector<std::vector<neighbour>> nearest( policy_t&& policy, const queries_t& queries, const std::size_t k ) const
+     {
+         return batch( policy, queries, [&]( const point_type& q ){ return nearest(q,k); } );
+     }
+
+      template<execution_policy policy_t, typename queries_t>
+         requires point_range<queries_t>
+      [[nodiscard]] std::vector<std::vector<neighbour>> within_radius( policy_t&& policy, const queries_t& queries, const value_type radius ) const
+     {
+         return batch( policy, queries, [&]( const point_type& q ){ return within_radius(q,radius); } );
+     }
+
+      template<execution_policy policy_t, typename queries_t>
+         requires point_range<queries_t>
+      [[nodiscard]] std::vector<std::vector<neighbour>> within_box( policy_t&& policy, const queries_t& queries, const delta_type& half_width ) const
+     {
+         return batch( policy, queries, [&]( const point_type& q ){ return within_box(q,half_width); } );
+     }
+
+      private:
+
+      // max-heap order for the k nearest, ties broken by index so that results do not depend on the traversal
+      static bool closer( const neighbour& lhs, const neighbour& rhs )
+     {
+         return lhs.distance2<rhs.distance2 || ( lhs.distance2==rhs.distance2 && lhs.index<rhs.index );
+     }
+
+      [[nodiscard]] neighbour make_neighbour( const std::size_t i, const point_type& q ) const
+     {
+         const delta_type offset = nodes[i]-q;
+         return { order[i], offset, norm2( euclidean_metric{}, offset ) };
+     }
+
+      void partition( const std::size_t lo, const std::size_t hi, const point_array<point_type>& input );
+
+      void search_nearest( const std::size_t lo, const std::size_t hi, const point_type& q, const std::size_t k, std::vector<neighbour>& heap ) const
+     {
+         const auto visit = [&]( const std::size_t i )
+        {
+            const neighbour candidate = make_neighbour(i,q);
+            if( heap.size()<k )
+           {
+               heap.push_back(candidate);
+               std::push_heap( heap.begin(), heap.end(), closer );
+           }
+            else if( closer( candidate, heap.front() ) )
+           {
+               std::pop_heap( heap.begin(), heap.end(), closer );
+               heap.back() = candidate;
+               std::push_heap( heap.begin(), heap.end(), closer );
+           }
+        };
+
+         if( hi-lo<=leaf_size )
+        {
+            for( std::size_t i=lo; i<hi; ++i ){ visit(i); }
+            return;
+        }
+
+         const std::size_t mid = lo+(hi-lo)/2;
+         const std::size_t s = split[mid];
+         const value_type diff = q[s]-nodes[mid][s];
+
+         visit(mid);
+         if( diff<0 ){ search_nearest( lo, mid, q, k, heap ); }
+         else        { search_nearest( mid+1, hi, q, k, heap ); }
+
+         if( heap.size()<k || diff*diff<=heap.front().distance2 )
+        {
+            if( diff<0 ){ search_nearest( mid+1, hi, q, k, heap ); }
+            else        { search_nearest( lo, mid, q, k, heap ); }
+        }
+     }
+
+      void search_radius( const std::size_t lo, const std::size_t hi, const point_type& q, const value_type radius2, std::vector<neighbour>& found ) const
+     {
+         const auto visit = [&]( const std::size_t i )
+        {
+            const neighbour candidate = make_neighbour(i,q);
+            if( candidate.distance2<=radius2 ){ found.push_back(candidate); }
+        };
+
+         if( hi-lo<=leaf_size )
+        {
+            for( std::size_t i=lo; i<hi; ++i ){ visit(i); }
+            return;
+        }
+
+         const std::size_t mid = lo+(hi-lo)/2;
+         const std::size_t s = split[mid];
+         const value_type diff = q[s]-nodes[mid][s];
+
+         visit(mid);
+         if( diff<=0 || diff*diff<=radius2 ){ search_radius( lo, mid, q, radius2, found ); }
+         if( diff>=0 || diff*diff<=radius2 ){ search_radius( mid+1, hi, q, radius2, found ); }
+     }
+
+      void search_box( const std::size_t lo, const std::size_t hi, const point_type& q, const delta_type& half_width, std::vector<neighbour>& found ) const
+     {
+         const auto visit = [&]( const std::size_t i )
+        {
+            const neighbour candidate = make_neighbour(i,q);
+            bool inside=true;
+            for( std::size_t c=0; c<ndim; ++c ){ inside = inside && candidate.offset[c]<=half_width[c] && -candidate.offset[c]<=half_width[c]; }
+            if( inside ){ found.push_back(candidate); }
+        };
+
+         if( hi-lo<=leaf_size )
+        {
+            for( std::size_t i=lo; i<hi; ++i ){ visit(i); }
+            return;
+        }
+
+         const std::size_t mid = lo+(hi-lo)/2;
+         const std::size_t s = split[mid];
+         const value_type diff = q[s]-nodes[mid][s];
+
+         visit(mid);
+         if( diff<= half_width[s] ){ search_box( lo, mid, q, half_width, found ); }
+         if( diff>=-half_width[s] ){ search_box( mid+1, hi, q, half_width, found ); }
+     }
+
+      template<typename policy_t, typename queries_t, typename query_t>
+      std::vector<std::vector<neighbour>> batch( policy_t&& policy, const queries_t& queries, query_t&& query ) const
+     {
+         const std::size_t n = std::ranges::size(queries);
+         const auto q = std::ranges::begin(queries);
+
+         std::vector<std::vector<neighbour>> results(n);
+         detail::parallel_for( policy, n,
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t j=b; j<e; ++j ){ results[j]=query( static_cast<point_type>(q[j]) ); }
+                              },
+                               detail::query_grain );
+         return results;
+     }
+
+      // the points in tree order, and the input index and splitting coordinate of each
+      point_array<point_type>   nodes;
+      std::vector<std::size_t>  order;
+      std::vector<std::uint8_t> split;
+  };
+
+
+// --------------- construction ---------------
+
+   template<typename point_t>
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   kdtree<point_t>::kdtree( policy_t&& policy, const points_t& points )
+  {
+      const std::size_t n = std::ranges::size(points);
+      const auto p = std::ranges::begin(points);
+
+      // SoA copy of the input, so that the partitioning reads one column at a time
+      point_array<point_type> input(n);
+      for( std::size_t i=0; i<n; ++i ){ input[i]=static_cast<point_type>(p[i]); }
+
+      order.resize(n);
+      split.assign(n,0);
+      for( std::size_t i=0; i<n; ++i ){ order[i]=i; }
+
+      // the nodes of one level have disjoint ranges, so they are partitioned concurrently
+      std::vector<std::pair<std::size_t,std::size_t>> level, next;
+      if( n>leaf_size ){ level.emplace_back(0,n); }
+      while( !level.empty() )
+     {
+         detail::parallel_for( policy, level.size(),
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t r=b; r<e; ++r ){ partition( level[r].first, level[r].second, input ); }
+                              },
+                               1 );
+
+         next.clear();
+         for( const auto& [lo,hi] : level )
+        {
+            const std::size_t mid = lo+(hi-lo)/2;
+            if( mid-lo>leaf_size ){ next.emplace_back(lo,mid); }
+            if( hi-mid-1>leaf_size ){ next.emplace_back(mid+1,hi); }
+        }
+         level.swap(next);
+     }
+
+      nodes.resize(n);
+      for( std::size_t c=0; c<ndim; ++c )
+     {
+         const auto from = input.column(c);
+         const auto to = nodes.column(c);
+         detail::parallel_for( policy, n,
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t i=b; i<e; ++i ){ to[i]=from[order[i]]; }
+                              } );
+     }
+  }
+
+   // choose the splitting coordinate of the node of [lo,hi), and move its median to mid
+   template<typename point_t>
+   void kdtree<point_t>::partition( const std::size_t lo, const std::size_t hi, const point_array<point_type>& input )
+  {
+      std::size_t s=0;
+      value_type widest{-1};
+      for( std::size_t c=0; c<ndim; ++c )
+     {
+         const auto x = input.column(c);
+         const auto [min,max] = std::minmax_element( order.begin()+lo, order.begin()+hi,
+                                                     [&]( const std::size_t i, const std::size_t j ){ return x[i]<x[j]; } );
+         const value_type spread = x[*max]-x[*min];
+         if( spread>widest ){ widest=spread; s=c; }
+     }
+
+      const std::size_t mid = lo+(hi-lo)/2;
+      const auto x = input.column(s);
+      std::nth_element( order.begin()+lo, order.begin()+mid, order.begin()+hi,
+                        [&]( const std::size_t i, const std::size_t j ){ return x[i]<x[j]; } );
+      split[mid] = static_cast<std::uint8_t>(s);
+  }
+}
+
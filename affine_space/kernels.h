@@ -0,0 +1,2896 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines batched kernels over spans of points and deltas, with runtime instruction set dispatch.
+ *
+ *    axpy(a,x,y)           y[i] += a*x[i]    for deltas x,y
+ *    advance(p,a,d)        p[i] += a*d[i]    for points p and deltas d
+ *    scale(a,d)            d[i] *= a         for deltas d
+ *    difference(p,q,d)     d[i]  = p[i]-q[i] for points p,q and deltas d
+ *    norm2(d,r)            r[i]  = |d[i]|²   for deltas d
+ *    distance2(p,q,r)      r[i]  = |p[i]-q|² for points p and a point q
+ *    normalize(d)          d[i] /= |d[i]|    for deltas d, zero deltas are left zero
+ *
+ *    The type rules are the same as the operators in affine_space.h, but each kernel is one pass over all coordinates of all elements.
+ *    The spans must have the same length. point_array/delta_array overloads apply the same kernels to each column.
+ *
+ *    For float and double, the elements are treated as one flat array of coordinates and processed with hand written sse2/avx2/avx512 loops.
+ *    Heads are processed separately until the output is aligned to the vector width, and tails are processed separately (scalar for sse2/avx2, masked for avx512).
+ *    axpy, scale and difference also have vector loops for int32 (avx2/avx512), and for float16/bfloat16 (see half.h),
+ *    which are widened to float on load (F16C, avx512 or shifts) and rounded once on store.
+ *    Signed integer coordinates wrap modulo 2^bits on overflow with every instruction set, the scalar loops compute them in unsigned arithmetic.
+ *    advance and difference of points and deltas with different number types are computed in the common type,
+ *    with vector loops for double points with float deltas and float points with 16 bit float deltas.
+ *    flat_quantize/flat_dequantize convert columns of float or double to and from 16 bit integer codes with a scale and offset, and flat_bounds finds their range (see quantized.h).
+ *    flat_compensated_axpy and flat_compensated_sum carry the rounding errors of each coordinate in a second column (Neumaier summation, see compensated.h),
+ *    with branch free vector loops for float, double, and double with float deltas.
+ *    Other value types fall back to a loop over the operators of point_t/delta_t.
+ *
+ *    norm2, distance2 and normalize put consecutive elements in the vector lanes, and load coordinates with gathers unless they are contiguous (SoA).
+ *    normalize uses the hardware reciprocal square root estimate (or an integer estimate for double without avx512), refined by newton iterations
+ *    to within a few ulp of 1/sqrt. Elements whose squared length is subnormal or overflows are divided by their largest coordinate first instead.
+ *    These kernels use the euclidean metric, and fall back to a loop over norm2/norm if metric_traits<delta_t> is specialised,
+ *    for other value types (eg integers or fixed point), and for points whose deltas have a different value type.
+ *    distance2 writes the value type of the deltas, like affine::distance2.
+ *
+ *    The instruction set is detected once (cpuid, on first use) and can be queried with kernel_isa(), or lowered with set_kernel_isa() e.g. for testing.
+ *    Dispatch requires gcc or clang on x86-64, otherwise only the scalar path is available.
+ *
+ *    Code example:
+ *
+ *       std::vector<cartesian_point_t<3>> x(n);
+ *       std::vector<cartesian_delta_t<3>> v(n);
+ *
+ *       advance( std::span(x), dt, std::span(v) );      // x[i]+= dt*v[i]
+ *
+ *       std::cout << isa_name(kernel_isa());            // e.g. "avx2"
+ */
+
+# include "affine_space.h"
+# include "half.h"
+# include "metric.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <cmath>
+# include <concepts>
+# include <cstddef>
+# include <cstdint>
+# include <limits>
+# include <span>
+# include <type_traits>
+
+# if defined(__x86_64__) && ( defined(__GNUC__) || defined(__clang__) )
+#    define AFFINE_X86_DISPATCH 1
+#    include <immintrin.h>
+#    define AFFINE_TARGET_SSE2   __attribute__((target("sse2")))
+#    define AFFINE_TARGET_AVX2   __attribute__((target("avx2,fma,f16c")))
+#    define AFFINE_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma,f16c")))
+#    define AFFINE_TARGET_BMI2   __attribute__((target("bmi2")))
+# endif
+
+namespace affine
+{
+
+// --------------- instruction set selection ---------------
+
+/*
+ * instruction sets with a kernel implementation, in increasing order of preference
+ */
+   enum class isa { scalar, sse2, avx2, avx512 };
+
+   [[nodiscard]]
+   constexpr const char* isa_name( const isa i )
+  {
+      switch( i )
+     {
+         case isa::sse2:   return "sse2";
+         case isa::avx2:   return "avx2";
+         case isa::avx512: return "avx512";
+         default:          return "scalar";
+     }
+  }
+
+/*
+ * best instruction set supported by this cpu
+ */
+   [[nodiscard]]
+   inline isa detect_isa()
+  {
+# if defined(AFFINE_X86_DISPATCH)
+      __builtin_cpu_init();
+      if( __builtin_cpu_supports("avx512f") ){ return isa::avx512; }
+      if( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c") ){ return isa::avx2; }
+      if( __builtin_cpu_supports("sse2") ){ return isa::sse2; }
+# endif
+      return isa::scalar;
+  }
+
+namespace detail
+{
+   [[nodiscard]]
+   inline isa& selected_isa()
+  {
+      static isa selected = detect_isa();
+      return selected;
+  }
+}
+
+/*
+ * instruction set used by the kernels
+ */
+   [[nodiscard]]
+   inline isa kernel_isa()
+  {
+      return detail::selected_isa();
+  }
+
+/*
+ * select the instruction set used by the kernels
+ *    requests above the best supported instruction set are lowered to it
+ *    returns the instruction set actually selected
+ */
+   inline isa set_kernel_isa( const isa requested )
+  {
+      detail::selected_isa() = std::min( requested, detect_isa() );
+      return kernel_isa();
+  }
+
+// --------------- flat kernels ---------------
+
+namespace detail
+{
+   // number of elements before p is aligned to alignment bytes, at most n
+   template<std::size_t alignment, typename num_t>
+   [[nodiscard]]
+   inline std::size_t head_length( const num_t* p, const std::size_t n )
+  {
+      const auto offset = reinterpret_cast<std::uintptr_t>(p)%alignment;
+      const auto head = offset==0 ? 0 : (alignment-offset)/sizeof(num_t);
+      return std::min<std::size_t>( head, n );
+  }
+
+   // gram blocks have a multiple of gram_rows rows, and a multiple of gram_columns columns (two vectors of the widest instruction set)
+   constexpr std::size_t gram_rows = 4;
+
+   template<typename num_t>
+   constexpr std::size_t gram_columns = 128/sizeof(num_t);
+
+   // number type the flat kernels compute in, compressed floats (see half.h) are widened to float
+   template<typename num_t>
+   using compute_t = std::conditional_t<compressed_floating_point<num_t>,float,num_t>;
+
+/*
+ * y+a*x, a*y and x-y of one coordinate, converted back to num_t
+ *    narrow integers are promoted to int by the arithmetic, and signed integers are computed in unsigned arithmetic,
+ *    so that they wrap on overflow like the int32 vector loops instead of being undefined
+ */
+   template<typename num_t>
+   using modular_t = std::common_type_t<std::make_unsigned_t<num_t>,unsigned>;
+
+   template<typename num_t>
+   [[nodiscard]]
+   constexpr num_t axpy_element( const compute_t<num_t> a, const num_t x, const num_t y )
+  {
+      if constexpr( std::signed_integral<num_t> )
+     {
+         using unsigned_t = modular_t<num_t>;
+         return static_cast<num_t>( static_cast<unsigned_t>(y)+static_cast<unsigned_t>(a)*static_cast<unsigned_t>(x) );
+     }
+      else{ return static_cast<num_t>( y+a*x ); }
+  }
+
+   template<typename num_t>
+   [[nodiscard]]
+   constexpr num_t scale_element( const compute_t<num_t> a, const num_t y )
+  {
+      if constexpr( std::signed_integral<num_t> )
+     {
+         using unsigned_t = modular_t<num_t>;
+         return static_cast<num_t>( static_cast<unsigned_t>(a)*static_cast<unsigned_t>(y) );
+     }
+      else{ return static_cast<num_t>( a*y ); }
+  }
+
+   template<typename num_t>
+   [[nodiscard]]
+   constexpr num_t difference_element( const num_t x, const num_t y )
+  {
+      if constexpr( std::signed_integral<num_t> )
+     {
+         using unsigned_t = modular_t<num_t>;
+         return static_cast<num_t>( static_cast<unsigned_t>(x)-static_cast<unsigned_t>(y) );
+     }
+      else{ return static_cast<num_t>( x-y ); }
+  }
+
+   // 16 bit integer codes of quantized coordinates, see quantized.h
+   template<typename code_t>
+   concept quantized_code = std::same_as<code_t,std::int16_t> || std::same_as<code_t,std::uint16_t>;
+
+/*
+ * s+v accumulated into s, with its rounding error added to the compensation c (Neumaier)
+ *    the error is computed from whichever of s and v is larger in magnitude, without branches in the vector kernels
+ */
+   template<std::floating_point num_t>
+   void neumaier_add( num_t& s, num_t& c, const num_t v )
+  {
+      const num_t t = s+v;
+      const bool s_larger = std::abs(s)>=std::abs(v);
+      c = c+( ( (s_larger ? s : v)-t )+( s_larger ? v : s ) );
+      s = t;
+  }
+
+namespace scalar
+{
+   template<typename num_t>
+   void axpy( const std::size_t n, const compute_t<num_t> a, const num_t* x, num_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=axpy_element(a,x[i],y[i]); }
+  }
+
+   template<typename num_t>
+   void scale( const std::size_t n, const compute_t<num_t> a, num_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=scale_element(a,y[i]); }
+  }
+
+   template<typename num_t>
+   void difference( const std::size_t n, const num_t* x, const num_t* y, num_t* z )
+  {
+      for( std::size_t i=0; i<n; ++i ){ z[i]=difference_element(x[i],y[i]); }
+  }
+
+   // y += a*x for point coordinates y and delta coordinates x of a different type, computed in the common type
+   template<typename num_t, typename dnum_t>
+   void mixed_axpy( const std::size_t n, const std::common_type_t<num_t,dnum_t> a, const dnum_t* x, num_t* y )
+  {
+      using common_t = std::common_type_t<num_t,dnum_t>;
+      for( std::size_t i=0; i<n; ++i ){ y[i]=static_cast<num_t>( static_cast<common_t>(y[i])+a*static_cast<common_t>(x[i]) ); }
+  }
+
+   // z = x-y for point coordinates x,y and delta coordinates z of a different type, computed in the common type
+   template<typename num_t, typename dnum_t>
+   void mixed_difference( const std::size_t n, const num_t* x, const num_t* y, dnum_t* z )
+  {
+      using common_t = std::common_type_t<num_t,dnum_t>;
+      for( std::size_t i=0; i<n; ++i ){ z[i]=static_cast<dnum_t>( static_cast<common_t>(x[i])-static_cast<common_t>(y[i]) ); }
+  }
+
+   // y = offset+scale*x, for integer codes x
+   template<typename num_t, typename code_t>
+   void dequantize( const std::size_t n, const num_t offset, const num_t scale, const code_t* x, num_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=offset+scale*static_cast<num_t>(x[i]); }
+  }
+
+   // v clamped to the range of code_t, NaN to the lowest code
+   template<typename code_t, typename num_t>
+   [[nodiscard]]
+   num_t clamp_code( const num_t v )
+  {
+      constexpr auto lo = static_cast<num_t>( std::numeric_limits<code_t>::min() );
+      constexpr auto hi = static_cast<num_t>( std::numeric_limits<code_t>::max() );
+      return v>lo ? ( v<hi ? v : hi ) : lo;
+  }
+
+   // x = (y-offset)*inverse_scale, rounded to the nearest code (ties to even) and clamped to the range of code_t
+   template<typename num_t, typename code_t>
+   void quantize( const std::size_t n, const num_t offset, const num_t inverse_scale, const num_t* y, code_t* x )
+  {
+      for( std::size_t i=0; i<n; ++i ){ x[i]=static_cast<code_t>( std::nearbyint( clamp_code<code_t>( (y[i]-offset)*inverse_scale ) ) ); }
+  }
+
+   // lo = min(lo,x[i]), hi = max(hi,x[i]) over x[0..n), NaN is ignored unless it is the initial value
+   template<typename num_t>
+   void bounds( const std::size_t n, const num_t* x, num_t* lo, num_t* hi )
+  {
+      for( std::size_t i=0; i<n; ++i )
+     {
+         *lo = x[i]<*lo ? x[i] : *lo;
+         *hi = x[i]>*hi ? x[i] : *hi;
+     }
+  }
+
+   // y += a*x in num_t, with the rounding errors of the product (by fma) and the sum added to c
+   template<std::floating_point num_t, typename dnum_t>
+   void compensated_axpy( const std::size_t n, const num_t a, const dnum_t* x, num_t* y, num_t* c )
+  {
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const auto xi = static_cast<num_t>(x[i]);
+         const num_t v = a*xi;
+         neumaier_add( y[i], c[i], v );
+         c[i] = c[i]+std::fma( a, xi, -v );
+     }
+  }
+
+   // s+c += Σ (x[i]-origin), with the rounding errors of the differences and the sum added to c
+   template<std::floating_point num_t>
+   void compensated_sum( const std::size_t n, const num_t origin, const num_t* x, num_t* s, num_t* c )
+  {
+      for( std::size_t i=0; i<n; ++i )
+     {
+         num_t d = x[i];
+         num_t e = 0;
+         neumaier_add( d, e, -origin );
+         neumaier_add( *s, *c, d );
+         *c = *c+e;
+     }
+  }
+
+   // out[k] = Σ_c (x[k*step+c*stride]-q[c])², q is the origin if !centred
+   template<bool centred, typename num_t>
+   void sum_squares( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride,
+                     [[maybe_unused]] const num_t* q, num_t* out )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         num_t sum(0);
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            num_t v = x[k*step+c*stride];
+            if constexpr( centred ){ v-=q[c]; }
+            sum+=v*v;
+        }
+         out[k]=sum;
+     }
+  }
+
+   template<typename num_t>
+   void rsqrt( const std::size_t n, const num_t* x, num_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=num_t(1)/std::sqrt(x[i]); }
+  }
+
+/*
+ * y_r[k] = t[r] + Σ_c a[r*ncols+c]*x_c[k], for columns x_c = x+c*xs and y_r = y+r*ys of n elements
+ * a is row major, t may be null, and y may be x if xs==ys
+ */
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   void matrix_apply( const std::size_t n, const num_t* a, const num_t* t,
+                      const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         num_t xk[ncols];
+         for( std::size_t c=0; c<ncols; ++c ){ xk[c]=x[c*xs+k]; }
+         for( std::size_t r=0; r<nrows; ++r )
+        {
+            num_t sum = t ? t[r] : num_t(0);
+            for( std::size_t c=0; c<ncols; ++c ){ sum+=a[r*ncols+c]*xk[c]; }
+            y[r*ys+k]=sum;
+        }
+     }
+  }
+
+/*
+ * t[i*nb+j] = Σ_c (a[c*na+i]-b[c*nb+j])², with a and b packed in columns of na and nb elements
+ */
+   template<typename num_t>
+   void distance_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                        const num_t* a, const num_t* b, num_t* t )
+  {
+      for( std::size_t i=0; i<na; ++i )
+     {
+         for( std::size_t j=0; j<nb; ++j ){ t[i*nb+j]=num_t(0); }
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            for( std::size_t j=0; j<nb; ++j )
+           {
+               const num_t v = a[c*na+i]-b[c*nb+j];
+               t[i*nb+j]+=v*v;
+           }
+        }
+     }
+  }
+
+/*
+ * t[i*nb+j] = a2[i]+b2[j]-2 Σ_c a[c*na+i]*b[c*nb+j]
+ * cancelled[i*(nb/gram_columns)+j/gram_columns] is set if some entry of that block of row i is less than ratio*(a2[i]+b2[j]),
+ * and is left unchanged otherwise
+ */
+   template<typename num_t>
+   void gram_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                    const num_t* a, const num_t* a2, const num_t* b, const num_t* b2, const num_t ratio,
+                    num_t* t, std::uint8_t* cancelled )
+  {
+      const std::size_t blocks = nb/gram_columns<num_t>;
+      for( std::size_t i=0; i<na; ++i )
+     {
+         for( std::size_t j=0; j<nb; ++j ){ t[i*nb+j]=num_t(0); }
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            for( std::size_t j=0; j<nb; ++j ){ t[i*nb+j]+=a[c*na+i]*b[c*nb+j]; }
+        }
+         for( std::size_t j=0; j<nb; ++j )
+        {
+            t[i*nb+j] = a2[i]+b2[j]-num_t(2)*t[i*nb+j];
+            if( t[i*nb+j]<ratio*(a2[i]+b2[j]) ){ cancelled[i*blocks+j/gram_columns<num_t>]=1; }
+        }
+     }
+  }
+
+/*
+ * y[4k+r] = Σ_c a[r*4+c]*x[4k+c], for n elements of 4 interleaved lanes, see homogeneous_storage
+ * the fourth lane is the homogeneous coordinate, so a single matrix [L t; 0 1] maps points (w=1) and deltas (w=0), y may be x
+ */
+   template<typename num_t>
+   void homogeneous_apply( const std::size_t n, const num_t* a, const num_t* x, num_t* y )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         num_t xk[4];
+         for( std::size_t c=0; c<4; ++c ){ xk[c]=x[4*k+c]; }
+         for( std::size_t r=0; r<4; ++r )
+        {
+            num_t sum = a[r*4]*xk[0];
+            for( std::size_t c=1; c<4; ++c ){ sum+=a[r*4+c]*xk[c]; }
+            y[4*k+r]=sum;
+        }
+     }
+  }
+
+}
+
+# if defined(AFFINE_X86_DISPATCH)
+
+namespace sse2
+{
+   AFFINE_TARGET_SSE2 inline __m128d broadcast( const double a ){ return _mm_set1_pd(a); }
+   AFFINE_TARGET_SSE2 inline __m128  broadcast( const float  a ){ return _mm_set1_ps(a); }
+
+   AFFINE_TARGET_SSE2 inline __m128d loadu( const double* p ){ return _mm_loadu_pd(p); }
+   AFFINE_TARGET_SSE2 inline __m128  loadu( const float*  p ){ return _mm_loadu_ps(p); }
+
+   AFFINE_TARGET_SSE2 inline __m128d load( const double* p ){ return _mm_load_pd(p); }
+   AFFINE_TARGET_SSE2 inline __m128  load( const float*  p ){ return _mm_load_ps(p); }
+
+   AFFINE_TARGET_SSE2 inline void store( double* p, const __m128d v ){ _mm_store_pd(p,v); }
+   AFFINE_TARGET_SSE2 inline void store( float*  p, const __m128  v ){ _mm_store_ps(p,v); }
+
+   AFFINE_TARGET_SSE2 inline __m128d mul( const __m128d a, const __m128d b ){ return _mm_mul_pd(a,b); }
+   AFFINE_TARGET_SSE2 inline __m128  mul( const __m128  a, const __m128  b ){ return _mm_mul_ps(a,b); }
+
+   AFFINE_TARGET_SSE2 inline __m128d sub( const __m128d a, const __m128d b ){ return _mm_sub_pd(a,b); }
+   AFFINE_TARGET_SSE2 inline __m128  sub( const __m128  a, const __m128  b ){ return _mm_sub_ps(a,b); }
+
+   AFFINE_TARGET_SSE2 inline __m128d add( const __m128d a, const __m128d b ){ return _mm_add_pd(a,b); }
+   AFFINE_TARGET_SSE2 inline __m128  add( const __m128  a, const __m128  b ){ return _mm_add_ps(a,b); }
+
+   // a*x+y, no fma in sse2
+   AFFINE_TARGET_SSE2 inline __m128d muladd( const __m128d a, const __m128d x, const __m128d y ){ return _mm_add_pd(_mm_mul_pd(a,x),y); }
+   AFFINE_TARGET_SSE2 inline __m128  muladd( const __m128  a, const __m128  x, const __m128  y ){ return _mm_add_ps(_mm_mul_ps(a,x),y); }
+
+   template<typename num_t>
+   constexpr std::size_t width = 16/sizeof(num_t);
+
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void axpy( const std::size_t n, const num_t a, const num_t* x, num_t* y )
+  {
+      std::size_t i = head_length<16>(y,n);
+      for( std::size_t j=0; j<i; ++j ){ y[j]+=a*x[j]; }
+
+      const auto va = broadcast(a);
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, muladd( va, loadu(x+i), load(y+i) ) ); }
+
+      for( ; i<n; ++i ){ y[i]+=a*x[i]; }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void scale( const std::size_t n, const num_t a, num_t* y )
+  {
+      std::size_t i = head_length<16>(y,n);
+      for( std::size_t j=0; j<i; ++j ){ y[j]*=a; }
+
+      const auto va = broadcast(a);
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, mul( va, load(y+i) ) ); }
+
+      for( ; i<n; ++i ){ y[i]*=a; }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void difference( const std::size_t n, const num_t* x, const num_t* y, num_t* z )
+  {
+      std::size_t i = head_length<16>(z,n);
+      for( std::size_t j=0; j<i; ++j ){ z[j]=x[j]-y[j]; }
+
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+
+      for( ; i<n; ++i ){ z[i]=x[i]-y[i]; }
+  }
+
+   // int32 coordinates, pmulld needs sse4.1 so only the differences are explicitly vectorised
+   AFFINE_TARGET_SSE2 inline void axpy( const std::size_t n, const std::int32_t a, const std::int32_t* x, std::int32_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=axpy_element(a,x[i],y[i]); }
+  }
+
+   AFFINE_TARGET_SSE2 inline void scale( const std::size_t n, const std::int32_t a, std::int32_t* y )
+  {
+      for( std::size_t i=0; i<n; ++i ){ y[i]=scale_element(a,y[i]); }
+  }
+
+   AFFINE_TARGET_SSE2 inline void difference( const std::size_t n, const std::int32_t* x, const std::int32_t* y, std::int32_t* z )
+  {
+      std::size_t i=0;
+      for( ; i+4<=n; i+=4 )
+     {
+         const __m128i v = _mm_sub_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(x+i) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>(y+i) ) );
+         _mm_storeu_si128( reinterpret_cast<__m128i*>(z+i), v );
+     }
+      for( ; i<n; ++i ){ z[i]=difference_element(x[i],y[i]); }
+  }
+
+   // 16 bit floats, without F16C the conversions are scalar
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_SSE2 void axpy( const std::size_t n, const float a, const half_t* x, half_t* y ){ scalar::axpy(n,a,x,y); }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_SSE2 void scale( const std::size_t n, const float a, half_t* y ){ scalar::scale(n,a,y); }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_SSE2 void difference( const std::size_t n, const half_t* x, const half_t* y, half_t* z ){ scalar::difference(n,x,y,z); }
+
+   AFFINE_TARGET_SSE2 inline void storeu( double* p, const __m128d v ){ _mm_storeu_pd(p,v); }
+   AFFINE_TARGET_SSE2 inline void storeu( float*  p, const __m128  v ){ _mm_storeu_ps(p,v); }
+
+   // double points and float deltas, 2 lanes, the deltas are widened on load and the differences rounded to float on store
+   AFFINE_TARGET_SSE2 inline __m128d widen( const float* p ){ return _mm_cvtps_pd( _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>(p) ) ) ); }
+   AFFINE_TARGET_SSE2 inline void narrow( float* p, const __m128d v ){ _mm_storel_pi( reinterpret_cast<__m64*>(p), _mm_cvtpd_ps(v) ); }
+
+   AFFINE_TARGET_SSE2 inline void mixed_axpy( const std::size_t n, const double a, const float* x, double* y )
+  {
+      constexpr std::size_t w = width<double>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, widen(x+i), loadu(y+i) ) ); }
+      scalar::mixed_axpy( n-i, a, x+i, y+i );
+  }
+
+   AFFINE_TARGET_SSE2 inline void mixed_difference( const std::size_t n, const double* x, const double* y, float* z )
+  {
+      constexpr std::size_t w = width<double>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ narrow( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::mixed_difference( n-i, x+i, y+i, z+i );
+  }
+
+   // float points and 16 bit float deltas, without F16C the conversions are scalar
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_SSE2 void mixed_axpy( const std::size_t n, const float a, const half_t* x, float* y ){ scalar::mixed_axpy(n,a,x,y); }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_SSE2 void mixed_difference( const std::size_t n, const float* x, const float* y, half_t* z ){ scalar::mixed_difference(n,x,y,z); }
+
+   // 16 bit integer codes, widening and packing 32 bit lanes needs sse4.1 so the conversions are scalar
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_SSE2 void dequantize( const std::size_t n, const num_t offset, const num_t scale, const code_t* x, num_t* y ){ scalar::dequantize(n,offset,scale,x,y); }
+
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_SSE2 void quantize( const std::size_t n, const num_t offset, const num_t inverse_scale, const num_t* y, code_t* x ){ scalar::quantize(n,offset,inverse_scale,y,x); }
+
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void bounds( const std::size_t n, const num_t* x, num_t* lo, num_t* hi ){ scalar::bounds(n,x,lo,hi); }
+
+   // the compensated kernels need fma for the error of the product, and blends, so they are scalar
+   template<typename num_t, typename dnum_t>
+   AFFINE_TARGET_SSE2 void compensated_axpy( const std::size_t n, const num_t a, const dnum_t* x, num_t* y, num_t* c ){ scalar::compensated_axpy(n,a,x,y,c); }
+
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void compensated_sum( const std::size_t n, const num_t origin, const num_t* x, num_t* s, num_t* c ){ scalar::compensated_sum(n,origin,x,s,c); }
+
+   // lanes p[0], p[step], ...
+   AFFINE_TARGET_SSE2 inline __m128d load_strided( const double* p, const std::size_t step )
+  {
+      return step==1 ? _mm_loadu_pd(p) : _mm_set_pd( p[step], p[0] );
+  }
+
+   AFFINE_TARGET_SSE2 inline __m128 load_strided( const float* p, const std::size_t step )
+  {
+      return step==1 ? _mm_loadu_ps(p) : _mm_set_ps( p[3*step], p[2*step], p[step], p[0] );
+  }
+
+   // 12 bit estimate for float, and for double the integer shift estimate, which is valid over the whole exponent range
+   AFFINE_TARGET_SSE2 inline __m128 rsqrt_estimate( const __m128 x ){ return _mm_rsqrt_ps(x); }
+   AFFINE_TARGET_SSE2 inline __m128d rsqrt_estimate( const __m128d x )
+  {
+      const __m128i magic = _mm_set1_epi64x( 0x5fe6eb50c7b537a9 );
+      return _mm_castsi128_pd( _mm_sub_epi64( magic, _mm_srli_epi64( _mm_castpd_si128(x), 1 ) ) );
+  }
+
+   template<typename num_t>
+   constexpr std::size_t newton_steps = std::same_as<num_t,float> ? 1 : 4;
+
+   // lanes along the elements, scalar tail
+   template<bool centred, typename num_t>
+   AFFINE_TARGET_SSE2 void sum_squares( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride,
+                            [[maybe_unused]] const num_t* q, num_t* out )
+  {
+      std::size_t k=0;
+      for( ; k+width<num_t><=n; k+=width<num_t> )
+     {
+         const num_t* xk = x+k*step;
+         auto acc = broadcast( num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            auto v = load_strided( xk+c*stride, step );
+            if constexpr( centred ){ v = sub( v, broadcast(q[c]) ); }
+            acc = muladd( v, v, acc );
+        }
+         storeu( out+k, acc );
+     }
+
+      for( ; k<n; ++k )
+     {
+         num_t sum(0);
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            num_t v = x[k*step+c*stride];
+            if constexpr( centred ){ v-=q[c]; }
+            sum = sum+v*v;
+        }
+         out[k]=sum;
+     }
+  }
+
+   // estimate refined by newton iterations r <- r*(3/2 - x/2*r*r)
+   template<typename num_t, typename vector_t>
+   AFFINE_TARGET_SSE2 inline vector_t refine_rsqrt( const vector_t x )
+  {
+      const auto h = mul( broadcast( num_t(0.5) ), x );
+      const auto three_halves = broadcast( num_t(1.5) );
+      auto r = rsqrt_estimate(x);
+      for( std::size_t s=0; s<newton_steps<num_t>; ++s ){ r = mul( r, sub( three_halves, mul( h, mul(r,r) ) ) ); }
+      return r;
+  }
+
+   // the tail is padded so that every element is rounded the same way
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void rsqrt( const std::size_t n, const num_t* x, num_t* y )
+  {
+      std::size_t i=0;
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ storeu( y+i, refine_rsqrt<num_t>( loadu(x+i) ) ); }
+
+      if( i<n )
+     {
+         std::array<num_t,width<num_t>> tail;
+         tail.fill( num_t(1) );
+         std::copy( x+i, x+n, tail.begin() );
+         storeu( tail.data(), refine_rsqrt<num_t>( loadu(tail.data()) ) );
+         std::copy_n( tail.begin(), n-i, y+i );
+     }
+  }
+
+   // t[i*nb+j] = Σ_c (a[c*na+i]-b[c*nb+j])², see scalar::distance_block
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void distance_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                               const num_t* a, const num_t* b, num_t* t )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  const auto v0 = sub( ar, b0 );
+                  const auto v1 = sub( ar, b1 );
+                  acc[r][0] = muladd( v0, v0, acc[r][0] );
+                  acc[r][1] = muladd( v1, v1, acc[r][1] );
+              }
+           }
+
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               storeu( t+(i+r)*nb+j,   acc[r][0] );
+               storeu( t+(i+r)*nb+j+w, acc[r][1] );
+           }
+        }
+     }
+  }
+
+   // y_r[k] = t[r] + Σ_c a[r*ncols+c]*x_c[k], two vectors of elements at a time with the matrix held in registers, see scalar::matrix_apply
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   AFFINE_TARGET_SSE2 void matrix_apply( const std::size_t n, const num_t* a, const num_t* t,
+                             const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      vector_t va[nrows][ncols], vt[nrows];
+      for( std::size_t r=0; r<nrows; ++r )
+     {
+         vt[r] = broadcast( t ? t[r] : num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c ){ va[r][c] = broadcast( a[r*ncols+c] ); }
+     }
+
+      std::size_t k=0;
+      for( ; k+2*w<=n; k+=2*w )
+     {
+         vector_t x0[ncols], x1[ncols];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            x0[c] = loadu( x+c*xs+k );
+            x1[c] = loadu( x+c*xs+k+w );
+        }
+         for( std::size_t r=0; r<nrows; ++r )
+        {
+            vector_t y0 = vt[r], y1 = vt[r];
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               y0 = muladd( va[r][c], x0[c], y0 );
+               y1 = muladd( va[r][c], x1[c], y1 );
+           }
+            storeu( y+r*ys+k,   y0 );
+            storeu( y+r*ys+k+w, y1 );
+        }
+     }
+
+      // the tail is padded so that every element is rounded the same way
+      if( k<n )
+     {
+         num_t xt[ncols][2*w], yt[nrows][2*w];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            std::fill( xt[c], xt[c]+2*w, num_t(0) );
+            std::copy( x+c*xs+k, x+c*xs+n, xt[c] );
+        }
+         matrix_apply<nrows,ncols>( 2*w, a, t, &xt[0][0], 2*w, &yt[0][0], 2*w );
+         for( std::size_t r=0; r<nrows; ++r ){ std::copy_n( yt[r], n-k, y+r*ys+k ); }
+     }
+  }
+
+   // lane c of each group of four lanes, broadcast across its group
+   template<int c> AFFINE_TARGET_SSE2 inline __m128 spread( const __m128 v ){ return _mm_shuffle_ps(v,v,_MM_SHUFFLE(c,c,c,c)); }
+
+   // y[4k+r] = Σ_c a[r*4+c]*x[4k+c], with the columns of a held in registers and full width loads and stores, see scalar::homogeneous_apply
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void homogeneous_apply( const std::size_t n, const num_t* a, const num_t* x, num_t* y )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+      if constexpr( w<4 )
+     {
+         // two vectors per element
+         vector_t lo[4], hi[4];
+         for( std::size_t c=0; c<4; ++c )
+        {
+            const num_t l[2]={ a[c], a[4+c] };
+            const num_t h[2]={ a[8+c], a[12+c] };
+            lo[c] = loadu( l );
+            hi[c] = loadu( h );
+        }
+         for( std::size_t k=0; k<n; ++k )
+        {
+            const vector_t x0 = broadcast( x[4*k] );
+            vector_t r0 = mul( lo[0], x0 ), r1 = mul( hi[0], x0 );
+            for( std::size_t c=1; c<4; ++c )
+           {
+               const vector_t xc = broadcast( x[4*k+c] );
+               r0 = muladd( lo[c], xc, r0 );
+               r1 = muladd( hi[c], xc, r1 );
+           }
+            storeu( y+4*k,   r0 );
+            storeu( y+4*k+2, r1 );
+        }
+     }
+      else
+     {
+         // column c of a, repeated for each element in a vector
+         constexpr std::size_t e = w/4;
+         num_t lanes[4][w];
+         for( std::size_t c=0; c<4; ++c )
+        {
+            for( std::size_t l=0; l<w; ++l ){ lanes[c][l]=a[(l%4)*4+c]; }
+        }
+         const vector_t a0 = loadu( lanes[0] ), a1 = loadu( lanes[1] ), a2 = loadu( lanes[2] ), a3 = loadu( lanes[3] );
+
+         std::size_t k=0;
+         for( ; k+e<=n; k+=e )
+        {
+            const vector_t v = loadu( x+4*k );
+            vector_t r = mul( a0, spread<0>(v) );
+            r = muladd( a1, spread<1>(v), r );
+            r = muladd( a2, spread<2>(v), r );
+            r = muladd( a3, spread<3>(v), r );
+            storeu( y+4*k, r );
+        }
+
+         // the tail is padded so that every element is rounded the same way
+         if( k<n )
+        {
+            num_t xt[w]={}, yt[w];
+            std::copy( x+4*k, x+4*n, xt );
+            homogeneous_apply( e, a, xt, yt );
+            std::copy( yt, yt+4*(n-k), y+4*k );
+        }
+     }
+  }
+
+   // some lane of a is less than the same lane of b
+   AFFINE_TARGET_SSE2 inline bool any_less( const __m128d a, const __m128d b ){ return _mm_movemask_pd( _mm_cmplt_pd(a,b) )!=0; }
+   AFFINE_TARGET_SSE2 inline bool any_less( const __m128  a, const __m128  b ){ return _mm_movemask_ps( _mm_cmplt_ps(a,b) )!=0; }
+
+   // t[i*nb+j] = a2[i]+b2[j]-2 Σ_c a[c*na+i]*b[c*nb+j], with a 4x2 block of vector accumulators, see scalar::gram_block
+   template<typename num_t>
+   AFFINE_TARGET_SSE2 void gram_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                           const num_t* a, const num_t* a2, const num_t* b, const num_t* b2, const num_t ratio,
+                           num_t* t, std::uint8_t* cancelled )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+      const vector_t minus_two = broadcast( num_t(-2) );
+      const vector_t threshold = broadcast( ratio );
+      const std::size_t blocks = nb/gram_columns<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  acc[r][0] = muladd( ar, b0, acc[r][0] );
+                  acc[r][1] = muladd( ar, b1, acc[r][1] );
+              }
+           }
+
+            const auto s0 = loadu( b2+j );
+            const auto s1 = loadu( b2+j+w );
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               const auto ar = broadcast( a2[i+r] );
+               const auto n0 = add( ar, s0 );
+               const auto n1 = add( ar, s1 );
+               const auto d0 = muladd( minus_two, acc[r][0], n0 );
+               const auto d1 = muladd( minus_two, acc[r][1], n1 );
+               storeu( t+(i+r)*nb+j,   d0 );
+               storeu( t+(i+r)*nb+j+w, d1 );
+               if( any_less( d0, mul(threshold,n0) ) || any_less( d1, mul(threshold,n1) ) ){ cancelled[(i+r)*blocks+j/gram_columns<num_t>]=1; }
+           }
+        }
+     }
+  }
+}
+
+namespace avx2
+{
+   AFFINE_TARGET_AVX2 inline __m256d broadcast( const double a ){ return _mm256_set1_pd(a); }
+   AFFINE_TARGET_AVX2 inline __m256  broadcast( const float  a ){ return _mm256_set1_ps(a); }
+
+   AFFINE_TARGET_AVX2 inline __m256d loadu( const double* p ){ return _mm256_loadu_pd(p); }
+   AFFINE_TARGET_AVX2 inline __m256  loadu( const float*  p ){ return _mm256_loadu_ps(p); }
+
+   AFFINE_TARGET_AVX2 inline __m256d load( const double* p ){ return _mm256_load_pd(p); }
+   AFFINE_TARGET_AVX2 inline __m256  load( const float*  p ){ return _mm256_load_ps(p); }
+
+   AFFINE_TARGET_AVX2 inline void store( double* p, const __m256d v ){ _mm256_store_pd(p,v); }
+   AFFINE_TARGET_AVX2 inline void store( float*  p, const __m256  v ){ _mm256_store_ps(p,v); }
+
+   AFFINE_TARGET_AVX2 inline __m256d mul( const __m256d a, const __m256d b ){ return _mm256_mul_pd(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256  mul( const __m256  a, const __m256  b ){ return _mm256_mul_ps(a,b); }
+
+   AFFINE_TARGET_AVX2 inline __m256d sub( const __m256d a, const __m256d b ){ return _mm256_sub_pd(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256  sub( const __m256  a, const __m256  b ){ return _mm256_sub_ps(a,b); }
+
+   AFFINE_TARGET_AVX2 inline __m256d add( const __m256d a, const __m256d b ){ return _mm256_add_pd(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256  add( const __m256  a, const __m256  b ){ return _mm256_add_ps(a,b); }
+
+   AFFINE_TARGET_AVX2 inline __m256d muladd( const __m256d a, const __m256d x, const __m256d y ){ return _mm256_fmadd_pd(a,x,y); }
+   AFFINE_TARGET_AVX2 inline __m256  muladd( const __m256  a, const __m256  x, const __m256  y ){ return _mm256_fmadd_ps(a,x,y); }
+
+   template<typename num_t>
+   constexpr std::size_t width = 32/sizeof(num_t);
+
+   // heads and tails also use fma, so every element is rounded the same way
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void axpy( const std::size_t n, const num_t a, const num_t* x, num_t* y )
+  {
+      std::size_t i = head_length<32>(y,n);
+      for( std::size_t j=0; j<i; ++j ){ y[j]=std::fma(a,x[j],y[j]); }
+
+      const auto va = broadcast(a);
+      for( ; i+2*width<num_t><=n; i+=2*width<num_t> )
+     {
+         store( y+i,              muladd( va, loadu(x+i),              load(y+i) ) );
+         store( y+i+width<num_t>, muladd( va, loadu(x+i+width<num_t>), load(y+i+width<num_t>) ) );
+     }
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, muladd( va, loadu(x+i), load(y+i) ) ); }
+
+      for( ; i<n; ++i ){ y[i]=std::fma(a,x[i],y[i]); }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void scale( const std::size_t n, const num_t a, num_t* y )
+  {
+      std::size_t i = head_length<32>(y,n);
+      for( std::size_t j=0; j<i; ++j ){ y[j]*=a; }
+
+      const auto va = broadcast(a);
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, mul( va, load(y+i) ) ); }
+
+      for( ; i<n; ++i ){ y[i]*=a; }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void difference( const std::size_t n, const num_t* x, const num_t* y, num_t* z )
+  {
+      std::size_t i = head_length<32>(z,n);
+      for( std::size_t j=0; j<i; ++j ){ z[j]=x[j]-y[j]; }
+
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+
+      for( ; i<n; ++i ){ z[i]=x[i]-y[i]; }
+  }
+
+   // int32 coordinates, 8 lanes (twice as many as double)
+   AFFINE_TARGET_AVX2 inline __m256i broadcast( const std::int32_t a ){ return _mm256_set1_epi32(a); }
+   AFFINE_TARGET_AVX2 inline __m256i loadu( const std::int32_t* p ){ return _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) ); }
+   AFFINE_TARGET_AVX2 inline void storeu( std::int32_t* p, const __m256i v ){ _mm256_storeu_si256( reinterpret_cast<__m256i*>(p), v ); }
+   AFFINE_TARGET_AVX2 inline __m256i mul( const __m256i a, const __m256i b ){ return _mm256_mullo_epi32(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256i add( const __m256i a, const __m256i b ){ return _mm256_add_epi32(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256i sub( const __m256i a, const __m256i b ){ return _mm256_sub_epi32(a,b); }
+
+   AFFINE_TARGET_AVX2 inline void axpy( const std::size_t n, const std::int32_t a, const std::int32_t* x, std::int32_t* y )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, add( mul( va, loadu(x+i) ), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=axpy_element(a,x[i],y[i]); }
+  }
+
+   AFFINE_TARGET_AVX2 inline void scale( const std::size_t n, const std::int32_t a, std::int32_t* y )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, mul( va, loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=scale_element(a,y[i]); }
+  }
+
+   AFFINE_TARGET_AVX2 inline void difference( const std::size_t n, const std::int32_t* x, const std::int32_t* y, std::int32_t* z )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ z[i]=difference_element(x[i],y[i]); }
+  }
+
+   // 16 bit floats, widened to 8 lanes of float on load and rounded to nearest even on store
+   AFFINE_TARGET_AVX2 inline __m256 loadu( const float16* p ){ return _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) ); }
+
+   AFFINE_TARGET_AVX2 inline void storeu( float16* p, const __m256 v )
+  {
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC ) );
+  }
+
+   AFFINE_TARGET_AVX2 inline __m256 loadu( const bfloat16* p )
+  {
+      const __m256i u = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) );
+      return _mm256_castsi256_ps( _mm256_slli_epi32( u, 16 ) );
+  }
+
+   // as bfloat16_format::encode, then the low halves of the 8 lanes are packed together
+   AFFINE_TARGET_AVX2 inline void storeu( bfloat16* p, const __m256 v )
+  {
+      const __m256i u = _mm256_castps_si256(v);
+      const __m256i high = _mm256_srli_epi32( u, 16 );
+      const __m256i odd = _mm256_and_si256( high, _mm256_set1_epi32(1) );
+      const __m256i rounded = _mm256_srli_epi32( _mm256_add_epi32( _mm256_add_epi32( u, _mm256_set1_epi32(0x7fff) ), odd ), 16 );
+      const __m256i quiet = _mm256_or_si256( high, _mm256_set1_epi32(0x40) );
+      const __m256i h = _mm256_blendv_epi8( rounded, quiet, _mm256_castps_si256( _mm256_cmp_ps( v, v, _CMP_UNORD_Q ) ) );
+      const __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi32( h, h ), 0x08 );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(packed) );
+  }
+
+   // computed in float, and the tail also uses fma so every element is rounded the same way
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX2 void axpy( const std::size_t n, const float a, const half_t* x, half_t* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, float(x[i]), float(y[i]) ); }
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX2 void scale( const std::size_t n, const float a, half_t* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, mul( va, loadu(y+i) ) ); }
+      scalar::scale( n-i, a, y+i );
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX2 void difference( const std::size_t n, const half_t* x, const half_t* y, half_t* z )
+  {
+      constexpr std::size_t w = width<float>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::difference( n-i, x+i, y+i, z+i );
+  }
+
+   AFFINE_TARGET_AVX2 inline void storeu( double* p, const __m256d v ){ _mm256_storeu_pd(p,v); }
+   AFFINE_TARGET_AVX2 inline void storeu( float*  p, const __m256  v ){ _mm256_storeu_ps(p,v); }
+
+   // double points and float deltas, 4 lanes, the deltas are widened on load and the differences rounded to float on store
+   AFFINE_TARGET_AVX2 inline __m256d widen( const float* p ){ return _mm256_cvtps_pd( _mm_loadu_ps(p) ); }
+   AFFINE_TARGET_AVX2 inline void narrow( float* p, const __m256d v ){ _mm_storeu_ps( p, _mm256_cvtpd_ps(v) ); }
+
+   // the tail also uses fma, so every element is rounded the same way
+   AFFINE_TARGET_AVX2 inline void mixed_axpy( const std::size_t n, const double a, const float* x, double* y )
+  {
+      constexpr std::size_t w = width<double>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, widen(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, double(x[i]), y[i] ); }
+  }
+
+   AFFINE_TARGET_AVX2 inline void mixed_difference( const std::size_t n, const double* x, const double* y, float* z )
+  {
+      constexpr std::size_t w = width<double>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ narrow( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::mixed_difference( n-i, x+i, y+i, z+i );
+  }
+
+   // float points and 16 bit float deltas, with the conversions of the compressed kernels
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX2 void mixed_axpy( const std::size_t n, const float a, const half_t* x, float* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, float(x[i]), y[i] ); }
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX2 void mixed_difference( const std::size_t n, const float* x, const float* y, half_t* z )
+  {
+      constexpr std::size_t w = width<float>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::mixed_difference( n-i, x+i, y+i, z+i );
+  }
+
+   // 16 bit integer codes, widened to the lanes of the output type y on load, 8 for float and 4 for double
+   AFFINE_TARGET_AVX2 inline __m128i load_codes( const float*,  const std::uint16_t* p ){ return _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ); }
+   AFFINE_TARGET_AVX2 inline __m128i load_codes( const float*,  const std::int16_t*  p ){ return _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ); }
+   AFFINE_TARGET_AVX2 inline __m128i load_codes( const double*, const std::uint16_t* p ){ return _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p) ); }
+   AFFINE_TARGET_AVX2 inline __m128i load_codes( const double*, const std::int16_t*  p ){ return _mm_loadl_epi64( reinterpret_cast<const __m128i*>(p) ); }
+
+   AFFINE_TARGET_AVX2 inline __m256  widen_codes( const float*,  const std::uint16_t*, const __m128i v ){ return _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32(v) ); }
+   AFFINE_TARGET_AVX2 inline __m256  widen_codes( const float*,  const std::int16_t*,  const __m128i v ){ return _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32(v) ); }
+   AFFINE_TARGET_AVX2 inline __m256d widen_codes( const double*, const std::uint16_t*, const __m128i v ){ return _mm256_cvtepi32_pd( _mm_cvtepu16_epi32(v) ); }
+   AFFINE_TARGET_AVX2 inline __m256d widen_codes( const double*, const std::int16_t*,  const __m128i v ){ return _mm256_cvtepi32_pd( _mm_cvtepi16_epi32(v) ); }
+
+   // lanes already clamped to the range of the codes, so the saturation of the packs never applies
+   AFFINE_TARGET_AVX2 inline __m128i pack_codes( const std::uint16_t*, const __m256i v ){ return _mm_packus_epi32( _mm256_castsi256_si128(v), _mm256_extracti128_si256(v,1) ); }
+   AFFINE_TARGET_AVX2 inline __m128i pack_codes( const std::int16_t*,  const __m256i v ){ return _mm_packs_epi32( _mm256_castsi256_si128(v), _mm256_extracti128_si256(v,1) ); }
+   AFFINE_TARGET_AVX2 inline __m128i pack_codes( const std::uint16_t*, const __m128i v ){ return _mm_packus_epi32(v,v); }
+   AFFINE_TARGET_AVX2 inline __m128i pack_codes( const std::int16_t*,  const __m128i v ){ return _mm_packs_epi32(v,v); }
+
+   AFFINE_TARGET_AVX2 inline void store_codes( std::uint16_t* p, const __m256  v ){ _mm_storeu_si128( reinterpret_cast<__m128i*>(p), pack_codes( p, _mm256_cvtps_epi32(v) ) ); }
+   AFFINE_TARGET_AVX2 inline void store_codes( std::int16_t*  p, const __m256  v ){ _mm_storeu_si128( reinterpret_cast<__m128i*>(p), pack_codes( p, _mm256_cvtps_epi32(v) ) ); }
+   AFFINE_TARGET_AVX2 inline void store_codes( std::uint16_t* p, const __m256d v ){ _mm_storel_epi64( reinterpret_cast<__m128i*>(p), pack_codes( p, _mm256_cvtpd_epi32(v) ) ); }
+   AFFINE_TARGET_AVX2 inline void store_codes( std::int16_t*  p, const __m256d v ){ _mm_storel_epi64( reinterpret_cast<__m128i*>(p), pack_codes( p, _mm256_cvtpd_epi32(v) ) ); }
+
+   // minps/maxps return the second operand if either is NaN, so NaN is ignored by bounds and clamped to lo, as in the scalar kernels
+   AFFINE_TARGET_AVX2 inline __m256d min( const __m256d a, const __m256d b ){ return _mm256_min_pd(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256  min( const __m256  a, const __m256  b ){ return _mm256_min_ps(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256d max( const __m256d a, const __m256d b ){ return _mm256_max_pd(a,b); }
+   AFFINE_TARGET_AVX2 inline __m256  max( const __m256  a, const __m256  b ){ return _mm256_max_ps(a,b); }
+
+   template<typename vector_t>
+   AFFINE_TARGET_AVX2 vector_t clamp( const vector_t v, const vector_t lo, const vector_t hi ){ return min( max(v,lo), hi ); }
+
+   // the tail also uses fma, so every element is rounded the same way
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_AVX2 void dequantize( const std::size_t n, const num_t offset, const num_t scale, const code_t* x, num_t* y )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(offset);
+      const auto vs = broadcast(scale);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( vs, widen_codes( y, x, load_codes( y, x+i ) ), vo ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( scale, static_cast<num_t>(x[i]), offset ); }
+  }
+
+   // rounded to nearest even by the conversion, as the scalar tail
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_AVX2 void quantize( const std::size_t n, const num_t offset, const num_t inverse_scale, const num_t* y, code_t* x )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(offset);
+      const auto vi = broadcast(inverse_scale);
+      const auto lo = broadcast( static_cast<num_t>( std::numeric_limits<code_t>::min() ) );
+      const auto hi = broadcast( static_cast<num_t>( std::numeric_limits<code_t>::max() ) );
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ store_codes( x+i, clamp( mul( sub( loadu(y+i), vo ), vi ), lo, hi ) ); }
+      scalar::quantize( n-i, offset, inverse_scale, y+i, x+i );
+  }
+
+   // one running bound per lane, the lanes are reduced at the end
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void bounds( const std::size_t n, const num_t* x, num_t* lo, num_t* hi )
+  {
+      constexpr std::size_t w = width<num_t>;
+      auto vlo = broadcast(*lo);
+      auto vhi = broadcast(*hi);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         const auto v = loadu(x+i);
+         vlo = min( v, vlo );
+         vhi = max( v, vhi );
+     }
+      alignas(32) num_t lows[w];
+      alignas(32) num_t highs[w];
+      store( lows, vlo );
+      store( highs, vhi );
+      for( std::size_t j=0; j<w; ++j )
+     {
+         *lo = lows[j]<*lo ? lows[j] : *lo;
+         *hi = highs[j]>*hi ? highs[j] : *hi;
+     }
+      scalar::bounds( n-i, x+i, lo, hi );
+  }
+
+   // branch free neumaier_add, the lanes of s are larger in magnitude where s_larger is set
+   AFFINE_TARGET_AVX2 inline __m256d abs( const __m256d v ){ return _mm256_andnot_pd( _mm256_set1_pd(-0.0), v ); }
+   AFFINE_TARGET_AVX2 inline __m256  abs( const __m256  v ){ return _mm256_andnot_ps( _mm256_set1_ps(-0.f), v ); }
+
+   AFFINE_TARGET_AVX2 inline __m256d not_less( const __m256d a, const __m256d b ){ return _mm256_cmp_pd(a,b,_CMP_GE_OQ); }
+   AFFINE_TARGET_AVX2 inline __m256  not_less( const __m256  a, const __m256  b ){ return _mm256_cmp_ps(a,b,_CMP_GE_OQ); }
+
+   AFFINE_TARGET_AVX2 inline __m256d select( const __m256d m, const __m256d a, const __m256d b ){ return _mm256_blendv_pd(b,a,m); }
+   AFFINE_TARGET_AVX2 inline __m256  select( const __m256  m, const __m256  a, const __m256  b ){ return _mm256_blendv_ps(b,a,m); }
+
+   // a*x-y rounded once
+   AFFINE_TARGET_AVX2 inline __m256d mulsub( const __m256d a, const __m256d x, const __m256d y ){ return _mm256_fmsub_pd(a,x,y); }
+   AFFINE_TARGET_AVX2 inline __m256  mulsub( const __m256  a, const __m256  x, const __m256  y ){ return _mm256_fmsub_ps(a,x,y); }
+
+   template<typename vector_t>
+   AFFINE_TARGET_AVX2 void neumaier_add( vector_t& s, vector_t& c, const vector_t v )
+  {
+      const vector_t t = add(s,v);
+      const auto s_larger = not_less( abs(s), abs(v) );
+      c = add( c, add( sub( select(s_larger,s,v), t ), select(s_larger,v,s) ) );
+      s = t;
+  }
+
+   // coordinates of x in the lanes of y, double lanes of float x are widened
+   AFFINE_TARGET_AVX2 inline __m256d load_lanes( const double*, const double* p ){ return loadu(p); }
+   AFFINE_TARGET_AVX2 inline __m256  load_lanes( const float*,  const float*  p ){ return loadu(p); }
+   AFFINE_TARGET_AVX2 inline __m256d load_lanes( const double*, const float*  p ){ return widen(p); }
+
+   // the same operations as the scalar kernel, which also does the tail, so the result is identical for every instruction set
+   template<typename num_t, typename dnum_t>
+   AFFINE_TARGET_AVX2 void compensated_axpy( const std::size_t n, const num_t a, const dnum_t* x, num_t* y, num_t* c )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         const auto vx = load_lanes( y, x+i );
+         const auto v = mul( va, vx );
+         auto vy = loadu(y+i);
+         auto vc = loadu(c+i);
+         neumaier_add( vy, vc, v );
+         storeu( y+i, vy );
+         storeu( c+i, add( vc, mulsub( va, vx, v ) ) );
+     }
+      scalar::compensated_axpy( n-i, a, x+i, y+i, c+i );
+  }
+
+   // one running sum and compensation per lane, the lanes are accumulated in order at the end
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void compensated_sum( const std::size_t n, const num_t origin, const num_t* x, num_t* s, num_t* c )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(-origin);
+      const auto zero = broadcast( num_t(0) );
+      auto vs = zero;
+      auto vc = zero;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         auto d = loadu(x+i);
+         auto e = zero;
+         neumaier_add( d, e, vo );
+         neumaier_add( vs, vc, d );
+         vc = add( vc, e );
+     }
+      alignas(32) num_t sums[w];
+      alignas(32) num_t errors[w];
+      store( sums, vs );
+      store( errors, vc );
+      for( std::size_t j=0; j<w; ++j )
+     {
+         detail::neumaier_add( *s, *c, sums[j] );
+         *c = *c+errors[j];
+     }
+      scalar::compensated_sum( n-i, origin, x+i, s, c );
+  }
+
+   // lanes p[0], p[step], ..., gathered unless contiguous
+   AFFINE_TARGET_AVX2 inline __m256d load_strided( const double* p, const std::size_t step )
+  {
+      if( step==1 ){ return _mm256_loadu_pd(p); }
+      const int s = static_cast<int>(step);
+      return _mm256_mask_i32gather_pd( _mm256_setzero_pd(), p, _mm_setr_epi32(0,s,2*s,3*s), _mm256_castsi256_pd( _mm256_set1_epi64x(-1) ), 8 );
+  }
+
+   AFFINE_TARGET_AVX2 inline __m256 load_strided( const float* p, const std::size_t step )
+  {
+      if( step==1 ){ return _mm256_loadu_ps(p); }
+      const int s = static_cast<int>(step);
+      return _mm256_mask_i32gather_ps( _mm256_setzero_ps(), p, _mm256_setr_epi32(0,s,2*s,3*s,4*s,5*s,6*s,7*s), _mm256_castsi256_ps( _mm256_set1_epi32(-1) ), 4 );
+  }
+
+   AFFINE_TARGET_AVX2 inline __m256 rsqrt_estimate( const __m256 x ){ return _mm256_rsqrt_ps(x); }
+   AFFINE_TARGET_AVX2 inline __m256d rsqrt_estimate( const __m256d x )
+  {
+      const __m256i magic = _mm256_set1_epi64x( 0x5fe6eb50c7b537a9 );
+      return _mm256_castsi256_pd( _mm256_sub_epi64( magic, _mm256_srli_epi64( _mm256_castpd_si256(x), 1 ) ) );
+  }
+
+   template<typename num_t>
+   constexpr std::size_t newton_steps = std::same_as<num_t,float> ? 1 : 4;
+
+   // lanes along the elements, scalar tail
+   template<bool centred, typename num_t>
+   AFFINE_TARGET_AVX2 void sum_squares( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride,
+                            [[maybe_unused]] const num_t* q, num_t* out )
+  {
+      std::size_t k=0;
+      for( ; k+width<num_t><=n; k+=width<num_t> )
+     {
+         const num_t* xk = x+k*step;
+         auto acc = broadcast( num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            auto v = load_strided( xk+c*stride, step );
+            if constexpr( centred ){ v = sub( v, broadcast(q[c]) ); }
+            acc = muladd( v, v, acc );
+        }
+         storeu( out+k, acc );
+     }
+
+      for( ; k<n; ++k )
+     {
+         num_t sum(0);
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            num_t v = x[k*step+c*stride];
+            if constexpr( centred ){ v-=q[c]; }
+            sum = std::fma(v,v,sum);
+        }
+         out[k]=sum;
+     }
+  }
+
+   // estimate refined by newton iterations r <- r*(3/2 - x/2*r*r)
+   template<typename num_t, typename vector_t>
+   AFFINE_TARGET_AVX2 inline vector_t refine_rsqrt( const vector_t x )
+  {
+      const auto h = mul( broadcast( num_t(0.5) ), x );
+      const auto three_halves = broadcast( num_t(1.5) );
+      auto r = rsqrt_estimate(x);
+      for( std::size_t s=0; s<newton_steps<num_t>; ++s ){ r = mul( r, sub( three_halves, mul( h, mul(r,r) ) ) ); }
+      return r;
+  }
+
+   // the tail is padded so that every element is rounded the same way
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void rsqrt( const std::size_t n, const num_t* x, num_t* y )
+  {
+      std::size_t i=0;
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ storeu( y+i, refine_rsqrt<num_t>( loadu(x+i) ) ); }
+
+      if( i<n )
+     {
+         std::array<num_t,width<num_t>> tail;
+         tail.fill( num_t(1) );
+         std::copy( x+i, x+n, tail.begin() );
+         storeu( tail.data(), refine_rsqrt<num_t>( loadu(tail.data()) ) );
+         std::copy_n( tail.begin(), n-i, y+i );
+     }
+  }
+
+   // t[i*nb+j] = Σ_c (a[c*na+i]-b[c*nb+j])², see scalar::distance_block
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void distance_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                               const num_t* a, const num_t* b, num_t* t )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  const auto v0 = sub( ar, b0 );
+                  const auto v1 = sub( ar, b1 );
+                  acc[r][0] = muladd( v0, v0, acc[r][0] );
+                  acc[r][1] = muladd( v1, v1, acc[r][1] );
+              }
+           }
+
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               storeu( t+(i+r)*nb+j,   acc[r][0] );
+               storeu( t+(i+r)*nb+j+w, acc[r][1] );
+           }
+        }
+     }
+  }
+
+   // y_r[k] = t[r] + Σ_c a[r*ncols+c]*x_c[k], two vectors of elements at a time with the matrix held in registers, see scalar::matrix_apply
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   AFFINE_TARGET_AVX2 void matrix_apply( const std::size_t n, const num_t* a, const num_t* t,
+                             const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      vector_t va[nrows][ncols], vt[nrows];
+      for( std::size_t r=0; r<nrows; ++r )
+     {
+         vt[r] = broadcast( t ? t[r] : num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c ){ va[r][c] = broadcast( a[r*ncols+c] ); }
+     }
+
+      std::size_t k=0;
+      for( ; k+2*w<=n; k+=2*w )
+     {
+         vector_t x0[ncols], x1[ncols];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            x0[c] = loadu( x+c*xs+k );
+            x1[c] = loadu( x+c*xs+k+w );
+        }
+         for( std::size_t r=0; r<nrows; ++r )
+        {
+            vector_t y0 = vt[r], y1 = vt[r];
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               y0 = muladd( va[r][c], x0[c], y0 );
+               y1 = muladd( va[r][c], x1[c], y1 );
+           }
+            storeu( y+r*ys+k,   y0 );
+            storeu( y+r*ys+k+w, y1 );
+        }
+     }
+
+      // the tail is padded so that every element is rounded the same way
+      if( k<n )
+     {
+         num_t xt[ncols][2*w], yt[nrows][2*w];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            std::fill( xt[c], xt[c]+2*w, num_t(0) );
+            std::copy( x+c*xs+k, x+c*xs+n, xt[c] );
+        }
+         matrix_apply<nrows,ncols>( 2*w, a, t, &xt[0][0], 2*w, &yt[0][0], 2*w );
+         for( std::size_t r=0; r<nrows; ++r ){ std::copy_n( yt[r], n-k, y+r*ys+k ); }
+     }
+  }
+
+   // lane c of each group of four lanes, broadcast across its group
+   template<int c> AFFINE_TARGET_AVX2 inline __m256d spread( const __m256d v ){ return _mm256_permute4x64_pd(v,c*0x55); }
+   template<int c> AFFINE_TARGET_AVX2 inline __m256  spread( const __m256  v ){ return _mm256_permute_ps(v,c*0x55); }
+
+   // y[4k+r] = Σ_c a[r*4+c]*x[4k+c], with the columns of a held in registers and full width loads and stores, see scalar::homogeneous_apply
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void homogeneous_apply( const std::size_t n, const num_t* a, const num_t* x, num_t* y )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      // column c of a, repeated for each element in a vector
+      constexpr std::size_t e = w/4;
+      num_t lanes[4][w];
+      for( std::size_t c=0; c<4; ++c )
+     {
+         for( std::size_t l=0; l<w; ++l ){ lanes[c][l]=a[(l%4)*4+c]; }
+     }
+      const vector_t a0 = loadu( lanes[0] ), a1 = loadu( lanes[1] ), a2 = loadu( lanes[2] ), a3 = loadu( lanes[3] );
+
+      std::size_t k=0;
+      for( ; k+e<=n; k+=e )
+     {
+         const vector_t v = loadu( x+4*k );
+         vector_t r = mul( a0, spread<0>(v) );
+         r = muladd( a1, spread<1>(v), r );
+         r = muladd( a2, spread<2>(v), r );
+         r = muladd( a3, spread<3>(v), r );
+         storeu( y+4*k, r );
+     }
+
+      // the tail is padded so that every element is rounded the same way
+      if( k<n )
+     {
+         num_t xt[w]={}, yt[w];
+         std::copy( x+4*k, x+4*n, xt );
+         homogeneous_apply( e, a, xt, yt );
+         std::copy( yt, yt+4*(n-k), y+4*k );
+     }
+  }
+
+   // some lane of a is less than the same lane of b
+   AFFINE_TARGET_AVX2 inline bool any_less( const __m256d a, const __m256d b ){ return _mm256_movemask_pd( _mm256_cmp_pd(a,b,_CMP_LT_OQ) )!=0; }
+   AFFINE_TARGET_AVX2 inline bool any_less( const __m256  a, const __m256  b ){ return _mm256_movemask_ps( _mm256_cmp_ps(a,b,_CMP_LT_OQ) )!=0; }
+
+   // t[i*nb+j] = a2[i]+b2[j]-2 Σ_c a[c*na+i]*b[c*nb+j], with a 4x2 block of vector accumulators, see scalar::gram_block
+   template<typename num_t>
+   AFFINE_TARGET_AVX2 void gram_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                           const num_t* a, const num_t* a2, const num_t* b, const num_t* b2, const num_t ratio,
+                           num_t* t, std::uint8_t* cancelled )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+      const vector_t minus_two = broadcast( num_t(-2) );
+      const vector_t threshold = broadcast( ratio );
+      const std::size_t blocks = nb/gram_columns<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  acc[r][0] = muladd( ar, b0, acc[r][0] );
+                  acc[r][1] = muladd( ar, b1, acc[r][1] );
+              }
+           }
+
+            const auto s0 = loadu( b2+j );
+            const auto s1 = loadu( b2+j+w );
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               const auto ar = broadcast( a2[i+r] );
+               const auto n0 = add( ar, s0 );
+               const auto n1 = add( ar, s1 );
+               const auto d0 = muladd( minus_two, acc[r][0], n0 );
+               const auto d1 = muladd( minus_two, acc[r][1], n1 );
+               storeu( t+(i+r)*nb+j,   d0 );
+               storeu( t+(i+r)*nb+j+w, d1 );
+               if( any_less( d0, mul(threshold,n0) ) || any_less( d1, mul(threshold,n1) ) ){ cancelled[(i+r)*blocks+j/gram_columns<num_t>]=1; }
+           }
+        }
+     }
+  }
+}
+
+namespace avx512
+{
+   // masks selecting the first m lanes
+   AFFINE_TARGET_AVX512 inline __mmask8  first_lanes( const double*, const std::size_t m ){ return static_cast<__mmask8 >( (1u<<m)-1u ); }
+   AFFINE_TARGET_AVX512 inline __mmask16 first_lanes( const float*,  const std::size_t m ){ return static_cast<__mmask16>( (1u<<m)-1u ); }
+
+   AFFINE_TARGET_AVX512 inline __m512d broadcast( const double a ){ return _mm512_set1_pd(a); }
+   AFFINE_TARGET_AVX512 inline __m512  broadcast( const float  a ){ return _mm512_set1_ps(a); }
+
+   AFFINE_TARGET_AVX512 inline __m512d loadu( const double* p ){ return _mm512_loadu_pd(p); }
+   AFFINE_TARGET_AVX512 inline __m512  loadu( const float*  p ){ return _mm512_loadu_ps(p); }
+
+   AFFINE_TARGET_AVX512 inline __m512d load( const double* p ){ return _mm512_load_pd(p); }
+   AFFINE_TARGET_AVX512 inline __m512  load( const float*  p ){ return _mm512_load_ps(p); }
+
+   AFFINE_TARGET_AVX512 inline __m512d loadu( const __mmask8  m, const double* p ){ return _mm512_maskz_loadu_pd(m,p); }
+   AFFINE_TARGET_AVX512 inline __m512  loadu( const __mmask16 m, const float*  p ){ return _mm512_maskz_loadu_ps(m,p); }
+
+   AFFINE_TARGET_AVX512 inline void store( double* p, const __m512d v ){ _mm512_store_pd(p,v); }
+   AFFINE_TARGET_AVX512 inline void store( float*  p, const __m512  v ){ _mm512_store_ps(p,v); }
+
+   AFFINE_TARGET_AVX512 inline void storeu( const __mmask8  m, double* p, const __m512d v ){ _mm512_mask_storeu_pd(p,m,v); }
+   AFFINE_TARGET_AVX512 inline void storeu( const __mmask16 m, float*  p, const __m512  v ){ _mm512_mask_storeu_ps(p,m,v); }
+
+   AFFINE_TARGET_AVX512 inline __m512d mul( const __m512d a, const __m512d b ){ return _mm512_mul_pd(a,b); }
+   AFFINE_TARGET_AVX512 inline __m512  mul( const __m512  a, const __m512  b ){ return _mm512_mul_ps(a,b); }
+
+   AFFINE_TARGET_AVX512 inline __m512d sub( const __m512d a, const __m512d b ){ return _mm512_sub_pd(a,b); }
+   AFFINE_TARGET_AVX512 inline __m512  sub( const __m512  a, const __m512  b ){ return _mm512_sub_ps(a,b); }
+
+   AFFINE_TARGET_AVX512 inline __m512d add( const __m512d a, const __m512d b ){ return _mm512_add_pd(a,b); }
+   AFFINE_TARGET_AVX512 inline __m512  add( const __m512  a, const __m512  b ){ return _mm512_add_ps(a,b); }
+
+   AFFINE_TARGET_AVX512 inline __m512d muladd( const __m512d a, const __m512d x, const __m512d y ){ return _mm512_fmadd_pd(a,x,y); }
+   AFFINE_TARGET_AVX512 inline __m512  muladd( const __m512  a, const __m512  x, const __m512  y ){ return _mm512_fmadd_ps(a,x,y); }
+
+   template<typename num_t>
+   constexpr std::size_t width = 64/sizeof(num_t);
+
+   // heads and tails are single masked iterations
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void axpy( const std::size_t n, const num_t a, const num_t* x, num_t* y )
+  {
+      const auto va = broadcast(a);
+
+      std::size_t i = head_length<64>(y,n);
+      if( i>0 )
+     {
+         const auto m = first_lanes(y,i);
+         storeu( m, y, muladd( va, loadu(m,x), loadu(m,y) ) );
+     }
+
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, muladd( va, loadu(x+i), load(y+i) ) ); }
+
+      if( i<n )
+     {
+         const auto m = first_lanes(y,n-i);
+         storeu( m, y+i, muladd( va, loadu(m,x+i), loadu(m,y+i) ) );
+     }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void scale( const std::size_t n, const num_t a, num_t* y )
+  {
+      const auto va = broadcast(a);
+
+      std::size_t i = head_length<64>(y,n);
+      if( i>0 )
+     {
+         const auto m = first_lanes(y,i);
+         storeu( m, y, mul( va, loadu(m,y) ) );
+     }
+
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( y+i, mul( va, load(y+i) ) ); }
+
+      if( i<n )
+     {
+         const auto m = first_lanes(y,n-i);
+         storeu( m, y+i, mul( va, loadu(m,y+i) ) );
+     }
+  }
+
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void difference( const std::size_t n, const num_t* x, const num_t* y, num_t* z )
+  {
+      std::size_t i = head_length<64>(z,n);
+      if( i>0 )
+     {
+         const auto m = first_lanes(z,i);
+         storeu( m, z, sub( loadu(m,x), loadu(m,y) ) );
+     }
+
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ store( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+
+      if( i<n )
+     {
+         const auto m = first_lanes(z,n-i);
+         storeu( m, z+i, sub( loadu(m,x+i), loadu(m,y+i) ) );
+     }
+  }
+
+   // int32 coordinates, 16 lanes (twice as many as double)
+   AFFINE_TARGET_AVX512 inline __m512i broadcast( const std::int32_t a ){ return _mm512_set1_epi32(a); }
+   AFFINE_TARGET_AVX512 inline __m512i loadu( const std::int32_t* p ){ return _mm512_loadu_si512( reinterpret_cast<const __m512i*>(p) ); }
+   AFFINE_TARGET_AVX512 inline void storeu( std::int32_t* p, const __m512i v ){ _mm512_storeu_si512( reinterpret_cast<__m512i*>(p), v ); }
+   AFFINE_TARGET_AVX512 inline __m512i mul( const __m512i a, const __m512i b ){ return _mm512_mullo_epi32(a,b); }
+   AFFINE_TARGET_AVX512 inline __m512i add( const __m512i a, const __m512i b ){ return _mm512_add_epi32(a,b); }
+   AFFINE_TARGET_AVX512 inline __m512i sub( const __m512i a, const __m512i b ){ return _mm512_sub_epi32(a,b); }
+
+   AFFINE_TARGET_AVX512 inline void axpy( const std::size_t n, const std::int32_t a, const std::int32_t* x, std::int32_t* y )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, add( mul( va, loadu(x+i) ), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=axpy_element(a,x[i],y[i]); }
+  }
+
+   AFFINE_TARGET_AVX512 inline void scale( const std::size_t n, const std::int32_t a, std::int32_t* y )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, mul( va, loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=scale_element(a,y[i]); }
+  }
+
+   AFFINE_TARGET_AVX512 inline void difference( const std::size_t n, const std::int32_t* x, const std::int32_t* y, std::int32_t* z )
+  {
+      constexpr std::size_t w = width<std::int32_t>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ z[i]=difference_element(x[i],y[i]); }
+  }
+
+   // 16 bit floats, widened to 16 lanes of float on load and rounded to nearest even on store
+   // the zero masked forms avoid the undefined source operand of the unmasked intrinsics
+   constexpr __mmask16 all_lanes = 0xffff;
+
+   AFFINE_TARGET_AVX512 inline __m512 loadu( const float16* p ){ return _mm512_maskz_cvtph_ps( all_lanes, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) ) ); }
+
+   AFFINE_TARGET_AVX512 inline void storeu( float16* p, const __m512 v )
+  {
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(p), _mm512_maskz_cvtps_ph( all_lanes, v, _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC ) );
+  }
+
+   AFFINE_TARGET_AVX512 inline __m512 loadu( const bfloat16* p )
+  {
+      const __m512i u = _mm512_maskz_cvtepu16_epi32( all_lanes, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) ) );
+      return _mm512_castsi512_ps( _mm512_maskz_slli_epi32( all_lanes, u, 16 ) );
+  }
+
+   // as bfloat16_format::encode
+   AFFINE_TARGET_AVX512 inline void storeu( bfloat16* p, const __m512 v )
+  {
+      const __m512i u = _mm512_castps_si512(v);
+      const __m512i high = _mm512_maskz_srli_epi32( all_lanes, u, 16 );
+      const __m512i odd = _mm512_and_si512( high, _mm512_set1_epi32(1) );
+      const __m512i rounded = _mm512_maskz_srli_epi32( all_lanes, _mm512_add_epi32( _mm512_add_epi32( u, _mm512_set1_epi32(0x7fff) ), odd ), 16 );
+      const __m512i quiet = _mm512_or_si512( high, _mm512_set1_epi32(0x40) );
+      const __m512i h = _mm512_mask_mov_epi32( rounded, _mm512_cmp_ps_mask( v, v, _CMP_UNORD_Q ), quiet );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(p), _mm512_maskz_cvtepi32_epi16( all_lanes, h ) );
+  }
+
+   // computed in float, and the tail also uses fma so every element is rounded the same way
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX512 void axpy( const std::size_t n, const float a, const half_t* x, half_t* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, float(x[i]), float(y[i]) ); }
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX512 void scale( const std::size_t n, const float a, half_t* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, mul( va, loadu(y+i) ) ); }
+      scalar::scale( n-i, a, y+i );
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX512 void difference( const std::size_t n, const half_t* x, const half_t* y, half_t* z )
+  {
+      constexpr std::size_t w = width<float>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::difference( n-i, x+i, y+i, z+i );
+  }
+
+   AFFINE_TARGET_AVX512 inline void storeu( double* p, const __m512d v ){ _mm512_storeu_pd(p,v); }
+   AFFINE_TARGET_AVX512 inline void storeu( float*  p, const __m512  v ){ _mm512_storeu_ps(p,v); }
+
+   // double points and float deltas, 8 lanes, the deltas are widened on load and the differences rounded to float on store
+   AFFINE_TARGET_AVX512 inline __m512d widen( const float* p ){ return _mm512_maskz_cvtps_pd( __mmask8(0xff), _mm256_loadu_ps(p) ); }
+   AFFINE_TARGET_AVX512 inline void narrow( float* p, const __m512d v ){ _mm256_storeu_ps( p, _mm512_maskz_cvtpd_ps( __mmask8(0xff), v ) ); }
+
+   // the tail also uses fma, so every element is rounded the same way
+   AFFINE_TARGET_AVX512 inline void mixed_axpy( const std::size_t n, const double a, const float* x, double* y )
+  {
+      constexpr std::size_t w = width<double>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, widen(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, double(x[i]), y[i] ); }
+  }
+
+   AFFINE_TARGET_AVX512 inline void mixed_difference( const std::size_t n, const double* x, const double* y, float* z )
+  {
+      constexpr std::size_t w = width<double>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ narrow( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::mixed_difference( n-i, x+i, y+i, z+i );
+  }
+
+   // float points and 16 bit float deltas, with the conversions of the compressed kernels
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX512 void mixed_axpy( const std::size_t n, const float a, const half_t* x, float* y )
+  {
+      constexpr std::size_t w = width<float>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( va, loadu(x+i), loadu(y+i) ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( a, float(x[i]), y[i] ); }
+  }
+
+   template<compressed_floating_point half_t>
+   AFFINE_TARGET_AVX512 void mixed_difference( const std::size_t n, const float* x, const float* y, half_t* z )
+  {
+      constexpr std::size_t w = width<float>;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( z+i, sub( loadu(x+i), loadu(y+i) ) ); }
+      scalar::mixed_difference( n-i, x+i, y+i, z+i );
+  }
+
+   // 16 bit integer codes, widened to the lanes of the output type y on load, 16 for float and 8 for double
+   // 16 bit lanes cannot be masked without avx512bw, so the tails are scalar
+   AFFINE_TARGET_AVX512 inline __m512i widen_codes( const float*, const std::uint16_t* p ){ return _mm512_maskz_cvtepu16_epi32( all_lanes, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) ) ); }
+   AFFINE_TARGET_AVX512 inline __m512i widen_codes( const float*, const std::int16_t*  p ){ return _mm512_maskz_cvtepi16_epi32( all_lanes, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(p) ) ); }
+   AFFINE_TARGET_AVX512 inline __m256i widen_codes( const double*, const std::uint16_t* p ){ return _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) ); }
+   AFFINE_TARGET_AVX512 inline __m256i widen_codes( const double*, const std::int16_t*  p ){ return _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) ); }
+
+   AFFINE_TARGET_AVX512 inline __m512  to_lanes( const __m512i v ){ return _mm512_maskz_cvtepi32_ps( all_lanes, v ); }
+   AFFINE_TARGET_AVX512 inline __m512d to_lanes( const __m256i v ){ return _mm512_maskz_cvtepi32_pd( __mmask8(0xff), v ); }
+
+   // lanes already clamped to the range of the codes, so truncating to 16 bits is exact
+   template<quantized_code code_t>
+   AFFINE_TARGET_AVX512 void store_codes( code_t* p, const __m512 v )
+  {
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(p), _mm512_maskz_cvtepi32_epi16( all_lanes, _mm512_maskz_cvtps_epi32( all_lanes, v ) ) );
+  }
+
+   // 8 lanes are packed as in the avx2 kernels
+   template<quantized_code code_t>
+   AFFINE_TARGET_AVX512 void store_codes( code_t* p, const __m512d v )
+  {
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(p), avx2::pack_codes( p, _mm512_maskz_cvtpd_epi32( __mmask8(0xff), v ) ) );
+  }
+
+   // minps/maxps return the second operand if either is NaN, so NaN is ignored by bounds and clamped to lo, as in the scalar kernels
+   AFFINE_TARGET_AVX512 inline __m512d min( const __m512d a, const __m512d b ){ return _mm512_maskz_min_pd(__mmask8(0xff),a,b); }
+   AFFINE_TARGET_AVX512 inline __m512  min( const __m512  a, const __m512  b ){ return _mm512_maskz_min_ps(all_lanes,a,b); }
+   AFFINE_TARGET_AVX512 inline __m512d max( const __m512d a, const __m512d b ){ return _mm512_maskz_max_pd(__mmask8(0xff),a,b); }
+   AFFINE_TARGET_AVX512 inline __m512  max( const __m512  a, const __m512  b ){ return _mm512_maskz_max_ps(all_lanes,a,b); }
+
+   template<typename vector_t>
+   AFFINE_TARGET_AVX512 vector_t clamp( const vector_t v, const vector_t lo, const vector_t hi ){ return min( max(v,lo), hi ); }
+
+   // the tail also uses fma, so every element is rounded the same way
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_AVX512 void dequantize( const std::size_t n, const num_t offset, const num_t scale, const code_t* x, num_t* y )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(offset);
+      const auto vs = broadcast(scale);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ storeu( y+i, muladd( vs, to_lanes( widen_codes( y, x+i ) ), vo ) ); }
+      for( ; i<n; ++i ){ y[i]=std::fma( scale, static_cast<num_t>(x[i]), offset ); }
+  }
+
+   // rounded to nearest even by the conversion, as the scalar tail
+   template<typename num_t, quantized_code code_t>
+   AFFINE_TARGET_AVX512 void quantize( const std::size_t n, const num_t offset, const num_t inverse_scale, const num_t* y, code_t* x )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(offset);
+      const auto vi = broadcast(inverse_scale);
+      const auto lo = broadcast( static_cast<num_t>( std::numeric_limits<code_t>::min() ) );
+      const auto hi = broadcast( static_cast<num_t>( std::numeric_limits<code_t>::max() ) );
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w ){ store_codes( x+i, clamp( mul( sub( loadu(y+i), vo ), vi ), lo, hi ) ); }
+      scalar::quantize( n-i, offset, inverse_scale, y+i, x+i );
+  }
+
+   // one running bound per lane, the lanes are reduced at the end
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void bounds( const std::size_t n, const num_t* x, num_t* lo, num_t* hi )
+  {
+      constexpr std::size_t w = width<num_t>;
+      auto vlo = broadcast(*lo);
+      auto vhi = broadcast(*hi);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         const auto v = loadu(x+i);
+         vlo = min( v, vlo );
+         vhi = max( v, vhi );
+     }
+      alignas(64) num_t lows[w];
+      alignas(64) num_t highs[w];
+      store( lows, vlo );
+      store( highs, vhi );
+      for( std::size_t j=0; j<w; ++j )
+     {
+         *lo = lows[j]<*lo ? lows[j] : *lo;
+         *hi = highs[j]>*hi ? highs[j] : *hi;
+     }
+      scalar::bounds( n-i, x+i, lo, hi );
+  }
+
+   // branch free neumaier_add, the lanes of s are larger in magnitude where s_larger is set
+   AFFINE_TARGET_AVX512 inline __m512d abs( const __m512d v ){ return _mm512_abs_pd(v); }
+   AFFINE_TARGET_AVX512 inline __m512  abs( const __m512  v ){ return _mm512_abs_ps(v); }
+
+   AFFINE_TARGET_AVX512 inline __mmask8  not_less( const __m512d a, const __m512d b ){ return _mm512_cmp_pd_mask(a,b,_CMP_GE_OQ); }
+   AFFINE_TARGET_AVX512 inline __mmask16 not_less( const __m512  a, const __m512  b ){ return _mm512_cmp_ps_mask(a,b,_CMP_GE_OQ); }
+
+   AFFINE_TARGET_AVX512 inline __m512d select( const __mmask8  m, const __m512d a, const __m512d b ){ return _mm512_mask_blend_pd(m,b,a); }
+   AFFINE_TARGET_AVX512 inline __m512  select( const __mmask16 m, const __m512  a, const __m512  b ){ return _mm512_mask_blend_ps(m,b,a); }
+
+   // a*x-y rounded once
+   AFFINE_TARGET_AVX512 inline __m512d mulsub( const __m512d a, const __m512d x, const __m512d y ){ return _mm512_fmsub_pd(a,x,y); }
+   AFFINE_TARGET_AVX512 inline __m512  mulsub( const __m512  a, const __m512  x, const __m512  y ){ return _mm512_fmsub_ps(a,x,y); }
+
+   template<typename vector_t>
+   AFFINE_TARGET_AVX512 void neumaier_add( vector_t& s, vector_t& c, const vector_t v )
+  {
+      const vector_t t = add(s,v);
+      const auto s_larger = not_less( abs(s), abs(v) );
+      c = add( c, add( sub( select(s_larger,s,v), t ), select(s_larger,v,s) ) );
+      s = t;
+  }
+
+   // coordinates of x in the lanes of y, double lanes of float x are widened
+   AFFINE_TARGET_AVX512 inline __m512d load_lanes( const double*, const double* p ){ return loadu(p); }
+   AFFINE_TARGET_AVX512 inline __m512  load_lanes( const float*,  const float*  p ){ return loadu(p); }
+   AFFINE_TARGET_AVX512 inline __m512d load_lanes( const double*, const float*  p ){ return widen(p); }
+
+   // the same operations as the scalar kernel, which also does the tail, so the result is identical for every instruction set
+   template<typename num_t, typename dnum_t>
+   AFFINE_TARGET_AVX512 void compensated_axpy( const std::size_t n, const num_t a, const dnum_t* x, num_t* y, num_t* c )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto va = broadcast(a);
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         const auto vx = load_lanes( y, x+i );
+         const auto v = mul( va, vx );
+         auto vy = loadu(y+i);
+         auto vc = loadu(c+i);
+         neumaier_add( vy, vc, v );
+         storeu( y+i, vy );
+         storeu( c+i, add( vc, mulsub( va, vx, v ) ) );
+     }
+      scalar::compensated_axpy( n-i, a, x+i, y+i, c+i );
+  }
+
+   // one running sum and compensation per lane, the lanes are accumulated in order at the end
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void compensated_sum( const std::size_t n, const num_t origin, const num_t* x, num_t* s, num_t* c )
+  {
+      constexpr std::size_t w = width<num_t>;
+      const auto vo = broadcast(-origin);
+      const auto zero = broadcast( num_t(0) );
+      auto vs = zero;
+      auto vc = zero;
+      std::size_t i=0;
+      for( ; i+w<=n; i+=w )
+     {
+         auto d = loadu(x+i);
+         auto e = zero;
+         neumaier_add( d, e, vo );
+         neumaier_add( vs, vc, d );
+         vc = add( vc, e );
+     }
+      alignas(64) num_t sums[w];
+      alignas(64) num_t errors[w];
+      store( sums, vs );
+      store( errors, vc );
+      for( std::size_t j=0; j<w; ++j )
+     {
+         detail::neumaier_add( *s, *c, sums[j] );
+         *c = *c+errors[j];
+     }
+      scalar::compensated_sum( n-i, origin, x+i, s, c );
+  }
+
+   // lanes p[0], p[step], ..., gathered unless contiguous
+   AFFINE_TARGET_AVX512 inline __m512d load_strided( const double* p, const std::size_t step )
+  {
+      if( step==1 ){ return _mm512_loadu_pd(p); }
+      const __m256i lanes = _mm256_mullo_epi32( _mm256_setr_epi32(0,1,2,3,4,5,6,7), _mm256_set1_epi32( static_cast<int>(step) ) );
+      return _mm512_mask_i32gather_pd( _mm512_setzero_pd(), 0xff, lanes, p, 8 );
+  }
+
+   AFFINE_TARGET_AVX512 inline __m512 load_strided( const float* p, const std::size_t step )
+  {
+      if( step==1 ){ return _mm512_loadu_ps(p); }
+      const __m512i lanes = _mm512_mullo_epi32( _mm512_setr_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15), _mm512_set1_epi32( static_cast<int>(step) ) );
+      return _mm512_mask_i32gather_ps( _mm512_setzero_ps(), 0xffff, lanes, p, 4 );
+  }
+
+   // 14 bit estimates
+   AFFINE_TARGET_AVX512 inline __m512  rsqrt_estimate( const __m512  x ){ return _mm512_maskz_rsqrt14_ps(0xffff,x); }
+   AFFINE_TARGET_AVX512 inline __m512d rsqrt_estimate( const __m512d x ){ return _mm512_maskz_rsqrt14_pd(0xff,x); }
+
+   template<typename num_t>
+   constexpr std::size_t newton_steps = std::same_as<num_t,float> ? 1 : 2;
+
+   // lanes along the elements, scalar tail
+   template<bool centred, typename num_t>
+   AFFINE_TARGET_AVX512 void sum_squares( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride,
+                            [[maybe_unused]] const num_t* q, num_t* out )
+  {
+      std::size_t k=0;
+      for( ; k+width<num_t><=n; k+=width<num_t> )
+     {
+         const num_t* xk = x+k*step;
+         auto acc = broadcast( num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            auto v = load_strided( xk+c*stride, step );
+            if constexpr( centred ){ v = sub( v, broadcast(q[c]) ); }
+            acc = muladd( v, v, acc );
+        }
+         storeu( out+k, acc );
+     }
+
+      for( ; k<n; ++k )
+     {
+         num_t sum(0);
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            num_t v = x[k*step+c*stride];
+            if constexpr( centred ){ v-=q[c]; }
+            sum = std::fma(v,v,sum);
+        }
+         out[k]=sum;
+     }
+  }
+
+   // estimate refined by newton iterations r <- r*(3/2 - x/2*r*r)
+   template<typename num_t, typename vector_t>
+   AFFINE_TARGET_AVX512 inline vector_t refine_rsqrt( const vector_t x )
+  {
+      const auto h = mul( broadcast( num_t(0.5) ), x );
+      const auto three_halves = broadcast( num_t(1.5) );
+      auto r = rsqrt_estimate(x);
+      for( std::size_t s=0; s<newton_steps<num_t>; ++s ){ r = mul( r, sub( three_halves, mul( h, mul(r,r) ) ) ); }
+      return r;
+  }
+
+   // the tail is padded so that every element is rounded the same way
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void rsqrt( const std::size_t n, const num_t* x, num_t* y )
+  {
+      std::size_t i=0;
+      for( ; i+width<num_t><=n; i+=width<num_t> ){ storeu( y+i, refine_rsqrt<num_t>( loadu(x+i) ) ); }
+
+      if( i<n )
+     {
+         std::array<num_t,width<num_t>> tail;
+         tail.fill( num_t(1) );
+         std::copy( x+i, x+n, tail.begin() );
+         storeu( tail.data(), refine_rsqrt<num_t>( loadu(tail.data()) ) );
+         std::copy_n( tail.begin(), n-i, y+i );
+     }
+  }
+
+   // t[i*nb+j] = Σ_c (a[c*na+i]-b[c*nb+j])², see scalar::distance_block
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void distance_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                               const num_t* a, const num_t* b, num_t* t )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  const auto v0 = sub( ar, b0 );
+                  const auto v1 = sub( ar, b1 );
+                  acc[r][0] = muladd( v0, v0, acc[r][0] );
+                  acc[r][1] = muladd( v1, v1, acc[r][1] );
+              }
+           }
+
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               storeu( t+(i+r)*nb+j,   acc[r][0] );
+               storeu( t+(i+r)*nb+j+w, acc[r][1] );
+           }
+        }
+     }
+  }
+
+   // y_r[k] = t[r] + Σ_c a[r*ncols+c]*x_c[k], two vectors of elements at a time with the matrix held in registers, see scalar::matrix_apply
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   AFFINE_TARGET_AVX512 void matrix_apply( const std::size_t n, const num_t* a, const num_t* t,
+                             const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      vector_t va[nrows][ncols], vt[nrows];
+      for( std::size_t r=0; r<nrows; ++r )
+     {
+         vt[r] = broadcast( t ? t[r] : num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c ){ va[r][c] = broadcast( a[r*ncols+c] ); }
+     }
+
+      std::size_t k=0;
+      for( ; k+2*w<=n; k+=2*w )
+     {
+         vector_t x0[ncols], x1[ncols];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            x0[c] = loadu( x+c*xs+k );
+            x1[c] = loadu( x+c*xs+k+w );
+        }
+         for( std::size_t r=0; r<nrows; ++r )
+        {
+            vector_t y0 = vt[r], y1 = vt[r];
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               y0 = muladd( va[r][c], x0[c], y0 );
+               y1 = muladd( va[r][c], x1[c], y1 );
+           }
+            storeu( y+r*ys+k,   y0 );
+            storeu( y+r*ys+k+w, y1 );
+        }
+     }
+
+      // the tail is padded so that every element is rounded the same way
+      if( k<n )
+     {
+         num_t xt[ncols][2*w], yt[nrows][2*w];
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            std::fill( xt[c], xt[c]+2*w, num_t(0) );
+            std::copy( x+c*xs+k, x+c*xs+n, xt[c] );
+        }
+         matrix_apply<nrows,ncols>( 2*w, a, t, &xt[0][0], 2*w, &yt[0][0], 2*w );
+         for( std::size_t r=0; r<nrows; ++r ){ std::copy_n( yt[r], n-k, y+r*ys+k ); }
+     }
+  }
+
+   // lane c of each group of four lanes, broadcast across its group
+   template<int c> AFFINE_TARGET_AVX512 inline __m512d spread( const __m512d v ){ return _mm512_mask_permutex_pd(v,0xff,v,c*0x55); }
+   template<int c> AFFINE_TARGET_AVX512 inline __m512  spread( const __m512  v ){ return _mm512_shuffle_ps(v,v,c*0x55); }
+
+   // y[4k+r] = Σ_c a[r*4+c]*x[4k+c], with the columns of a held in registers and full width loads and stores, see scalar::homogeneous_apply
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void homogeneous_apply( const std::size_t n, const num_t* a, const num_t* x, num_t* y )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+
+      // column c of a, repeated for each element in a vector
+      constexpr std::size_t e = w/4;
+      num_t lanes[4][w];
+      for( std::size_t c=0; c<4; ++c )
+     {
+         for( std::size_t l=0; l<w; ++l ){ lanes[c][l]=a[(l%4)*4+c]; }
+     }
+      const vector_t a0 = loadu( lanes[0] ), a1 = loadu( lanes[1] ), a2 = loadu( lanes[2] ), a3 = loadu( lanes[3] );
+
+      std::size_t k=0;
+      for( ; k+e<=n; k+=e )
+     {
+         const vector_t v = loadu( x+4*k );
+         vector_t r = mul( a0, spread<0>(v) );
+         r = muladd( a1, spread<1>(v), r );
+         r = muladd( a2, spread<2>(v), r );
+         r = muladd( a3, spread<3>(v), r );
+         storeu( y+4*k, r );
+     }
+
+      // the tail is padded so that every element is rounded the same way
+      if( k<n )
+     {
+         num_t xt[w]={}, yt[w];
+         std::copy( x+4*k, x+4*n, xt );
+         homogeneous_apply( e, a, xt, yt );
+         std::copy( yt, yt+4*(n-k), y+4*k );
+     }
+  }
+
+   // some lane of a is less than the same lane of b
+   AFFINE_TARGET_AVX512 inline bool any_less( const __m512d a, const __m512d b ){ return _mm512_cmp_pd_mask(a,b,_CMP_LT_OQ)!=0; }
+   AFFINE_TARGET_AVX512 inline bool any_less( const __m512  a, const __m512  b ){ return _mm512_cmp_ps_mask(a,b,_CMP_LT_OQ)!=0; }
+
+   // t[i*nb+j] = a2[i]+b2[j]-2 Σ_c a[c*na+i]*b[c*nb+j], with a 4x2 block of vector accumulators, see scalar::gram_block
+   template<typename num_t>
+   AFFINE_TARGET_AVX512 void gram_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                           const num_t* a, const num_t* a2, const num_t* b, const num_t* b2, const num_t ratio,
+                           num_t* t, std::uint8_t* cancelled )
+  {
+      using vector_t = decltype( broadcast( num_t(0) ) );
+      constexpr std::size_t w = width<num_t>;
+      const vector_t minus_two = broadcast( num_t(-2) );
+      const vector_t threshold = broadcast( ratio );
+      const std::size_t blocks = nb/gram_columns<num_t>;
+
+      for( std::size_t i=0; i<na; i+=gram_rows )
+     {
+         for( std::size_t j=0; j<nb; j+=2*w )
+        {
+            vector_t acc[gram_rows][2];
+            for( auto& row : acc ){ row[0] = row[1] = broadcast( num_t(0) ); }
+
+            for( std::size_t c=0; c<ncols; ++c )
+           {
+               const auto b0 = loadu( b+c*nb+j );
+               const auto b1 = loadu( b+c*nb+j+w );
+               for( std::size_t r=0; r<gram_rows; ++r )
+              {
+                  const auto ar = broadcast( a[c*na+i+r] );
+                  acc[r][0] = muladd( ar, b0, acc[r][0] );
+                  acc[r][1] = muladd( ar, b1, acc[r][1] );
+              }
+           }
+
+            const auto s0 = loadu( b2+j );
+            const auto s1 = loadu( b2+j+w );
+            for( std::size_t r=0; r<gram_rows; ++r )
+           {
+               const auto ar = broadcast( a2[i+r] );
+               const auto n0 = add( ar, s0 );
+               const auto n1 = add( ar, s1 );
+               const auto d0 = muladd( minus_two, acc[r][0], n0 );
+               const auto d1 = muladd( minus_two, acc[r][1], n1 );
+               storeu( t+(i+r)*nb+j,   d0 );
+               storeu( t+(i+r)*nb+j+w, d1 );
+               if( any_less( d0, mul(threshold,n0) ) || any_less( d1, mul(threshold,n1) ) ){ cancelled[(i+r)*blocks+j/gram_columns<num_t>]=1; }
+           }
+        }
+     }
+  }
+}
+
+# endif
+
+/*
+ * dispatch the flat kernels to the selected instruction set
+ */
+
+   // number types with vector axpy, scale and difference kernels, others use the scalar loops
+   template<typename num_t>
+   concept vector_arithmetic =
+      std::same_as<num_t,float> || std::same_as<num_t,double> || std::same_as<num_t,std::int32_t> || compressed_floating_point<num_t>;
+
+   template<typename num_t>
+   void flat_axpy( const std::size_t n, const compute_t<num_t> a, const num_t* x, num_t* y )
+  {
+      if constexpr( !vector_arithmetic<num_t> ){ scalar::axpy(n,a,x,y); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::axpy(n,a,x,y); return;
+         case isa::avx2:   avx2::axpy(n,a,x,y);   return;
+         case isa::sse2:   sse2::axpy(n,a,x,y);   return;
+# endif
+         default:          scalar::axpy(n,a,x,y); return;
+     }
+  }
+
+   template<typename num_t>
+   void flat_scale( const std::size_t n, const compute_t<num_t> a, num_t* y )
+  {
+      if constexpr( !vector_arithmetic<num_t> ){ scalar::scale(n,a,y); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::scale(n,a,y); return;
+         case isa::avx2:   avx2::scale(n,a,y);   return;
+         case isa::sse2:   sse2::scale(n,a,y);   return;
+# endif
+         default:          scalar::scale(n,a,y); return;
+     }
+  }
+
+   template<typename num_t>
+   void flat_difference( const std::size_t n, const num_t* x, const num_t* y, num_t* z )
+  {
+      if constexpr( !vector_arithmetic<num_t> ){ scalar::difference(n,x,y,z); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::difference(n,x,y,z); return;
+         case isa::avx2:   avx2::difference(n,x,y,z);   return;
+         case isa::sse2:   sse2::difference(n,x,y,z);   return;
+# endif
+         default:          scalar::difference(n,x,y,z); return;
+     }
+  }
+
+   // point coordinates num_t and delta coordinates dnum_t with vector kernels, double with float or float with 16 bit floats
+   template<typename num_t, typename dnum_t>
+   concept vector_mixed_arithmetic =
+      ( std::same_as<num_t,double> && std::same_as<dnum_t,float> )
+   || ( std::same_as<num_t,float>  && compressed_floating_point<dnum_t> );
+
+   // other pairs of number types use the scalar loops
+   template<typename num_t, typename dnum_t>
+   void flat_mixed_axpy( const std::size_t n, const std::common_type_t<num_t,dnum_t> a, const dnum_t* x, num_t* y )
+  {
+      if constexpr( !vector_mixed_arithmetic<num_t,dnum_t> ){ scalar::mixed_axpy(n,a,x,y); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::mixed_axpy(n,a,x,y); return;
+         case isa::avx2:   avx2::mixed_axpy(n,a,x,y);   return;
+         case isa::sse2:   sse2::mixed_axpy(n,a,x,y);   return;
+# endif
+         default:          scalar::mixed_axpy(n,a,x,y); return;
+     }
+  }
+
+   template<typename num_t, typename dnum_t>
+   void flat_mixed_difference( const std::size_t n, const num_t* x, const num_t* y, dnum_t* z )
+  {
+      if constexpr( !vector_mixed_arithmetic<num_t,dnum_t> ){ scalar::mixed_difference(n,x,y,z); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::mixed_difference(n,x,y,z); return;
+         case isa::avx2:   avx2::mixed_difference(n,x,y,z);   return;
+         case isa::sse2:   sse2::mixed_difference(n,x,y,z);   return;
+# endif
+         default:          scalar::mixed_difference(n,x,y,z); return;
+     }
+  }
+
+   // y = offset+scale*x for 16 bit integer codes x, float and double have vector kernels
+   template<typename num_t, quantized_code code_t>
+   void flat_dequantize( const std::size_t n, const num_t offset, const num_t scale, const code_t* x, num_t* y )
+  {
+      if constexpr( !( std::same_as<num_t,float> || std::same_as<num_t,double> ) ){ scalar::dequantize(n,offset,scale,x,y); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::dequantize(n,offset,scale,x,y); return;
+         case isa::avx2:   avx2::dequantize(n,offset,scale,x,y);   return;
+         case isa::sse2:   sse2::dequantize(n,offset,scale,x,y);   return;
+# endif
+         default:          scalar::dequantize(n,offset,scale,x,y); return;
+     }
+  }
+
+   // x = nearest code to (y-offset)*inverse_scale, clamped to the range of code_t, identical for every instruction set
+   template<typename num_t, quantized_code code_t>
+   void flat_quantize( const std::size_t n, const num_t offset, const num_t inverse_scale, const num_t* y, code_t* x )
+  {
+      if constexpr( !( std::same_as<num_t,float> || std::same_as<num_t,double> ) ){ scalar::quantize(n,offset,inverse_scale,y,x); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::quantize(n,offset,inverse_scale,y,x); return;
+         case isa::avx2:   avx2::quantize(n,offset,inverse_scale,y,x);   return;
+         case isa::sse2:   sse2::quantize(n,offset,inverse_scale,y,x);   return;
+# endif
+         default:          scalar::quantize(n,offset,inverse_scale,y,x); return;
+     }
+  }
+
+   // lo = min(lo,x[i]), hi = max(hi,x[i]) over x[0..n), NaN is ignored unless lo or hi is NaN
+   template<typename num_t>
+   void flat_bounds( const std::size_t n, const num_t* x, num_t* lo, num_t* hi )
+  {
+      if constexpr( !( std::same_as<num_t,float> || std::same_as<num_t,double> ) ){ scalar::bounds(n,x,lo,hi); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::bounds(n,x,lo,hi); return;
+         case isa::avx2:   avx2::bounds(n,x,lo,hi);   return;
+         case isa::sse2:   sse2::bounds(n,x,lo,hi);   return;
+# endif
+         default:          scalar::bounds(n,x,lo,hi); return;
+     }
+  }
+
+   // coordinates num_t and dnum_t of the compensated kernels with vector loops, float, double, or double with float
+   template<typename num_t, typename dnum_t>
+   concept vector_compensated_arithmetic =
+      ( std::same_as<num_t,float> || std::same_as<num_t,double> )
+   && ( std::same_as<num_t,dnum_t> || std::same_as<dnum_t,float> );
+
+   // y += a*x with the rounding errors added to c, identical for every instruction set
+   template<std::floating_point num_t, typename dnum_t>
+   void flat_compensated_axpy( const std::size_t n, const num_t a, const dnum_t* x, num_t* y, num_t* c )
+  {
+      if constexpr( !vector_compensated_arithmetic<num_t,dnum_t> ){ scalar::compensated_axpy(n,a,x,y,c); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::compensated_axpy(n,a,x,y,c); return;
+         case isa::avx2:   avx2::compensated_axpy(n,a,x,y,c);   return;
+         case isa::sse2:   sse2::compensated_axpy(n,a,x,y,c);   return;
+# endif
+         default:          scalar::compensated_axpy(n,a,x,y,c); return;
+     }
+  }
+
+   // s+c += Σ (x[i]-origin), the order of the additions depends on the instruction set
+   template<std::floating_point num_t>
+   void flat_compensated_sum( const std::size_t n, const num_t origin, const num_t* x, num_t* s, num_t* c )
+  {
+      if constexpr( !vector_compensated_arithmetic<num_t,num_t> ){ scalar::compensated_sum(n,origin,x,s,c); return; }
+      else switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::compensated_sum(n,origin,x,s,c); return;
+         case isa::avx2:   avx2::compensated_sum(n,origin,x,s,c);   return;
+         case isa::sse2:   sse2::compensated_sum(n,origin,x,s,c);   return;
+# endif
+         default:          scalar::compensated_sum(n,origin,x,s,c); return;
+     }
+  }
+
+   // out[k] = |x_k|², with element k, coordinate c at x[k*step+c*stride]
+   template<typename num_t>
+   void flat_norm2( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride, num_t* out )
+  {
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::sum_squares<false>(n,ncols,x,step,stride,x,out); return;
+         case isa::avx2:   avx2::sum_squares<false>(n,ncols,x,step,stride,x,out);   return;
+         case isa::sse2:   sse2::sum_squares<false>(n,ncols,x,step,stride,x,out);   return;
+# endif
+         default:          scalar::sum_squares<false>(n,ncols,x,step,stride,x,out); return;
+     }
+  }
+
+   // out[k] = |x_k-q|²
+   template<typename num_t>
+   void flat_distance2( const std::size_t n, const std::size_t ncols, const num_t* x, const std::size_t step, const std::size_t stride, const num_t* q, num_t* out )
+  {
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::sum_squares<true>(n,ncols,x,step,stride,q,out); return;
+         case isa::avx2:   avx2::sum_squares<true>(n,ncols,x,step,stride,q,out);   return;
+         case isa::sse2:   sse2::sum_squares<true>(n,ncols,x,step,stride,q,out);   return;
+# endif
+         default:          scalar::sum_squares<true>(n,ncols,x,step,stride,q,out); return;
+     }
+  }
+
+   // y[i] = 1/sqrt(x[i])
+   template<typename num_t>
+   void flat_rsqrt( const std::size_t n, const num_t* x, num_t* y )
+  {
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::rsqrt(n,x,y); return;
+         case isa::avx2:   avx2::rsqrt(n,x,y);   return;
+         case isa::sse2:   sse2::rsqrt(n,x,y);   return;
+# endif
+         default:          scalar::rsqrt(n,x,y); return;
+     }
+  }
+
+   // x /= |x| for one element whose squared length underflows or overflows, by first dividing by the largest coordinate
+   template<typename num_t>
+   void normalize_rescaled( const std::size_t ncols, num_t* x, const std::size_t stride )
+  {
+      num_t big(0);
+      for( std::size_t c=0; c<ncols; ++c ){ big = std::max( big, std::abs( x[c*stride] ) ); }
+      if( !( big>num_t(0) ) ){ return; }
+
+      num_t sum(0);
+      for( std::size_t c=0; c<ncols; ++c ){ x[c*stride]/=big; sum+=x[c*stride]*x[c*stride]; }
+
+      const num_t s = num_t(1)/std::sqrt(sum);
+      for( std::size_t c=0; c<ncols; ++c ){ x[c*stride]*=s; }
+  }
+
+   // x_k /= |x_k|, in blocks so that the norms stay in cache, zero elements are left zero
+   //    the vector estimates are wrong for subnormal or infinite |x_k|², and lose precision when r*r is subnormal, so those elements are rescaled
+   template<typename num_t>
+   void flat_normalize( const std::size_t n, const std::size_t ncols, num_t* x, const std::size_t step, const std::size_t stride )
+  {
+      constexpr std::size_t block = 256;
+      constexpr num_t lowest  = std::numeric_limits<num_t>::min();
+      constexpr num_t highest = num_t(1)/std::numeric_limits<num_t>::min();
+      std::array<num_t,block> length2, inverse;
+
+      for( std::size_t b=0; b<n; b+=block )
+     {
+         const std::size_t m = std::min( block, n-b );
+         num_t* xb = x+b*step;
+
+         flat_norm2( m, ncols, xb, step, stride, length2.data() );
+         flat_rsqrt( m, length2.data(), inverse.data() );
+
+         for( std::size_t k=0; k<m; ++k )
+        {
+            if( length2[k]>=lowest && length2[k]<=highest )
+           {
+               for( std::size_t c=0; c<ncols; ++c ){ xb[k*step+c*stride]*=inverse[k]; }
+           }
+            else if( !std::isnan( length2[k] ) )
+           {
+               normalize_rescaled( ncols, xb+k*step, stride );
+           }
+            else
+           {
+               for( std::size_t c=0; c<ncols; ++c ){ xb[k*step+c*stride]*=num_t(0); }
+           }
+        }
+     }
+  }
+
+   // matrix-vector products of n elements stored in columns, see scalar::matrix_apply
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   void flat_matrix_apply( const std::size_t n, const num_t* a, const num_t* t,
+                           const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::matrix_apply<nrows,ncols>(n,a,t,x,xs,y,ys); return;
+         case isa::avx2:   avx2::matrix_apply<nrows,ncols>(n,a,t,x,xs,y,ys);   return;
+         case isa::sse2:   sse2::matrix_apply<nrows,ncols>(n,a,t,x,xs,y,ys);   return;
+# endif
+         default:          scalar::matrix_apply<nrows,ncols>(n,a,t,x,xs,y,ys); return;
+     }
+  }
+
+   // 4x4 matrix-vector products of n elements of 4 interleaved lanes, see scalar::homogeneous_apply
+   template<typename num_t>
+   void flat_homogeneous_apply( const std::size_t n, const num_t* a, const num_t* x, num_t* y )
+  {
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::homogeneous_apply(n,a,x,y); return;
+         case isa::avx2:   avx2::homogeneous_apply(n,a,x,y);   return;
+         case isa::sse2:   sse2::homogeneous_apply(n,a,x,y);   return;
+# endif
+         default:          scalar::homogeneous_apply(n,a,x,y); return;
+     }
+  }
+
+   // pairwise squared distances of a block of packed elements, see scalar::distance_block
+   template<typename num_t>
+   void flat_distance_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                             const num_t* a, const num_t* b, num_t* t )
+  {
+      assert( na%gram_rows==0 && nb%gram_columns<num_t> ==0 );
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::distance_block(na,nb,ncols,a,b,t); return;
+         case isa::avx2:   avx2::distance_block(na,nb,ncols,a,b,t);   return;
+         case isa::sse2:   sse2::distance_block(na,nb,ncols,a,b,t);   return;
+# endif
+         default:          scalar::distance_block(na,nb,ncols,a,b,t); return;
+     }
+  }
+
+   // pairwise squared distances of a block of packed elements, as a matrix product, see scalar::gram_block
+   template<typename num_t>
+   void flat_gram_block( const std::size_t na, const std::size_t nb, const std::size_t ncols,
+                         const num_t* a, const num_t* a2, const num_t* b, const num_t* b2, const num_t ratio,
+                         num_t* t, std::uint8_t* cancelled )
+  {
+      assert( na%gram_rows==0 && nb%gram_columns<num_t> ==0 );
+      switch( kernel_isa() )
+     {
+# if defined(AFFINE_X86_DISPATCH)
+         case isa::avx512: avx512::gram_block(na,nb,ncols,a,a2,b,b2,ratio,t,cancelled); return;
+         case isa::avx2:   avx2::gram_block(na,nb,ncols,a,a2,b,b2,ratio,t,cancelled);   return;
+         case isa::sse2:   sse2::gram_block(na,nb,ncols,a,a2,b,b2,ratio,t,cancelled);   return;
+# endif
+         default:          scalar::gram_block(na,nb,ncols,a,a2,b,b2,ratio,t,cancelled); return;
+     }
+  }
+
+/*
+ * T is stored as a contiguous array of float or double, so a span of T is a flat array of coordinates
+ */
+   template<typename T>
+   concept flat_layout =
+      !T::dynamic
+   && ( std::same_as<typename T::value_type,float> || std::same_as<typename T::value_type,double> )
+   && std::is_standard_layout_v<T>
+   && sizeof(T)==column_count<T>()*sizeof(typename T::value_type);
+
+/*
+ * T is a 3D point or delta of float or double stored with homogeneous_storage, so a span of T is a flat array of groups of 4 lanes
+ */
+   template<typename T>
+   concept homogeneous_layout =
+      !T::dynamic && T::vector_valued
+   && T::size()==3
+   && ( std::same_as<typename T::value_type,float> || std::same_as<typename T::value_type,double> )
+   && std::same_as<typename T::element_type,homogeneous_array<typename T::value_type,3,std::same_as<std::remove_const_t<T>,typename T::point_type>>>
+   && std::is_standard_layout_v<T>
+   && sizeof(T)==4*sizeof(typename T::value_type);
+
+/*
+ * T is stored as a contiguous array of int32, which the span kernels process with integer vector instructions
+ */
+   template<typename T>
+   concept flat_int32_layout =
+      !T::dynamic
+   && std::same_as<typename T::value_type,std::int32_t>
+   && std::is_standard_layout_v<T>
+   && sizeof(T)==column_count<T>()*sizeof(std::int32_t);
+
+/*
+ * T is stored as a contiguous array of 16 bit floats, which the span kernels widen to float
+ */
+   template<typename T>
+   concept flat_compressed_layout =
+      !T::dynamic
+   && compressed_floating_point<typename T::value_type>
+   && std::is_standard_layout_v<T>
+   && sizeof(T)==column_count<T>()*sizeof(typename T::value_type);
+
+/*
+ * spans of T and U can be processed as flat arrays of the same number type by axpy, scale and difference
+ */
+   template<typename T, typename U=T>
+   concept flat_arithmetic =
+      std::same_as<typename T::value_type,typename U::value_type>
+   && (    ( flat_layout<T>            && flat_layout<U> )
+        || ( flat_int32_layout<T>      && flat_int32_layout<U> )
+        || ( flat_compressed_layout<T> && flat_compressed_layout<U> ) );
+
+/*
+ * spans of points T and deltas U with different number types can be processed as flat arrays by advance and difference
+ */
+   template<typename T, typename U>
+   concept flat_mixed_arithmetic =
+      !std::same_as<typename T::value_type,typename U::value_type>
+   && column_count<T>()==column_count<U>()
+   && flat_layout<T> && ( flat_layout<U> || flat_compressed_layout<U> );
+
+/*
+ * the norm2, distance2 and normalize kernels apply to T: its coordinates are float or double, the same as those of its deltas,
+ * and its default metric is euclidean. Spans of T also need flat_layout<T>, the columns of point_array/delta_array do not
+ */
+   template<typename T>
+   concept flat_metric =
+      ( std::same_as<typename T::value_type,float> || std::same_as<typename T::value_type,double> )
+   && std::same_as<typename T::value_type,typename T::delta_type::value_type>
+   && std::same_as<default_metric<typename T::delta_type>,euclidean_metric>;
+
+   template<typename T>
+   [[nodiscard]]
+   auto* flat_data( const std::span<T> s )
+  {
+      using num_t = std::conditional_t<std::is_const_v<T>,
+                                       const typename T::value_type,
+                                             typename T::value_type>;
+      return reinterpret_cast<num_t*>(s.data());
+  }
+}
+
+// --------------- span kernels ---------------
+
+   // y += a*x
+   template<typename delta_t>
+      requires std::same_as<delta_t,typename delta_t::delta_type>
+   void axpy( const scale_factor<typename delta_t::value_type> auto a,
+              const std::span<const std::type_identity_t<delta_t>> x,
+              const std::span<delta_t> y )
+  {
+      assert( x.size()==y.size() );
+      using num_t = typename delta_t::value_type;
+      if constexpr( detail::flat_arithmetic<delta_t> )
+     {
+         detail::flat_axpy( y.size()*detail::column_count<delta_t>(), detail::compute_t<num_t>(a), detail::flat_data(x), detail::flat_data(y) );
+     }
+      else
+     {
+         for( std::size_t i=0; i<y.size(); ++i ){ y[i]+=a*x[i]; }
+     }
+  }
+
+   // p += a*d
+   template<typename point_t>
+      requires std::same_as<point_t,typename point_t::point_type>
+   void advance( const std::span<point_t> points,
+                 const scale_factor<typename point_t::delta_type::value_type> auto a,
+                 const std::span<const typename point_t::delta_type> deltas )
+  {
+      assert( points.size()==deltas.size() );
+      using delta_t = typename point_t::delta_type;
+      using num_t = typename point_t::value_type;
+      if constexpr( detail::flat_arithmetic<point_t,delta_t> )
+     {
+         detail::flat_axpy( points.size()*detail::column_count<point_t>(), detail::compute_t<num_t>(a), detail::flat_data(deltas), detail::flat_data(points) );
+     }
+      else if constexpr( detail::flat_mixed_arithmetic<point_t,delta_t> )
+     {
+         using common_t = std::common_type_t<num_t,typename delta_t::value_type>;
+         detail::flat_mixed_axpy( points.size()*detail::column_count<point_t>(), static_cast<common_t>(a), detail::flat_data(deltas), detail::flat_data(points) );
+     }
+      else
+     {
+         for( std::size_t i=0; i<points.size(); ++i ){ points[i]+=a*deltas[i]; }
+     }
+  }
+
+   // d *= a
+   template<typename delta_t>
+      requires std::same_as<delta_t,typename delta_t::delta_type>
+   void scale( const scale_factor<typename delta_t::value_type> auto a,
+               const std::span<delta_t> deltas )
+  {
+      using num_t = typename delta_t::value_type;
+      if constexpr( detail::flat_arithmetic<delta_t> )
+     {
+         detail::flat_scale( deltas.size()*detail::column_count<delta_t>(), detail::compute_t<num_t>(a), detail::flat_data(deltas) );
+     }
+      else
+     {
+         for( auto& d : deltas ){ d*=a; }
+     }
+  }
+
+   // d = p-q
+   template<typename delta_t>
+      requires std::same_as<delta_t,typename delta_t::delta_type>
+   void difference( const std::span<const typename delta_t::point_type> points_a,
+                    const std::span<const typename delta_t::point_type> points_b,
+                    const std::span<delta_t> deltas )
+  {
+      assert( points_a.size()==points_b.size() && points_a.size()==deltas.size() );
+      using point_t = typename delta_t::point_type;
+      if constexpr( detail::flat_arithmetic<point_t,delta_t> )
+     {
+         detail::flat_difference( deltas.size()*detail::column_count<point_t>(), detail::flat_data(points_a), detail::flat_data(points_b), detail::flat_data(deltas) );
+     }
+      else if constexpr( detail::flat_mixed_arithmetic<point_t,delta_t> )
+     {
+         detail::flat_mixed_difference( deltas.size()*detail::column_count<point_t>(), detail::flat_data(points_a), detail::flat_data(points_b), detail::flat_data(deltas) );
+     }
+      else
+     {
+         for( std::size_t i=0; i<deltas.size(); ++i ){ deltas[i]=points_a[i]-points_b[i]; }
+     }
+  }
+
+   // r = |d|²
+   template<typename delta_t>
+      requires std::same_as<std::remove_const_t<delta_t>,typename delta_t::delta_type>
+   void norm2( const std::span<delta_t> deltas,
+               const std::span<typename delta_t::value_type> result )
+  {
+      assert( deltas.size()==result.size() );
+      using value_t = std::remove_const_t<delta_t>;
+      if constexpr( detail::flat_layout<value_t> && detail::flat_metric<value_t> )
+     {
+         constexpr std::size_t ncols = detail::column_count<value_t>();
+         detail::flat_norm2( deltas.size(), ncols, detail::flat_data(deltas), ncols, 1, result.data() );
+     }
+      else
+     {
+         for( std::size_t i=0; i<deltas.size(); ++i ){ result[i]=norm2(deltas[i]); }
+     }
+  }
+
+   // r = |p-q|²
+   template<typename point_t>
+      requires std::same_as<std::remove_const_t<point_t>,typename point_t::point_type>
+   void distance2( const std::span<point_t> points,
+                   const typename point_t::point_type& q,
+                   const std::span<typename point_t::delta_type::value_type> result )
+  {
+      assert( points.size()==result.size() );
+      using value_t = std::remove_const_t<point_t>;
+      if constexpr( detail::flat_layout<value_t> && detail::flat_metric<value_t> )
+     {
+         constexpr std::size_t ncols = detail::column_count<value_t>();
+         detail::flat_distance2( points.size(), ncols, detail::flat_data(points), ncols, 1,
+                                 detail::flat_data(std::span(&q,1)), result.data() );
+     }
+      else
+     {
+         for( std::size_t i=0; i<points.size(); ++i ){ result[i]=distance2(points[i],q); }
+     }
+  }
+
+   // d /= |d|
+   template<typename delta_t>
+      requires std::same_as<delta_t,typename delta_t::delta_type>
+   void normalize( const std::span<delta_t> deltas )
+  {
+      using num_t = typename delta_t::value_type;
+      if constexpr( detail::flat_layout<delta_t> && detail::flat_metric<delta_t> )
+     {
+         constexpr std::size_t ncols = detail::column_count<delta_t>();
+         detail::flat_normalize( deltas.size(), ncols, detail::flat_data(deltas), ncols, 1 );
+     }
+      else
+     {
+         for( auto& d : deltas )
+        {
+            const num_t length = norm(d);
+            if( length>num_t(0) ){ d/=length; }
+        }
+     }
+  }
+
+// --------------- SoA container kernels ---------------
+
+   // y += a*x
+   template<typename delta_t>
+   void axpy( const scale_factor<typename delta_t::value_type> auto a,
+              const delta_array<delta_t>& x,
+                    delta_array<delta_t>& y )
+  {
+      assert( x.size()==y.size() );
+      using num_t = typename delta_t::value_type;
+      for( std::size_t c=0; c<y.columns(); ++c ){ detail::flat_axpy( y.size(), detail::compute_t<num_t>(a), x.data(c), y.data(c) ); }
+  }
+
+   // p += a*d
+   template<typename point_t>
+   void advance( point_array<point_t>& points,
+                 const scale_factor<typename point_t::delta_type::value_type> auto a,
+                 const delta_array<typename point_t::delta_type>& deltas )
+  {
+      assert( points.size()==deltas.size() );
+      using num_t = typename point_t::value_type;
+      using dnum_t = typename point_t::delta_type::value_type;
+      for( std::size_t c=0; c<points.columns(); ++c )
+     {
+         if constexpr( std::same_as<num_t,dnum_t> )
+        {
+            detail::flat_axpy( points.size(), detail::compute_t<num_t>(a), deltas.data(c), points.data(c) );
+        }
+         else
+        {
+            detail::flat_mixed_axpy( points.size(), static_cast<std::common_type_t<num_t,dnum_t>>(a), deltas.data(c), points.data(c) );
+        }
+     }
+  }
+
+   // d *= a
+   template<typename delta_t>
+   void scale( const scale_factor<typename delta_t::value_type> auto a,
+               delta_array<delta_t>& deltas )
+  {
+      using num_t = typename delta_t::value_type;
+      for( std::size_t c=0; c<deltas.columns(); ++c ){ detail::flat_scale( deltas.size(), detail::compute_t<num_t>(a), deltas.data(c) ); }
+  }
+
+   // d = p-q
+   template<typename point_t>
+   void difference( const point_array<point_t>& points_a,
+                    const point_array<point_t>& points_b,
+                    delta_array<typename point_t::delta_type>& deltas )
+  {
+      assert( points_a.size()==points_b.size() );
+      deltas.resize( points_a.size() );
+      for( std::size_t c=0; c<deltas.columns(); ++c )
+     {
+         if constexpr( std::same_as<typename point_t::value_type,typename point_t::delta_type::value_type> )
+        {
+            detail::flat_difference( deltas.size(), points_a.data(c), points_b.data(c), deltas.data(c) );
+        }
+         else
+        {
+            detail::flat_mixed_difference( deltas.size(), points_a.data(c), points_b.data(c), deltas.data(c) );
+        }
+     }
+  }
+
+   // r = |d|²
+   template<typename delta_t>
+   void norm2( const delta_array<delta_t>& deltas,
+               const std::span<typename delta_t::value_type> result )
+  {
+      assert( deltas.size()==result.size() );
+      if constexpr( detail::flat_metric<delta_t> )
+     {
+         detail::flat_norm2( deltas.size(), deltas.columns(), deltas.data(), 1, deltas.capacity(), result.data() );
+     }
+      else
+     {
+         for( std::size_t i=0; i<deltas.size(); ++i ){ result[i]=norm2(deltas[i].value()); }
+     }
+  }
+
+   // r = |p-q|²
+   template<typename point_t>
+   void distance2( const point_array<point_t>& points,
+                   const point_t& q,
+                   const std::span<typename point_t::delta_type::value_type> result )
+  {
+      assert( points.size()==result.size() );
+      if constexpr( detail::flat_metric<point_t> )
+     {
+         std::array<typename point_t::value_type,detail::column_count<point_t>()> qs;
+         if constexpr( point_t::vector_valued ){ for( std::size_t c=0; c<qs.size(); ++c ){ qs[c]=q[c]; } }
+         else { qs[0]=q.element; }
+         detail::flat_distance2( points.size(), points.columns(), points.data(), 1, points.capacity(), qs.data(), result.data() );
+     }
+      else
+     {
+         for( std::size_t i=0; i<points.size(); ++i ){ result[i]=distance2(points[i].value(),q); }
+     }
+  }
+
+   // d /= |d|
+   template<typename delta_t>
+   void normalize( delta_array<delta_t>& deltas )
+  {
+      using num_t = typename delta_t::value_type;
+      if constexpr( detail::flat_metric<delta_t> )
+     {
+         detail::flat_normalize( deltas.size(), deltas.columns(), deltas.data(), 1, deltas.capacity() );
+     }
+      else
+     {
+         for( const auto d : deltas )
+        {
+            const num_t length = norm(d.value());
+            if( length>num_t(0) ){ d/=length; }
+        }
+     }
+  }
+
+}
@@ -0,0 +1,481 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines linear and affine maps between spaces of fixed dimension.
+ *
+ *    linear_map<N,M,num_t> is an MxN matrix, mapping deltas of an N dimensional space to deltas of an M dimensional space.
+ *    affine_map<N,M,num_t> is a linear_map and a translation, mapping points p -> Lp+t, and deltas d -> Ld.
+ *    Points are only mapped by affine maps, and the image of a delta never includes the translation, so p-q maps to f(p)-f(q).
+ *
+ *    f(x)                 image of x, with the same type as x, for maps with N==M
+ *    apply<T>(f,x)        image of x as a T, e.g. for a different space or dimension
+ *    g*f                  composition, (g*f)(x) = g(f(x)), only compiles if the dimensions agree
+ *    f.inverse()          inverse of a square map, by gauss-jordan elimination with partial pivoting
+ *    Maps are aggregates and all of their operations are constexpr, so maps can be composed and inverted at compile time.
+ *
+ *    Batch versions map a span or SoA container of points/deltas into another, or in place:
+ *       apply(f,x,y)         y[i] = f(x[i])
+ *       apply(f,x)           x[i] = f(x[i])
+ *    For float and double these use a matrix-vector kernel (matrix_apply in kernels.h) which holds the broadcast matrix in vector registers,
+ *    with the lanes along the elements. Spans are packed into columns in blocks of map_block elements, SoA containers are used as they are.
+ *    Spans of 3D types with homogeneous_storage are mapped in place by the 4x4 matrix [L t; 0 1] (homogeneous_apply in kernels.h),
+ *    with one full width load and store per element, and the same kernel for points and deltas.
+ *
+ *    Code example:
+ *
+ *       constexpr affine_map<3,3> rotate{ {{{ {0,-1,0}, {1,0,0}, {0,0,1} }}}, {0,0,0} };
+ *       constexpr affine_map<3,3> shift{ linear_map<3,3>::identity(), {1,2,3} };
+ *
+ *       constexpr auto f = shift*rotate;                // rotate, then shift
+ *       constexpr auto g = f.inverse();
+ *
+ *       cartesian_point_t<3> q = f(p);                  // g(q) == p
+ *       cartesian_delta_t<3> e = f(d);                  // rotated only
+ *
+ *       affine::apply( f, std::span(ps) );              // in place
+ */
+
+# include "affine_space.h"
+# include "kernels.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <span>
+# include <type_traits>
+
+namespace affine
+{
+
+namespace detail
+{
+   template<typename T>
+   concept point_like = std::same_as<std::remove_const_t<T>,typename T::point_type>;
+
+   template<typename T>
+   concept delta_like = std::same_as<std::remove_const_t<T>,typename T::delta_type>;
+
+   // T has exactly n coordinates, known at compile time
+   template<typename T, std::size_t n>
+   concept fixed_extent = T::vector_valued && !T::dynamic && T::size()==n;
+
+   template<typename num_t>
+   [[nodiscard]]
+   constexpr num_t magnitude( const num_t x ){ return x<num_t(0) ? -x : x; }
+
+   // number of elements of a span packed into columns at a time
+   constexpr std::size_t map_block = 256;
+}
+
+// --------------- linear maps ---------------
+
+/*
+ * MxN matrix mapping deltas with N coordinates to deltas with M coordinates
+ */
+   template<std::size_t N, std::size_t M, typename num_t=double>
+   struct linear_map
+  {
+      static_assert( N>0 && M>0 && N!=dynamic_extent && M!=dynamic_extent, "maps require fixed, non-zero dimensions" );
+
+      using value_type = num_t;
+
+      constexpr static std::size_t domain_size = N;
+      constexpr static std::size_t range_size  = M;
+
+      // matrix[r][c], row r gives coordinate r of the image
+      std::array<std::array<num_t,N>,M> matrix;
+
+      static_assert( sizeof(std::array<std::array<num_t,N>,M>)==M*N*sizeof(num_t), "rows of the matrix must be contiguous" );
+
+      [[nodiscard]]
+      constexpr static linear_map identity() requires (N==M)
+     {
+         linear_map l{};
+         for( std::size_t i=0; i<N; ++i ){ l.matrix[i][i]=num_t(1); }
+         return l;
+     }
+
+      [[nodiscard]] constexpr       std::array<num_t,N>& operator[]( const std::size_t r )       { return matrix[r]; }
+      [[nodiscard]] constexpr const std::array<num_t,N>& operator[]( const std::size_t r ) const { return matrix[r]; }
+
+      [[nodiscard]] const num_t* data() const noexcept { return matrix[0].data(); }
+
+      template<typename delta_t>
+         requires detail::delta_like<delta_t> && detail::fixed_extent<delta_t,N> && (N==M)
+      [[nodiscard]]
+      constexpr delta_t operator()( const delta_t& d ) const;
+
+      [[nodiscard]]
+      constexpr linear_map<M,N,num_t> transpose() const
+     {
+         linear_map<M,N,num_t> t{};
+         for( std::size_t r=0; r<M; ++r )
+        {
+            for( std::size_t c=0; c<N; ++c ){ t.matrix[c][r]=matrix[r][c]; }
+        }
+         return t;
+     }
+
+      [[nodiscard]]
+      constexpr num_t determinant() const requires (N==M)
+     {
+         auto a = matrix;
+         num_t det(1);
+         for( std::size_t k=0; k<N; ++k )
+        {
+            std::size_t p=k;
+            for( std::size_t r=k+1; r<N; ++r ){ if( detail::magnitude(a[r][k])>detail::magnitude(a[p][k]) ){ p=r; } }
+            if( a[p][k]==num_t(0) ){ return num_t(0); }
+            if( p!=k ){ std::swap( a[p], a[k] ); det=-det; }
+
+            det*=a[k][k];
+            for( std::size_t r=k+1; r<N; ++r )
+           {
+               const num_t f = a[r][k]/a[k][k];
+               for( std::size_t c=k; c<N; ++c ){ a[r][c]-=f*a[k][c]; }
+           }
+        }
+         return det;
+     }
+
+      // the map must be invertible
+      [[nodiscard]]
+      constexpr linear_map inverse() const requires (N==M)
+     {
+         auto a = matrix;
+         linear_map inv = identity();
+         for( std::size_t k=0; k<N; ++k )
+        {
+            std::size_t p=k;
+            for( std::size_t r=k+1; r<N; ++r ){ if( detail::magnitude(a[r][k])>detail::magnitude(a[p][k]) ){ p=r; } }
+            assert( a[p][k]!=num_t(0) && "linear_map is singular" );
+            std::swap( a[p], a[k] );
+            std::swap( inv.matrix[p], inv.matrix[k] );
+
+            const num_t pivot = a[k][k];
+            for( std::size_t c=0; c<N; ++c ){ a[k][c]/=pivot; inv.matrix[k][c]/=pivot; }
+
+            for( std::size_t r=0; r<N; ++r )
+           {
+               if( r==k ){ continue; }
+               const num_t f = a[r][k];
+               for( std::size_t c=0; c<N; ++c ){ a[r][c]-=f*a[k][c]; inv.matrix[r][c]-=f*inv.matrix[k][c]; }
+           }
+        }
+         return inv;
+     }
+
+      [[nodiscard]] friend constexpr bool operator==( const linear_map&, const linear_map& ) = default;
+  };
+
+   // composition, (g*f)(d) = g(f(d))
+   template<std::size_t N, std::size_t M, std::size_t K, typename num_t>
+   [[nodiscard]]
+   constexpr linear_map<N,K,num_t> operator*( const linear_map<M,K,num_t>& g, const linear_map<N,M,num_t>& f )
+  {
+      linear_map<N,K,num_t> h{};
+      for( std::size_t r=0; r<K; ++r )
+     {
+         for( std::size_t c=0; c<N; ++c )
+        {
+            num_t sum(0);
+            for( std::size_t k=0; k<M; ++k ){ sum+=g.matrix[r][k]*f.matrix[k][c]; }
+            h.matrix[r][c]=sum;
+        }
+     }
+      return h;
+  }
+
+// --------------- affine maps ---------------
+
+/*
+ * linear map and translation, mapping points with N coordinates to points with M coordinates
+ */
+   template<std::size_t N, std::size_t M, typename num_t=double>
+   struct affine_map
+  {
+      using value_type = num_t;
+
+      constexpr static std::size_t domain_size = N;
+      constexpr static std::size_t range_size  = M;
+
+      linear_map<N,M,num_t> linear;
+      std::array<num_t,M>   translation;
+
+      [[nodiscard]]
+      constexpr static affine_map identity() requires (N==M)
+     {
+         return affine_map{ linear_map<N,M,num_t>::identity(), {} };
+     }
+
+      template<typename point_t>
+         requires detail::point_like<point_t> && detail::fixed_extent<point_t,N> && (N==M)
+      [[nodiscard]]
+      constexpr point_t operator()( const point_t& p ) const;
+
+      template<typename delta_t>
+         requires detail::delta_like<delta_t> && detail::fixed_extent<delta_t,N> && (N==M)
+      [[nodiscard]]
+      constexpr delta_t operator()( const delta_t& d ) const { return linear(d); }
+
+      // the linear part must be invertible
+      [[nodiscard]]
+      constexpr affine_map inverse() const requires (N==M)
+     {
+         const auto inv = linear.inverse();
+
+         affine_map f{ inv, {} };
+         for( std::size_t r=0; r<N; ++r )
+        {
+            num_t sum(0);
+            for( std::size_t c=0; c<N; ++c ){ sum-=inv.matrix[r][c]*translation[c]; }
+            f.translation[r]=sum;
+        }
+         return f;
+     }
+
+      [[nodiscard]] friend constexpr bool operator==( const affine_map&, const affine_map& ) = default;
+  };
+
+   // composition, (g*f)(p) = g(f(p))
+   template<std::size_t N, std::size_t M, std::size_t K, typename num_t>
+   [[nodiscard]]
+   constexpr affine_map<N,K,num_t> operator*( const affine_map<M,K,num_t>& g, const affine_map<N,M,num_t>& f )
+  {
+      affine_map<N,K,num_t> h{ g.linear*f.linear, g.translation };
+      for( std::size_t r=0; r<K; ++r )
+     {
+         for( std::size_t k=0; k<M; ++k ){ h.translation[r]+=g.linear.matrix[r][k]*f.translation[k]; }
+     }
+      return h;
+  }
+
+// --------------- single elements ---------------
+
+namespace detail
+{
+   // the linear part of a map, and its translation if it applies to T (nullptr otherwise)
+   template<typename T, std::size_t N, std::size_t M, typename num_t>
+   constexpr const linear_map<N,M,num_t>& linear_part( const linear_map<N,M,num_t>& f ){ return f; }
+
+   template<typename T, std::size_t N, std::size_t M, typename num_t>
+   constexpr const linear_map<N,M,num_t>& linear_part( const affine_map<N,M,num_t>& f ){ return f.linear; }
+
+   template<typename T, std::size_t N, std::size_t M, typename num_t>
+   constexpr const num_t* translation_part( const linear_map<N,M,num_t>& ){ return nullptr; }
+
+   template<typename T, std::size_t N, std::size_t M, typename num_t>
+   constexpr const num_t* translation_part( const affine_map<N,M,num_t>& f )
+  {
+      if constexpr( point_like<T> ){ return f.translation.data(); }
+      else { return nullptr; }
+  }
+
+   // x -> Lx+t, with coordinates read by get(c)
+   template<typename result_t, std::size_t N, std::size_t M, typename num_t, typename get_t>
+   [[nodiscard]]
+   constexpr result_t map_coordinates( const linear_map<N,M,num_t>& l, const num_t* t, get_t&& get )
+  {
+      result_t y{};
+      for( std::size_t r=0; r<M; ++r )
+     {
+         num_t sum = t ? t[r] : num_t(0);
+         for( std::size_t c=0; c<N; ++c ){ sum+=l.matrix[r][c]*get(c); }
+         y[r]=static_cast<typename result_t::value_type>(sum);
+     }
+      return y;
+  }
+
+   template<typename map_t, typename T, typename result_t>
+   concept maps_to =
+      ( point_like<T> || delta_like<T> )
+   && ( point_like<T> ? point_like<result_t> : delta_like<result_t> )
+   && fixed_extent<T,map_t::domain_size>
+   && fixed_extent<result_t,map_t::range_size>
+   && ( point_like<T> ? requires( const map_t f ){ f.translation; } : true );
+}
+
+/*
+ * image of x as a result_t, for a point x only affine maps apply
+ */
+   template<typename result_t, typename map_t, typename T>
+      requires detail::maps_to<map_t,T,result_t>
+   [[nodiscard]]
+   constexpr result_t apply( const map_t& f, const T& x )
+  {
+      return detail::map_coordinates<result_t>( detail::linear_part<T>(f), detail::translation_part<T>(f),
+                                                [&x]( const std::size_t c ){ return x[c]; } );
+  }
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   template<typename delta_t>
+      requires detail::delta_like<delta_t> && detail::fixed_extent<delta_t,N> && (N==M)
+   constexpr delta_t linear_map<N,M,num_t>::operator()( const delta_t& d ) const { return apply<delta_t>( *this, d ); }
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   template<typename point_t>
+      requires detail::point_like<point_t> && detail::fixed_extent<point_t,N> && (N==M)
+   constexpr point_t affine_map<N,M,num_t>::operator()( const point_t& p ) const { return apply<point_t>( *this, p ); }
+
+// --------------- batches ---------------
+
+   // y[i] = f(x[i])
+   template<typename map_t, typename T, typename result_t>
+      requires detail::maps_to<map_t,T,result_t>
+   void apply( const map_t& f, const std::span<T> x, const std::span<result_t> y )
+  {
+      assert( x.size()==y.size() );
+      using value_t = std::remove_const_t<T>;
+      using num_t = typename map_t::value_type;
+      constexpr std::size_t N = map_t::domain_size;
+      constexpr std::size_t M = map_t::range_size;
+
+      const auto& l = detail::linear_part<value_t>(f);
+      const num_t* t = detail::translation_part<value_t>(f);
+
+      if constexpr( detail::homogeneous_layout<value_t> && std::same_as<value_t,result_t> && std::same_as<typename value_t::value_type,num_t> )
+     {
+         // [L t; 0 1], the homogeneous coordinate selects whether the translation applies
+         num_t h[16]={};
+         for( std::size_t r=0; r<3; ++r )
+        {
+            for( std::size_t c=0; c<3; ++c ){ h[r*4+c]=l.matrix[r][c]; }
+            if constexpr( requires{ f.translation; } ){ h[r*4+3]=f.translation[r]; }
+        }
+         h[15]=num_t(1);
+         detail::flat_homogeneous_apply( x.size(), h, detail::flat_data(x), detail::flat_data(y) );
+     }
+      else if constexpr( detail::flat_layout<value_t> && detail::flat_layout<result_t>
+                 && std::same_as<typename value_t::value_type,num_t> && std::same_as<typename result_t::value_type,num_t> )
+     {
+         constexpr std::size_t B = detail::map_block;
+         std::array<num_t,N*B> xb;
+         std::array<num_t,M*B> yb;
+
+         const num_t* xs = detail::flat_data(x);
+         num_t* ys = detail::flat_data(y);
+         for( std::size_t b=0; b<x.size(); b+=B )
+        {
+            const std::size_t m = std::min( B, x.size()-b );
+            for( std::size_t k=0; k<m; ++k )
+           {
+               for( std::size_t c=0; c<N; ++c ){ xb[c*B+k]=xs[(b+k)*N+c]; }
+           }
+            detail::flat_matrix_apply<M,N>( m, l.data(), t, xb.data(), B, yb.data(), B );
+            for( std::size_t k=0; k<m; ++k )
+           {
+               for( std::size_t r=0; r<M; ++r ){ ys[(b+k)*M+r]=yb[r*B+k]; }
+           }
+        }
+     }
+      else
+     {
+         for( std::size_t i=0; i<x.size(); ++i ){ y[i]=apply<result_t>( f, x[i] ); }
+     }
+  }
+
+   // x[i] = f(x[i])
+   template<typename map_t, typename T>
+      requires detail::maps_to<map_t,T,T>
+   void apply( const map_t& f, const std::span<T> x )
+  {
+      apply( f, std::span<const T>(x), x );
+  }
+
+namespace detail
+{
+   // simd kernels for float and double columns, scalar loops otherwise
+   template<std::size_t nrows, std::size_t ncols, typename num_t>
+   void apply_matrix( const std::size_t n, const num_t* a, const num_t* t,
+                      const num_t* x, const std::size_t xs, num_t* y, const std::size_t ys )
+  {
+      if constexpr( std::same_as<num_t,float> || std::same_as<num_t,double> )
+     {
+         flat_matrix_apply<nrows,ncols>( n, a, t, x, xs, y, ys );
+     }
+      else
+     {
+         scalar::matrix_apply<nrows,ncols>( n, a, t, x, xs, y, ys );
+     }
+  }
+
+   // y[i] = f(x[i]) for SoA containers, the columns are used directly
+   template<typename T, typename map_t, typename in_t, typename out_t>
+   void apply_columns( const map_t& f, const in_t& x, out_t& y )
+  {
+      using num_t = typename map_t::value_type;
+      static_assert( std::same_as<typename in_t::value_type,num_t> && std::same_as<typename out_t::value_type,num_t>,
+                     "SoA containers must have the same number type as the map" );
+
+      y.resize( x.size() );
+      apply_matrix<map_t::range_size,map_t::domain_size>( x.size(),
+                                                          linear_part<T>(f).data(), translation_part<T>(f),
+                                                          x.data(), x.capacity(), y.data(), y.capacity() );
+  }
+}
+
+   // y[i] = f(x[i]), y is resized to match x
+   template<typename map_t, typename point_t, typename result_t>
+      requires detail::maps_to<map_t,point_t,result_t>
+   void apply( const map_t& f, const point_array<point_t>& x, point_array<result_t>& y )
+  {
+      detail::apply_columns<point_t>( f, x, y );
+  }
+
+   template<typename map_t, typename delta_t, typename result_t>
+      requires detail::maps_to<map_t,delta_t,result_t>
+   void apply( const map_t& f, const delta_array<delta_t>& x, delta_array<result_t>& y )
+  {
+      detail::apply_columns<delta_t>( f, x, y );
+  }
+
+   // x[i] = f(x[i])
+   template<typename map_t, typename point_t>
+      requires detail::maps_to<map_t,point_t,point_t>
+   void apply( const map_t& f, point_array<point_t>& x )
+  {
+      detail::apply_matrix<map_t::range_size,map_t::domain_size>( x.size(),
+                                                                  detail::linear_part<point_t>(f).data(), detail::translation_part<point_t>(f),
+                                                                  x.data(), x.capacity(), x.data(), x.capacity() );
+  }
+
+   template<typename map_t, typename delta_t>
+      requires detail::maps_to<map_t,delta_t,delta_t>
+   void apply( const map_t& f, delta_array<delta_t>& x )
+  {
+      detail::apply_matrix<map_t::range_size,map_t::domain_size>( x.size(),
+                                                                  detail::linear_part<delta_t>(f).data(), detail::translation_part<delta_t>(f),
+                                                                  x.data(), x.capacity(), x.data(), x.capacity() );
+  }
+}
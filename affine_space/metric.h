@@ -0,0 +1,284 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines inner products, norms and distances for the delta types of an affine space.
+ *
+ *    Only displacements have a length, so dot, norm2 and norm take delta_t, and the distance between two points is the norm of p-q.
+ *    The inner product is given by a metric, any type with a member inner(d,e) returning the value type:
+ *       euclidean_metric              Σ d[i]*e[i]
+ *       weighted_metric<num_t,ndim>   Σ w[i]*d[i]*e[i], for positive weights w
+ *       user defined metrics, e.g. for a non-orthonormal basis
+ *    Each function takes an optional metric as its first argument. Without one, the default metric of delta_t is used,
+ *    which is euclidean_metric unless metric_traits<delta_t> is specialised (the default metric must be default constructible).
+ *
+ *    Batched versions of norm2, distance2 and normalize over spans and SoA containers are in kernels.h.
+ *
+ *    Code example:
+ *
+ *       template<>
+ *       struct affine::metric_traits<cartesian_delta_t<3>> { using type = my_metric; };
+ *
+ *       const double l = norm(d);
+ *       const double c = dot(d,e)/(norm(d)*norm(e));
+ *       const double r = distance( weighted_metric<double,3>{{1,1,0.25}}, p, q );
+ */
+
+# include "affine_space.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <cmath>
+# include <concepts>
+# include <cstddef>
+
+namespace affine
+{
+
+/*
+ * metric_t defines an inner product of two delta_t
+ */
+   template<typename metric_t, typename delta_t>
+   concept metric =
+      requires( const metric_t m, const delta_t d )
+     {
+         { m.inner(d,d) } -> std::convertible_to<typename delta_t::value_type>;
+     };
+
+namespace detail
+{
+   // coordinate i of a delta, or its element in a scalar space
+   template<typename delta_t>
+   [[nodiscard]]
+   constexpr const auto& coordinate( const delta_t& d, [[maybe_unused]] const std::size_t i )
+  {
+      if constexpr( delta_t::vector_valued ){ return d[i]; }
+      else { return d.element; }
+  }
+
+   template<typename delta_t>
+   [[nodiscard]]
+   constexpr std::size_t coordinate_count( [[maybe_unused]] const delta_t& d )
+  {
+      if constexpr( delta_t::dynamic ){ return d.size(); }
+      else if constexpr( delta_t::vector_valued ){ return delta_t::size(); }
+      else { return 1; }
+  }
+}
+
+// --------------- metrics ---------------
+
+/*
+ * standard inner product, Σ d[i]*e[i]
+ *    each term is converted back to the value type, since narrow integers are promoted to int
+ */
+   struct euclidean_metric
+  {
+      template<typename delta_t>
+      [[nodiscard]]
+      constexpr typename delta_t::value_type inner( const delta_t& d, const delta_t& e ) const
+     {
+         assert( detail::coordinate_count(d)==detail::coordinate_count(e) );
+         using value_t = typename delta_t::value_type;
+         value_t sum(0);
+         for( std::size_t i=0; i<detail::coordinate_count(d); ++i ){ sum=static_cast<value_t>( sum+detail::coordinate(d,i)*detail::coordinate(e,i) ); }
+         return sum;
+     }
+  };
+
+/*
+ * diagonal inner product, Σ w[i]*d[i]*e[i]
+ *    ndim=0 for scalar spaces, which have a single weight
+ */
+   template<numeric num_t,
+            std::size_t ndim>
+   struct weighted_metric
+  {
+      std::array<num_t,std::max<std::size_t>(ndim,1)> weight;
+
+      template<typename delta_t>
+      [[nodiscard]]
+      constexpr num_t inner( const delta_t& d, const delta_t& e ) const
+     {
+         assert( detail::coordinate_count(d)==weight.size() );
+         num_t sum(0);
+         for( std::size_t i=0; i<weight.size(); ++i ){ sum=static_cast<num_t>( sum+weight[i]*detail::coordinate(d,i)*detail::coordinate(e,i) ); }
+         return sum;
+     }
+  };
+
+/*
+ * customisation point for the default metric of a delta_t
+ */
+   template<typename delta_t>
+   struct metric_traits
+  {
+      using type = euclidean_metric;
+  };
+
+   template<typename delta_t>
+   using default_metric = typename metric_traits<delta_t>::type;
+
+// --------------- inner product and norms ---------------
+
+   // <d,e>
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t,
+            metric<delta_t> metric_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type dot( const metric_t& m,
+                                               const delta_base<ndim,point_t,delta_t,num_t>& d,
+                                               const delta_base<ndim,point_t,delta_t,num_t>& e )
+  {
+      return m.inner( static_cast<const delta_t&>(d), static_cast<const delta_t&>(e) );
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type dot( const delta_base<ndim,point_t,delta_t,num_t>& d,
+                                               const delta_base<ndim,point_t,delta_t,num_t>& e )
+  {
+      return dot( default_metric<delta_t>{}, d, e );
+  }
+
+   // <d,d>
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t,
+            metric<delta_t> metric_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type norm2( const metric_t& m,
+                                                 const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      return dot( m, d, d );
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type norm2( const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      return dot( d, d );
+  }
+
+   // sqrt(<d,d>), truncated towards zero for integer deltas
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t,
+            metric<delta_t> metric_t>
+   [[nodiscard]]
+   typename delta_t::value_type norm( const metric_t& m,
+                                      const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      using value_t = typename delta_t::value_type;
+      if constexpr( std::integral<value_t> )
+     {
+         return detail::integer_sqrt( norm2(m,d) );
+     }
+      else
+     {
+         using std::sqrt;
+         return static_cast<value_t>( sqrt( norm2(m,d) ) );
+     }
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+   [[nodiscard]]
+   typename delta_t::value_type norm( const delta_base<ndim,point_t,delta_t,num_t>& d )
+  {
+      return norm( default_metric<delta_t>{}, d );
+  }
+
+// --------------- distances ---------------
+
+   // <p-q,p-q>
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t,
+            metric<delta_t> metric_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type distance2( const metric_t& m,
+                                                     const point_base<ndim,point_t,delta_t,num_t>& p,
+                                                     const point_base<ndim,point_t,delta_t,num_t>& q )
+  {
+      return norm2( m, p-q );
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+   [[nodiscard]]
+   constexpr typename delta_t::value_type distance2( const point_base<ndim,point_t,delta_t,num_t>& p,
+                                                     const point_base<ndim,point_t,delta_t,num_t>& q )
+  {
+      return norm2( p-q );
+  }
+
+   // |p-q|
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t,
+            metric<delta_t> metric_t>
+   [[nodiscard]]
+   typename delta_t::value_type distance( const metric_t& m,
+                                          const point_base<ndim,point_t,delta_t,num_t>& p,
+                                          const point_base<ndim,point_t,delta_t,num_t>& q )
+  {
+      return norm( m, p-q );
+  }
+
+   template<std::size_t ndim,
+            typename point_t,
+            typename delta_t,
+            numeric    num_t>
+   [[nodiscard]]
+   typename delta_t::value_type distance( const point_base<ndim,point_t,delta_t,num_t>& p,
+                                          const point_base<ndim,point_t,delta_t,num_t>& q )
+  {
+      return norm( p-q );
+  }
+}
+
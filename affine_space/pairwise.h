@@ -0,0 +1,434 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines the matrix of squared distances between two sets of points.
+ *
+ *    pairwise_distance2(a,b,r)          r[i*b.size()+j] = |a[i]-b[j]|²
+ *    pairwise_distance2(a,b,consume)    consume(tile) for each tile of the matrix, without storing the whole matrix
+ *
+ *    The matrix is computed in tiles of pairwise_tile_rows x pairwise_tile_columns, which are distributed across threads by the execution policy.
+ *    Each tile is a distance_tile, a read only view of the distances between rows [row_begin(),row_begin()+rows()) of a
+ *    and columns [column_begin(),column_begin()+columns()) of b. With a parallel policy consume is called concurrently for different tiles.
+ *
+ *    For float and double, the points of each tile are copied with the coordinates contiguous (SoA), and each block of gram_rows x 2 vectors of
+ *    distances is accumulated in registers (distance_block/gram_block in kernels.h), so every coordinate loaded is used for several distances.
+ *       up to 16 coordinates, the block accumulates (a-b)², which is exact up to rounding, and the tile is limited by the stores
+ *       above 16 coordinates, the block computes |a|²+|b|²-2a.b like a matrix product, relative to the first point of the a tile
+ *    The expansion loses digits to cancellation when |a-b|² is much smaller than |a|²+|b|². Blocks of entries smaller than 1/64 of |a|²+|b|² are
+ *    recomputed directly from the original coordinates, so the relative error of every entry is at most about 64(ndim+1) ulp, and coincident points give 0.
+ *    Other value types (eg integers or fixed point), points whose deltas have a different value type, and point types whose default metric
+ *    is not euclidean, use distance2 for each pair with the same tiling. The distances have the value type of the deltas, like affine::distance2.
+ *
+ *    Code example:
+ *
+ *       std::vector<cartesian_point_t<3>> sources = ..., targets = ...;
+ *
+ *       std::vector<double> r( sources.size()*targets.size() );
+ *       pairwise_distance2( affine::execution::par, std::span(sources), std::span(targets), std::span(r) );
+ *
+ *       std::vector<std::atomic<std::size_t>> close( sources.size() );
+ *       pairwise_distance2( affine::execution::par, std::span(sources), std::span(targets),
+ *                           [&]( const distance_tile<double>& tile )
+ *                          {
+ *                              for( std::size_t i=0; i<tile.rows(); ++i )
+ *                             {
+ *                                 for( const double d2 : tile.row(i) ){ if( d2<h*h ){ ++close[tile.row_begin()+i]; } }
+ *                             }
+ *                          } );
+ */
+
+# include "affine_space.h"
+# include "kernels.h"
+# include "metric.h"
+# include "parallel.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <cstdint>
+# include <span>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+// --------------- tiles ---------------
+
+   // number of rows (points of a) and columns (points of b) in a full tile
+   constexpr std::size_t pairwise_tile_rows = 32;
+   constexpr std::size_t pairwise_tile_columns = 256;
+
+/*
+ * read only view of a rectangular block of a pairwise distance matrix
+ */
+   template<typename value_t>
+   class distance_tile
+  {
+      public:
+
+      using value_type = value_t;
+
+      distance_tile( const std::size_t i0, const std::size_t j0, const std::size_t m, const std::size_t n,
+                     const value_t* p, const std::size_t ld ) :
+         first_row(i0), first_column(j0), nrows(m), ncolumns(n), values(p), row_stride(ld) {}
+
+      // position of the tile in the whole matrix
+      [[nodiscard]] std::size_t row_begin()    const noexcept { return first_row; }
+      [[nodiscard]] std::size_t column_begin() const noexcept { return first_column; }
+
+      [[nodiscard]] std::size_t rows()    const noexcept { return nrows; }
+      [[nodiscard]] std::size_t columns() const noexcept { return ncolumns; }
+
+      // squared distance between a[row_begin()+i] and b[column_begin()+j]
+      [[nodiscard]] const value_t& operator()( const std::size_t i, const std::size_t j ) const
+     {
+         assert( i<nrows && j<ncolumns );
+         return values[i*row_stride+j];
+     }
+
+      [[nodiscard]] std::span<const value_t> row( const std::size_t i ) const
+     {
+         assert( i<nrows );
+         return std::span( values+i*row_stride, ncolumns );
+     }
+
+      private:
+
+      std::size_t first_row, first_column;
+      std::size_t nrows, ncolumns;
+
+      const value_t* values;
+      std::size_t    row_stride;
+  };
+
+namespace detail
+{
+   // smallest number of tiles worth a thread of their own
+   constexpr std::size_t tile_grain = std::max<std::size_t>( 1, parallel_grain/(pairwise_tile_rows*pairwise_tile_columns) );
+
+   static_assert( pairwise_tile_rows%gram_rows==0 );
+   static_assert( pairwise_tile_columns%gram_columns<float> ==0 && pairwise_tile_columns%gram_columns<double> ==0 );
+
+   [[nodiscard]]
+   constexpr std::size_t round_up( const std::size_t n, const std::size_t multiple )
+  {
+      return (n+multiple-1)/multiple*multiple;
+  }
+
+/*
+ * call consume(worker(i0,rows,j0,columns)) for each tile, with one worker per chunk of tiles
+ * the tiles of a chunk are consecutive in row major order, so the worker can reuse the a tile
+ */
+   template<execution_policy policy_t, typename make_worker_t, typename consume_t>
+   void tiled_pairwise( policy_t&& policy, const std::size_t na, const std::size_t nb, make_worker_t&& make_worker, consume_t&& consume )
+  {
+      const std::size_t tile_rows = (na+pairwise_tile_rows-1)/pairwise_tile_rows;
+      const std::size_t tile_columns = (nb+pairwise_tile_columns-1)/pairwise_tile_columns;
+
+      parallel_for( policy, tile_rows*tile_columns,
+                    [&]( const std::size_t begin, const std::size_t end )
+                   {
+                       if( begin==end ){ return; }
+                       auto worker = make_worker();
+                       for( std::size_t t=begin; t<end; ++t )
+                      {
+                          const std::size_t i0 = (t/tile_columns)*pairwise_tile_rows;
+                          const std::size_t j0 = (t%tile_columns)*pairwise_tile_columns;
+                          consume( worker( i0, std::min(pairwise_tile_rows,na-i0), j0, std::min(pairwise_tile_columns,nb-j0) ) );
+                      }
+                   },
+                    tile_grain );
+  }
+
+   // coordinate c of element k is x[k*step+c*stride]
+   template<typename num_t>
+   struct strided_coordinates
+  {
+      const num_t* x;
+      std::size_t  step, stride;
+
+      [[nodiscard]] num_t operator()( const std::size_t k, const std::size_t c ) const { return x[k*step+c*stride]; }
+  };
+
+/*
+ * tiles of float/double coordinates, from copies of the a and b tiles packed in columns
+ *    up to direct_columns coordinates, as Σ_c (a_c-b_c)²
+ *    otherwise as |a|²+|b|²-2a.b relative to the first point of the a tile, with blocks containing cancelled entries recomputed directly
+ */
+   template<typename num_t>
+   class block_worker
+  {
+      public:
+
+      // the expansion saves work once there are more coordinates than this, below it the tiles are limited by stores
+      constexpr static std::size_t direct_columns = 16;
+
+      // entries below this fraction of |a|²+|b|² are recomputed
+      constexpr static num_t cancellation_ratio = num_t(1)/num_t(64);
+
+      block_worker( const std::size_t n, const strided_coordinates<num_t> xa, const strided_coordinates<num_t> xb ) :
+         ncols(n), expand(n>direct_columns), a(xa), b(xb),
+         origin(ncols,num_t(0)),
+         a_packed(ncols*pairwise_tile_rows),    a2(pairwise_tile_rows),
+         b_packed(ncols*pairwise_tile_columns), b2(pairwise_tile_columns),
+         distances(pairwise_tile_rows*pairwise_tile_columns),
+         cancelled(pairwise_tile_rows*pairwise_tile_columns/gram_columns<num_t>) {}
+
+      [[nodiscard]]
+      distance_tile<num_t> operator()( const std::size_t i0, const std::size_t rows, const std::size_t j0, const std::size_t columns )
+     {
+         const std::size_t ra = round_up( rows, gram_rows );
+         const std::size_t rb = round_up( columns, gram_columns<num_t> );
+
+         // consecutive tiles usually share the a tile, and its origin
+         if( i0!=packed_row )
+        {
+            if( expand ){ for( std::size_t c=0; c<ncols; ++c ){ origin[c]=a(i0,c); } }
+            pack( a, i0, rows, ra, a_packed.data() );
+            if( expand ){ flat_norm2( ra, ncols, a_packed.data(), 1, ra, a2.data() ); }
+            packed_row=i0;
+        }
+         pack( b, j0, columns, rb, b_packed.data() );
+
+         if( !expand )
+        {
+            flat_distance_block( ra, rb, ncols, a_packed.data(), b_packed.data(), distances.data() );
+            return distance_tile<num_t>( i0, j0, rows, columns, distances.data(), rb );
+        }
+
+         flat_norm2( rb, ncols, b_packed.data(), 1, rb, b2.data() );
+
+         constexpr std::size_t block = gram_columns<num_t>;
+         const std::size_t blocks = rb/block;
+         std::fill( cancelled.begin(), cancelled.end(), std::uint8_t(0) );
+         flat_gram_block( ra, rb, ncols, a_packed.data(), a2.data(), b_packed.data(), b2.data(), cancellation_ratio, distances.data(), cancelled.data() );
+
+         for( std::size_t i=0; i<rows; ++i )
+        {
+            num_t* row = distances.data()+i*rb;
+            for( std::size_t k=0; k<blocks; ++k )
+           {
+               if( cancelled[i*blocks+k]!=0 ){ direct( i0+i, j0+k*block, std::min(block,columns-k*block), row+k*block ); }
+           }
+        }
+
+         return distance_tile<num_t>( i0, j0, rows, columns, distances.data(), rb );
+     }
+
+      private:
+
+      // packed[c*padded+k] = x(first+k,c)-origin[c], zero padded
+      void pack( const strided_coordinates<num_t> x, const std::size_t first, const std::size_t n, const std::size_t padded, num_t* packed ) const
+     {
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            num_t* column = packed+c*padded;
+            for( std::size_t k=0; k<n; ++k ){ column[k]=x(first+k,c)-origin[c]; }
+            std::fill( column+n, column+padded, num_t(0) );
+        }
+     }
+
+      // out[j] = |a_i-b_{j0+j}|² from the original coordinates
+      void direct( const std::size_t i, const std::size_t j0, const std::size_t n, num_t* out ) const
+     {
+         std::fill( out, out+n, num_t(0) );
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            const num_t ac = a(i,c);
+            for( std::size_t j=0; j<n; ++j )
+           {
+               const num_t v = ac-b(j0+j,c);
+               out[j]+=v*v;
+           }
+        }
+     }
+
+      std::size_t ncols;
+      bool        expand;
+      strided_coordinates<num_t> a, b;
+
+      std::vector<num_t> origin;
+      std::vector<num_t> a_packed, a2;
+      std::vector<num_t> b_packed, b2;
+      std::vector<num_t> distances;
+      std::vector<std::uint8_t> cancelled;
+
+      std::size_t packed_row = std::size_t(-1);
+  };
+
+/*
+ * tiles computed with distance2 for each pair, a(i) and b(j) return points
+ */
+   template<typename value_t, typename points_a_t, typename points_b_t>
+   class direct_worker
+  {
+      public:
+
+      direct_worker( const points_a_t& pa, const points_b_t& pb ) :
+         a(pa), b(pb), distances(pairwise_tile_rows*pairwise_tile_columns) {}
+
+      [[nodiscard]]
+      distance_tile<value_t> operator()( const std::size_t i0, const std::size_t rows, const std::size_t j0, const std::size_t columns )
+     {
+         for( std::size_t i=0; i<rows; ++i )
+        {
+            for( std::size_t j=0; j<columns; ++j ){ distances[i*columns+j]=distance2( a(i0+i), b(j0+j) ); }
+        }
+         return distance_tile<value_t>( i0, j0, rows, columns, distances.data(), columns );
+     }
+
+      private:
+
+      const points_a_t& a;
+      const points_b_t& b;
+
+      std::vector<value_t> distances;
+  };
+
+   // consume that writes each tile into a row major matrix with nb columns
+   template<typename value_t>
+   [[nodiscard]]
+   auto store_tiles( const std::span<value_t> result, const std::size_t nb )
+  {
+      return [result,nb]( const distance_tile<value_t>& tile )
+     {
+         for( std::size_t i=0; i<tile.rows(); ++i )
+        {
+            const auto row = tile.row(i);
+            std::copy( row.begin(), row.end(), result.begin()+(tile.row_begin()+i)*nb+tile.column_begin() );
+        }
+     };
+  }
+}
+
+// --------------- pairwise distances ---------------
+
+   // consume(tile) for each tile of |a[i]-b[j]|²
+   template<execution_policy policy_t, typename point_t, typename consume_t>
+      requires std::same_as<std::remove_const_t<point_t>,typename point_t::point_type>
+            && std::invocable<consume_t&,const distance_tile<typename point_t::delta_type::value_type>&>
+   void pairwise_distance2( policy_t&& policy,
+                            const std::span<point_t> a,
+                            const std::span<const typename point_t::point_type> b,
+                            consume_t&& consume )
+  {
+      using value_t = std::remove_const_t<point_t>;
+      using num_t = typename point_t::delta_type::value_type;
+      if constexpr( detail::flat_layout<value_t> && detail::flat_metric<value_t> )
+     {
+         constexpr std::size_t ncols = detail::column_count<value_t>();
+         const detail::strided_coordinates<num_t> xa{ detail::flat_data(a), ncols, 1 };
+         const detail::strided_coordinates<num_t> xb{ detail::flat_data(b), ncols, 1 };
+         detail::tiled_pairwise( policy, a.size(), b.size(),
+                                 [&]{ return detail::block_worker<num_t>( ncols, xa, xb ); },
+                                 consume );
+     }
+      else
+     {
+         const auto pa = [a]( const std::size_t i ) -> const value_t& { return a[i]; };
+         const auto pb = [b]( const std::size_t j ) -> const value_t& { return b[j]; };
+         detail::tiled_pairwise( policy, a.size(), b.size(),
+                                 [&]{ return detail::direct_worker<num_t,decltype(pa),decltype(pb)>( pa, pb ); },
+                                 consume );
+     }
+  }
+
+   // r[i*b.size()+j] = |a[i]-b[j]|²
+   template<execution_policy policy_t, typename point_t>
+      requires std::same_as<std::remove_const_t<point_t>,typename point_t::point_type>
+   void pairwise_distance2( policy_t&& policy,
+                            const std::span<point_t> a,
+                            const std::span<const typename point_t::point_type> b,
+                            const std::span<typename point_t::delta_type::value_type> result )
+  {
+      assert( result.size()==a.size()*b.size() );
+      pairwise_distance2( policy, a, b, detail::store_tiles( result, b.size() ) );
+  }
+
+   template<typename point_t, typename output_t>
+      requires std::same_as<std::remove_const_t<point_t>,typename point_t::point_type>
+   void pairwise_distance2( const std::span<point_t> a,
+                            const std::span<const typename point_t::point_type> b,
+                            output_t&& output )
+  {
+      pairwise_distance2( execution::seq, a, b, std::forward<output_t>(output) );
+  }
+
+   // consume(tile) for each tile of |a[i]-b[j]|², for SoA containers
+   template<execution_policy policy_t, typename point_t, typename consume_t>
+      requires std::invocable<consume_t&,const distance_tile<typename point_t::delta_type::value_type>&>
+   void pairwise_distance2( policy_t&& policy,
+                            const point_array<point_t>& a,
+                            const point_array<point_t>& b,
+                            consume_t&& consume )
+  {
+      using num_t = typename point_t::delta_type::value_type;
+      if constexpr( detail::flat_metric<point_t> )
+     {
+         const detail::strided_coordinates<num_t> xa{ a.data(), 1, a.capacity() };
+         const detail::strided_coordinates<num_t> xb{ b.data(), 1, b.capacity() };
+         detail::tiled_pairwise( policy, a.size(), b.size(),
+                                 [&]{ return detail::block_worker<num_t>( a.columns(), xa, xb ); },
+                                 consume );
+     }
+      else
+     {
+         const auto pa = [&a]( const std::size_t i ){ return a[i].value(); };
+         const auto pb = [&b]( const std::size_t j ){ return b[j].value(); };
+         detail::tiled_pairwise( policy, a.size(), b.size(),
+                                 [&]{ return detail::direct_worker<num_t,decltype(pa),decltype(pb)>( pa, pb ); },
+                                 consume );
+     }
+  }
+
+   // r[i*b.size()+j] = |a[i]-b[j]|², for SoA containers
+   template<execution_policy policy_t, typename point_t>
+   void pairwise_distance2( policy_t&& policy,
+                            const point_array<point_t>& a,
+                            const point_array<point_t>& b,
+                            const std::span<typename point_t::delta_type::value_type> result )
+  {
+      assert( result.size()==a.size()*b.size() );
+      pairwise_distance2( policy, a, b, detail::store_tiles( result, b.size() ) );
+  }
+
+   template<typename point_t, typename output_t>
+   void pairwise_distance2( const point_array<point_t>& a,
+                            const point_array<point_t>& b,
+                            output_t&& output )
+  {
+      pairwise_distance2( execution::seq, a, b, std::forward<output_t>(output) );
+  }
+
+}
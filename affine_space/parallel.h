@@ -0,0 +1,202 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines the chunked parallel loops used by the algorithms of the library.
+ *
+ *    The algorithms take an affine::execution policy as their first argument:
+ *       seq/unseq       run on the calling thread
+ *       par/par_unseq   split the index range into contiguous chunks, one per hardware thread, run on std::jthreads
+ *       unseq/par_unseq additionally allow the algorithm to reorder operations within a chunk (eg several accumulators)
+ *
+ *    The policies mirror those of std::execution, but are defined here so that <execution> is not included:
+ *    with libstdc++ it includes the TBB backend whenever TBB is installed, and every program would then have to link -ltbb.
+ *
+ *    Partial results of the chunks are combined with a pairwise tree reduction, so the result only depends on the number of chunks.
+ *    blocked_reduce splits the range into blocks of a fixed size instead, so its result does not depend on the policy or the number of threads.
+ *    Chunk functions must not throw.
+ *
+ *    Code example:
+ *
+ *       const double sum = detail::parallel_reduce( execution::par, n, 0.0,
+ *                                                   [&]( std::size_t b, std::size_t e ){ return std::accumulate(x+b,x+e,0.0); },
+ *                                                   std::plus{} );
+ */
+
+# include <algorithm>
+# include <concepts>
+# include <cstddef>
+# include <span>
+# include <thread>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+namespace execution
+{
+   struct sequenced_policy {};
+   struct parallel_policy {};
+   struct parallel_unsequenced_policy {};
+   struct unsequenced_policy {};
+
+   inline constexpr sequenced_policy            seq{};
+   inline constexpr parallel_policy             par{};
+   inline constexpr parallel_unsequenced_policy par_unseq{};
+   inline constexpr unsequenced_policy          unseq{};
+}
+
+   template<typename policy_t>
+   concept execution_policy =
+      std::same_as<std::remove_cvref_t<policy_t>,execution::sequenced_policy>
+   || std::same_as<std::remove_cvref_t<policy_t>,execution::parallel_policy>
+   || std::same_as<std::remove_cvref_t<policy_t>,execution::parallel_unsequenced_policy>
+   || std::same_as<std::remove_cvref_t<policy_t>,execution::unsequenced_policy>;
+
+namespace detail
+{
+   template<typename policy_t>
+   constexpr bool is_parallel_policy =
+      std::same_as<std::remove_cvref_t<policy_t>,execution::parallel_policy>
+   || std::same_as<std::remove_cvref_t<policy_t>,execution::parallel_unsequenced_policy>;
+
+   template<typename policy_t>
+   constexpr bool is_unsequenced_policy =
+      std::same_as<std::remove_cvref_t<policy_t>,execution::unsequenced_policy>
+   || std::same_as<std::remove_cvref_t<policy_t>,execution::parallel_unsequenced_policy>;
+
+   // smallest number of elements worth a thread of its own
+   constexpr std::size_t parallel_grain = 1<<14;
+
+   // smallest number of queries (eg of a kdtree) worth a thread of their own
+   constexpr std::size_t query_grain = 64;
+
+   // elements per block of blocked_reduce
+   constexpr std::size_t reduction_block = 1<<12;
+
+   // number of chunks to split n elements into
+   template<typename policy_t>
+   [[nodiscard]]
+   std::size_t chunk_count( const std::size_t n, const std::size_t grain=parallel_grain )
+  {
+      if constexpr( !is_parallel_policy<policy_t> ){ return 1; }
+      else
+     {
+         const std::size_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+         return std::clamp<std::size_t>( n/grain, 1, threads );
+     }
+  }
+
+   // first index of chunk i of k chunks of n elements
+   [[nodiscard]]
+   constexpr std::size_t chunk_begin( const std::size_t n, const std::size_t k, const std::size_t i )
+  {
+      return (n/k)*i + std::min(i,n%k);
+  }
+
+/*
+ * combine values pairwise, ((v0+v1)+(v2+v3))+..., overwriting values
+ */
+   template<typename value_t, typename combine_t>
+   [[nodiscard]]
+   value_t tree_reduce( const std::span<value_t> values, combine_t&& combine )
+  {
+      for( std::size_t w=1; w<values.size(); w*=2 )
+     {
+         for( std::size_t i=0; i+w<values.size(); i+=2*w ){ values[i]=combine(values[i],values[i+w]); }
+     }
+      return values[0];
+  }
+
+/*
+ * call body(begin,end) for each chunk of [0,n)
+ */
+   template<execution_policy policy_t, typename body_t>
+   void parallel_for( policy_t&&, const std::size_t n, body_t&& body, const std::size_t grain=parallel_grain )
+  {
+      const std::size_t k = chunk_count<policy_t>(n,grain);
+      if( k==1 ){ body( std::size_t(0), n ); return; }
+
+      std::vector<std::jthread> workers;
+      workers.reserve(k-1);
+      for( std::size_t i=1; i<k; ++i )
+     {
+         workers.emplace_back( [&body,n,k,i]{ body( chunk_begin(n,k,i), chunk_begin(n,k,i+1) ); } );
+     }
+      body( std::size_t(0), chunk_begin(n,k,1) );
+  }
+
+/*
+ * reduce each chunk of [0,n) with reduce_chunk(begin,end), then tree_reduce the partial results
+ */
+   template<execution_policy policy_t, typename value_t, typename reduce_t, typename combine_t>
+   [[nodiscard]]
+   value_t parallel_reduce( policy_t&& policy, const std::size_t n, const value_t& identity,
+                            reduce_t&& reduce_chunk, combine_t&& combine, const std::size_t grain=parallel_grain )
+  {
+      const std::size_t k = chunk_count<policy_t>(n,grain);
+      std::vector<value_t> partial(k,identity);
+
+      parallel_for( policy, k,
+                    [&]( const std::size_t b, const std::size_t e )
+                   {
+                       for( std::size_t i=b; i<e; ++i ){ partial[i]=reduce_chunk( chunk_begin(n,k,i), chunk_begin(n,k,i+1) ); }
+                   },
+                    1 );
+
+      return tree_reduce( std::span(partial), combine );
+  }
+
+/*
+ * reduce each block of [0,n) with reduce_block(begin,end), then tree_reduce the partial results
+ *    the blocks only depend on n and block, not on the number of chunks, so the result is identical for every policy and thread count
+ */
+   template<execution_policy policy_t, typename value_t, typename reduce_t, typename combine_t>
+   [[nodiscard]]
+   value_t blocked_reduce( policy_t&& policy, const std::size_t n, const value_t& identity,
+                           reduce_t&& reduce_block, combine_t&& combine, const std::size_t block=reduction_block )
+  {
+      const std::size_t k = std::max<std::size_t>( (n+block-1)/block, 1 );
+      std::vector<value_t> partial(k,identity);
+
+      parallel_for( policy, k,
+                    [&]( const std::size_t b, const std::size_t e )
+                   {
+                       for( std::size_t i=b; i<e; ++i ){ partial[i]=reduce_block( i*block, std::min((i+1)*block,n) ); }
+                   },
+                    std::max<std::size_t>( parallel_grain/block, 1 ) );
+
+      return tree_reduce( std::span(partial), combine );
+  }
+}
+
+}
+
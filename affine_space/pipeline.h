@@ -0,0 +1,258 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines lazy pipelines of transforms, applied to spans of points or deltas in a single pass.
+ *
+ *    A pipeline is built with operator|, from linear_map/affine_map (map.h) and any other callable stage, eg a perspective divide.
+ *    Consecutive maps are composed as they are added, so p|f|g|h holds the single map h*g*f. Other stages are kept as they are.
+ *    If the maps are constexpr then so is the pipeline, and the composition happens at compile time.
+ *
+ *    Applying the pipeline to a span streams it through memory once:
+ *       the span is split into chunks across threads by the execution policy (see parallel.h)
+ *       each chunk is processed in tiles of pipeline_tile elements, small enough to stay in cache between stages
+ *       each stage maps the whole tile, maps with the batched kernels of map.h, other stages element by element
+ *
+ *    The element type may change between stages, maps keep it and other stages return a new one.
+ *    Stages are called concurrently from several threads under parallel policies, so must be safe to call through a const reference.
+ *
+ *    p.stage_count()      number of stages added to the pipeline
+ *    p.size()             number of stages after composing consecutive maps
+ *    p.passes_saved()     number of passes through memory saved compared to applying each added stage separately
+ *
+ *    Code example:
+ *
+ *       constexpr auto camera = affine::pipeline() | local_to_world | world_to_camera
+ *                                                  | []( const point3& p ){ return point2{{p[0]/p[2],p[1]/p[2]}}; }
+ *                                                  | camera_to_pixels;
+ *
+ *       static_assert( camera.size()==3 );
+ *       camera( affine::execution::par, std::span<const point3>(vertices), std::span(pixels) );  // saves 3 passes
+ */
+
+# include "map.h"
+# include "parallel.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <cstddef>
+# include <functional>
+# include <span>
+# include <tuple>
+# include <type_traits>
+# include <utility>
+
+namespace affine
+{
+
+   // number of elements processed by all the stages of a pipeline before moving on
+   constexpr std::size_t pipeline_tile = 256;
+
+namespace detail
+{
+   template<typename T>
+   struct is_map : std::false_type {};
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   struct is_map<linear_map<N,M,num_t>> : std::true_type {};
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   struct is_map<affine_map<N,M,num_t>> : std::true_type {};
+
+   template<typename T>
+   concept map_stage = is_map<T>::value;
+
+   // maps g and f that can be composed into g*f
+   template<typename G, typename F>
+   concept composable_maps =
+      map_stage<G> && map_stage<F>
+   && std::same_as<typename G::value_type,typename F::value_type>
+   && G::domain_size==F::range_size;
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   constexpr affine_map<N,M,num_t> as_affine( const affine_map<N,M,num_t>& f ){ return f; }
+
+   template<std::size_t N, std::size_t M, typename num_t>
+   constexpr affine_map<N,M,num_t> as_affine( const linear_map<N,M,num_t>& f ){ return { f, {} }; }
+
+   // g*f, an affine map if either is
+   template<typename G, typename F>
+   [[nodiscard]]
+   constexpr auto compose( const G& g, const F& f )
+  {
+      if constexpr( requires{ g*f; } ){ return g*f; }
+      else { return as_affine(g)*as_affine(f); }
+  }
+
+   // element type produced by stage_t from T, maps keep the type
+   template<typename stage_t, typename T>
+   struct stage_result { using type = std::remove_cvref_t<std::invoke_result_t<const stage_t&,const T&>>; };
+
+   template<map_stage stage_t, typename T>
+   struct stage_result<stage_t,T> { using type = T; };
+
+   template<typename T, typename... stages_t>
+   struct pipeline_result { using type = T; };
+
+   template<typename T, typename stage_t, typename... stages_t>
+   struct pipeline_result<T,stage_t,stages_t...> { using type = typename pipeline_result<typename stage_result<stage_t,T>::type,stages_t...>::type; };
+
+   // y[i] = s(x[i])
+   template<typename stage_t, typename T, typename result_t>
+   void apply_stage( const stage_t& s, const std::span<const T> x, const std::span<result_t> y )
+  {
+      if constexpr( map_stage<stage_t> ){ apply( s, x, y ); }
+      else
+     {
+         for( std::size_t i=0; i<x.size(); ++i ){ y[i]=std::invoke( s, x[i] ); }
+     }
+  }
+}
+
+/*
+ * sequence of transforms applied in a single pass, see pipeline()
+ */
+   template<typename... stages_t>
+   class transform_pipeline
+  {
+      template<typename...> friend class transform_pipeline;
+
+      std::tuple<stages_t...> stages;
+      std::size_t added=0;
+
+      template<std::size_t k, typename T, typename result_t>
+      void run_tile( const std::span<const T> x, const std::span<result_t> y ) const
+     {
+         if constexpr( k==sizeof...(stages_t) ){ std::copy( x.begin(), x.end(), y.begin() ); }
+         else
+        {
+            using next_t = typename detail::stage_result<std::tuple_element_t<k,std::tuple<stages_t...>>,T>::type;
+            if constexpr( k+1==sizeof...(stages_t) ){ detail::apply_stage( std::get<k>(stages), x, y ); }
+            else
+           {
+               std::array<next_t,pipeline_tile> buffer;
+               const std::span<next_t> b( buffer.data(), x.size() );
+               detail::apply_stage( std::get<k>(stages), x, b );
+               run_tile<k+1>( std::span<const next_t>(b), y );
+           }
+        }
+     }
+
+      template<typename stage_t, std::size_t... i>
+      [[nodiscard]]
+      constexpr auto compose_last( const stage_t& s, std::index_sequence<i...> ) const
+     {
+         auto f = detail::compose( s, std::get<sizeof...(stages_t)-1>(stages) );
+         return transform_pipeline<std::tuple_element_t<i,std::tuple<stages_t...>>...,decltype(f)>( { std::get<i>(stages)..., f }, added+1 );
+     }
+
+   public:
+
+      constexpr transform_pipeline() = default;
+
+      constexpr transform_pipeline( std::tuple<stages_t...> s, const std::size_t n )
+         : stages(std::move(s)), added(n) {}
+
+      // number of stages after composing consecutive maps
+      [[nodiscard]] constexpr static std::size_t size() noexcept { return sizeof...(stages_t); }
+
+      // number of stages added
+      [[nodiscard]] constexpr std::size_t stage_count() const noexcept { return added; }
+
+      // passes through memory saved by applying every stage to each tile in turn
+      [[nodiscard]] constexpr std::size_t passes_saved() const noexcept { return added>0 ? added-1 : 0; }
+
+      [[nodiscard]] constexpr const std::tuple<stages_t...>& stage_tuple() const noexcept { return stages; }
+
+      // this pipeline followed by s, composing s with the last stage if both are maps
+      template<typename stage_t>
+      [[nodiscard]]
+      constexpr auto operator|( const stage_t& s ) const
+     {
+         if constexpr( sizeof...(stages_t)>0 )
+        {
+            if constexpr( detail::composable_maps<stage_t,std::tuple_element_t<sizeof...(stages_t)-1,std::tuple<stages_t...>>> )
+           {
+               return compose_last( s, std::make_index_sequence<sizeof...(stages_t)-1>{} );
+           }
+            else { return transform_pipeline<stages_t...,stage_t>( std::tuple_cat( stages, std::tuple<stage_t>(s) ), added+1 ); }
+        }
+         else { return transform_pipeline<stage_t>( std::tuple<stage_t>(s), added+1 ); }
+     }
+
+      // single element
+      template<typename T>
+         requires requires{ typename T::point_type; }
+      [[nodiscard]]
+      constexpr auto operator()( const T& x ) const
+     {
+         typename detail::pipeline_result<T,stages_t...>::type y;
+         run_tile<0>( std::span<const T>(&x,1), std::span(&y,1) );
+         return y;
+     }
+
+      // y[i] = pipeline(x[i])
+      template<execution_policy policy_t, typename T, typename result_t>
+         requires std::same_as<typename detail::pipeline_result<std::remove_const_t<T>,stages_t...>::type,result_t>
+      void operator()( policy_t&& policy, const std::span<T> x, const std::span<result_t> y ) const
+     {
+         using value_t = std::remove_const_t<T>;
+         assert( x.size()==y.size() );
+         detail::parallel_for( policy, x.size(),
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t i=b; i<e; i+=pipeline_tile )
+                                 {
+                                     const std::size_t n = std::min( pipeline_tile, e-i );
+                                     run_tile<0>( std::span<const value_t>( x.data()+i, n ), y.subspan( i, n ) );
+                                 }
+                              } );
+     }
+
+      // x[i] = pipeline(x[i])
+      template<execution_policy policy_t, typename T>
+         requires std::same_as<typename detail::pipeline_result<T,stages_t...>::type,T>
+      void operator()( policy_t&& policy, const std::span<T> x ) const
+     {
+         (*this)( policy, std::span<const T>(x), x );
+     }
+
+      template<typename T, typename result_t>
+      void operator()( const std::span<T> x, const std::span<result_t> y ) const { (*this)( execution::seq, x, y ); }
+
+      template<typename T>
+      void operator()( const std::span<T> x ) const { (*this)( execution::seq, x ); }
+  };
+
+   // empty pipeline, add stages with operator|
+   [[nodiscard]]
+   constexpr transform_pipeline<> pipeline() noexcept { return {}; }
+}
@@ -0,0 +1,991 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines structure-of-arrays (SoA) containers for the point and delta types of an affine space.
+ *
+ *    point_array<point_t> and delta_array<delta_t> hold a sequence of point_t/delta_t, but store each coordinate in its own contiguous column.
+ *    Every column starts on a column_alignment byte boundary, so loops over a column are unit-stride and can be vectorised across elements.
+ *
+ *    The bulk arithmetic follows the same rules as the free operators in affine_space.h, applied elementwise in one pass over each column,
+ *    i.e. delta_arrays can be added/subtracted to give other delta_arrays,
+ *         delta_arrays can be added/subtracted to/from point_arrays to give other point_arrays,
+ *         point_arrays can be subtracted to give delta_arrays,
+ *         delta_arrays can be multiplied by scalars to give other delta_arrays,
+ *         point_arrays cannot be added, nor multiplied by scalars
+ *         in-place versions of these operations are also defined
+ *    Both operands of a binary operation must have the same size.
+ *
+ *    Elements are accessed through proxy references, which read and write the columns directly.
+ *    A proxy converts implicitly to point_t/delta_t, and supports the same accessors and arithmetic as the type it refers to.
+ *
+ *    Code example:
+ *
+ *       point_array<cartesian_point_t<3>> x0(n),x1(n);
+ *       delta_array<cartesian_delta_t<3>> d0(n),d1(n);
+ *       const double a = ...
+ *
+ *       // ... initialise ... x0[i][0]= ... or x0.column(0)[i]= ...
+ *
+ *       d1 = x1-x0;
+ *       x1 = x0+a*d0;
+ *       x1+= d1;
+ *
+ *       cartesian_delta_t<3> d = x1[i]-x0[j];
+ *       x0[i]+=d;
+ *
+ *       // x0 = x0+x1;    // will not compile!
+ */
+
+# include "affine_space.h"
+
+# include <algorithm>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <functional>
+# include <initializer_list>
+# include <iterator>
+# include <memory>
+# include <new>
+# include <span>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+/*
+ * alignment in bytes of the start of every column
+ *    one cache line, which is also the width of an avx512 register
+ */
+   constexpr std::size_t column_alignment = 64;
+
+/*
+ * minimal allocator for over-aligned storage
+ */
+   template<typename T,
+            std::size_t alignment = column_alignment>
+   struct aligned_allocator
+  {
+      using value_type = T;
+
+      template<typename U>
+      struct rebind { using other = aligned_allocator<U,alignment>; };
+
+      constexpr aligned_allocator() noexcept = default;
+
+      template<typename U>
+      constexpr aligned_allocator( const aligned_allocator<U,alignment>& ) noexcept {}
+
+      [[nodiscard]]
+      T* allocate( const std::size_t n )
+     {
+         return static_cast<T*>( ::operator new( n*sizeof(T), std::align_val_t{alignment} ) );
+     }
+
+      void deallocate( T* p, const std::size_t ) noexcept
+     {
+         ::operator delete( p, std::align_val_t{alignment} );
+     }
+
+      template<typename U>
+      [[nodiscard]]
+      constexpr bool operator==( const aligned_allocator<U,alignment>& ) const noexcept { return true; }
+  };
+
+// --------------- forward declarations ---------------
+
+   template<typename point_t>
+   class point_array;
+
+   template<typename delta_t>
+   class delta_array;
+
+   template<typename point_t,
+            typename value_t>
+   class point_reference;
+
+   template<typename delta_t,
+            typename value_t>
+   class delta_reference;
+
+namespace detail
+{
+   // number of columns needed to store T, scalar spaces use a single column
+   template<typename T>
+   consteval std::size_t column_count()
+  {
+      if constexpr( T::vector_valued ){ return T::size(); }
+      else{ return 1; }
+  }
+
+   // column length rounded up so that consecutive columns stay aligned
+   template<typename num_t>
+   constexpr std::size_t padded_length( const std::size_t n )
+  {
+      constexpr std::size_t width = column_alignment/sizeof(num_t);
+      return (n+width-1)/width*width;
+  }
+
+   // out[i] = op(lhs[i],rhs[i]) over one aligned column, the columns of points and deltas may have different number types
+   template<typename out_t, typename lhs_t, typename rhs_t, typename op_t>
+   constexpr void column_transform( const std::size_t n,
+                                          out_t* out,
+                                    const lhs_t* lhs,
+                                    const rhs_t* rhs,
+                                          op_t   op )
+  {
+      out = std::assume_aligned<column_alignment>(out);
+      lhs = std::assume_aligned<column_alignment>(lhs);
+      rhs = std::assume_aligned<column_alignment>(rhs);
+      for( std::size_t i=0; i<n; ++i ){ out[i]=static_cast<out_t>(op(lhs[i],rhs[i])); }
+  }
+
+   // p+d, p-d and p-q for one coordinate, see affine_space.h
+   struct offset_op
+  {
+      template<typename num_t, typename dnum_t>
+      constexpr num_t operator()( const num_t& p, const dnum_t& d ) const { return offset_coordinate(p,d); }
+  };
+
+   struct negative_offset_op
+  {
+      template<typename num_t, typename dnum_t>
+      constexpr num_t operator()( const num_t& p, const dnum_t& d ) const { return negative_offset_coordinate(p,d); }
+  };
+
+   template<typename dnum_t>
+   struct difference_op
+  {
+      template<typename num_t>
+      constexpr dnum_t operator()( const num_t& p, const num_t& q ) const { return difference_coordinate<dnum_t>(p,q); }
+  };
+
+   // out[i] = op(in[i]) over one aligned column, converted back to num_t since narrow integers are promoted by op
+   template<typename num_t, typename op_t>
+   constexpr void column_transform( const std::size_t n,
+                                          num_t* out,
+                                    const num_t* in,
+                                          op_t   op )
+  {
+      out = std::assume_aligned<column_alignment>(out);
+      in  = std::assume_aligned<column_alignment>(in);
+      for( std::size_t i=0; i<n; ++i ){ out[i]=static_cast<num_t>( op(in[i]) ); }
+  }
+
+   template<typename T>
+   struct is_point_reference : std::false_type {};
+
+   template<typename point_t, typename value_t>
+   struct is_point_reference<point_reference<point_t,value_t>> : std::true_type {};
+
+   template<typename T>
+   struct is_delta_reference : std::false_type {};
+
+   template<typename delta_t, typename value_t>
+   struct is_delta_reference<delta_reference<delta_t,value_t>> : std::true_type {};
+
+   // T is either point_t or a proxy reference to a point_t
+   template<typename T, typename point_t>
+   concept point_operand =
+      std::same_as<T,point_t> || ( is_point_reference<T>::value && std::same_as<typename T::point_type,point_t> );
+
+   // T is either delta_t or a proxy reference to a delta_t
+   template<typename T, typename delta_t>
+   concept delta_operand =
+      std::same_as<T,delta_t> || ( is_delta_reference<T>::value && std::same_as<typename T::delta_type,delta_t> );
+
+   // at least one of the operands is a proxy, otherwise the operators in affine_space.h apply
+   template<typename lhs_t, typename rhs_t>
+   concept has_reference_operand =
+      is_point_reference<lhs_t>::value || is_point_reference<rhs_t>::value
+   || is_delta_reference<lhs_t>::value || is_delta_reference<rhs_t>::value;
+
+/*
+ * random access iterator over the elements of a point_array or delta_array, dereferencing to a proxy
+ */
+   template<typename reference_t,
+            typename value_t>
+   class column_iterator
+  {
+      public:
+
+      using iterator_concept = std::random_access_iterator_tag;
+      using value_type       = typename reference_t::referenced_type;
+      using difference_type  = std::ptrdiff_t;
+      using reference        = reference_t;
+
+      constexpr column_iterator() noexcept = default;
+      constexpr column_iterator( value_t* p, const std::size_t s ) noexcept : first(p), stride(s) {}
+
+      [[nodiscard]] constexpr reference operator*() const { return reference(first,stride); }
+      [[nodiscard]] constexpr reference operator[]( const difference_type n ) const { return reference(first+n,stride); }
+
+      constexpr column_iterator& operator++(){ ++first; return *this; }
+      constexpr column_iterator& operator--(){ --first; return *this; }
+      constexpr column_iterator  operator++(int){ auto tmp=*this; ++first; return tmp; }
+      constexpr column_iterator  operator--(int){ auto tmp=*this; --first; return tmp; }
+
+      constexpr column_iterator& operator+=( const difference_type n ){ first+=n; return *this; }
+      constexpr column_iterator& operator-=( const difference_type n ){ first-=n; return *this; }
+
+      [[nodiscard]] friend constexpr column_iterator operator+( column_iterator it, const difference_type n ){ return it+=n; }
+      [[nodiscard]] friend constexpr column_iterator operator+( const difference_type n, column_iterator it ){ return it+=n; }
+      [[nodiscard]] friend constexpr column_iterator operator-( column_iterator it, const difference_type n ){ return it-=n; }
+
+      [[nodiscard]] friend constexpr difference_type operator-( const column_iterator& lhs, const column_iterator& rhs ){ return lhs.first-rhs.first; }
+
+      [[nodiscard]] friend constexpr bool operator==( const column_iterator& lhs, const column_iterator& rhs ){ return lhs.first==rhs.first; }
+      [[nodiscard]] friend constexpr auto operator<=>( const column_iterator& lhs, const column_iterator& rhs ){ return lhs.first<=>rhs.first; }
+
+      private:
+
+      value_t*    first=nullptr;
+      std::size_t stride=0;
+  };
+
+/*
+ * aligned column buffer shared by point_array and delta_array
+ *    column c of element i is buffer[c*stride+i], stride is the capacity padded to column_alignment
+ */
+   template<typename num_t,
+            std::size_t ncols>
+   class column_storage
+  {
+      public:
+
+      using value_type = num_t;
+
+      constexpr column_storage() = default;
+
+      explicit column_storage( const std::size_t n )
+     {
+         resize(n);
+     }
+
+      [[nodiscard]] std::size_t size()     const noexcept { return length; }
+      [[nodiscard]] std::size_t capacity() const noexcept { return stride; }
+      [[nodiscard]] bool        empty()    const noexcept { return length==0; }
+
+      [[nodiscard]] constexpr static std::size_t columns() noexcept { return ncols; }
+
+      // contiguous, aligned storage for one coordinate of every element
+      [[nodiscard]] std::span<      num_t> column( const std::size_t c )       { return {data(c),length}; }
+      [[nodiscard]] std::span<const num_t> column( const std::size_t c ) const { return {data(c),length}; }
+
+      [[nodiscard]]       num_t* data( const std::size_t c=0 )       noexcept { return std::assume_aligned<column_alignment>(buffer.data()+c*stride); }
+      [[nodiscard]] const num_t* data( const std::size_t c=0 ) const noexcept { return std::assume_aligned<column_alignment>(buffer.data()+c*stride); }
+
+      void reserve( const std::size_t n )
+     {
+         if( n<=stride ){ return; }
+
+         const std::size_t new_stride = padded_length<num_t>(n);
+         std::vector<num_t,aligned_allocator<num_t>> new_buffer(ncols*new_stride,num_t{});
+
+         for( std::size_t c=0; c<ncols; ++c )
+        {
+            std::copy_n( buffer.data()+c*stride, length, new_buffer.data()+c*new_stride );
+        }
+
+         buffer.swap(new_buffer);
+         stride=new_stride;
+     }
+
+      // new elements are value initialised
+      void resize( const std::size_t n )
+     {
+         reserve(n);
+         for( std::size_t c=0; c<ncols && n<length; ++c )
+        {
+            std::fill( data(c)+n, data(c)+length, num_t{} );
+        }
+         length=n;
+     }
+
+      void clear() noexcept { resize(0); }
+
+      protected:
+
+      // make room for one more element at the back
+      void grow()
+     {
+         if( length==stride ){ reserve( std::max( 2*stride, padded_length<num_t>(1) ) ); }
+         ++length;
+     }
+
+      std::size_t length=0;
+      std::size_t stride=0;
+      std::vector<num_t,aligned_allocator<num_t>> buffer;
+  };
+}
+
+// --------------- proxy references ---------------
+
+/*
+ * proxy reference to one element of a point_array
+ *    value_t is const for references into a const point_array
+ */
+   template<typename point_t,
+            typename value_t>
+   class point_reference
+  {
+      public:
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+      using referenced_type = point_t;
+
+      constexpr static bool        vector_valued = point_t::vector_valued;
+      constexpr static std::size_t ncols = detail::column_count<point_t>();
+
+      // coordinate i is p[i*s], s=1 for contiguous coordinates
+      constexpr point_reference( value_t* p, const std::size_t s=1 ) noexcept : first(p), stride(s) {}
+
+      constexpr point_reference( const point_reference& ) noexcept = default;
+
+      [[nodiscard]]
+      constexpr static std::size_t size() requires vector_valued { return ncols; }
+
+   // accessors
+      [[nodiscard]] constexpr value_t& operator[]( const std::size_t i ) const requires vector_valued { return first[i*stride]; }
+
+      [[nodiscard]]
+      constexpr point_type value() const
+     {
+         point_type p{};
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ p[i]=first[i*stride]; }
+        }
+         else
+        {
+            p.element=*first;
+        }
+         return p;
+     }
+
+      constexpr operator point_type() const { return value(); }
+
+   // write through
+      constexpr const point_reference& operator=( const point_type& p ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]=p[i]; }
+        }
+         else
+        {
+            *first=p.element;
+        }
+         return *this;
+     }
+
+      constexpr const point_reference& operator=( const point_reference& other ) const requires (!std::is_const_v<value_t>)
+     {
+         return *this=other.value();
+     }
+
+   // in-place arithmetic
+      constexpr const point_reference& operator+=( const delta_type& d ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]=detail::offset_coordinate(first[i*stride],d[i]); }
+        }
+         else
+        {
+            *first=detail::offset_coordinate(*first,d.element);
+        }
+         return *this;
+     }
+
+      constexpr const point_reference& operator-=( const delta_type& d ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]=detail::negative_offset_coordinate(first[i*stride],d[i]); }
+        }
+         else
+        {
+            *first=detail::negative_offset_coordinate(*first,d.element);
+        }
+         return *this;
+     }
+
+      private:
+
+      value_t*    first;
+      std::size_t stride;
+  };
+
+/*
+ * proxy reference to one element of a delta_array
+ *    value_t is const for references into a const delta_array
+ */
+   template<typename delta_t,
+            typename value_t>
+   class delta_reference
+  {
+      public:
+
+      using point_type = typename delta_t::point_type;
+      using delta_type = delta_t;
+      using value_type = typename delta_t::value_type;
+      using referenced_type = delta_t;
+
+      constexpr static bool        vector_valued = delta_t::vector_valued;
+      constexpr static std::size_t ncols = detail::column_count<delta_t>();
+
+      // coordinate i is p[i*s], s=1 for contiguous coordinates
+      constexpr delta_reference( value_t* p, const std::size_t s=1 ) noexcept : first(p), stride(s) {}
+
+      constexpr delta_reference( const delta_reference& ) noexcept = default;
+
+      [[nodiscard]]
+      constexpr static std::size_t size() requires vector_valued { return ncols; }
+
+   // accessors
+      [[nodiscard]] constexpr value_t& operator[]( const std::size_t i ) const requires vector_valued { return first[i*stride]; }
+
+      [[nodiscard]]
+      constexpr delta_type value() const
+     {
+         delta_type d{};
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ d[i]=first[i*stride]; }
+        }
+         else
+        {
+            d.element=*first;
+        }
+         return d;
+     }
+
+      constexpr operator delta_type() const { return value(); }
+
+   // write through
+      constexpr const delta_reference& operator=( const delta_type& d ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]=d[i]; }
+        }
+         else
+        {
+            *first=d.element;
+        }
+         return *this;
+     }
+
+      constexpr const delta_reference& operator=( const delta_reference& other ) const requires (!std::is_const_v<value_t>)
+     {
+         return *this=other.value();
+     }
+
+   // in-place arithmetic
+      constexpr const delta_reference& operator+=( const delta_type& d ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]+=d[i]; }
+        }
+         else
+        {
+            *first+=d.element;
+        }
+         return *this;
+     }
+
+      constexpr const delta_reference& operator-=( const delta_type& d ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( vector_valued )
+        {
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]-=d[i]; }
+        }
+         else
+        {
+            *first-=d.element;
+        }
+         return *this;
+     }
+
+      constexpr const delta_reference& operator*=( const scale_factor<value_type> auto a ) const requires (!std::is_const_v<value_t>)
+     {
+         const value_type b = static_cast<value_type>(a);
+         for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]*=b; }
+         return *this;
+     }
+
+      // exact value_type divide each coordinate, see delta_base::operator/=
+      constexpr const delta_reference& operator/=( const scale_factor<value_type> auto a ) const requires (!std::is_const_v<value_t>)
+     {
+         if constexpr( exact_numeric<value_type> )
+        {
+            const value_type b = static_cast<value_type>(a);
+            for( std::size_t i=0; i<ncols; ++i ){ first[i*stride]/=b; }
+            return *this;
+        }
+         else
+        {
+            return *this*=value_type(1)/a;
+        }
+     }
+
+      [[nodiscard]]
+      constexpr delta_type operator-() const
+     {
+         return -value();
+     }
+
+      private:
+
+      value_t*    first;
+      std::size_t stride;
+  };
+
+// --------------- proxy arithmetic ---------------
+
+/*
+ * mixed proxy/value operands are converted to values and forwarded to the operators in affine_space.h
+ *    these only participate when at least one operand is a proxy
+ */
+
+   // d = p-p
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::has_reference_operand<lhs_t,rhs_t>
+            && detail::point_operand<lhs_t,typename lhs_t::point_type>
+            && detail::point_operand<rhs_t,typename lhs_t::point_type>
+   [[nodiscard]]
+   constexpr typename lhs_t::delta_type operator-( const lhs_t& lhs,
+                                                   const rhs_t& rhs )
+  {
+      using point_t = typename lhs_t::point_type;
+      return static_cast<point_t>(lhs)-static_cast<point_t>(rhs);
+  }
+
+   // p = p+d
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::has_reference_operand<lhs_t,rhs_t>
+            && detail::point_operand<lhs_t,typename lhs_t::point_type>
+            && detail::delta_operand<rhs_t,typename lhs_t::delta_type>
+   [[nodiscard]]
+   constexpr typename lhs_t::point_type operator+( const lhs_t& p,
+                                                   const rhs_t& d )
+  {
+      using point_t = typename lhs_t::point_type;
+      using delta_t = typename lhs_t::delta_type;
+      return static_cast<point_t>(p)+static_cast<delta_t>(d);
+  }
+
+   // p = p-d
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::has_reference_operand<lhs_t,rhs_t>
+            && detail::point_operand<lhs_t,typename lhs_t::point_type>
+            && detail::delta_operand<rhs_t,typename lhs_t::delta_type>
+   [[nodiscard]]
+   constexpr typename lhs_t::point_type operator-( const lhs_t& p,
+                                                   const rhs_t& d )
+  {
+      using point_t = typename lhs_t::point_type;
+      using delta_t = typename lhs_t::delta_type;
+      return static_cast<point_t>(p)-static_cast<delta_t>(d);
+  }
+
+   // d = d+d
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::has_reference_operand<lhs_t,rhs_t>
+            && detail::delta_operand<lhs_t,typename lhs_t::delta_type>
+            && detail::delta_operand<rhs_t,typename lhs_t::delta_type>
+   [[nodiscard]]
+   constexpr typename lhs_t::delta_type operator+( const lhs_t& lhs,
+                                                   const rhs_t& rhs )
+  {
+      using delta_t = typename lhs_t::delta_type;
+      return static_cast<delta_t>(lhs)+static_cast<delta_t>(rhs);
+  }
+
+   // d = d-d
+   template<typename lhs_t,
+            typename rhs_t>
+      requires detail::has_reference_operand<lhs_t,rhs_t>
+            && detail::delta_operand<lhs_t,typename lhs_t::delta_type>
+            && detail::delta_operand<rhs_t,typename lhs_t::delta_type>
+   [[nodiscard]]
+   constexpr typename lhs_t::delta_type operator-( const lhs_t& lhs,
+                                                   const rhs_t& rhs )
+  {
+      using delta_t = typename lhs_t::delta_type;
+      return static_cast<delta_t>(lhs)-static_cast<delta_t>(rhs);
+  }
+
+   // d = a*d
+   template<typename delta_t,
+            typename value_t>
+   [[nodiscard]]
+   constexpr delta_t operator*( const scale_factor<typename delta_t::value_type> auto a,
+                                const delta_reference<delta_t,value_t>& d )
+  {
+      return a*d.value();
+  }
+
+   // d = d*a
+   template<typename delta_t,
+            typename value_t>
+   [[nodiscard]]
+   constexpr delta_t operator*( const delta_reference<delta_t,value_t>& d,
+                                const scale_factor<typename delta_t::value_type> auto a )
+  {
+      return a*d.value();
+  }
+
+   // d = d/a
+   template<typename delta_t,
+            typename value_t>
+   [[nodiscard]]
+   constexpr delta_t operator/( const delta_reference<delta_t,value_t>& d,
+                                const scale_factor<typename delta_t::value_type> auto a )
+  {
+      return d.value()/a;
+  }
+
+// --------------- SoA containers ---------------
+
+/*
+ * structure-of-arrays container of point_t
+ */
+   template<typename point_t>
+   class point_array : public detail::column_storage<typename point_t::value_type,
+                                                     detail::column_count<point_t>()>
+  {
+      using storage_type = detail::column_storage<typename point_t::value_type,
+                                                  detail::column_count<point_t>()>;
+
+      public:
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using value_type = typename point_t::value_type;
+
+      using reference       = point_reference<point_t,value_type>;
+      using const_reference = point_reference<point_t,const value_type>;
+
+      using iterator       = detail::column_iterator<reference,value_type>;
+      using const_iterator = detail::column_iterator<const_reference,const value_type>;
+
+      using storage_type::storage_type;
+
+      explicit point_array( const std::span<const point_type> points )
+        : storage_type(points.size())
+     {
+         for( std::size_t i=0; i<points.size(); ++i ){ (*this)[i]=points[i]; }
+     }
+
+      point_array( const std::initializer_list<point_type> points )
+        : point_array(std::span<const point_type>(points.begin(),points.size())) {}
+
+   // element access
+      [[nodiscard]] reference       operator[]( const std::size_t i )       { return reference(this->data()+i,this->stride); }
+      [[nodiscard]] const_reference operator[]( const std::size_t i ) const { return const_reference(this->data()+i,this->stride); }
+
+      [[nodiscard]] iterator       begin()       { return iterator(this->data(),this->stride); }
+      [[nodiscard]] iterator       end()         { return iterator(this->data()+this->length,this->stride); }
+      [[nodiscard]] const_iterator begin() const { return const_iterator(this->data(),this->stride); }
+      [[nodiscard]] const_iterator end()   const { return const_iterator(this->data()+this->length,this->stride); }
+
+      void push_back( const point_type& p )
+     {
+         this->grow();
+         (*this)[this->length-1]=p;
+     }
+
+   // in-place arithmetic
+      point_array& operator+=( const delta_array<delta_type>& d )
+     {
+         assert( this->size()==d.size() );
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), this->data(c), this->data(c), d.data(c), detail::offset_op{} );
+        }
+         return *this;
+     }
+
+      point_array& operator-=( const delta_array<delta_type>& d )
+     {
+         assert( this->size()==d.size() );
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), this->data(c), this->data(c), d.data(c), detail::negative_offset_op{} );
+        }
+         return *this;
+     }
+  };
+
+/*
+ * structure-of-arrays container of delta_t
+ */
+   template<typename delta_t>
+   class delta_array : public detail::column_storage<typename delta_t::value_type,
+                                                     detail::column_count<delta_t>()>
+  {
+      using storage_type = detail::column_storage<typename delta_t::value_type,
+                                                  detail::column_count<delta_t>()>;
+
+      public:
+
+      using point_type = typename delta_t::point_type;
+      using delta_type = delta_t;
+      using value_type = typename delta_t::value_type;
+
+      using reference       = delta_reference<delta_t,value_type>;
+      using const_reference = delta_reference<delta_t,const value_type>;
+
+      using iterator       = detail::column_iterator<reference,value_type>;
+      using const_iterator = detail::column_iterator<const_reference,const value_type>;
+
+      using storage_type::storage_type;
+
+      explicit delta_array( const std::span<const delta_type> deltas )
+        : storage_type(deltas.size())
+     {
+         for( std::size_t i=0; i<deltas.size(); ++i ){ (*this)[i]=deltas[i]; }
+     }
+
+      delta_array( const std::initializer_list<delta_type> deltas )
+        : delta_array(std::span<const delta_type>(deltas.begin(),deltas.size())) {}
+
+   // element access
+      [[nodiscard]] reference       operator[]( const std::size_t i )       { return reference(this->data()+i,this->stride); }
+      [[nodiscard]] const_reference operator[]( const std::size_t i ) const { return const_reference(this->data()+i,this->stride); }
+
+      [[nodiscard]] iterator       begin()       { return iterator(this->data(),this->stride); }
+      [[nodiscard]] iterator       end()         { return iterator(this->data()+this->length,this->stride); }
+      [[nodiscard]] const_iterator begin() const { return const_iterator(this->data(),this->stride); }
+      [[nodiscard]] const_iterator end()   const { return const_iterator(this->data()+this->length,this->stride); }
+
+      void push_back( const delta_type& d )
+     {
+         this->grow();
+         (*this)[this->length-1]=d;
+     }
+
+   // in-place arithmetic
+      delta_array& operator+=( const delta_array& d )
+     {
+         assert( this->size()==d.size() );
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), this->data(c), this->data(c), d.data(c), std::plus<>{} );
+        }
+         return *this;
+     }
+
+      delta_array& operator-=( const delta_array& d )
+     {
+         assert( this->size()==d.size() );
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), this->data(c), this->data(c), d.data(c), std::minus<>{} );
+        }
+         return *this;
+     }
+
+      delta_array& operator*=( const scale_factor<value_type> auto a )
+     {
+         const value_type b = static_cast<value_type>(a);
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), this->data(c), this->data(c), [b]( const value_type x ){ return b*x; } );
+        }
+         return *this;
+     }
+
+      // exact value_type divide each coordinate, see delta_base::operator/=
+      delta_array& operator/=( const scale_factor<value_type> auto a )
+     {
+         if constexpr( exact_numeric<value_type> )
+        {
+            const value_type b = static_cast<value_type>(a);
+            for( std::size_t c=0; c<this->columns(); ++c )
+           {
+               detail::column_transform( this->size(), this->data(c), this->data(c), [b]( const value_type x ){ return x/b; } );
+           }
+            return *this;
+        }
+         else
+        {
+            return *this*=value_type(1)/a;
+        }
+     }
+
+      [[nodiscard]]
+      delta_array operator-() const
+     {
+         delta_array result(this->size());
+         for( std::size_t c=0; c<this->columns(); ++c )
+        {
+            detail::column_transform( this->size(), result.data(c), this->data(c), std::negate<>{} );
+        }
+         return result;
+     }
+  };
+
+// --------------- point_array arithmetic ---------------
+
+   // d = p-p
+   template<typename point_t>
+   [[nodiscard]]
+   delta_array<typename point_t::delta_type> operator-( const point_array<point_t>& lhs,
+                                                        const point_array<point_t>& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      delta_array<typename point_t::delta_type> result(lhs.size());
+      for( std::size_t c=0; c<lhs.columns(); ++c )
+     {
+         detail::column_transform( lhs.size(), result.data(c), lhs.data(c), rhs.data(c), detail::difference_op<typename point_t::delta_type::value_type>{} );
+     }
+      return result;
+  }
+
+   // p = p+d
+   template<typename point_t>
+   [[nodiscard]]
+   point_array<point_t> operator+( const point_array<point_t>& p,
+                                   const delta_array<typename point_t::delta_type>& d )
+  {
+      assert( p.size()==d.size() );
+      point_array<point_t> result(p.size());
+      for( std::size_t c=0; c<p.columns(); ++c )
+     {
+         detail::column_transform( p.size(), result.data(c), p.data(c), d.data(c), detail::offset_op{} );
+     }
+      return result;
+  }
+
+   // p = p-d
+   template<typename point_t>
+   [[nodiscard]]
+   point_array<point_t> operator-( const point_array<point_t>& p,
+                                   const delta_array<typename point_t::delta_type>& d )
+  {
+      assert( p.size()==d.size() );
+      point_array<point_t> result(p.size());
+      for( std::size_t c=0; c<p.columns(); ++c )
+     {
+         detail::column_transform( p.size(), result.data(c), p.data(c), d.data(c), detail::negative_offset_op{} );
+     }
+      return result;
+  }
+
+// --------------- delta_array arithmetic ---------------
+
+   // d = d+d
+   template<typename delta_t>
+   [[nodiscard]]
+   delta_array<delta_t> operator+( const delta_array<delta_t>& lhs,
+                                   const delta_array<delta_t>& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      delta_array<delta_t> result(lhs.size());
+      for( std::size_t c=0; c<lhs.columns(); ++c )
+     {
+         detail::column_transform( lhs.size(), result.data(c), lhs.data(c), rhs.data(c), std::plus<>{} );
+     }
+      return result;
+  }
+
+   // d = d-d
+   template<typename delta_t>
+   [[nodiscard]]
+   delta_array<delta_t> operator-( const delta_array<delta_t>& lhs,
+                                   const delta_array<delta_t>& rhs )
+  {
+      assert( lhs.size()==rhs.size() );
+      delta_array<delta_t> result(lhs.size());
+      for( std::size_t c=0; c<lhs.columns(); ++c )
+     {
+         detail::column_transform( lhs.size(), result.data(c), lhs.data(c), rhs.data(c), std::minus<>{} );
+     }
+      return result;
+  }
+
+   // d = a*d
+   template<typename delta_t>
+   [[nodiscard]]
+   delta_array<delta_t> operator*( const scale_factor<typename delta_t::value_type> auto a,
+                                   const delta_array<delta_t>& d )
+  {
+      using num_t = typename delta_t::value_type;
+      const num_t b = static_cast<num_t>(a);
+      delta_array<delta_t> result(d.size());
+      for( std::size_t c=0; c<d.columns(); ++c )
+     {
+         detail::column_transform( d.size(), result.data(c), d.data(c), [b]( const num_t x ){ return b*x; } );
+     }
+      return result;
+  }
+
+   // d = d*a
+   template<typename delta_t>
+   [[nodiscard]]
+   delta_array<delta_t> operator*( const delta_array<delta_t>& d,
+                                   const scale_factor<typename delta_t::value_type> auto a )
+  {
+      return a*d;
+  }
+
+   // d = d/a
+   template<typename delta_t>
+   [[nodiscard]]
+   delta_array<delta_t> operator/( const delta_array<delta_t>& d,
+                                   const scale_factor<typename delta_t::value_type> auto a )
+  {
+      using num_t = typename delta_t::value_type;
+      if constexpr( exact_numeric<num_t> )
+     {
+         delta_array<delta_t> result(d);
+         result/=a;
+         return result;
+     }
+      else
+     {
+         return (num_t(1)/a)*d;
+     }
+  }
+
+}
+
@@ -0,0 +1,302 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines a compressed container of points or deltas, with each coordinate quantized to a 16 bit integer.
+ *
+ *    quantized_array<T,code_t> stores a sequence of T (a point_t or delta_t) in blocks of block_size consecutive elements.
+ *    Each block stores the offset and step of a uniform grid per coordinate, spanning the bounding box of the block,
+ *    and each coordinate of each element is the nearest grid point, x[c] = offset[c]+step[c]*code with a std::uint16_t or std::int16_t code.
+ *    So the error of each coordinate is at most half a step, (max-min)/131070 for the bounding box [min,max] of the block.
+ *    The codes are stored in columns, 2 bytes per coordinate rather than 8 for double (4 for float), plus 2 numbers per coordinate per block.
+ *
+ *       q.assign(xs)          encode a span, point_array or delta_array of T, replacing the contents
+ *       q.decode(ys)          decode every element into a span, point_array or delta_array of T
+ *       q[i]                  decode element i
+ *       begin()/end()         random access iterators, which decode the element they point to
+ *    q[i] and the iterators are the slow path: they decode one element at a time in scalar code, gathering a code from every column.
+ *    Loops over many elements should decode them in bulk with q.decode, into a point_array/delta_array reused between calls.
+ *    Encoding and decoding convert one column of one block at a time with flat_bounds, flat_quantize and flat_dequantize (kernels.h),
+ *    which widen or pack 8 or 16 codes per instruction with avx2/avx512. The codes of a block are identical on every instruction set.
+ *    T must have a fixed ndim and floating point coordinates.
+ *
+ *    Code example:
+ *
+ *       affine::quantized_array<cartesian_point_t<3>> cloud( std::span<const cartesian_point_t<3>>(points) );   // 6 bytes per point
+ *
+ *       affine::point_array<cartesian_point_t<3>> xs;
+ *       cloud.decode( xs );
+ *
+ *       for( const cartesian_point_t<3> p : cloud ){ ... }
+ */
+
+# include "affine_space.h"
+# include "kernels.h"
+# include "point_array.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <cstdint>
+# include <iterator>
+# include <limits>
+# include <span>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+/*
+ * points and deltas which can be quantized
+ */
+   template<typename T>
+   concept quantizable =
+      T::vector_valued && !T::dynamic
+   && std::floating_point<typename T::value_type>;
+
+   // default number of elements sharing one grid in a quantized_array
+   constexpr std::size_t quantized_block = 1024;
+
+/*
+ * container of T with 16 bit integer coordinates, on a uniform grid per block of block_size elements
+ */
+   template<quantizable T,
+            detail::quantized_code code_t = std::uint16_t>
+   class quantized_array
+  {
+      public:
+
+      constexpr static std::size_t ndim = T::size();
+
+      using element_type = T;
+      using value_type   = typename T::value_type;
+      using code_type    = code_t;
+
+      // SoA container of T
+      using array_type = std::conditional_t<std::same_as<T,typename T::point_type>,point_array<T>,delta_array<T>>;
+
+/*
+ * random access iterator, which decodes the element it points to with operator[]
+ */
+      class const_iterator
+     {
+         public:
+
+         using iterator_category = std::random_access_iterator_tag;
+         using value_type        = T;
+         using difference_type   = std::ptrdiff_t;
+         using reference         = T;
+
+         constexpr const_iterator() = default;
+
+         const_iterator( const quantized_array* q, const std::size_t i ) : array(q), index(i) {}
+
+         [[nodiscard]] T operator*() const { return (*array)[index]; }
+         [[nodiscard]] T operator[]( const difference_type n ) const { return (*array)[index+static_cast<std::size_t>(n)]; }
+
+         const_iterator& operator++() { ++index; return *this; }
+         const_iterator& operator--() { --index; return *this; }
+         const_iterator  operator++( int ) { const_iterator it=*this; ++index; return it; }
+         const_iterator  operator--( int ) { const_iterator it=*this; --index; return it; }
+
+         const_iterator& operator+=( const difference_type n ) { index+=static_cast<std::size_t>(n); return *this; }
+         const_iterator& operator-=( const difference_type n ) { index-=static_cast<std::size_t>(n); return *this; }
+
+         [[nodiscard]] friend const_iterator operator+( const_iterator it, const difference_type n ) { return it+=n; }
+         [[nodiscard]] friend const_iterator operator+( const difference_type n, const_iterator it ) { return it+=n; }
+         [[nodiscard]] friend const_iterator operator-( const_iterator it, const difference_type n ) { return it-=n; }
+
+         [[nodiscard]] friend difference_type operator-( const const_iterator& a, const const_iterator& b )
+        {
+            return static_cast<difference_type>(a.index)-static_cast<difference_type>(b.index);
+        }
+
+         [[nodiscard]] friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a.index==b.index; }
+         [[nodiscard]] friend auto operator<=>( const const_iterator& a, const const_iterator& b ) { return a.index<=>b.index; }
+
+         private:
+
+         const quantized_array* array=nullptr;
+         std::size_t index=0;
+     };
+
+      using iterator = const_iterator;
+
+      explicit quantized_array( const std::size_t block_size=quantized_block )
+        : block_length(block_size)
+     {
+         assert( block_size>0 );
+     }
+
+      explicit quantized_array( const std::span<const T> xs,
+                                const std::size_t block_size=quantized_block )
+        : quantized_array(block_size)
+     {
+         assign(xs);
+     }
+
+      explicit quantized_array( const array_type& xs,
+                                const std::size_t block_size=quantized_block )
+        : quantized_array(block_size)
+     {
+         assign(xs);
+     }
+
+      [[nodiscard]] std::size_t size()       const noexcept { return codes.size(); }
+      [[nodiscard]] bool        empty()      const noexcept { return codes.empty(); }
+      [[nodiscard]] std::size_t blocks()     const noexcept { return offsets.size(); }
+      [[nodiscard]] std::size_t block_size() const noexcept { return block_length; }
+
+      // block of element i, and the range of elements [begin,end) in block b
+      [[nodiscard]] std::size_t block( const std::size_t i )       const noexcept { return i/block_length; }
+      [[nodiscard]] std::size_t block_begin( const std::size_t b ) const noexcept { return b*block_length; }
+      [[nodiscard]] std::size_t block_end( const std::size_t b )   const noexcept { return std::min( (b+1)*block_length, size() ); }
+
+      // grid of block b, coordinate c of element i is offset(b)[c]+step(b)[c]*code(c)[i]
+      [[nodiscard]] const std::array<value_type,ndim>& offset( const std::size_t b ) const { return offsets[b]; }
+      [[nodiscard]] const std::array<value_type,ndim>& step( const std::size_t b )   const { return steps[b]; }
+
+      // contiguous, aligned codes for one coordinate of every element
+      [[nodiscard]] std::span<const code_t> code( const std::size_t c ) const { return codes.column(c); }
+
+      // one element in scalar code, decode(ys) converts whole columns with the vector kernels
+      [[nodiscard]]
+      T operator[]( const std::size_t i ) const
+     {
+         const std::size_t b = block(i);
+         return detail::elementwise<T,ndim>( [&]( const std::size_t c )
+        {
+            return offsets[b][c]+steps[b][c]*static_cast<value_type>(codes.data(c)[i]);
+        } );
+     }
+
+      [[nodiscard]] const_iterator begin() const { return const_iterator(this,0); }
+      [[nodiscard]] const_iterator end()   const { return const_iterator(this,size()); }
+
+   // encoding
+
+      void assign( const std::span<const T> xs )
+     {
+         resize( xs.size() );
+         std::vector<value_type,aligned_allocator<value_type>> column(block_length);
+         for( std::size_t b=0; b<blocks(); ++b )
+        {
+            const std::size_t first = block_begin(b);
+            const std::size_t last  = block_end(b);
+            for( std::size_t c=0; c<ndim; ++c )
+           {
+               for( std::size_t i=first; i<last; ++i ){ column[i-first]=xs[i][c]; }
+               encode( b, c, column.data(), codes.data(c)+first, last-first );
+           }
+        }
+     }
+
+      void assign( const array_type& xs )
+     {
+         resize( xs.size() );
+         for( std::size_t b=0; b<blocks(); ++b )
+        {
+            const std::size_t first = block_begin(b);
+            const std::size_t last  = block_end(b);
+            for( std::size_t c=0; c<ndim; ++c ){ encode( b, c, xs.data(c)+first, codes.data(c)+first, last-first ); }
+        }
+     }
+
+   // decoding
+
+      void decode( const std::span<T> ys ) const
+     {
+         assert( ys.size()==size() );
+         std::vector<value_type,aligned_allocator<value_type>> column(block_length);
+         for( std::size_t b=0; b<blocks(); ++b )
+        {
+            const std::size_t first = block_begin(b);
+            const std::size_t last  = block_end(b);
+            for( std::size_t c=0; c<ndim; ++c )
+           {
+               detail::flat_dequantize( last-first, offsets[b][c], steps[b][c], codes.data(c)+first, column.data() );
+               for( std::size_t i=first; i<last; ++i ){ ys[i][c]=column[i-first]; }
+           }
+        }
+     }
+
+      void decode( array_type& ys ) const
+     {
+         ys.resize( size() );
+         for( std::size_t b=0; b<blocks(); ++b )
+        {
+            const std::size_t first = block_begin(b);
+            const std::size_t last  = block_end(b);
+            for( std::size_t c=0; c<ndim; ++c )
+           {
+               detail::flat_dequantize( last-first, offsets[b][c], steps[b][c], codes.data(c)+first, ys.data(c)+first );
+           }
+        }
+     }
+
+      private:
+
+      void resize( const std::size_t n )
+     {
+         codes.resize(n);
+         offsets.resize( (n+block_length-1)/block_length );
+         steps.resize( offsets.size() );
+     }
+
+      // the grid of coordinate c of block b spans the range of x, and the codes are the nearest grid points
+      void encode( const std::size_t b, const std::size_t c, const value_type* x, code_t* q, const std::size_t n )
+     {
+         value_type lo = x[0];
+         value_type hi = x[0];
+         detail::flat_bounds( n, x, &lo, &hi );
+
+         constexpr auto first_code = static_cast<value_type>( std::numeric_limits<code_t>::min() );
+         constexpr auto codes_span = static_cast<value_type>( std::numeric_limits<code_t>::max() )-first_code;
+
+         const value_type step = (hi-lo)/codes_span;
+         const value_type inverse_step = step>value_type(0) ? value_type(1)/step : value_type(0);
+
+         // offset+step*first_code is the lowest coordinate
+         steps[b][c] = step;
+         offsets[b][c] = lo-step*first_code;
+
+         detail::flat_quantize( n, offsets[b][c], inverse_step, x, q );
+     }
+
+      std::size_t block_length;
+      std::vector<std::array<value_type,ndim>> offsets;
+      std::vector<std::array<value_type,ndim>> steps;
+      detail::column_storage<code_t,ndim> codes;
+  };
+
+}
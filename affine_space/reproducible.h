@@ -0,0 +1,199 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines sums, centroids and dot products of ranges of points and deltas which are bitwise reproducible.
+ *
+ *    Floating point addition is not associative, so the reductions of combination.h and compensated.h change in the last bits
+ *    with the number of chunks, ie with the policy and the number of hardware threads. The reproducible versions split the range
+ *    into blocks of a fixed size (detail::blocked_reduce in parallel.h), sum each block over a fixed number of accumulators whatever
+ *    the policy, and combine the sums of the blocks with a fixed tree reduction. The order of every addition only depends on the
+ *    size of the range, so the result is identical for seq, unseq, par and par_unseq on any number of threads.
+ *
+ *       reproducible_sum(deltas)          Σ d_i
+ *       reproducible_centroid(points)     p_0 + Σ (p_i-p_0)/n
+ *       reproducible_dot(m,ds,es)         Σ <d_i,e_i> with the metric m (see metric.h), or the default metric of delta_t
+ *
+ *    The ranges can be any sized random access range, eg std::vector, std::span, point_array or delta_array.
+ *    As for centroid, the division by n is in the delta coordinates, and truncates towards p_0 for exact number types.
+ *    The result is the same across builds only if they round the same way, eg a compiler which contracts a*b+c to fma does not.
+ *
+ *    Code example:
+ *
+ *       const cartesian_point_t<3> c = affine::reproducible_centroid( affine::execution::par, positions );
+ *       const double work = affine::reproducible_dot( affine::execution::par, forces, displacements );
+ */
+
+# include "affine_space.h"
+# include "combination.h"
+# include "metric.h"
+# include "parallel.h"
+
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <functional>
+# include <ranges>
+
+namespace affine
+{
+
+namespace detail
+{
+   // sum of a block, over reduction_lanes accumulators whatever the policy of the reduction
+   using block_lanes = execution::unsequenced_policy;
+}
+
+// --------------- reproducible_sum ---------------
+
+   // Σ d_i
+   template<execution_policy policy_t, typename deltas_t>
+      requires delta_range<deltas_t>
+   [[nodiscard]]
+   auto reproducible_sum( policy_t&& policy, const deltas_t& deltas )
+  {
+      using delta_t = std::ranges::range_value_t<deltas_t>;
+
+      const std::size_t n = std::ranges::size(deltas);
+      const auto d = std::ranges::begin(deltas);
+      const delta_t zero = n>0 ? detail::zero_delta( static_cast<delta_t>(d[0]) ) : delta_t{};
+
+      return detail::blocked_reduce( policy, n, zero,
+                                     [&]( const std::size_t b, const std::size_t e )
+                                    {
+                                        return detail::chunk_sum<detail::block_lanes,delta_t>( b, e, zero,
+                                           [&]( const std::size_t i ){ return static_cast<delta_t>(d[i]); } );
+                                    },
+                                     std::plus{} );
+  }
+
+   template<typename deltas_t>
+      requires delta_range<deltas_t>
+   [[nodiscard]]
+   auto reproducible_sum( const deltas_t& deltas )
+  {
+      return reproducible_sum( execution::seq, deltas );
+  }
+
+// --------------- reproducible_centroid ---------------
+
+   // p_0 + Σ (p_i-p_0)/n
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto reproducible_centroid( policy_t&& policy, const points_t& points )
+  {
+      using point_t = std::ranges::range_value_t<points_t>;
+      using delta_t = typename point_t::delta_type;
+      using num_t = typename delta_t::value_type;
+
+      const std::size_t n = std::ranges::size(points);
+      assert( n>0 );
+
+      const auto p = std::ranges::begin(points);
+      const point_t p0 = p[0];
+      const delta_t zero = detail::zero_delta(p0);
+
+      const delta_t sum =
+         detail::blocked_reduce( policy, n, zero,
+                                 [&]( const std::size_t b, const std::size_t e )
+                                {
+                                    return detail::chunk_sum<detail::block_lanes,delta_t>( b, e, zero,
+                                       [&]( const std::size_t i ){ return p[i]-p0; } );
+                                },
+                                 std::plus{} );
+      return p0+sum/static_cast<num_t>(n);
+  }
+
+   template<typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto reproducible_centroid( const points_t& points )
+  {
+      return reproducible_centroid( execution::seq, points );
+  }
+
+// --------------- reproducible_dot ---------------
+
+   // Σ <d_i,e_i>
+   template<execution_policy policy_t, typename metric_t, typename deltas_t, typename others_t>
+      requires delta_range<deltas_t> && delta_range<others_t>
+            && std::same_as<std::ranges::range_value_t<deltas_t>,std::ranges::range_value_t<others_t>>
+            && metric<metric_t,std::ranges::range_value_t<deltas_t>>
+   [[nodiscard]]
+   auto reproducible_dot( policy_t&& policy, const metric_t& m, const deltas_t& deltas, const others_t& others )
+  {
+      using delta_t = std::ranges::range_value_t<deltas_t>;
+      using num_t = typename delta_t::value_type;
+
+      const std::size_t n = std::ranges::size(deltas);
+      assert( std::ranges::size(others)==n );
+
+      const auto d = std::ranges::begin(deltas);
+      const auto e = std::ranges::begin(others);
+
+      return detail::blocked_reduce( policy, n, num_t(0),
+                                     [&]( const std::size_t b, const std::size_t f )
+                                    {
+                                        return detail::chunk_sum<detail::block_lanes,num_t>( b, f, num_t(0),
+                                           [&]( const std::size_t i ){ return dot( m, static_cast<delta_t>(d[i]), static_cast<delta_t>(e[i]) ); } );
+                                    },
+                                     std::plus{} );
+  }
+
+   template<execution_policy policy_t, typename deltas_t, typename others_t>
+      requires delta_range<deltas_t> && delta_range<others_t>
+            && std::same_as<std::ranges::range_value_t<deltas_t>,std::ranges::range_value_t<others_t>>
+   [[nodiscard]]
+   auto reproducible_dot( policy_t&& policy, const deltas_t& deltas, const others_t& others )
+  {
+      return reproducible_dot( policy, default_metric<std::ranges::range_value_t<deltas_t>>{}, deltas, others );
+  }
+
+   template<typename metric_t, typename deltas_t, typename others_t>
+      requires delta_range<deltas_t> && delta_range<others_t>
+            && std::same_as<std::ranges::range_value_t<deltas_t>,std::ranges::range_value_t<others_t>>
+            && metric<metric_t,std::ranges::range_value_t<deltas_t>>
+   [[nodiscard]]
+   auto reproducible_dot( const metric_t& m, const deltas_t& deltas, const others_t& others )
+  {
+      return reproducible_dot( execution::seq, m, deltas, others );
+  }
+
+   template<typename deltas_t, typename others_t>
+      requires delta_range<deltas_t> && delta_range<others_t>
+            && std::same_as<std::ranges::range_value_t<deltas_t>,std::ranges::range_value_t<others_t>>
+   [[nodiscard]]
+   auto reproducible_dot( const deltas_t& deltas, const others_t& others )
+  {
+      return reproducible_dot( execution::seq, deltas, others );
+  }
+
+}
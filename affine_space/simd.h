@@ -0,0 +1,312 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines a fixed width simd pack type which satisfies the numeric concept in affine_space.h.
+ *
+ *    simd<T,W> holds W lanes of the floating point type T, and each arithmetic operation acts on all lanes at once.
+ *    Using simd<T,W> as num_t, a single point_t/delta_t holds W points/deltas (one per lane), and the existing operators process all of them in each instruction.
+ *
+ *    The backend is chosen at compile time from the instruction sets enabled for the target:
+ *       16 byte packs use sse/sse2, 32 byte packs use avx, 64 byte packs use avx512f
+ *       any other pack, or one wider than the target supports, falls back to a loop over an array
+ *    simd_double and simd_float are the widest packs supported natively by the target.
+ *
+ *    Scalars convert implicitly to packs by broadcasting to every lane, so a*d works for scalar a.
+ *    Packs are loaded/stored from W contiguous values, and individual lanes are read with the [] operator.
+ *
+ *    Code example:
+ *
+ *       template<std::size_t N> struct particle_point_t;
+ *       template<std::size_t N> struct particle_delta_t;
+ *
+ *       template<std::size_t N>
+ *       struct particle_point_t :
+ *          point_base<N,
+ *                     particle_point_t<N>,
+ *                     particle_delta_t<N>,
+ *                     simd_double> {};
+ *
+ *       ... particle_delta_t similarly ...
+ *
+ *       particle_point_t<3> x;      // simd_double::size() points
+ *       particle_delta_t<3> v;
+ *
+ *       x[0] = simd_double::load( xs );
+ *       ...
+ *       x+= dt*v;                   // dt is a double, broadcast to all lanes
+ *       x[0].store( xs );
+ */
+
+# include "affine_space.h"
+
+# include <array>
+# include <bit>
+# include <cstddef>
+# include <type_traits>
+
+# if defined(__SSE2__) || defined(__AVX__) || defined(__AVX512F__)
+# include <immintrin.h>
+# endif
+
+namespace affine
+{
+
+/*
+ * widest register in bytes supported by the target
+ */
+# if defined(__AVX512F__)
+   constexpr std::size_t native_simd_bytes = 64;
+# elif defined(__AVX__)
+   constexpr std::size_t native_simd_bytes = 32;
+# elif defined(__SSE2__)
+   constexpr std::size_t native_simd_bytes = 16;
+# else
+   constexpr std::size_t native_simd_bytes = 0;
+# endif
+
+namespace detail
+{
+/*
+ * generic backend, loops over an array of lanes
+ */
+   template<typename T,
+            std::size_t W>
+   struct simd_backend
+  {
+      struct alignas(std::bit_ceil(W*sizeof(T))) register_type { std::array<T,W> lanes; };
+
+      static register_type broadcast( const T x ){ register_type r; r.lanes.fill(x); return r; }
+
+      static register_type load( const T* p ){ register_type r; for( std::size_t i=0; i<W; ++i ){ r.lanes[i]=p[i]; } return r; }
+      static void store( T* p, const register_type r ){ for( std::size_t i=0; i<W; ++i ){ p[i]=r.lanes[i]; } }
+
+      static register_type add( register_type a, const register_type b ){ for( std::size_t i=0; i<W; ++i ){ a.lanes[i]+=b.lanes[i]; } return a; }
+      static register_type sub( register_type a, const register_type b ){ for( std::size_t i=0; i<W; ++i ){ a.lanes[i]-=b.lanes[i]; } return a; }
+      static register_type mul( register_type a, const register_type b ){ for( std::size_t i=0; i<W; ++i ){ a.lanes[i]*=b.lanes[i]; } return a; }
+      static register_type div( register_type a, const register_type b ){ for( std::size_t i=0; i<W; ++i ){ a.lanes[i]/=b.lanes[i]; } return a; }
+      static register_type neg( register_type a ){ for( auto& x : a.lanes ){ x=-x; } return a; }
+  };
+
+# if defined(__SSE2__)
+   template<>
+   struct simd_backend<double,2>
+  {
+      using register_type = __m128d;
+
+      static register_type broadcast( const double x ){ return _mm_set1_pd(x); }
+
+      static register_type load( const double* p ){ return _mm_loadu_pd(p); }
+      static void store( double* p, const register_type r ){ _mm_storeu_pd(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm_add_pd(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm_sub_pd(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm_mul_pd(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm_div_pd(a,b); }
+      static register_type neg( const register_type a ){ return _mm_xor_pd(a,_mm_set1_pd(-0.0)); }
+  };
+
+   template<>
+   struct simd_backend<float,4>
+  {
+      using register_type = __m128;
+
+      static register_type broadcast( const float x ){ return _mm_set1_ps(x); }
+
+      static register_type load( const float* p ){ return _mm_loadu_ps(p); }
+      static void store( float* p, const register_type r ){ _mm_storeu_ps(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm_add_ps(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm_sub_ps(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm_mul_ps(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm_div_ps(a,b); }
+      static register_type neg( const register_type a ){ return _mm_xor_ps(a,_mm_set1_ps(-0.0f)); }
+  };
+# endif
+
+# if defined(__AVX__)
+   template<>
+   struct simd_backend<double,4>
+  {
+      using register_type = __m256d;
+
+      static register_type broadcast( const double x ){ return _mm256_set1_pd(x); }
+
+      static register_type load( const double* p ){ return _mm256_loadu_pd(p); }
+      static void store( double* p, const register_type r ){ _mm256_storeu_pd(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm256_add_pd(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm256_sub_pd(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm256_mul_pd(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm256_div_pd(a,b); }
+      static register_type neg( const register_type a ){ return _mm256_xor_pd(a,_mm256_set1_pd(-0.0)); }
+  };
+
+   template<>
+   struct simd_backend<float,8>
+  {
+      using register_type = __m256;
+
+      static register_type broadcast( const float x ){ return _mm256_set1_ps(x); }
+
+      static register_type load( const float* p ){ return _mm256_loadu_ps(p); }
+      static void store( float* p, const register_type r ){ _mm256_storeu_ps(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm256_add_ps(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm256_sub_ps(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm256_mul_ps(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm256_div_ps(a,b); }
+      static register_type neg( const register_type a ){ return _mm256_xor_ps(a,_mm256_set1_ps(-0.0f)); }
+  };
+# endif
+
+# if defined(__AVX512F__)
+   template<>
+   struct simd_backend<double,8>
+  {
+      using register_type = __m512d;
+
+      static register_type broadcast( const double x ){ return _mm512_set1_pd(x); }
+
+      static register_type load( const double* p ){ return _mm512_loadu_pd(p); }
+      static void store( double* p, const register_type r ){ _mm512_storeu_pd(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm512_add_pd(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm512_sub_pd(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm512_mul_pd(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm512_div_pd(a,b); }
+
+      // xor of the sign bit, avx512f has no floating point xor
+      static register_type neg( const register_type a )
+     {
+         return _mm512_castsi512_pd( _mm512_xor_si512( _mm512_castpd_si512(a), _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull)) ) );
+     }
+  };
+
+   template<>
+   struct simd_backend<float,16>
+  {
+      using register_type = __m512;
+
+      static register_type broadcast( const float x ){ return _mm512_set1_ps(x); }
+
+      static register_type load( const float* p ){ return _mm512_loadu_ps(p); }
+      static void store( float* p, const register_type r ){ _mm512_storeu_ps(p,r); }
+
+      static register_type add( const register_type a, const register_type b ){ return _mm512_add_ps(a,b); }
+      static register_type sub( const register_type a, const register_type b ){ return _mm512_sub_ps(a,b); }
+      static register_type mul( const register_type a, const register_type b ){ return _mm512_mul_ps(a,b); }
+      static register_type div( const register_type a, const register_type b ){ return _mm512_div_ps(a,b); }
+
+      // xor of the sign bit, avx512f has no floating point xor
+      static register_type neg( const register_type a )
+     {
+         return _mm512_castsi512_ps( _mm512_xor_si512( _mm512_castps_si512(a), _mm512_set1_epi32(static_cast<int>(0x80000000u)) ) );
+     }
+  };
+# endif
+}
+
+// --------------- simd pack ---------------
+
+/*
+ * fixed width pack of W lanes of T
+ */
+   template<std::floating_point T,
+            std::size_t         W>
+   struct simd
+  {
+      using value_type    = T;
+      using backend       = detail::simd_backend<T,W>;
+      using register_type = typename backend::register_type;
+
+      register_type reg;
+
+      [[nodiscard]]
+      constexpr static std::size_t size() { return W; }
+
+   // construction, scalars are broadcast to every lane
+      simd() = default;
+      simd( const T x ) : reg(backend::broadcast(x)) {}
+      explicit simd( const register_type r ) : reg(r) {}
+
+      // load W contiguous values
+      [[nodiscard]]
+      static simd load( const T* p ){ return simd(backend::load(p)); }
+
+      // store W contiguous values
+      void store( T* p ) const { backend::store(p,reg); }
+
+   // accessors
+      [[nodiscard]]
+      T operator[]( const std::size_t i ) const
+     {
+         std::array<T,W> lanes;
+         store(lanes.data());
+         return lanes[i];
+     }
+
+   // in-place arithmetic
+      simd& operator+=( const simd& other ){ reg=backend::add(reg,other.reg); return *this; }
+      simd& operator-=( const simd& other ){ reg=backend::sub(reg,other.reg); return *this; }
+      simd& operator*=( const simd& other ){ reg=backend::mul(reg,other.reg); return *this; }
+      simd& operator/=( const simd& other ){ reg=backend::div(reg,other.reg); return *this; }
+
+      [[nodiscard]]
+      simd operator-() const { return simd(backend::neg(reg)); }
+
+   // arithmetic, scalar operands are broadcast by the implicit conversion
+      [[nodiscard]] friend simd operator+( const simd& lhs, const simd& rhs ){ return simd(backend::add(lhs.reg,rhs.reg)); }
+      [[nodiscard]] friend simd operator-( const simd& lhs, const simd& rhs ){ return simd(backend::sub(lhs.reg,rhs.reg)); }
+      [[nodiscard]] friend simd operator*( const simd& lhs, const simd& rhs ){ return simd(backend::mul(lhs.reg,rhs.reg)); }
+      [[nodiscard]] friend simd operator/( const simd& lhs, const simd& rhs ){ return simd(backend::div(lhs.reg,rhs.reg)); }
+  };
+
+/*
+ * packs are valid underlying precision for point_base and delta_base
+ */
+   template<typename T,
+            std::size_t W>
+   struct numeric_traits<simd<T,W>>
+  {
+      constexpr static bool enabled = true;
+  };
+
+/*
+ * widest packs supported natively by the target, or a pair of lanes if the target has no simd registers
+ */
+   template<std::floating_point T>
+   using native_simd = simd<T,( native_simd_bytes>0 ? native_simd_bytes/sizeof(T) : 2 )>;
+
+   using simd_double = native_simd<double>;
+   using simd_float  = native_simd<float>;
+
+}
+
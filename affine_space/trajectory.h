@@ -0,0 +1,398 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines the conversion between a track of points and the start point plus the deltas between them,
+ * and a compact container of tracks which stores the deltas.
+ *
+ *    integrate(p0,d)       inclusive scan of the deltas d from p0, x_i = p0 + d_0 + ... + d_i, using point_t::operator+=
+ *    adjacent_deltas(x)    the inverse, d_i = x_{i+1}-x_i, one fewer delta than points
+ *    so integrate( x[0], adjacent_deltas(x) ) is x[1..n), up to the rounding of the deltas and the sums.
+ *
+ *    Both take an optional execution policy (see parallel.h). The parallel scan is two passes over the deltas:
+ *       1. each chunk but the last sums its deltas from the origin (so in the point coordinates, not rounded to the delta coordinates)
+ *       2. each chunk scans its deltas from its start point, p0 plus the sums of the chunks before it
+ *    so the parallel result only differs from the sequential one by the rounding of the sums, and is identical for exact coordinates.
+ *    Each pass is a stream through memory, so the scan scales with the number of cores until it is limited by memory bandwidth.
+ *
+ *    delta_encoded_array<point_t,step_t> stores a track in blocks of block_size points, as the first point of each block (a keyframe)
+ *    and the step to each following point, with each coordinate stored as a step_t (eg float or float16 for double points,
+ *    std::int16_t for integer points). Each step is the difference to the point decoded so far, so the error of every point
+ *    is the rounding of one step to step_t, rather than accumulating along the track. Blocks are independent, so
+ *    a block is decoded on demand in block_size steps, and the whole track is decoded in parallel over blocks.
+ *    The coordinates of each step must be representable by step_t, and point_t must have a fixed ndim.
+ *
+ *    Code example:
+ *
+ *       const std::vector<cartesian_point_t<3>> track = affine::integrate( affine::execution::par, start, velocities );
+ *
+ *       affine::delta_encoded_array<cartesian_point_t<3>,affine::float16> compact( std::span<const cartesian_point_t<3>>(track) );
+ *       compact.push_back( next );
+ *
+ *       std::vector<cartesian_point_t<3>> block( compact.block_size() );
+ *       compact.decode_block( b, std::span(block) );
+ */
+
+# include "affine_space.h"
+# include "combination.h"
+# include "parallel.h"
+
+# include <algorithm>
+# include <array>
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <ranges>
+# include <span>
+# include <type_traits>
+# include <vector>
+
+namespace affine
+{
+
+/*
+ * points which can be integrated from deltas
+ */
+   template<typename point_t>
+   concept integrable =
+      std::same_as<point_t,typename point_t::point_type>
+   && !point_t::dynamic;
+
+namespace detail
+{
+/*
+ * p plus the coordinates of q, for the start points of the chunks of a parallel scan
+ *    q is the sum of the deltas of a chunk from the origin, so it is added without rounding to the delta coordinates
+ */
+   template<integrable point_t>
+   [[nodiscard]]
+   constexpr point_t translate( const point_t& p, const point_t& q )
+  {
+      if constexpr( point_t::vector_valued )
+     {
+         return elementwise<point_t,point_t::size()>( [&]( const std::size_t i ){ return p[i]+q[i]; } );
+     }
+      else
+     {
+         return {{static_cast<typename point_t::value_type>(p.element+q.element)}};
+     }
+  }
+
+   // x_i = p + d_0 + ... + d_i
+   template<integrable point_t>
+   void inclusive_scan( point_t p, const std::span<const typename point_t::delta_type> d, const std::span<point_t> x )
+  {
+      for( std::size_t i=0; i<d.size(); ++i ){ x[i]=(p+=d[i]); }
+  }
+
+/*
+ * x_i = p0 + d_0 + ... + d_i, scanning k contiguous chunks of the deltas in two passes
+ */
+   template<execution_policy policy_t, integrable point_t>
+   void chunked_integrate( policy_t&& policy, const std::size_t k, const point_t& p0,
+                           const std::span<const typename point_t::delta_type> deltas, const std::span<point_t> points )
+  {
+      const std::size_t n = deltas.size();
+      if( k<=1 ){ inclusive_scan( p0, deltas, points ); return; }
+
+      // sum of the deltas of each chunk but the last, from the origin
+      std::vector<point_t> sums(k-1);
+      parallel_for( policy, k-1,
+                    [&]( const std::size_t b, const std::size_t e )
+                   {
+                       for( std::size_t i=b; i<e; ++i )
+                      {
+                          point_t sum{};
+                          for( std::size_t j=chunk_begin(n,k,i); j<chunk_begin(n,k,i+1); ++j ){ sum+=deltas[j]; }
+                          sums[i]=sum;
+                      }
+                   },
+                    1 );
+
+      std::vector<point_t> starts(k,p0);
+      for( std::size_t i=1; i<k; ++i ){ starts[i]=translate( starts[i-1], sums[i-1] ); }
+
+      parallel_for( policy, k,
+                    [&]( const std::size_t b, const std::size_t e )
+                   {
+                       for( std::size_t i=b; i<e; ++i )
+                      {
+                          const std::size_t first = chunk_begin(n,k,i);
+                          const std::size_t count = chunk_begin(n,k,i+1)-first;
+                          inclusive_scan( starts[i], deltas.subspan(first,count), points.subspan(first,count) );
+                      }
+                   },
+                    1 );
+  }
+}
+
+// --------------- integrate ---------------
+
+   // x_i = p0 + d_0 + ... + d_i
+   template<execution_policy policy_t, integrable point_t>
+   void integrate( policy_t&& policy, const point_t& p0,
+                   const std::span<const typename point_t::delta_type> deltas,
+                   const std::type_identity_t<std::span<point_t>> points )
+  {
+      assert( points.size()==deltas.size() );
+      detail::chunked_integrate( policy, detail::chunk_count<policy_t>(deltas.size()), p0, deltas, points );
+  }
+
+   template<integrable point_t>
+   void integrate( const point_t& p0,
+                   const std::span<const typename point_t::delta_type> deltas,
+                   const std::type_identity_t<std::span<point_t>> points )
+  {
+      integrate( execution::seq, p0, deltas, points );
+  }
+
+   template<execution_policy policy_t, integrable point_t>
+   [[nodiscard]]
+   std::vector<point_t> integrate( policy_t&& policy, const point_t& p0, const std::span<const typename point_t::delta_type> deltas )
+  {
+      std::vector<point_t> points( deltas.size() );
+      integrate( policy, p0, deltas, std::span(points) );
+      return points;
+  }
+
+   template<integrable point_t>
+   [[nodiscard]]
+   std::vector<point_t> integrate( const point_t& p0, const std::span<const typename point_t::delta_type> deltas )
+  {
+      return integrate( execution::seq, p0, deltas );
+  }
+
+// --------------- adjacent_deltas ---------------
+
+   // d_i = x_{i+1}-x_i
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   void adjacent_deltas( policy_t&& policy, const points_t& points,
+                         const std::span<typename std::ranges::range_value_t<points_t>::delta_type> deltas )
+  {
+      const std::size_t n = std::ranges::size(points);
+      assert( deltas.size()==(n>0 ? n-1 : 0) );
+
+      const auto x = std::ranges::begin(points);
+      detail::parallel_for( policy, deltas.size(),
+                            [&]( const std::size_t b, const std::size_t e )
+                           {
+                               for( std::size_t i=b; i<e; ++i ){ deltas[i]=x[i+1]-x[i]; }
+                           } );
+  }
+
+   template<typename points_t>
+      requires point_range<points_t>
+   void adjacent_deltas( const points_t& points,
+                         const std::span<typename std::ranges::range_value_t<points_t>::delta_type> deltas )
+  {
+      adjacent_deltas( execution::seq, points, deltas );
+  }
+
+   template<execution_policy policy_t, typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto adjacent_deltas( policy_t&& policy, const points_t& points )
+  {
+      const std::size_t n = std::ranges::size(points);
+      std::vector<typename std::ranges::range_value_t<points_t>::delta_type> deltas( n>0 ? n-1 : 0 );
+      adjacent_deltas( policy, points, std::span(deltas) );
+      return deltas;
+  }
+
+   template<typename points_t>
+      requires point_range<points_t>
+   [[nodiscard]]
+   auto adjacent_deltas( const points_t& points )
+  {
+      return adjacent_deltas( execution::seq, points );
+  }
+
+// --------------- delta_encoded_array ---------------
+
+   // default number of points per keyframe in a delta_encoded_array
+   constexpr std::size_t delta_block = 1024;
+
+/*
+ * container of a track of points, stored as a keyframe per block of block_size points and step_t steps between them
+ */
+   template<integrable point_t,
+            typename step_t = float>
+   class delta_encoded_array
+  {
+      public:
+
+      constexpr static std::size_t ndim = point_t::vector_valued ? point_t::size() : 1;
+
+      using point_type = point_t;
+      using delta_type = typename point_t::delta_type;
+      using step_type  = step_t;
+
+      explicit delta_encoded_array( const std::size_t block_size=delta_block )
+        : block_length(block_size)
+     {
+         assert( block_size>0 );
+     }
+
+      explicit delta_encoded_array( const std::span<const point_t> xs,
+                                    const std::size_t block_size=delta_block )
+        : delta_encoded_array(block_size)
+     {
+         assign(xs);
+     }
+
+      [[nodiscard]] std::size_t size()       const noexcept { return step_coordinates.size(); }
+      [[nodiscard]] bool        empty()      const noexcept { return step_coordinates.empty(); }
+      [[nodiscard]] std::size_t blocks()     const noexcept { return keyframes.size(); }
+      [[nodiscard]] std::size_t block_size() const noexcept { return block_length; }
+
+      // block of point i, and the range of points [begin,end) in block b
+      [[nodiscard]] std::size_t block( const std::size_t i )       const noexcept { return i/block_length; }
+      [[nodiscard]] std::size_t block_begin( const std::size_t b ) const noexcept { return b*block_length; }
+      [[nodiscard]] std::size_t block_end( const std::size_t b )   const noexcept { return std::min( (b+1)*block_length, size() ); }
+
+      // first point of block b, stored exactly
+      [[nodiscard]] const point_t& keyframe( const std::size_t b ) const { return keyframes[b]; }
+
+      // step from point i-1 to point i, zero at the start of a block
+      [[nodiscard]]
+      delta_type step( const std::size_t i ) const
+     {
+         const std::array<step_t,ndim>& s = step_coordinates[i];
+         if constexpr( point_t::vector_valued )
+        {
+            return detail::elementwise<delta_type,ndim>( [&]( const std::size_t c ){ return s[c]; } );
+        }
+         else
+        {
+            return {{static_cast<typename delta_type::value_type>(s[0])}};
+        }
+     }
+
+      // last point, which the next push_back is a step from
+      [[nodiscard]] const point_t& back() const { assert( !empty() ); return last; }
+
+      // decode point i, from the keyframe of its block
+      [[nodiscard]]
+      point_t operator[]( const std::size_t i ) const
+     {
+         point_t p = keyframes[block(i)];
+         for( std::size_t j=block_begin(block(i))+1; j<=i; ++j ){ p+=step(j); }
+         return p;
+     }
+
+   // encoding
+
+      void clear()
+     {
+         keyframes.clear();
+         step_coordinates.clear();
+     }
+
+      void reserve( const std::size_t n )
+     {
+         keyframes.reserve( (n+block_length-1)/block_length );
+         step_coordinates.reserve(n);
+     }
+
+      // append x as a step from back(), or as a keyframe at the start of a block
+      void push_back( const point_t& x )
+     {
+         if( size()%block_length==0 )
+        {
+            keyframes.push_back(x);
+            step_coordinates.emplace_back();
+            last=x;
+            return;
+        }
+
+         const delta_type d = x-last;
+         std::array<step_t,ndim>& s = step_coordinates.emplace_back();
+         if constexpr( point_t::vector_valued )
+        {
+            for( std::size_t c=0; c<ndim; ++c ){ s[c]=static_cast<step_t>(d[c]); }
+        }
+         else
+        {
+            s[0]=static_cast<step_t>(d.element);
+        }
+
+         // continue from the decoded point, so the rounding of the steps does not accumulate
+         last+=step(size()-1);
+     }
+
+      void assign( const std::span<const point_t> xs )
+     {
+         clear();
+         reserve( xs.size() );
+         for( const point_t& x : xs ){ push_back(x); }
+     }
+
+   // decoding
+
+      // decode the points of block b into the first block_end(b)-block_begin(b) elements of ys
+      void decode_block( const std::size_t b, const std::span<point_t> ys ) const
+     {
+         const std::size_t first = block_begin(b);
+         const std::size_t last_point = block_end(b);
+         assert( ys.size()>=last_point-first );
+
+         point_t p = keyframes[b];
+         ys[0] = p;
+         for( std::size_t i=first+1; i<last_point; ++i ){ ys[i-first]=(p+=step(i)); }
+     }
+
+      // decode every point, in parallel over blocks
+      template<execution_policy policy_t>
+      void decode( policy_t&& policy, const std::span<point_t> ys ) const
+     {
+         assert( ys.size()==size() );
+         detail::parallel_for( policy, blocks(),
+                               [&]( const std::size_t b, const std::size_t e )
+                              {
+                                  for( std::size_t i=b; i<e; ++i ){ decode_block( i, ys.subspan( block_begin(i) ) ); }
+                              },
+                               std::max<std::size_t>( detail::parallel_grain/block_length, 1 ) );
+     }
+
+      void decode( const std::span<point_t> ys ) const
+     {
+         decode( execution::seq, ys );
+     }
+
+      private:
+
+      std::size_t block_length;
+      point_t last{};
+      std::vector<point_t> keyframes;
+      std::vector<std::array<step_t,ndim>> step_coordinates;
+  };
+
+}
@@ -36,7 +36,7 @@
  *         vectors can be multiplied by scalars to give other vectors,
  *         in-place versions of these operations are also defined
  *    No assumption is made on whether the space is linear or nonlinear.
- *    All instances are assumed to be represented in the standard basis. Transformations between bases must be implemented by the deriving classes.
+ *    All instances are assumed to be represented in the standard basis. Linear and affine maps between bases are defined in map.h.
  *    Individual elements of Vectors can be accessed using the array accessor []
  *
  *    Code example:
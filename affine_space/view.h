@@ -0,0 +1,354 @@
+
+# pragma once
+
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Joshua T. Hope-Collins
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * https://github.com/JHopeCollins/affine_space
+ *
+ * This header defines non-owning views of points and displacements stored in caller owned memory,
+ * e.g. buffers read from a file, shared memory, or the arrays of another library.
+ *
+ *    point_view<point_t> and delta_view<delta_t> refer to the coordinates of a single point/delta at a pointer, without copying them.
+ *    They are the proxy references of point_array.h, so they support the same accessors and arithmetic as the type they refer to,
+ *    write through on assignment and in-place arithmetic, and convert implicitly to point_t/delta_t for the free operators.
+ *    The const_ versions are read only.
+ *
+ *    point_span<point_t> and delta_span<delta_t> are random access ranges of views over a sequence of points/deltas.
+ *    Element k, coordinate i is at first[k*step+i*stride], which covers
+ *       packed coordinates                      step=ndim,  stride=1 (array of structures)
+ *       a coordinate field inside a larger struct  step=sizeof(record)/sizeof(num_t), stride=1
+ *       coordinates stored in separate columns  step=1,     stride=column length (structure of arrays)
+ *    The in-place bulk arithmetic follows the same rules as the free operators in affine_space.h, applied elementwise.
+ *    Both operands of a bulk operation must have the same size.
+ *
+ *    Views require a fixed ndim, and the caller is responsible for keeping the memory alive.
+ *
+ *    Code example:
+ *
+ *       double xyz[3] = ...;
+ *       point_view<cartesian_point_t<3>> x(xyz);
+ *       x+=d;                                              // writes to xyz
+ *
+ *       struct particle{ double mass; double position[3]; double velocity[3]; };
+ *       std::vector<particle> particles = ...;
+ *
+ *       auto xs = make_point_span<cartesian_point_t<3>>( std::span(particles), &particle::position );
+ *       auto vs = make_delta_span<cartesian_delta_t<3>>( std::span(particles), &particle::velocity );
+ *
+ *       vs*=dt;
+ *       xs+=vs;
+ *       cartesian_delta_t<3> d = xs[i]-xs[j];
+ */
+
+# include "affine_space.h"
+# include "point_array.h"
+
+# include <cassert>
+# include <concepts>
+# include <cstddef>
+# include <iterator>
+# include <ranges>
+# include <span>
+# include <type_traits>
+
+namespace affine
+{
+
+// --------------- views ---------------
+
+   template<typename point_t>
+   using point_view = point_reference<point_t,typename point_t::value_type>;
+
+   template<typename point_t>
+   using const_point_view = point_reference<point_t,const typename point_t::value_type>;
+
+   template<typename delta_t>
+   using delta_view = delta_reference<delta_t,typename delta_t::value_type>;
+
+   template<typename delta_t>
+   using const_delta_view = delta_reference<delta_t,const typename delta_t::value_type>;
+
+
+namespace detail
+{
+/*
+ * random access iterator over a sequence of views, element k starts at first+k*step
+ */
+   template<typename reference_t,
+            typename value_t>
+   class strided_iterator
+  {
+      public:
+
+      using iterator_concept = std::random_access_iterator_tag;
+      using value_type       = typename reference_t::referenced_type;
+      using difference_type  = std::ptrdiff_t;
+      using reference        = reference_t;
+
+      constexpr strided_iterator() noexcept = default;
+      constexpr strided_iterator( value_t* p, const std::ptrdiff_t n, const std::size_t s ) noexcept : first(p), step(n), stride(s) {}
+
+      [[nodiscard]] constexpr reference operator*() const { return reference(first,stride); }
+      [[nodiscard]] constexpr reference operator[]( const difference_type n ) const { return reference(first+n*step,stride); }
+
+      constexpr strided_iterator& operator++(){ first+=step; return *this; }
+      constexpr strided_iterator& operator--(){ first-=step; return *this; }
+      constexpr strided_iterator  operator++(int){ auto tmp=*this; first+=step; return tmp; }
+      constexpr strided_iterator  operator--(int){ auto tmp=*this; first-=step; return tmp; }
+
+      constexpr strided_iterator& operator+=( const difference_type n ){ first+=n*step; return *this; }
+      constexpr strided_iterator& operator-=( const difference_type n ){ first-=n*step; return *this; }
+
+      [[nodiscard]] friend constexpr strided_iterator operator+( strided_iterator it, const difference_type n ){ return it+=n; }
+      [[nodiscard]] friend constexpr strided_iterator operator+( const difference_type n, strided_iterator it ){ return it+=n; }
+      [[nodiscard]] friend constexpr strided_iterator operator-( strided_iterator it, const difference_type n ){ return it-=n; }
+
+      [[nodiscard]] friend constexpr difference_type operator-( const strided_iterator& lhs, const strided_iterator& rhs ){ return (lhs.first-rhs.first)/lhs.step; }
+
+      [[nodiscard]] friend constexpr bool operator==( const strided_iterator& lhs, const strided_iterator& rhs ){ return lhs.first==rhs.first; }
+      [[nodiscard]] friend constexpr auto operator<=>( const strided_iterator& lhs, const strided_iterator& rhs ){ return lhs.first<=>rhs.first; }
+
+      private:
+
+      value_t*       first=nullptr;
+      std::ptrdiff_t step=1;
+      std::size_t    stride=1;
+  };
+}
+
+// --------------- spans of views ---------------
+
+/*
+ * non-owning random access range of point_view/delta_view (or the const versions) over caller owned memory
+ *    element k, coordinate i is first[k*step+i*stride]
+ */
+   template<typename reference_t,
+            typename value_t>
+   class view_span
+  {
+      public:
+
+      using point_type = typename reference_t::point_type;
+      using delta_type = typename reference_t::delta_type;
+      using value_type = typename reference_t::value_type;
+
+      using reference = reference_t;
+      using iterator  = detail::strided_iterator<reference_t,value_t>;
+
+      constexpr static std::size_t ncols = reference_t::ncols;
+      constexpr static bool        is_point = detail::is_point_reference<reference_t>::value;
+      constexpr static bool        writable = !std::is_const_v<value_t>;
+
+      constexpr view_span() noexcept = default;
+
+      constexpr view_span( value_t* p, const std::size_t n, const std::size_t element_step, const std::size_t coordinate_stride=1 ) noexcept
+        : first(p), length(n), step(element_step), stride(coordinate_stride) {}
+
+      // packed coordinates, ncols per element
+      constexpr explicit view_span( const std::span<value_t> coordinates ) noexcept
+        : view_span( coordinates.data(), coordinates.size()/ncols, ncols )
+     {
+         assert( coordinates.size()%ncols==0 );
+     }
+
+      // a view_span of mutable coordinates converts to a read only one
+      template<typename other_reference_t>
+         requires (!writable && std::same_as<typename other_reference_t::referenced_type,typename reference_t::referenced_type>)
+      constexpr view_span( const view_span<other_reference_t,std::remove_const_t<value_t>>& other ) noexcept
+        : view_span( other.data(), other.size(), other.element_step(), other.coordinate_stride() ) {}
+
+      [[nodiscard]] constexpr std::size_t size()  const noexcept { return length; }
+      [[nodiscard]] constexpr bool        empty() const noexcept { return length==0; }
+
+      [[nodiscard]] constexpr value_t*    data()              const noexcept { return first; }
+      [[nodiscard]] constexpr std::size_t element_step()      const noexcept { return step; }
+      [[nodiscard]] constexpr std::size_t coordinate_stride() const noexcept { return stride; }
+
+   // element access
+      [[nodiscard]] constexpr reference operator[]( const std::size_t k ) const { return reference(first+k*step,stride); }
+
+      [[nodiscard]] constexpr iterator begin() const { return iterator(first,signed_step(),stride); }
+      [[nodiscard]] constexpr iterator end()   const { return iterator(first+length*step,signed_step(),stride); }
+
+      // elements [offset,offset+count)
+      [[nodiscard]] constexpr view_span subspan( const std::size_t offset, const std::size_t count ) const
+     {
+         assert( offset+count<=length );
+         return view_span( first+offset*step, count, step, stride );
+     }
+
+   // in-place arithmetic
+      template<typename other_reference_t,
+               typename other_value_t>
+         requires writable
+               && detail::is_delta_reference<other_reference_t>::value
+               && std::same_as<typename other_reference_t::delta_type,delta_type>
+      constexpr const view_span& operator+=( const view_span<other_reference_t,other_value_t>& d ) const
+     {
+         return transform( d, []( value_type& x, const value_type y ){ x+=y; } );
+     }
+
+      template<typename other_reference_t,
+               typename other_value_t>
+         requires writable
+               && detail::is_delta_reference<other_reference_t>::value
+               && std::same_as<typename other_reference_t::delta_type,delta_type>
+      constexpr const view_span& operator-=( const view_span<other_reference_t,other_value_t>& d ) const
+     {
+         return transform( d, []( value_type& x, const value_type y ){ x-=y; } );
+     }
+
+      constexpr const view_span& operator*=( const scale_factor<value_type> auto a ) const requires (writable && !is_point)
+     {
+         const value_type b = static_cast<value_type>(a);
+         for( std::size_t k=0; k<length; ++k )
+        {
+            value_t* x = first+k*step;
+            for( std::size_t i=0; i<ncols; ++i ){ x[i*stride]*=b; }
+        }
+         return *this;
+     }
+
+      constexpr const view_span& operator/=( const scale_factor<value_type> auto a ) const requires (writable && !is_point)
+     {
+         if constexpr( exact_numeric<value_type> )
+        {
+            const value_type b = static_cast<value_type>(a);
+            for( std::size_t k=0; k<length; ++k )
+           {
+               value_t* x = first+k*step;
+               for( std::size_t i=0; i<ncols; ++i ){ x[i*stride]/=b; }
+           }
+            return *this;
+        }
+         else
+        {
+            return *this*=value_type(1)/a;
+        }
+     }
+
+   // write through
+      template<typename range_t>
+         requires writable
+      constexpr const view_span& assign( const range_t& values ) const
+     {
+         assert( std::ranges::size(values)==length );
+         std::size_t k=0;
+         for( const auto& v : values ){ (*this)[k++]=v; }
+         return *this;
+     }
+
+      private:
+
+      template<typename other_reference_t,
+               typename other_value_t,
+               typename op_t>
+      constexpr const view_span& transform( const view_span<other_reference_t,other_value_t>& other, op_t op ) const
+     {
+         assert( length==other.size() );
+         const std::size_t other_step   = other.element_step();
+         const std::size_t other_stride = other.coordinate_stride();
+         for( std::size_t k=0; k<length; ++k )
+        {
+                  value_t*       x = first+k*step;
+            const other_value_t* y = other.data()+k*other_step;
+            for( std::size_t i=0; i<ncols; ++i ){ op( x[i*stride], y[i*other_stride] ); }
+        }
+         return *this;
+     }
+
+      constexpr std::ptrdiff_t signed_step() const noexcept { return static_cast<std::ptrdiff_t>(step); }
+
+      value_t*    first=nullptr;
+      std::size_t length=0;
+      std::size_t step=ncols;
+      std::size_t stride=1;
+  };
+
+   template<typename point_t>
+   using point_span = view_span<point_view<point_t>,typename point_t::value_type>;
+
+   template<typename point_t>
+   using const_point_span = view_span<const_point_view<point_t>,const typename point_t::value_type>;
+
+   template<typename delta_t>
+   using delta_span = view_span<delta_view<delta_t>,typename delta_t::value_type>;
+
+   template<typename delta_t>
+   using const_delta_span = view_span<const_delta_view<delta_t>,const typename delta_t::value_type>;
+
+
+// --------------- struct field adaptors ---------------
+
+namespace detail
+{
+   // view_span over the coordinates field_t of every record, field_t must hold exactly the ncols coordinates of T
+   template<typename span_t,
+            typename record_t,
+            typename field_t>
+   span_t field_span( const std::span<record_t> records, field_t std::remove_const_t<record_t>::* field )
+  {
+      using num_t = typename span_t::value_type;
+
+      static_assert( sizeof(field_t)==span_t::ncols*sizeof(num_t), "the field must hold exactly the coordinates of one point/delta" );
+      static_assert( sizeof(record_t)%sizeof(num_t)==0, "the record size must be a multiple of the coordinate size" );
+
+      constexpr std::size_t step = sizeof(record_t)/sizeof(num_t);
+
+      if( records.empty() ){ return span_t( nullptr, 0, step ); }
+
+      auto* coordinates = reinterpret_cast<std::conditional_t<std::is_const_v<record_t>,const num_t,num_t>*>( &(records[0].*field) );
+      return span_t( coordinates, records.size(), step );
+  }
+}
+
+/*
+ * span of views of the coordinate field of each record in a span of structs, e.g. make_point_span<point_t>( std::span(particles), &particle::position )
+ *    the field can be a num_t[ndim], a std::array<num_t,ndim>, or a num_t for a scalar space
+ *    const records give a read only span
+ */
+   template<typename point_t,
+            typename record_t,
+            typename field_t>
+   [[nodiscard]]
+   auto make_point_span( const std::span<record_t> records, field_t std::remove_const_t<record_t>::* field )
+  {
+      using span_t = std::conditional_t<std::is_const_v<record_t>,const_point_span<point_t>,point_span<point_t>>;
+      return detail::field_span<span_t>( records, field );
+  }
+
+   template<typename delta_t,
+            typename record_t,
+            typename field_t>
+   [[nodiscard]]
+   auto make_delta_span( const std::span<record_t> records, field_t std::remove_const_t<record_t>::* field )
+  {
+      using span_t = std::conditional_t<std::is_const_v<record_t>,const_delta_span<delta_t>,delta_span<delta_t>>;
+      return detail::field_span<span_t>( records, field );
+  }
+}
+
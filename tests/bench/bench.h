@@ -0,0 +1,178 @@
+
+# pragma once
+
+/*
+ * minimal timing utilities shared by the benchmark programs
+ */
+
+# include <algorithm>
+# include <chrono>
+# include <cstddef>
+# include <cstdint>
+# include <limits>
+# include <optional>
+
+# if defined(__linux__)
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+# endif
+
+namespace bench
+{
+
+/*
+ * prevent the compiler from optimising away a value, or assuming anything about memory
+ */
+   template<typename T>
+   inline void do_not_optimize( T& value )
+  {
+      asm volatile( "" : "+m"(value) : : "memory" );
+  }
+
+   inline void clobber_memory()
+  {
+      asm volatile( "" : : : "memory" );
+  }
+
+/*
+ * minimum wall time in nanoseconds of one call to kernel, over repeats samples of iterations calls each
+ *    the minimum is the least noisy estimator for short, deterministic kernels
+ */
+   template<typename kernel_t>
+   double time_ns( kernel_t&& kernel,
+                   const std::size_t iterations,
+                   const std::size_t repeats=7 )
+  {
+      using clock = std::chrono::steady_clock;
+
+      double best = std::numeric_limits<double>::max();
+      for( std::size_t r=0; r<repeats; ++r )
+     {
+         const auto start = clock::now();
+         for( std::size_t i=0; i<iterations; ++i )
+        {
+            kernel();
+            clobber_memory();
+        }
+         const auto stop = clock::now();
+
+         const double ns = std::chrono::duration<double,std::nano>(stop-start).count();
+         best = std::min( best, ns/static_cast<double>(iterations) );
+     }
+      return best;
+  }
+
+   enum class hardware_event { cycles, instructions };
+
+/*
+ * hardware event counter for the calling thread, user space only
+ *    unavailable (stop() is empty) if perf_event_open is not supported or not permitted, e.g. perf_event_paranoid>2 or in a container
+ */
+   class perf_counter
+  {
+      int fd = -1;
+
+   public:
+      explicit perf_counter( [[maybe_unused]] const hardware_event event )
+     {
+# if defined(__linux__)
+         perf_event_attr attr{};
+         attr.type = PERF_TYPE_HARDWARE;
+         attr.size = sizeof(attr);
+         attr.config = event==hardware_event::cycles ? PERF_COUNT_HW_CPU_CYCLES : PERF_COUNT_HW_INSTRUCTIONS;
+         attr.disabled = 1;
+         attr.exclude_kernel = 1;
+         attr.exclude_hv = 1;
+         fd = static_cast<int>( syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 ) );
+# endif
+     }
+
+      perf_counter( const perf_counter& ) = delete;
+      perf_counter& operator=( const perf_counter& ) = delete;
+
+     ~perf_counter()
+     {
+# if defined(__linux__)
+         if( fd>=0 ){ close(fd); }
+# endif
+     }
+
+      [[nodiscard]] bool available() const { return fd>=0; }
+
+      void start()
+     {
+# if defined(__linux__)
+         if( fd>=0 ){ ioctl( fd, PERF_EVENT_IOC_RESET, 0 ); ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 ); }
+# endif
+     }
+
+      // events since start()
+      [[nodiscard]] std::optional<std::uint64_t> stop()
+     {
+# if defined(__linux__)
+         std::uint64_t value = 0;
+         if( fd>=0 )
+        {
+            ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+            if( read( fd, &value, sizeof(value) )==sizeof(value) ){ return value; }
+        }
+# endif
+         return std::nullopt;
+     }
+  };
+
+/*
+ * per call cost of a kernel, see measure
+ */
+   struct measurement
+  {
+      double ns;
+      std::optional<double> cycles;
+      std::optional<double> instructions;
+  };
+
+/*
+ * as time_ns, and also count cpu cycles and instructions per call where perf_event_open is available
+ *    each is the minimum over the repeats
+ */
+   template<typename kernel_t>
+   measurement measure( kernel_t&& kernel,
+                        const std::size_t iterations,
+                        const std::size_t repeats=7 )
+  {
+      perf_counter cycle_counter( hardware_event::cycles );
+      perf_counter instruction_counter( hardware_event::instructions );
+
+      measurement best{ time_ns( kernel, iterations, repeats ), std::nullopt, std::nullopt };
+
+      const auto per_call = [iterations]( const std::optional<std::uint64_t> count ) -> std::optional<double>
+     {
+         if( !count ){ return std::nullopt; }
+         return static_cast<double>(*count)/static_cast<double>(iterations);
+     };
+      const auto keep_min = []( std::optional<double>& current, const std::optional<double> sample )
+     {
+         if( sample && ( !current || *sample<*current ) ){ current = sample; }
+     };
+
+      for( std::size_t r=0; r<repeats && ( cycle_counter.available() || instruction_counter.available() ); ++r )
+     {
+         cycle_counter.start();
+         instruction_counter.start();
+         for( std::size_t i=0; i<iterations; ++i )
+        {
+            kernel();
+            clobber_memory();
+        }
+         const auto instructions = instruction_counter.stop();
+         const auto cycles = cycle_counter.stop();
+
+         keep_min( best.cycles, per_call(cycles) );
+         keep_min( best.instructions, per_call(instructions) );
+     }
+      return best;
+  }
+
+}
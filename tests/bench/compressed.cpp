@@ -0,0 +1,163 @@
+
+/*
+ * compares 16 bit float storage against float and the double points of vector_space.h, for a point cloud too large for the caches
+ *    advance      p[i] += a*d[i]
+ *    difference   d[i]  = p[i]-q[i]
+ * over spans of 3D points, with the batched kernels of kernels.h
+ *
+ * each row is the storage type, the bytes per point, the time per point of each kernel, the bytes read and written per second,
+ * and the largest error of one advance relative to the double result, in units of the largest coordinate
+ *
+ * the second table encodes the double points into a quantized_array of 16 bit integer codes (quantized.h) and decodes them into a point_array,
+ * with the largest error of the decoded coordinates in the same units
+ *
+ * the third table integrates a track of small steps (trajectory.h) sequentially and in parallel, then stores it in a delta_encoded_array
+ * of float or float16 steps and decodes it sequentially and in parallel, with the largest error of the decoded track in the same units
+ */
+
+# include <vector_space.h>
+# include <simd_space.h>
+# include <half.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <quantized.h>
+# include <trajectory.h>
+
+# include <bench.h>
+
+# include <algorithm>
+# include <cstdint>
+# include <cmath>
+# include <cstdio>
+# include <random>
+# include <span>
+# include <thread>
+# include <vector>
+
+   // 3 * 2^22 coordinates, 96 MB of doubles for each of p, q and d
+   constexpr std::size_t length = 1<<22;
+   constexpr double a = 0.125;
+
+   template<typename point_t, typename delta_t>
+   void run( const char* name, const std::vector<point<3>>& p0, const std::vector<delta<3>>& d0 )
+  {
+      std::vector<point_t> p(length), q(length);
+      std::vector<delta_t> d(length);
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i )
+        {
+            p[k][i] = typename point_t::value_type(p0[k][i]);
+            q[k][i] = typename point_t::value_type(p0[length-1-k][i]);
+            d[k][i] = typename delta_t::value_type(d0[k][i]);
+        }
+     }
+
+      // accuracy of one advance, against the exact double result
+      auto r = p;
+      affine::advance( std::span(r), a, std::span<const delta_t>(d) );
+      double error = 0;
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ error = std::max( error, std::abs( double(r[k][i]) - (p0[k][i]+a*d0[k][i]) ) ); }
+     }
+
+      // alternate the sign of a so the points do not drift between samples
+      double sign = 1;
+      const double advance_ns = bench::time_ns( [&]
+     {
+         affine::advance( std::span(p), sign*a, std::span<const delta_t>(d) );
+         sign = -sign;
+     }, 4 )/length;
+
+      const double difference_ns = bench::time_ns( [&]
+     {
+         affine::difference( std::span<const point_t>(p), std::span<const point_t>(q), std::span(d) );
+     }, 4 )/length;
+
+      // advance reads p and d and writes p, difference reads p and q and writes d
+      const double bytes = 3.*sizeof(point_t);
+      std::printf( "%-10s %6zu %12.3f %12.3f %12.2f %12.2f %12.2e\n",
+                   name, sizeof(point_t), advance_ns, difference_ns, bytes/advance_ns, bytes/difference_ns, error/100 );
+  }
+
+   template<typename code_t>
+   void run_quantized( const char* name, const std::vector<point<3>>& p0 )
+  {
+      const affine::point_array<point<3>> x( (std::span<const point<3>>(p0)) );
+      affine::point_array<point<3>> y(length);
+      affine::quantized_array<point<3>,code_t> q(x);
+
+      q.decode(y);
+      double error = 0;
+      for( std::size_t c=0; c<3; ++c )
+     {
+         for( std::size_t k=0; k<length; ++k ){ error = std::max( error, std::abs( y.data(c)[k]-x.data(c)[k] ) ); }
+     }
+
+      const double encode_ns = bench::time_ns( [&]{ q.assign(x); }, 4 )/length;
+      const double decode_ns = bench::time_ns( [&]{ q.decode(y); }, 4 )/length;
+
+      // encode reads the doubles and writes the codes, decode the reverse
+      const double bytes = 3.*(sizeof(double)+sizeof(code_t));
+      std::printf( "%-10s %6zu %12.3f %12.3f %12.2f %12.2f %12.2e\n",
+                   name, 3*sizeof(code_t), encode_ns, decode_ns, bytes/encode_ns, bytes/decode_ns, error/100 );
+  }
+
+   template<typename step_t>
+   void run_track( const char* name, const std::vector<point<3>>& p0, const std::vector<delta<3>>& d0 )
+  {
+      // steps of at most 1e-3, from a point far from the origin
+      std::vector<delta<3>> d(length);
+      for( std::size_t k=0; k<length; ++k ){ d[k] = 1e-5*d0[k]; }
+
+      std::vector<point<3>> x(length);
+      const double seq_ns = bench::time_ns( [&]{ affine::integrate( p0[0], d, std::span(x) ); }, 4 )/length;
+      const double par_ns = bench::time_ns( [&]{ affine::integrate( affine::execution::par, p0[0], d, std::span(x) ); }, 4 )/length;
+
+      const affine::delta_encoded_array<point<3>,step_t> track( (std::span<const point<3>>(x)) );
+      std::vector<point<3>> y(length);
+      const double decode_ns     = bench::time_ns( [&]{ track.decode( std::span(y) ); }, 4 )/length;
+      const double par_decode_ns = bench::time_ns( [&]{ track.decode( affine::execution::par, std::span(y) ); }, 4 )/length;
+
+      double error = 0;
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ error = std::max( error, std::abs( y[k][i]-x[k][i] ) ); }
+     }
+
+      std::printf( "%-10s %6zu %12.3f %12.3f %12.3f %12.3f %12.2e\n",
+                   name, 3*sizeof(step_t), seq_ns, par_ns, decode_ns, par_decode_ns, error/100 );
+  }
+
+   int main()
+  {
+      std::mt19937 generator(1);
+      std::uniform_real_distribution<double> uniform(-100,100);
+
+      std::vector<point<3>> p0(length);
+      std::vector<delta<3>> d0(length);
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ p0[k][i]=uniform(generator); d0[k][i]=uniform(generator); }
+     }
+
+      std::printf( "# kernel isa: %s, %zu points\n", affine::isa_name(affine::kernel_isa()), length );
+      std::printf( "%-10s %6s %12s %12s %12s %12s %12s\n", "# type", "bytes", "advance ns", "diff ns", "advance GB/s", "diff GB/s", "rel error" );
+
+      run<point<3>,delta<3>>( "double", p0, d0 );
+      run<simd_point<3,float>,simd_delta<3,float>>( "float", p0, d0 );
+      run<simd_point<3,affine::float16>,simd_delta<3,affine::float16>>( "float16", p0, d0 );
+      run<simd_point<3,affine::bfloat16>,simd_delta<3,affine::bfloat16>>( "bfloat16", p0, d0 );
+
+      std::printf( "%-10s %6s %12s %12s %12s %12s %12s\n", "# codes", "bytes", "encode ns", "decode ns", "encode GB/s", "decode GB/s", "rel error" );
+
+      run_quantized<std::uint16_t>( "uint16", p0 );
+      run_quantized<std::int16_t>( "int16", p0 );
+
+      std::printf( "# %u threads\n", std::thread::hardware_concurrency() );
+      std::printf( "%-10s %6s %12s %12s %12s %12s %12s\n", "# steps", "bytes", "scan ns", "par scan ns", "decode ns", "par dec ns", "rel error" );
+
+      run_track<float>( "float", p0, d0 );
+      run_track<affine::float16>( "float16", p0, d0 );
+  }
@@ -0,0 +1,117 @@
+
+/*
+ * compares eager operators, expression templates and raw loops for
+ *    p1 = p0 + a*(q-r) + b*d
+ * with the eager operators this creates four temporaries and four loops per element
+ * the lazy version should match the raw loop if the temporaries are removed
+ */
+
+# include <vector_space.h>
+# include <expression.h>
+
+# include <bench.h>
+
+# include <array>
+# include <cstdio>
+# include <vector>
+
+   constexpr std::size_t length = 1024;
+   constexpr double a = 0.5;
+   constexpr double b = -0.25;
+
+   template<std::size_t N>
+   struct workload
+  {
+      std::vector<point<N>> p0,q,r,p1;
+      std::vector<delta<N>> d;
+
+      workload() : p0(length), q(length), r(length), p1(length), d(length)
+     {
+         for( std::size_t k=0; k<length; ++k )
+        {
+            for( std::size_t i=0; i<N; ++i )
+           {
+               const auto x = static_cast<double>(k*N+i);
+               p0[k][i]=x; q[k][i]=2*x; r[k][i]=x+1; d[k][i]=3-x;
+           }
+        }
+     }
+  };
+
+   template<std::size_t N>
+   void run_ndim()
+  {
+      workload<N> w;
+
+      // raw loops over the same memory, without the affine types
+      using array_t = std::array<double,N>;
+      auto* raw_p0 = reinterpret_cast<const array_t*>(w.p0.data());
+      auto* raw_q  = reinterpret_cast<const array_t*>(w.q.data());
+      auto* raw_r  = reinterpret_cast<const array_t*>(w.r.data());
+      auto* raw_d  = reinterpret_cast<const array_t*>(w.d.data());
+      auto* raw_p1 = reinterpret_cast<      array_t*>(w.p1.data());
+
+      const double eager = bench::time_ns( [&]()
+     {
+         for( std::size_t k=0; k<length; ++k ){ w.p1[k] = w.p0[k]+a*(w.q[k]-w.r[k])+b*w.d[k]; }
+     }, 200 )/length;
+
+      const double lazy = bench::time_ns( [&]()
+     {
+         for( std::size_t k=0; k<length; ++k ){ affine::assign( w.p1[k], affine::lazy(w.p0[k])+a*(affine::lazy(w.q[k])-w.r[k])+b*affine::lazy(w.d[k]) ); }
+     }, 200 )/length;
+
+      const double raw = bench::time_ns( [&]()
+     {
+         for( std::size_t k=0; k<length; ++k )
+        {
+            for( std::size_t i=0; i<N; ++i ){ raw_p1[k][i] = raw_p0[k][i]+a*(raw_q[k][i]-raw_r[k][i])+b*raw_d[k][i]; }
+        }
+     }, 200 )/length;
+
+      std::printf( "%6zu %12.3f %12.3f %12.3f %10.2f\n", N, eager, lazy, raw, lazy/raw );
+  }
+
+   template<std::size_t N>
+   void run_bulk()
+  {
+      workload<N> w;
+
+      affine::point_array<point<N>> p0(w.p0),q(w.q),r(w.r),p1(length);
+      affine::delta_array<delta<N>> d(w.d);
+
+      const double eager = bench::time_ns( [&]()
+     {
+         p1 = p0+a*(q-r)+b*d;
+     }, 200 )/length;
+
+      const double lazy = bench::time_ns( [&]()
+     {
+         affine::assign( p1, affine::lazy(p0)+a*(affine::lazy(q)-r)+b*affine::lazy(d) );
+     }, 200 )/length;
+
+      std::printf( "%6zu %12.3f %12.3f\n", N, eager, lazy );
+  }
+
+   int main()
+  {
+      std::printf( "p1 = p0 + a*(q-r) + b*d, ns per element\n" );
+      std::printf( "%6s %12s %12s %12s %10s\n", "ndim", "eager", "lazy", "raw", "lazy/raw" );
+      run_ndim<1>();
+      run_ndim<2>();
+      run_ndim<3>();
+      run_ndim<4>();
+      run_ndim<8>();
+      run_ndim<16>();
+      run_ndim<32>();
+      run_ndim<64>();
+
+      std::printf( "\npoint_array/delta_array, ns per element\n" );
+      std::printf( "%6s %12s %12s\n", "ndim", "eager", "lazy" );
+      run_bulk<2>();
+      run_bulk<3>();
+      run_bulk<4>();
+
+      return 0;
+  }
+
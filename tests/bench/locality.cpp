@@ -0,0 +1,115 @@
+
+/*
+ * space filling curve ordering of a random 3D point cloud too large for the caches (curve.h)
+ *
+ * the first table is the time per point of each step of curve_sort: the bounding box, the keys with the portable bit interleaving
+ * and with the best instruction set (pdep with bmi2), the radix sort of the keys, and the permutation of the points
+ *
+ * the second table is the time per query of the radius queries of a kdtree (kdtree.h) and a hash_grid (hash_grid.h),
+ * one per point of the cloud, with the queries in random, Morton and Hilbert order
+ *
+ * the third table is the time per point to build each, and to update the hash_grid after every point moved a tenth of the radius
+ */
+
+# include <vector_space.h>
+# include <curve.h>
+# include <hash_grid.h>
+# include <kdtree.h>
+# include <kernels.h>
+
+# include <bench.h>
+
+# include <cstdio>
+# include <random>
+# include <span>
+# include <vector>
+
+   // 2^20 points, radius of about 8 neighbours
+   constexpr std::size_t length = 1<<20;
+   constexpr double radius = 0.0122;
+
+   int main()
+  {
+      std::mt19937 generator(1);
+      std::uniform_real_distribution<double> uniform(0,1);
+
+      std::vector<point<3>> cloud(length);
+      for( auto& p : cloud ){ p = point<3>{{uniform(generator),uniform(generator),uniform(generator)}}; }
+
+      const affine::isa best = affine::kernel_isa();
+      std::printf( "# kernel isa: %s, bmi2: %s, %zu points\n", affine::isa_name(best), affine::detail::has_bmi2() ? "yes" : "no", length );
+      std::printf( "%-16s %12s\n", "# step", "ns" );
+
+      const auto box = affine::bounds( cloud );
+      std::vector<std::uint64_t> keys(length);
+
+      {
+         affine::bounding_box<point<3>> b;
+         const double ns = bench::time_ns( [&]{ b = affine::bounds( cloud ); bench::do_not_optimize(b); }, 1 )/length;
+         std::printf( "%-16s %12.3f\n", "bounds", ns );
+      }
+
+      for( const auto c : { affine::curve::morton, affine::curve::hilbert } )
+     {
+         const char* name = c==affine::curve::morton ? "morton" : "hilbert";
+         char label[32];
+
+         affine::set_kernel_isa( affine::isa::scalar );
+         const double scalar_ns = bench::time_ns( [&]{ affine::curve_keys( c, cloud, box, std::span(keys) ); }, 1 )/length;
+         std::snprintf( label, sizeof(label), "%s scalar", name );
+         std::printf( "%-16s %12.3f\n", label, scalar_ns );
+
+         affine::set_kernel_isa( best );
+         const double best_ns = bench::time_ns( [&]{ affine::curve_keys( c, cloud, box, std::span(keys) ); }, 1 )/length;
+         std::snprintf( label, sizeof(label), "%s %s", name, affine::isa_name(best) );
+         std::printf( "%-16s %12.3f\n", label, best_ns );
+     }
+
+      std::vector<std::size_t> order;
+      {
+         const double ns = bench::time_ns( [&]{ order = affine::key_order( std::span<const std::uint64_t>(keys) ); bench::do_not_optimize(order); }, 1 )/length;
+         std::printf( "%-16s %12.3f\n", "key_order", ns );
+      }
+
+      {
+         std::vector<point<3>> ps = cloud;
+         const double ns = bench::time_ns( [&]{ affine::permute( std::span<const std::size_t>(order), ps ); }, 1 )/length;
+         std::printf( "%-16s %12.3f\n", "permute", ns );
+      }
+
+      // radius queries in each order
+      const affine::kdtree<point<3>> tree( affine::execution::par, cloud );
+      affine::hash_grid<point<3>> grid( affine::execution::par, cloud, radius );
+      std::printf( "\n%-16s %12s %12s\n", "# query order", "kdtree ns", "grid ns" );
+
+      const auto run_queries = [&]( const char* name, const std::vector<point<3>>& queries )
+     {
+         std::size_t found = 0;
+         const double tree_ns = bench::time_ns( [&]{ found = 0; for( const auto& q : queries ){ found += tree.within_radius( q, radius ).size(); } bench::do_not_optimize(found); }, 1, 3 )/length;
+         const double grid_ns = bench::time_ns( [&]{ found = 0; for( const auto& q : queries ){ grid.for_each_neighbour( q, radius, [&]( const auto& ){ ++found; } ); } bench::do_not_optimize(found); }, 1, 3 )/length;
+         std::printf( "%-16s %12.3f %12.3f\n", name, tree_ns, grid_ns );
+     };
+
+      run_queries( "random", cloud );
+      for( const auto c : { affine::curve::morton, affine::curve::hilbert } )
+     {
+         std::vector<point<3>> queries = cloud;
+         affine::curve_sort( affine::execution::par, c, queries );
+         run_queries( c==affine::curve::morton ? "morton" : "hilbert", queries );
+     }
+
+      // construction, and updates of the grid after a small step
+      std::printf( "\n%-16s %12s\n", "# build", "ns" );
+      {
+         const double tree_ns = bench::time_ns( [&]{ affine::kdtree<point<3>> t( cloud ); bench::do_not_optimize(t); }, 1, 3 )/length;
+         const double grid_ns = bench::time_ns( [&]{ affine::hash_grid<point<3>> g( cloud, radius ); bench::do_not_optimize(g); }, 1, 3 )/length;
+         std::printf( "%-16s %12.3f\n%-16s %12.3f\n", "kdtree", tree_ns, "hash_grid", grid_ns );
+
+         std::vector<point<3>> moved = cloud;
+         std::uniform_real_distribution<double> step(-radius/10,radius/10);
+         for( auto& p : moved ){ p += delta<3>{{step(generator),step(generator),step(generator)}}; }
+
+         const double update_ns = bench::time_ns( [&]{ grid.update( cloud ); grid.update( moved ); }, 1, 3 )/(2*length);
+         std::printf( "%-16s %12.3f\n", "hash_grid update", update_ns );
+      }
+  }
@@ -0,0 +1,221 @@
+
+/*
+ * compares every operator of affine_space.h against the same operation written as a raw loop over std::array
+ *    for ndim 0,1,2,3,4,8,16,64 and float/double, applied elementwise over arrays of length elements
+ *
+ * results are written to stdout as json, one record per operator, ndim, value type and implementation ("affine" or "raw")
+ *    ns_per_op                           time per element
+ *    gb_per_s                            bytes read and written per second, counting each operand and result once
+ *    cycles_per_op, instructions_per_op  per element, null if perf_event_open is unavailable
+ */
+
+# include <affine_space.h>
+
+# include <bench.h>
+
+# include <algorithm>
+# include <array>
+# include <cstdio>
+# include <optional>
+# include <type_traits>
+# include <vector>
+
+   template<std::size_t N, typename num_t> struct point;
+   template<std::size_t N, typename num_t> struct delta;
+
+   template<std::size_t N, typename num_t>
+   struct point :
+      affine::point_base<N,point<N,num_t>,delta<N,num_t>,num_t> {};
+
+   template<std::size_t N, typename num_t>
+   struct delta :
+      affine::delta_base<N,point<N,num_t>,delta<N,num_t>,num_t> {};
+
+   // the hand written equivalent of point<N,num_t> and delta<N,num_t>
+   template<std::size_t N, typename num_t>
+   using raw_t = std::conditional_t<N==0,num_t,std::array<num_t,N>>;
+
+   constexpr std::size_t length = 1024;
+
+   // coordinates processed per sample
+   constexpr std::size_t sample_size = 1<<20;
+
+   // coordinate i of a scalar or array
+   template<typename T>
+   constexpr auto& at( T& x, [[maybe_unused]] const std::size_t i )
+  {
+      if constexpr( std::is_arithmetic_v<T> ){ return x; }
+      else { return x[i]; }
+  }
+
+   template<typename num_t>
+   constexpr const char* type_name(){ return std::is_same_v<num_t,float> ? "float" : "double"; }
+
+   template<std::size_t N, typename num_t>
+   struct workload
+  {
+      constexpr static std::size_t ncoord = std::max<std::size_t>(N,1);
+
+      // p,q,d,e are operands, r,f are results
+      std::vector<point<N,num_t>> p,q,r;
+      std::vector<delta<N,num_t>> d,e,f;
+
+      std::vector<raw_t<N,num_t>> rp,rq,rr,rd,re,rf;
+
+      workload() :
+         p(length), q(length), r(length), d(length), e(length), f(length),
+         rp(length), rq(length), rr(length), rd(length), re(length), rf(length)
+     {
+         for( std::size_t k=0; k<length; ++k )
+        {
+            for( std::size_t i=0; i<ncoord; ++i )
+           {
+               const auto x = static_cast<num_t>(k*ncoord+i)/static_cast<num_t>(length);
+               at(p[k].element,i) = at(rp[k],i) = x;
+               at(q[k].element,i) = at(rq[k],i) = 2*x;
+               at(d[k].element,i) = at(rd[k],i) = 1-x;
+               at(e[k].element,i) = at(re[k],i) = x+1;
+           }
+        }
+     }
+  };
+
+   class json_writer
+  {
+      bool first = true;
+
+      static void print( const std::optional<double> x )
+     {
+         if( x ){ std::printf( "%.4f", *x ); }
+         else   { std::printf( "null" ); }
+     }
+
+   public:
+      json_writer()
+     {
+         std::printf( "{\n  \"benchmark\": \"operators\",\n  \"length\": %zu,\n  \"results\": [", length );
+     }
+
+     ~json_writer()
+     {
+         std::printf( "\n  ]\n}\n" );
+     }
+
+      void record( const char* op, const std::size_t ndim, const char* type, const char* impl,
+                   const bench::measurement& m, const double bytes )
+     {
+         std::printf( "%s\n    { \"op\": \"%s\", \"ndim\": %zu, \"type\": \"%s\", \"impl\": \"%s\", \"ns_per_op\": %.4f, \"gb_per_s\": %.3f, \"cycles_per_op\": ",
+                      first ? "" : ",", op, ndim, type, impl, m.ns, bytes/m.ns );
+         print( m.cycles );
+         std::printf( ", \"instructions_per_op\": " );
+         print( m.instructions );
+         std::printf( " }" );
+         first = false;
+     }
+  };
+
+   template<std::size_t N, typename num_t>
+   void run( json_writer& out )
+  {
+      workload<N,num_t> w;
+      constexpr std::size_t ncoord = workload<N,num_t>::ncoord;
+      constexpr std::size_t iterations = std::max<std::size_t>( sample_size/(length*ncoord), 1 );
+
+      // close to one, so repeated in-place scaling stays finite
+      const num_t a = num_t(1.0001);
+
+      // the library divides floating point deltas by multiplying by 1/a, so the raw loops do the same
+      const num_t inv_a = num_t(1)/a;
+
+      // time one pass of both implementations of an operator over all elements
+      // streams is the number of operands and results of the operator
+      const auto compare = [&]( const char* op, const std::size_t streams, auto&& affine_op, auto&& raw_op )
+     {
+         const double bytes = static_cast<double>(streams*ncoord*sizeof(num_t));
+
+         const auto affine_pass = [&]{ for( std::size_t k=0; k<length; ++k ){ affine_op(k); } };
+         const auto raw_pass    = [&]{ for( std::size_t k=0; k<length; ++k ){ raw_op(k); } };
+
+         auto affine_cost = bench::measure( affine_pass, iterations );
+         auto raw_cost    = bench::measure( raw_pass,    iterations );
+
+         for( auto* m : { &affine_cost, &raw_cost } )
+        {
+            m->ns/=length;
+            if( m->cycles ){ *m->cycles/=length; }
+            if( m->instructions ){ *m->instructions/=length; }
+        }
+
+         out.record( op, N, type_name<num_t>(), "affine", affine_cost, bytes );
+         out.record( op, N, type_name<num_t>(), "raw",    raw_cost,    bytes );
+     };
+
+   // in-place arithmetic
+      compare( "p+=d", 3, [&]( std::size_t k ){ w.p[k]+=w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rp[k],i)+=at(w.rd[k],i); } } );
+
+      compare( "p-=d", 3, [&]( std::size_t k ){ w.p[k]-=w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rp[k],i)-=at(w.rd[k],i); } } );
+
+      compare( "d+=d", 3, [&]( std::size_t k ){ w.d[k]+=w.e[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rd[k],i)+=at(w.re[k],i); } } );
+
+      compare( "d-=d", 3, [&]( std::size_t k ){ w.d[k]-=w.e[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rd[k],i)-=at(w.re[k],i); } } );
+
+      compare( "d*=a", 2, [&]( std::size_t k ){ w.d[k]*=a; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rd[k],i)*=a; } } );
+
+      compare( "d/=a", 2, [&]( std::size_t k ){ w.d[k]/=a; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rd[k],i)*=inv_a; } } );
+
+   // point arithmetic
+      compare( "p-p",  3, [&]( std::size_t k ){ w.f[k]=w.p[k]-w.q[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=at(w.rp[k],i)-at(w.rq[k],i); } } );
+
+      compare( "p+d",  3, [&]( std::size_t k ){ w.r[k]=w.p[k]+w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rr[k],i)=at(w.rp[k],i)+at(w.rd[k],i); } } );
+
+      compare( "p-d",  3, [&]( std::size_t k ){ w.r[k]=w.p[k]-w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rr[k],i)=at(w.rp[k],i)-at(w.rd[k],i); } } );
+
+   // delta arithmetic
+      compare( "d+d",  3, [&]( std::size_t k ){ w.f[k]=w.d[k]+w.e[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=at(w.rd[k],i)+at(w.re[k],i); } } );
+
+      compare( "d-d",  3, [&]( std::size_t k ){ w.f[k]=w.d[k]-w.e[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=at(w.rd[k],i)-at(w.re[k],i); } } );
+
+      compare( "-d",   2, [&]( std::size_t k ){ w.f[k]=-w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=-at(w.rd[k],i); } } );
+
+      compare( "a*d",  2, [&]( std::size_t k ){ w.f[k]=a*w.d[k]; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=a*at(w.rd[k],i); } } );
+
+      compare( "d*a",  2, [&]( std::size_t k ){ w.f[k]=w.d[k]*a; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=at(w.rd[k],i)*a; } } );
+
+      compare( "d/a",  2, [&]( std::size_t k ){ w.f[k]=w.d[k]/a; },
+                          [&]( std::size_t k ){ for( std::size_t i=0; i<ncoord; ++i ){ at(w.rf[k],i)=at(w.rd[k],i)*inv_a; } } );
+  }
+
+   template<typename num_t>
+   void run_all( json_writer& out )
+  {
+      run< 0,num_t>(out);
+      run< 1,num_t>(out);
+      run< 2,num_t>(out);
+      run< 3,num_t>(out);
+      run< 4,num_t>(out);
+      run< 8,num_t>(out);
+      run<16,num_t>(out);
+      run<64,num_t>(out);
+  }
+
+   int main()
+  {
+      json_writer out;
+      run_all<float>(out);
+      run_all<double>(out);
+      return 0;
+  }
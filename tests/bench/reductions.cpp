@@ -0,0 +1,150 @@
+
+/*
+ * compares the compensated accumulation of compensated.h against plain double arithmetic, for 3D points too large for the caches
+ *    advance      p[i] += a*d[i], a point_array against a compensated_array, repeated steps times
+ *    centroid     centroid of a point_array, and compensated_centroid
+ *    sum          Σ d[i], a loop of delta_t::operator+= against compensated_sum of a delta_array
+ *
+ * each row is the kernel, the time per point of the plain and compensated versions,
+ * and the largest error of each relative to a long double reference, in units of the largest coordinate
+ *
+ * a second table compares the parallel reductions of combination.h with the bitwise reproducible ones of reproducible.h
+ *    centroid     centroid and reproducible_centroid of a point_array
+ *    sum          Σ d[i] of a delta_array, a parallel_reduce of chunk sums against reproducible_sum
+ *    dot          Σ <d[i],e[i]> of two delta_arrays, a parallel_reduce of chunk sums against reproducible_dot
+ */
+
+# include <vector_space.h>
+# include <combination.h>
+# include <compensated.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <reproducible.h>
+
+# include <bench.h>
+
+# include <algorithm>
+# include <cmath>
+# include <cstdio>
+# include <functional>
+# include <random>
+# include <span>
+# include <vector>
+
+   // 3 * 2^21 coordinates, 48 MB of doubles for each of p and d
+   constexpr std::size_t length = 1<<21;
+
+   // steps of the advance benchmark, each smaller than an ulp of the points
+   constexpr std::size_t steps = 64;
+   constexpr double a = 1e-3;
+
+   int main()
+  {
+      std::mt19937 generator(1);
+      std::uniform_real_distribution<double> uniform(-1,1);
+
+      std::vector<point<3>> p0(length);
+      std::vector<delta<3>> d0(length);
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ p0[k][i]=1e6*(1+uniform(generator)); d0[k][i]=1e-7*uniform(generator); }
+     }
+
+      const affine::delta_array<delta<3>> d( (std::span<const delta<3>>(d0)) );
+
+      std::printf( "# kernel isa: %s, %zu points\n", affine::isa_name(affine::kernel_isa()), length );
+      std::printf( "%-10s %12s %12s %12s %12s\n", "# kernel", "plain ns", "comp ns", "plain error", "comp error" );
+
+      // advance, the error after all steps
+      {
+         affine::point_array<point<3>> p( (std::span<const point<3>>(p0)) );
+         affine::compensated_array<point<3>> q( (std::span<const point<3>>(p0)) );
+
+         const double plain_ns = bench::time_ns( [&]{ for( std::size_t s=0; s<steps; ++s ){ affine::advance( p, a, d ); } }, 1, 1 )/(steps*length);
+         const double comp_ns  = bench::time_ns( [&]{ for( std::size_t s=0; s<steps; ++s ){ affine::advance( q, a, d ); } }, 1, 1 )/(steps*length);
+
+         double plain_error = 0, comp_error = 0;
+         for( std::size_t k=0; k<length; ++k )
+        {
+            for( std::size_t i=0; i<3; ++i )
+           {
+               const long double exact = static_cast<long double>(p0[k][i])+steps*static_cast<long double>(a)*static_cast<long double>(d0[k][i]);
+               plain_error = std::max( plain_error, static_cast<double>( std::abs( p[k][i]-exact ) ) );
+               comp_error  = std::max( comp_error,  static_cast<double>( std::abs( q.value(k)[i]-exact ) ) );
+           }
+        }
+         std::printf( "%-10s %12.3f %12.3f %12.2e %12.2e\n", "advance", plain_ns, comp_ns, plain_error/2e6, comp_error/2e6 );
+      }
+
+      const affine::point_array<point<3>> p( (std::span<const point<3>>(p0)) );
+
+      // reductions, long double references
+      long double centroid[3] = {0,0,0}, sum[3] = {0,0,0};
+      for( std::size_t k=0; k<length; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ centroid[i]+=p0[k][i]; sum[i]+=d0[k][i]; }
+     }
+
+      {
+         point<3> c, e;
+         const double plain_ns = bench::time_ns( [&]{ c = affine::centroid( p ); bench::do_not_optimize(c); }, 4 )/length;
+         const double comp_ns  = bench::time_ns( [&]{ e = affine::compensated_centroid( p ); bench::do_not_optimize(e); }, 4 )/length;
+
+         double plain_error = 0, comp_error = 0;
+         for( std::size_t i=0; i<3; ++i )
+        {
+            const long double exact = centroid[i]/length;
+            plain_error = std::max( plain_error, static_cast<double>( std::abs( c[i]-exact ) ) );
+            comp_error  = std::max( comp_error,  static_cast<double>( std::abs( e[i]-exact ) ) );
+        }
+         std::printf( "%-10s %12.3f %12.3f %12.2e %12.2e\n", "centroid", plain_ns, comp_ns, plain_error/2e6, comp_error/2e6 );
+      }
+
+      {
+         delta<3> s, t;
+         const double plain_ns = bench::time_ns( [&]{ s = delta<3>{}; for( const delta<3>& x : d0 ){ s+=x; } bench::do_not_optimize(s); }, 4 )/length;
+         const double comp_ns  = bench::time_ns( [&]{ t = affine::compensated_sum( d ); bench::do_not_optimize(t); }, 4 )/length;
+
+         double plain_error = 0, comp_error = 0;
+         for( std::size_t i=0; i<3; ++i )
+        {
+            plain_error = std::max( plain_error, static_cast<double>( std::abs( s[i]-sum[i] ) ) );
+            comp_error  = std::max( comp_error,  static_cast<double>( std::abs( t[i]-sum[i] ) ) );
+        }
+         std::printf( "%-10s %12.3f %12.3f %12.2e %12.2e\n", "sum", plain_ns, comp_ns, plain_error/1e-7, comp_error/1e-7 );
+      }
+
+      // fast and reproducible parallel reductions
+      std::printf( "\n%-10s %12s %12s\n", "# kernel", "fast ns", "repro ns" );
+      constexpr auto par = affine::execution::par_unseq;
+
+      {
+         point<3> c, e;
+         const double fast_ns  = bench::time_ns( [&]{ c = affine::centroid( par, p ); bench::do_not_optimize(c); }, 4 )/length;
+         const double repro_ns = bench::time_ns( [&]{ e = affine::reproducible_centroid( par, p ); bench::do_not_optimize(e); }, 4 )/length;
+         std::printf( "%-10s %12.3f %12.3f\n", "centroid", fast_ns, repro_ns );
+      }
+
+      {
+         delta<3> s, t;
+         const auto chunk_sum = [&]( const std::size_t b, const std::size_t e )
+        {
+            return affine::detail::chunk_sum<decltype(par),delta<3>>( b, e, delta<3>{}, [&]( const std::size_t i ){ return d[i].value(); } );
+        };
+         const double fast_ns  = bench::time_ns( [&]{ s = affine::detail::parallel_reduce( par, length, delta<3>{}, chunk_sum, std::plus{} ); bench::do_not_optimize(s); }, 4 )/length;
+         const double repro_ns = bench::time_ns( [&]{ t = affine::reproducible_sum( par, d ); bench::do_not_optimize(t); }, 4 )/length;
+         std::printf( "%-10s %12.3f %12.3f\n", "sum", fast_ns, repro_ns );
+      }
+
+      {
+         const affine::delta_array<delta<3>> e( (std::span<const delta<3>>(d0)) );
+         double s = 0, t = 0;
+         const auto chunk_dot = [&]( const std::size_t b, const std::size_t f )
+        {
+            return affine::detail::chunk_sum<decltype(par),double>( b, f, 0., [&]( const std::size_t i ){ return affine::dot( d[i].value(), e[i].value() ); } );
+        };
+         const double fast_ns  = bench::time_ns( [&]{ s = affine::detail::parallel_reduce( par, length, 0., chunk_dot, std::plus{} ); bench::do_not_optimize(s); }, 4 )/length;
+         const double repro_ns = bench::time_ns( [&]{ t = affine::reproducible_dot( par, d, e ); bench::do_not_optimize(t); }, 4 )/length;
+         std::printf( "%-10s %12.3f %12.3f\n", "dot", fast_ns, repro_ns );
+      }
+  }
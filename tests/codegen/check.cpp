@@ -0,0 +1,187 @@
+
+/*
+ * codegen check, compares the assembly generated for the reference kernels in kernels.cpp
+ *
+ *    usage: check.out kernels.s
+ *
+ *    kernels.s is the AT&T syntax assembly of kernels.cpp (gcc or clang -S)
+ *    for each pair of functions affine_<name>, raw_<name> the affine version must have
+ *       the same instruction mix as the raw version, i.e. the same count of each mnemonic
+ *       no calls, including tail calls
+ *       no more stack traffic (push/pop, or memory operands relative to rsp/rbp) than the raw version
+ *
+ *    prints one line per kernel and returns non-zero if any kernel fails
+ */
+
+# include <cstdio>
+# include <fstream>
+# include <map>
+# include <string>
+# include <string_view>
+# include <vector>
+
+   struct instruction
+  {
+      std::string mnemonic;
+      std::string operands;
+  };
+
+   using function_map = std::map<std::string,std::vector<instruction>>;
+
+/*
+ * name of a function from its label, without any mangling
+ *    kernels are free functions in the global namespace, so a mangled label is _Z<length><name><parameters>
+ */
+   std::string function_name( const std::string_view label )
+  {
+      if( !label.starts_with("_Z") ){ return std::string(label); }
+
+      std::size_t i=2, length=0;
+      for( ; i<label.size() && label[i]>='0' && label[i]<='9'; ++i ){ length = 10*length + static_cast<std::size_t>(label[i]-'0'); }
+      return std::string( label.substr( i, length ) );
+  }
+
+/*
+ * instructions of each function in an assembly file
+ *    directives and local labels (.L*) are skipped
+ */
+   function_map read_functions( std::ifstream& file )
+  {
+      function_map functions;
+      std::vector<instruction>* current = nullptr;
+
+      std::string line;
+      while( std::getline( file, line ) )
+     {
+         if( line.empty() ){ continue; }
+
+         // label
+         if( line.back()==':' && line.front()!='\t' && line.front()!=' ' )
+        {
+            if( line.front()!='.' ){ current = &functions[ function_name( std::string_view(line).substr(0,line.size()-1) ) ]; }
+            continue;
+        }
+
+         // instruction
+         const auto first = line.find_first_not_of(" \t");
+         if( current==nullptr || first==std::string::npos || line[first]=='.' || line[first]=='#' ){ continue; }
+
+         const auto end = line.find_first_of( " \t", first );
+         instruction ins;
+         ins.mnemonic = line.substr( first, end-first );
+         if( end!=std::string::npos )
+        {
+            const auto operands = line.find_first_not_of( " \t", end );
+            if( operands!=std::string::npos ){ ins.operands = line.substr(operands); }
+        }
+         current->push_back(ins);
+     }
+      return functions;
+  }
+
+   bool is_call( const instruction& ins )
+  {
+      const bool call = ins.mnemonic.starts_with("call");
+      const bool tail_call = ins.mnemonic.starts_with("jmp") && !ins.operands.starts_with(".L");
+      return call || tail_call;
+  }
+
+   bool is_stack_access( const instruction& ins )
+  {
+      return ins.mnemonic.starts_with("push")
+          || ins.mnemonic.starts_with("pop")
+          || ins.operands.find("(%rsp")!=std::string::npos
+          || ins.operands.find("(%rbp")!=std::string::npos;
+  }
+
+   // packed floating point or integer vector instructions, e.g. vaddpd, vfmadd231ps, vpxor
+   bool is_packed( const instruction& ins )
+  {
+      const std::string_view m = ins.mnemonic;
+      return m.ends_with("pd") || m.ends_with("ps") || m.starts_with("vp") || m.starts_with("vbroadcast");
+  }
+
+   struct summary
+  {
+      std::size_t instructions = 0;
+      std::size_t packed = 0;
+      std::size_t calls = 0;
+      std::size_t stack = 0;
+      std::map<std::string,std::size_t> mix;
+  };
+
+   summary summarise( const std::vector<instruction>& function )
+  {
+      summary s;
+      for( const auto& ins : function )
+     {
+         ++s.instructions;
+         ++s.mix[ins.mnemonic];
+         if( is_packed(ins) ){ ++s.packed; }
+         if( is_call(ins) ){ ++s.calls; }
+         if( is_stack_access(ins) ){ ++s.stack; }
+     }
+      return s;
+  }
+
+   // mnemonics which occur more often in lhs than in rhs, as "mnemonic(+count) ..."
+   std::string excess( const summary& lhs, const summary& rhs )
+  {
+      std::string result;
+      for( const auto& [mnemonic,count] : lhs.mix )
+     {
+         const auto it = rhs.mix.find(mnemonic);
+         const std::size_t other = it==rhs.mix.end() ? 0 : it->second;
+         if( count>other ){ result += " "+mnemonic+"(+"+std::to_string(count-other)+")"; }
+     }
+      return result;
+  }
+
+   int main( int argc, char** argv )
+  {
+      if( argc!=2 ){ std::fprintf( stderr, "usage: %s kernels.s\n", argv[0] ); return 2; }
+
+      std::ifstream file(argv[1]);
+      if( !file ){ std::fprintf( stderr, "cannot open %s\n", argv[1] ); return 2; }
+
+      const function_map functions = read_functions(file);
+
+      std::size_t checked=0, failed=0;
+      for( const auto& [name,code] : functions )
+     {
+         if( !name.starts_with("affine_") ){ continue; }
+
+         const std::string kernel = name.substr(7);
+         const auto raw = functions.find( "raw_"+kernel );
+         if( raw==functions.end() )
+        {
+            std::printf( "%-24s FAIL no raw_%s\n", kernel.c_str(), kernel.c_str() );
+            ++checked;
+            ++failed;
+            continue;
+        }
+
+         const summary a = summarise(code);
+         const summary r = summarise(raw->second);
+
+         const bool same_mix = a.mix==r.mix;
+         const bool pass = same_mix && a.calls==0 && a.stack<=r.stack;
+
+         std::printf( "%-24s %s  instructions %zu/%zu  packed %zu/%zu  calls %zu/%zu  stack %zu/%zu  (affine/raw)\n",
+                      kernel.c_str(), pass ? "ok  " : "FAIL",
+                      a.instructions, r.instructions, a.packed, r.packed, a.calls, r.calls, a.stack, r.stack );
+         if( !same_mix )
+        {
+            std::printf( "   affine only:%s\n", excess(a,r).c_str() );
+            std::printf( "   raw only:   %s\n", excess(r,a).c_str() );
+        }
+
+         ++checked;
+         if( !pass ){ ++failed; }
+     }
+
+      if( checked==0 ){ std::fprintf( stderr, "no kernels found in %s\n", argv[1] ); return 2; }
+
+      std::printf( "%zu of %zu kernels match\n", checked-failed, checked );
+      return failed==0 ? 0 : 1;
+  }
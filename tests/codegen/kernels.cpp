@@ -0,0 +1,141 @@
+
+/*
+ * reference kernels for the codegen check, see check.cpp
+ *    each kernel is written twice, once with the affine types (affine_<name>) and once as a raw loop over std::array (raw_<name>)
+ *    both versions must compile to the same instruction mix
+ *
+ * kernels are compiled to assembly only, never linked, so each one is an external function with its operands as arguments
+ */
+
+# include <vector_space.h>
+
+# include <array>
+# include <cstddef>
+
+   template<std::size_t N>
+   using raw = std::array<double,N>;
+
+// --------------- single elements ---------------
+
+   // p + a*d, ndim=3
+   point<3> affine_p_plus_ad_3( const point<3>& p, const double a, const delta<3>& d ){ return p+a*d; }
+
+   raw<3> raw_p_plus_ad_3( const raw<3>& p, const double a, const raw<3>& d )
+  {
+      raw<3> r;
+      for( std::size_t i=0; i<3; ++i ){ r[i]=p[i]+a*d[i]; }
+      return r;
+  }
+
+   // p - q, ndim=4
+   delta<4> affine_p_minus_q_4( const point<4>& p, const point<4>& q ){ return p-q; }
+
+   raw<4> raw_p_minus_q_4( const raw<4>& p, const raw<4>& q )
+  {
+      raw<4> r;
+      for( std::size_t i=0; i<4; ++i ){ r[i]=p[i]-q[i]; }
+      return r;
+  }
+
+   // p + d, ndim=3
+   point<3> affine_p_plus_d_3( const point<3>& p, const delta<3>& d ){ return p+d; }
+
+   raw<3> raw_p_plus_d_3( const raw<3>& p, const raw<3>& d )
+  {
+      raw<3> r;
+      for( std::size_t i=0; i<3; ++i ){ r[i]=p[i]+d[i]; }
+      return r;
+  }
+
+   // d + e - f, ndim=4
+   delta<4> affine_d_plus_e_minus_f_4( const delta<4>& d, const delta<4>& e, const delta<4>& f ){ return d+e-f; }
+
+   raw<4> raw_d_plus_e_minus_f_4( const raw<4>& d, const raw<4>& e, const raw<4>& f )
+  {
+      raw<4> r;
+      for( std::size_t i=0; i<4; ++i ){ r[i]=d[i]+e[i]-f[i]; }
+      return r;
+  }
+
+   // -d, ndim=2
+   delta<2> affine_negate_2( const delta<2>& d ){ return -d; }
+
+   raw<2> raw_negate_2( const raw<2>& d )
+  {
+      raw<2> r;
+      for( std::size_t i=0; i<2; ++i ){ r[i]=-d[i]; }
+      return r;
+  }
+
+   // d*a, ndim=4
+   delta<4> affine_d_times_a_4( const delta<4>& d, const double a ){ return d*a; }
+
+   raw<4> raw_d_times_a_4( const raw<4>& d, const double a )
+  {
+      raw<4> r;
+      for( std::size_t i=0; i<4; ++i ){ r[i]=d[i]*a; }
+      return r;
+  }
+
+// --------------- in-place ---------------
+
+   // p += d, ndim=3
+   void affine_p_advance_3( point<3>& p, const delta<3>& d ){ p+=d; }
+
+   void raw_p_advance_3( raw<3>& p, const raw<3>& d )
+  {
+      for( std::size_t i=0; i<3; ++i ){ p[i]+=d[i]; }
+  }
+
+   // d *= a, ndim=8
+   void affine_d_scale_8( delta<8>& d, const double a ){ d*=a; }
+
+   void raw_d_scale_8( raw<8>& d, const double a )
+  {
+      for( std::size_t i=0; i<8; ++i ){ d[i]*=a; }
+  }
+
+// --------------- loops ---------------
+
+   // p[k] += a*d[k], ndim=3
+   void affine_loop_p_plus_ad_3( const std::size_t n, point<3>* __restrict p, const double a, const delta<3>* __restrict d )
+  {
+      for( std::size_t k=0; k<n; ++k ){ p[k]+=a*d[k]; }
+  }
+
+   void raw_loop_p_plus_ad_3( const std::size_t n, raw<3>* __restrict p, const double a, const raw<3>* __restrict d )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i ){ p[k][i]+=a*d[k][i]; }
+     }
+  }
+
+   // d[k] = p[k]-q[k], ndim=4
+   void affine_loop_p_minus_q_4( const std::size_t n, const point<4>* __restrict p, const point<4>* __restrict q, delta<4>* __restrict d )
+  {
+      for( std::size_t k=0; k<n; ++k ){ d[k]=p[k]-q[k]; }
+  }
+
+   void raw_loop_p_minus_q_4( const std::size_t n, const raw<4>* __restrict p, const raw<4>* __restrict q, raw<4>* __restrict d )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         for( std::size_t i=0; i<4; ++i ){ d[k][i]=p[k][i]-q[k][i]; }
+     }
+  }
+
+   // r[k] = p[k]+d[k], ndim=3, without restrict so the result is copied through a temporary
+   void affine_loop_p_plus_d_3( const std::size_t n, const point<3>* p, const delta<3>* d, point<3>* r )
+  {
+      for( std::size_t k=0; k<n; ++k ){ r[k]=p[k]+d[k]; }
+  }
+
+   void raw_loop_p_plus_d_3( const std::size_t n, const raw<3>* p, const raw<3>* d, raw<3>* r )
+  {
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const raw<3> t{ p[k][0]+d[k][0], p[k][1]+d[k][1], p[k][2]+d[k][2] };
+         r[k]=t;
+     }
+  }
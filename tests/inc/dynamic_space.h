@@ -0,0 +1,11 @@
+
+# include <affine_space.h>
+
+   struct dynamic_point;
+   struct dynamic_delta;
+
+   struct dynamic_point :
+      affine::point_base<affine::dynamic_extent,dynamic_point,dynamic_delta,double> {};
+
+   struct dynamic_delta :
+      affine::delta_base<affine::dynamic_extent,dynamic_point,dynamic_delta,double> {};
@@ -0,0 +1,16 @@
+
+# include <affine_space.h>
+
+# include <cstddef>
+
+   template<std::size_t ndim, typename num_t, typename dnum_t> struct exact_point;
+   template<std::size_t ndim, typename num_t, typename dnum_t> struct exact_delta;
+
+   // points with integer or fixed point coordinates, and deltas with a (possibly wider) number type
+   template<std::size_t ndim, typename num_t, typename dnum_t=num_t>
+   struct exact_point :
+      affine::point_base<ndim,exact_point<ndim,num_t,dnum_t>,exact_delta<ndim,num_t,dnum_t>,num_t> {};
+
+   template<std::size_t ndim, typename num_t, typename dnum_t=num_t>
+   struct exact_delta :
+      affine::delta_base<ndim,exact_point<ndim,num_t,dnum_t>,exact_delta<ndim,num_t,dnum_t>,dnum_t> {};
@@ -0,0 +1,16 @@
+
+# include <affine_space.h>
+
+   template<typename num_t> struct homogeneous_point;
+   template<typename num_t> struct homogeneous_delta;
+
+   template<typename num_t>
+   struct affine::storage_traits<homogeneous_point<num_t>> { using type = affine::homogeneous_storage; };
+
+   template<typename num_t>
+   struct homogeneous_point :
+      affine::point_base<3,homogeneous_point<num_t>,homogeneous_delta<num_t>,num_t> {};
+
+   template<typename num_t>
+   struct homogeneous_delta :
+      affine::delta_base<3,homogeneous_point<num_t>,homogeneous_delta<num_t>,num_t> {};
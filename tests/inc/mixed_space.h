@@ -0,0 +1,16 @@
+
+# include <affine_space.h>
+
+# include <cstddef>
+
+   template<std::size_t N, typename num_t, typename dnum_t> struct mixed_point;
+   template<std::size_t N, typename num_t, typename dnum_t> struct mixed_delta;
+
+   // points and deltas with different number types, by default double points with float deltas
+   template<std::size_t N, typename num_t=double, typename dnum_t=float>
+   struct mixed_point :
+      affine::point_base<N,mixed_point<N,num_t,dnum_t>,mixed_delta<N,num_t,dnum_t>,num_t> {};
+
+   template<std::size_t N, typename num_t=double, typename dnum_t=float>
+   struct mixed_delta :
+      affine::delta_base<N,mixed_point<N,num_t,dnum_t>,mixed_delta<N,num_t,dnum_t>,dnum_t> {};
@@ -0,0 +1,31 @@
+
+# include <concepts>
+# include <cstddef>
+# include <random>
+# include <vector>
+
+   // n points with every coordinate drawn uniformly from [centre-width,centre+width)
+   template<typename point_t>
+   inline std::vector<point_t> make_cloud( const std::size_t n, const unsigned seed, const double centre=0, const double width=1 )
+  {
+      using num_t = typename point_t::value_type;
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> uniform(-width,width);
+
+      std::vector<point_t> ps(n);
+      for( auto& p : ps )
+     {
+         for( std::size_t c=0; c<point_t::size(); ++c ){ p[c]=static_cast<num_t>(centre+uniform(rng)); }
+     }
+      return ps;
+  }
+
+   // n points, the i-th given by point_at(i)
+   template<typename point_t, typename generator_t>
+      requires std::invocable<generator_t&,std::size_t>
+   inline std::vector<point_t> make_cloud( const std::size_t n, generator_t&& point_at )
+  {
+      std::vector<point_t> ps(n);
+      for( std::size_t i=0; i<n; ++i ){ ps[i]=point_at(i); }
+      return ps;
+  }
@@ -0,0 +1,14 @@
+
+# include <affine_space.h>
+# include <simd.h>
+
+   template<std::size_t N, typename num_t> struct simd_point;
+   template<std::size_t N, typename num_t> struct simd_delta;
+
+   template<std::size_t N, typename num_t>
+   struct simd_point :
+      affine::point_base<N,simd_point<N,num_t>,simd_delta<N,num_t>,num_t> {};
+
+   template<std::size_t N, typename num_t>
+   struct simd_delta :
+      affine::delta_base<N,simd_point<N,num_t>,simd_delta<N,num_t>,num_t> {};
@@ -0,0 +1,15 @@
+
+# include <kernels.h>
+
+# include <vector>
+
+   // every instruction set supported by this cpu
+   inline std::vector<affine::isa> supported_isas()
+  {
+      std::vector<affine::isa> isas;
+      for( auto i : { affine::isa::scalar, affine::isa::sse2, affine::isa::avx2, affine::isa::avx512 } )
+     {
+         if( i<=affine::detect_isa() ){ isas.push_back(i); }
+     }
+      return isas;
+  }
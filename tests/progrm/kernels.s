@@ -0,0 +1,749 @@
+	.file	"kernels.cpp"
+	.text
+	.p2align 4
+	.globl	_Z18affine_p_plus_ad_3RK5pointILm3EEdRK5deltaILm3EE
+	.type	_Z18affine_p_plus_ad_3RK5pointILm3EEdRK5deltaILm3EE, @function
+_Z18affine_p_plus_ad_3RK5pointILm3EEdRK5deltaILm3EE:
+.LFB1469:
+	.cfi_startproc
+	vmovupd	(%rsi), %xmm2
+	vmovsd	16(%rsi), %xmm3
+	vmovddup	%xmm0, %xmm1
+	movq	%rdi, %rax
+	vfmadd132pd	(%rdx), %xmm2, %xmm1
+	vfmadd132sd	16(%rdx), %xmm3, %xmm0
+	vmovupd	%xmm1, (%rdi)
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1469:
+	.size	_Z18affine_p_plus_ad_3RK5pointILm3EEdRK5deltaILm3EE, .-_Z18affine_p_plus_ad_3RK5pointILm3EEdRK5deltaILm3EE
+	.p2align 4
+	.globl	_Z15raw_p_plus_ad_3RKSt5arrayIdLm3EEdS2_
+	.type	_Z15raw_p_plus_ad_3RKSt5arrayIdLm3EEdS2_, @function
+_Z15raw_p_plus_ad_3RKSt5arrayIdLm3EEdS2_:
+.LFB1470:
+	.cfi_startproc
+	vmovupd	(%rsi), %xmm2
+	vmovsd	16(%rsi), %xmm3
+	vmovddup	%xmm0, %xmm1
+	movq	%rdi, %rax
+	vfmadd132pd	(%rdx), %xmm2, %xmm1
+	vfmadd132sd	16(%rdx), %xmm3, %xmm0
+	vmovupd	%xmm1, (%rdi)
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1470:
+	.size	_Z15raw_p_plus_ad_3RKSt5arrayIdLm3EEdS2_, .-_Z15raw_p_plus_ad_3RKSt5arrayIdLm3EEdS2_
+	.p2align 4
+	.globl	_Z18affine_p_minus_q_4RK5pointILm4EES2_
+	.type	_Z18affine_p_minus_q_4RK5pointILm4EES2_, @function
+_Z18affine_p_minus_q_4RK5pointILm4EES2_:
+.LFB1471:
+	.cfi_startproc
+	vmovupd	(%rsi), %ymm0
+	vsubpd	(%rdx), %ymm0, %ymm0
+	movq	%rdi, %rax
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1471:
+	.size	_Z18affine_p_minus_q_4RK5pointILm4EES2_, .-_Z18affine_p_minus_q_4RK5pointILm4EES2_
+	.p2align 4
+	.globl	_Z15raw_p_minus_q_4RKSt5arrayIdLm4EES2_
+	.type	_Z15raw_p_minus_q_4RKSt5arrayIdLm4EES2_, @function
+_Z15raw_p_minus_q_4RKSt5arrayIdLm4EES2_:
+.LFB1472:
+	.cfi_startproc
+	vmovupd	(%rsi), %ymm0
+	vsubpd	(%rdx), %ymm0, %ymm0
+	movq	%rdi, %rax
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1472:
+	.size	_Z15raw_p_minus_q_4RKSt5arrayIdLm4EES2_, .-_Z15raw_p_minus_q_4RKSt5arrayIdLm4EES2_
+	.p2align 4
+	.globl	_Z17affine_p_plus_d_3RK5pointILm3EERK5deltaILm3EE
+	.type	_Z17affine_p_plus_d_3RK5pointILm3EERK5deltaILm3EE, @function
+_Z17affine_p_plus_d_3RK5pointILm3EERK5deltaILm3EE:
+.LFB1473:
+	.cfi_startproc
+	vmovupd	(%rsi), %xmm1
+	vaddpd	(%rdx), %xmm1, %xmm0
+	movq	%rdi, %rax
+	vmovupd	%xmm0, (%rdi)
+	vmovsd	16(%rsi), %xmm0
+	vaddsd	16(%rdx), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1473:
+	.size	_Z17affine_p_plus_d_3RK5pointILm3EERK5deltaILm3EE, .-_Z17affine_p_plus_d_3RK5pointILm3EERK5deltaILm3EE
+	.p2align 4
+	.globl	_Z14raw_p_plus_d_3RKSt5arrayIdLm3EES2_
+	.type	_Z14raw_p_plus_d_3RKSt5arrayIdLm3EES2_, @function
+_Z14raw_p_plus_d_3RKSt5arrayIdLm3EES2_:
+.LFB1474:
+	.cfi_startproc
+	vmovupd	(%rsi), %xmm1
+	vaddpd	(%rdx), %xmm1, %xmm0
+	movq	%rdi, %rax
+	vmovupd	%xmm0, (%rdi)
+	vmovsd	16(%rsi), %xmm0
+	vaddsd	16(%rdx), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1474:
+	.size	_Z14raw_p_plus_d_3RKSt5arrayIdLm3EES2_, .-_Z14raw_p_plus_d_3RKSt5arrayIdLm3EES2_
+	.p2align 4
+	.globl	_Z25affine_d_plus_e_minus_f_4RK5deltaILm4EES2_S2_
+	.type	_Z25affine_d_plus_e_minus_f_4RK5deltaILm4EES2_S2_, @function
+_Z25affine_d_plus_e_minus_f_4RK5deltaILm4EES2_S2_:
+.LFB1475:
+	.cfi_startproc
+	vmovupd	(%rdx), %ymm0
+	vaddpd	(%rsi), %ymm0, %ymm0
+	movq	%rdi, %rax
+	vsubpd	(%rcx), %ymm0, %ymm0
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1475:
+	.size	_Z25affine_d_plus_e_minus_f_4RK5deltaILm4EES2_S2_, .-_Z25affine_d_plus_e_minus_f_4RK5deltaILm4EES2_S2_
+	.p2align 4
+	.globl	_Z22raw_d_plus_e_minus_f_4RKSt5arrayIdLm4EES2_S2_
+	.type	_Z22raw_d_plus_e_minus_f_4RKSt5arrayIdLm4EES2_S2_, @function
+_Z22raw_d_plus_e_minus_f_4RKSt5arrayIdLm4EES2_S2_:
+.LFB1476:
+	.cfi_startproc
+	vmovupd	(%rsi), %ymm0
+	vaddpd	(%rdx), %ymm0, %ymm0
+	movq	%rdi, %rax
+	vsubpd	(%rcx), %ymm0, %ymm0
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1476:
+	.size	_Z22raw_d_plus_e_minus_f_4RKSt5arrayIdLm4EES2_S2_, .-_Z22raw_d_plus_e_minus_f_4RKSt5arrayIdLm4EES2_S2_
+	.p2align 4
+	.globl	_Z15affine_negate_2RK5deltaILm2EE
+	.type	_Z15affine_negate_2RK5deltaILm2EE, @function
+_Z15affine_negate_2RK5deltaILm2EE:
+.LFB1477:
+	.cfi_startproc
+	vmovddup	.LC1(%rip), %xmm0
+	vxorpd	(%rdi), %xmm0, %xmm2
+	vmovapd	%xmm2, -24(%rsp)
+	vmovsd	-16(%rsp), %xmm1
+	vmovsd	-24(%rsp), %xmm0
+	ret
+	.cfi_endproc
+.LFE1477:
+	.size	_Z15affine_negate_2RK5deltaILm2EE, .-_Z15affine_negate_2RK5deltaILm2EE
+	.p2align 4
+	.globl	_Z12raw_negate_2RKSt5arrayIdLm2EE
+	.type	_Z12raw_negate_2RKSt5arrayIdLm2EE, @function
+_Z12raw_negate_2RKSt5arrayIdLm2EE:
+.LFB1478:
+	.cfi_startproc
+	vmovddup	.LC1(%rip), %xmm0
+	vxorpd	(%rdi), %xmm0, %xmm2
+	vmovapd	%xmm2, -24(%rsp)
+	vmovsd	-16(%rsp), %xmm1
+	vmovsd	-24(%rsp), %xmm0
+	ret
+	.cfi_endproc
+.LFE1478:
+	.size	_Z12raw_negate_2RKSt5arrayIdLm2EE, .-_Z12raw_negate_2RKSt5arrayIdLm2EE
+	.p2align 4
+	.globl	_Z18affine_d_times_a_4RK5deltaILm4EEd
+	.type	_Z18affine_d_times_a_4RK5deltaILm4EEd, @function
+_Z18affine_d_times_a_4RK5deltaILm4EEd:
+.LFB1479:
+	.cfi_startproc
+	vbroadcastsd	%xmm0, %ymm0
+	movq	%rdi, %rax
+	vmulpd	(%rsi), %ymm0, %ymm0
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1479:
+	.size	_Z18affine_d_times_a_4RK5deltaILm4EEd, .-_Z18affine_d_times_a_4RK5deltaILm4EEd
+	.p2align 4
+	.globl	_Z15raw_d_times_a_4RKSt5arrayIdLm4EEd
+	.type	_Z15raw_d_times_a_4RKSt5arrayIdLm4EEd, @function
+_Z15raw_d_times_a_4RKSt5arrayIdLm4EEd:
+.LFB1480:
+	.cfi_startproc
+	vbroadcastsd	%xmm0, %ymm0
+	movq	%rdi, %rax
+	vmulpd	(%rsi), %ymm0, %ymm0
+	vmovupd	%ymm0, (%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1480:
+	.size	_Z15raw_d_times_a_4RKSt5arrayIdLm4EEd, .-_Z15raw_d_times_a_4RKSt5arrayIdLm4EEd
+	.p2align 4
+	.globl	_Z18affine_p_advance_3R5pointILm3EERK5deltaILm3EE
+	.type	_Z18affine_p_advance_3R5pointILm3EERK5deltaILm3EE, @function
+_Z18affine_p_advance_3R5pointILm3EERK5deltaILm3EE:
+.LFB1481:
+	.cfi_startproc
+	leaq	8(%rsi), %rax
+	cmpq	%rax, %rdi
+	je	.L15
+	vmovupd	(%rdi), %xmm1
+	vaddpd	(%rsi), %xmm1, %xmm0
+	vmovupd	%xmm0, (%rdi)
+	vmovsd	16(%rdi), %xmm0
+	vaddsd	16(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.p2align 4,,10
+	.p2align 3
+.L15:
+	vmovsd	(%rdi), %xmm0
+	vaddsd	(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, (%rdi)
+	vmovsd	8(%rdi), %xmm0
+	vaddsd	8(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, 8(%rdi)
+	vmovsd	16(%rdi), %xmm0
+	vaddsd	16(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1481:
+	.size	_Z18affine_p_advance_3R5pointILm3EERK5deltaILm3EE, .-_Z18affine_p_advance_3R5pointILm3EERK5deltaILm3EE
+	.p2align 4
+	.globl	_Z15raw_p_advance_3RSt5arrayIdLm3EERKS0_
+	.type	_Z15raw_p_advance_3RSt5arrayIdLm3EERKS0_, @function
+_Z15raw_p_advance_3RSt5arrayIdLm3EERKS0_:
+.LFB1482:
+	.cfi_startproc
+	leaq	8(%rsi), %rax
+	cmpq	%rax, %rdi
+	je	.L18
+	vmovupd	(%rsi), %xmm1
+	vaddpd	(%rdi), %xmm1, %xmm0
+	vmovupd	%xmm0, (%rdi)
+	vmovsd	16(%rsi), %xmm0
+	vaddsd	16(%rdi), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.p2align 4,,10
+	.p2align 3
+.L18:
+	vmovsd	(%rdi), %xmm0
+	vaddsd	(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, (%rdi)
+	vmovsd	8(%rdi), %xmm0
+	vaddsd	8(%rsi), %xmm0, %xmm0
+	vmovsd	%xmm0, 8(%rdi)
+	vmovsd	16(%rsi), %xmm0
+	vaddsd	16(%rdi), %xmm0, %xmm0
+	vmovsd	%xmm0, 16(%rdi)
+	ret
+	.cfi_endproc
+.LFE1482:
+	.size	_Z15raw_p_advance_3RSt5arrayIdLm3EERKS0_, .-_Z15raw_p_advance_3RSt5arrayIdLm3EERKS0_
+	.p2align 4
+	.globl	_Z16affine_d_scale_8R5deltaILm8EEd
+	.type	_Z16affine_d_scale_8R5deltaILm8EEd, @function
+_Z16affine_d_scale_8R5deltaILm8EEd:
+.LFB1483:
+	.cfi_startproc
+	vbroadcastsd	%xmm0, %ymm0
+	vmulpd	(%rdi), %ymm0, %ymm1
+	vmulpd	32(%rdi), %ymm0, %ymm0
+	vmovupd	%ymm1, (%rdi)
+	vmovupd	%ymm0, 32(%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1483:
+	.size	_Z16affine_d_scale_8R5deltaILm8EEd, .-_Z16affine_d_scale_8R5deltaILm8EEd
+	.p2align 4
+	.globl	_Z13raw_d_scale_8RSt5arrayIdLm8EEd
+	.type	_Z13raw_d_scale_8RSt5arrayIdLm8EEd, @function
+_Z13raw_d_scale_8RSt5arrayIdLm8EEd:
+.LFB1484:
+	.cfi_startproc
+	vbroadcastsd	%xmm0, %ymm0
+	vmulpd	(%rdi), %ymm0, %ymm1
+	vmulpd	32(%rdi), %ymm0, %ymm0
+	vmovupd	%ymm1, (%rdi)
+	vmovupd	%ymm0, 32(%rdi)
+	vzeroupper
+	ret
+	.cfi_endproc
+.LFE1484:
+	.size	_Z13raw_d_scale_8RSt5arrayIdLm8EEd, .-_Z13raw_d_scale_8RSt5arrayIdLm8EEd
+	.p2align 4
+	.globl	_Z23affine_loop_p_plus_ad_3mP5pointILm3EEdPK5deltaILm3EE
+	.type	_Z23affine_loop_p_plus_ad_3mP5pointILm3EEdPK5deltaILm3EE, @function
+_Z23affine_loop_p_plus_ad_3mP5pointILm3EEdPK5deltaILm3EE:
+.LFB1485:
+	.cfi_startproc
+	movq	%rsi, %rcx
+	movq	%rdx, %rsi
+	testq	%rdi, %rdi
+	je	.L44
+	leaq	-1(%rdi), %rax
+	cmpq	$2, %rax
+	jbe	.L29
+	movq	%rdi, %r8
+	vbroadcastsd	%xmm0, %ymm1
+	movq	%rcx, %rax
+	shrq	$2, %r8
+	leaq	(%r8,%r8,2), %r8
+	salq	$5, %r8
+	addq	%rdx, %r8
+	.p2align 4,,10
+	.p2align 3
+.L25:
+	vmovupd	(%rdx), %ymm4
+	vmovupd	32(%rdx), %ymm3
+	addq	$96, %rdx
+	addq	$96, %rax
+	vfmadd213pd	-96(%rax), %ymm1, %ymm4
+	vfmadd213pd	-64(%rax), %ymm1, %ymm3
+	vmovupd	-32(%rdx), %ymm2
+	vfmadd213pd	-32(%rax), %ymm1, %ymm2
+	vmovupd	%ymm4, -96(%rax)
+	vmovupd	%ymm3, -64(%rax)
+	vmovupd	%ymm2, -32(%rax)
+	cmpq	%rdx, %r8
+	jne	.L25
+	movq	%rdi, %rdx
+	andq	$-4, %rdx
+	testb	$3, %dil
+	je	.L45
+	vzeroupper
+.L24:
+	subq	%rdx, %rdi
+	vmovddup	%xmm0, %xmm1
+	cmpq	$1, %rdi
+	je	.L27
+	leaq	(%rdx,%rdx,2), %rax
+	salq	$3, %rax
+	leaq	(%rsi,%rax), %r8
+	addq	%rcx, %rax
+	vmovupd	(%r8), %xmm4
+	vmovupd	16(%r8), %xmm3
+	vfmadd213pd	(%rax), %xmm1, %xmm4
+	vfmadd213pd	16(%rax), %xmm1, %xmm3
+	vmovupd	32(%r8), %xmm2
+	vfmadd213pd	32(%rax), %xmm1, %xmm2
+	vmovupd	%xmm4, (%rax)
+	vmovupd	%xmm3, 16(%rax)
+	vmovupd	%xmm2, 32(%rax)
+	testb	$1, %dil
+	je	.L44
+	andq	$-2, %rdi
+	addq	%rdi, %rdx
+.L27:
+	leaq	(%rdx,%rdx,2), %rax
+	salq	$3, %rax
+	leaq	(%rsi,%rax), %rdx
+	addq	%rcx, %rax
+	vmovupd	(%rax), %xmm5
+	vmovsd	16(%rax), %xmm6
+	vfmadd132pd	(%rdx), %xmm5, %xmm1
+	vfmadd132sd	16(%rdx), %xmm6, %xmm0
+	vmovupd	%xmm1, (%rax)
+	vmovsd	%xmm0, 16(%rax)
+.L44:
+	ret
+.L45:
+	vzeroupper
+	ret
+.L29:
+	xorl	%edx, %edx
+	jmp	.L24
+	.cfi_endproc
+.LFE1485:
+	.size	_Z23affine_loop_p_plus_ad_3mP5pointILm3EEdPK5deltaILm3EE, .-_Z23affine_loop_p_plus_ad_3mP5pointILm3EEdPK5deltaILm3EE
+	.p2align 4
+	.globl	_Z20raw_loop_p_plus_ad_3mPSt5arrayIdLm3EEdPKS0_
+	.type	_Z20raw_loop_p_plus_ad_3mPSt5arrayIdLm3EEdPKS0_, @function
+_Z20raw_loop_p_plus_ad_3mPSt5arrayIdLm3EEdPKS0_:
+.LFB1486:
+	.cfi_startproc
+	movq	%rsi, %rcx
+	movq	%rdx, %rsi
+	testq	%rdi, %rdi
+	je	.L68
+	leaq	-1(%rdi), %rax
+	cmpq	$2, %rax
+	jbe	.L53
+	movq	%rdi, %r8
+	vbroadcastsd	%xmm0, %ymm1
+	movq	%rcx, %rax
+	shrq	$2, %r8
+	leaq	(%r8,%r8,2), %r8
+	salq	$5, %r8
+	addq	%rdx, %r8
+	.p2align 4,,10
+	.p2align 3
+.L49:
+	vmovupd	(%rdx), %ymm4
+	vmovupd	32(%rdx), %ymm3
+	addq	$96, %rdx
+	addq	$96, %rax
+	vfmadd213pd	-96(%rax), %ymm1, %ymm4
+	vfmadd213pd	-64(%rax), %ymm1, %ymm3
+	vmovupd	-32(%rdx), %ymm2
+	vfmadd213pd	-32(%rax), %ymm1, %ymm2
+	vmovupd	%ymm4, -96(%rax)
+	vmovupd	%ymm3, -64(%rax)
+	vmovupd	%ymm2, -32(%rax)
+	cmpq	%rdx, %r8
+	jne	.L49
+	movq	%rdi, %rdx
+	andq	$-4, %rdx
+	testb	$3, %dil
+	je	.L69
+	vzeroupper
+.L48:
+	subq	%rdx, %rdi
+	vmovddup	%xmm0, %xmm1
+	cmpq	$1, %rdi
+	je	.L51
+	leaq	(%rdx,%rdx,2), %rax
+	salq	$3, %rax
+	leaq	(%rsi,%rax), %r8
+	addq	%rcx, %rax
+	vmovupd	(%r8), %xmm4
+	vmovupd	16(%r8), %xmm3
+	vfmadd213pd	(%rax), %xmm1, %xmm4
+	vfmadd213pd	16(%rax), %xmm1, %xmm3
+	vmovupd	32(%r8), %xmm2
+	vfmadd213pd	32(%rax), %xmm1, %xmm2
+	vmovupd	%xmm4, (%rax)
+	vmovupd	%xmm3, 16(%rax)
+	vmovupd	%xmm2, 32(%rax)
+	testb	$1, %dil
+	je	.L68
+	andq	$-2, %rdi
+	addq	%rdi, %rdx
+.L51:
+	leaq	(%rdx,%rdx,2), %rax
+	salq	$3, %rax
+	leaq	(%rsi,%rax), %rdx
+	addq	%rcx, %rax
+	vmovupd	(%rax), %xmm5
+	vmovsd	16(%rax), %xmm6
+	vfmadd132pd	(%rdx), %xmm5, %xmm1
+	vfmadd132sd	16(%rdx), %xmm6, %xmm0
+	vmovupd	%xmm1, (%rax)
+	vmovsd	%xmm0, 16(%rax)
+.L68:
+	ret
+.L69:
+	vzeroupper
+	ret
+.L53:
+	xorl	%edx, %edx
+	jmp	.L48
+	.cfi_endproc
+.LFE1486:
+	.size	_Z20raw_loop_p_plus_ad_3mPSt5arrayIdLm3EEdPKS0_, .-_Z20raw_loop_p_plus_ad_3mPSt5arrayIdLm3EEdPKS0_
+	.p2align 4
+	.globl	_Z23affine_loop_p_minus_q_4mPK5pointILm4EES2_P5deltaILm4EE
+	.type	_Z23affine_loop_p_minus_q_4mPK5pointILm4EES2_P5deltaILm4EE, @function
+_Z23affine_loop_p_minus_q_4mPK5pointILm4EES2_P5deltaILm4EE:
+.LFB1487:
+	.cfi_startproc
+	testq	%rdi, %rdi
+	je	.L77
+	salq	$5, %rdi
+	xorl	%eax, %eax
+	.p2align 4,,10
+	.p2align 3
+.L72:
+	vmovupd	(%rsi,%rax), %ymm1
+	vsubpd	(%rdx,%rax), %ymm1, %ymm0
+	vmovupd	%ymm0, (%rcx,%rax)
+	addq	$32, %rax
+	cmpq	%rdi, %rax
+	jne	.L72
+	vzeroupper
+.L77:
+	ret
+	.cfi_endproc
+.LFE1487:
+	.size	_Z23affine_loop_p_minus_q_4mPK5pointILm4EES2_P5deltaILm4EE, .-_Z23affine_loop_p_minus_q_4mPK5pointILm4EES2_P5deltaILm4EE
+	.p2align 4
+	.globl	_Z20raw_loop_p_minus_q_4mPKSt5arrayIdLm4EES2_PS0_
+	.type	_Z20raw_loop_p_minus_q_4mPKSt5arrayIdLm4EES2_PS0_, @function
+_Z20raw_loop_p_minus_q_4mPKSt5arrayIdLm4EES2_PS0_:
+.LFB1488:
+	.cfi_startproc
+	testq	%rdi, %rdi
+	je	.L85
+	salq	$5, %rdi
+	xorl	%eax, %eax
+	.p2align 4,,10
+	.p2align 3
+.L80:
+	vmovupd	(%rsi,%rax), %ymm1
+	vsubpd	(%rdx,%rax), %ymm1, %ymm0
+	vmovupd	%ymm0, (%rcx,%rax)
+	addq	$32, %rax
+	cmpq	%rdi, %rax
+	jne	.L80
+	vzeroupper
+.L85:
+	ret
+	.cfi_endproc
+.LFE1488:
+	.size	_Z20raw_loop_p_minus_q_4mPKSt5arrayIdLm4EES2_PS0_, .-_Z20raw_loop_p_minus_q_4mPKSt5arrayIdLm4EES2_PS0_
+	.p2align 4
+	.globl	_Z22affine_loop_p_plus_d_3mPK5pointILm3EEPK5deltaILm3EEPS0_
+	.type	_Z22affine_loop_p_plus_d_3mPK5pointILm3EEPK5deltaILm3EEPS0_, @function
+_Z22affine_loop_p_plus_d_3mPK5pointILm3EEPK5deltaILm3EEPS0_:
+.LFB1489:
+	.cfi_startproc
+	movq	%rcx, %r8
+	testq	%rdi, %rdi
+	je	.L122
+	cmpq	$1, %rdi
+	je	.L88
+	movq	%rcx, %rax
+	subq	%rsi, %rax
+	subq	$8, %rax
+	cmpq	$80, %rax
+	jbe	.L88
+	movq	%rcx, %rax
+	subq	%rdx, %rax
+	subq	$8, %rax
+	cmpq	$80, %rax
+	jbe	.L88
+	leaq	-1(%rdi), %rax
+	cmpq	$2, %rax
+	jbe	.L96
+	movq	%rdi, %rax
+	shrq	$2, %rax
+	leaq	(%rax,%rax,2), %rcx
+	xorl	%eax, %eax
+	salq	$5, %rcx
+	.p2align 4,,10
+	.p2align 3
+.L90:
+	vmovupd	32(%rsi,%rax), %ymm4
+	vmovupd	64(%rsi,%rax), %ymm5
+	vmovupd	(%rsi,%rax), %ymm6
+	vaddpd	32(%rdx,%rax), %ymm4, %ymm1
+	vaddpd	64(%rdx,%rax), %ymm5, %ymm0
+	vaddpd	(%rdx,%rax), %ymm6, %ymm2
+	vmovupd	%ymm1, 32(%r8,%rax)
+	vmovupd	%ymm2, (%r8,%rax)
+	vmovupd	%ymm0, 64(%r8,%rax)
+	addq	$96, %rax
+	cmpq	%rcx, %rax
+	jne	.L90
+	testb	$3, %dil
+	je	.L120
+	movq	%rdi, %rax
+	andq	$-4, %rax
+	subq	%rax, %rdi
+	cmpq	$1, %rdi
+	je	.L123
+	vzeroupper
+.L89:
+	leaq	(%rax,%rax,2), %rcx
+	salq	$3, %rcx
+	leaq	(%rsi,%rcx), %r9
+	leaq	(%rdx,%rcx), %r10
+	addq	%r8, %rcx
+	vmovupd	16(%r9), %xmm7
+	vmovupd	(%r10), %xmm2
+	vaddpd	16(%r10), %xmm7, %xmm1
+	vaddpd	(%r9), %xmm2, %xmm2
+	vmovupd	32(%r9), %xmm7
+	vaddpd	32(%r10), %xmm7, %xmm0
+	vmovupd	%xmm2, (%rcx)
+	vmovupd	%xmm1, 16(%rcx)
+	vmovupd	%xmm0, 32(%rcx)
+	testb	$1, %dil
+	je	.L122
+	andq	$-2, %rdi
+	addq	%rdi, %rax
+.L92:
+	leaq	(%rax,%rax,2), %rax
+	salq	$3, %rax
+	addq	%rax, %rdx
+	addq	%rax, %rsi
+	addq	%r8, %rax
+	vmovsd	16(%rsi), %xmm0
+	vmovupd	(%rsi), %xmm1
+	vaddsd	16(%rdx), %xmm0, %xmm0
+	vaddpd	(%rdx), %xmm1, %xmm1
+	vmovsd	%xmm0, 16(%rax)
+	vmovupd	%xmm1, (%rax)
+	ret
+.L120:
+	vzeroupper
+.L122:
+	ret
+	.p2align 4,,10
+	.p2align 3
+.L88:
+	leaq	(%rdi,%rdi,2), %rcx
+	xorl	%eax, %eax
+	salq	$3, %rcx
+	.p2align 4,,10
+	.p2align 3
+.L94:
+	vmovsd	16(%rsi,%rax), %xmm0
+	vmovupd	(%rsi,%rax), %xmm3
+	vaddsd	16(%rdx,%rax), %xmm0, %xmm0
+	vaddpd	(%rdx,%rax), %xmm3, %xmm1
+	vmovsd	%xmm0, 16(%r8,%rax)
+	vmovupd	%xmm1, (%r8,%rax)
+	addq	$24, %rax
+	cmpq	%rcx, %rax
+	jne	.L94
+	ret
+.L96:
+	xorl	%eax, %eax
+	jmp	.L89
+.L123:
+	vzeroupper
+	jmp	.L92
+	.cfi_endproc
+.LFE1489:
+	.size	_Z22affine_loop_p_plus_d_3mPK5pointILm3EEPK5deltaILm3EEPS0_, .-_Z22affine_loop_p_plus_d_3mPK5pointILm3EEPK5deltaILm3EEPS0_
+	.p2align 4
+	.globl	_Z19raw_loop_p_plus_d_3mPKSt5arrayIdLm3EES2_PS0_
+	.type	_Z19raw_loop_p_plus_d_3mPKSt5arrayIdLm3EES2_PS0_, @function
+_Z19raw_loop_p_plus_d_3mPKSt5arrayIdLm3EES2_PS0_:
+.LFB1490:
+	.cfi_startproc
+	movq	%rcx, %r8
+	testq	%rdi, %rdi
+	je	.L160
+	cmpq	$1, %rdi
+	je	.L126
+	movq	%rcx, %rax
+	subq	%rdx, %rax
+	subq	$8, %rax
+	cmpq	$80, %rax
+	jbe	.L126
+	movq	%rcx, %rax
+	subq	%rsi, %rax
+	subq	$8, %rax
+	cmpq	$80, %rax
+	jbe	.L126
+	leaq	-1(%rdi), %rax
+	cmpq	$2, %rax
+	jbe	.L134
+	movq	%rdi, %rax
+	shrq	$2, %rax
+	leaq	(%rax,%rax,2), %rcx
+	xorl	%eax, %eax
+	salq	$5, %rcx
+	.p2align 4,,10
+	.p2align 3
+.L128:
+	vmovupd	32(%rsi,%rax), %ymm4
+	vmovupd	64(%rsi,%rax), %ymm5
+	vmovupd	(%rsi,%rax), %ymm6
+	vaddpd	32(%rdx,%rax), %ymm4, %ymm1
+	vaddpd	64(%rdx,%rax), %ymm5, %ymm0
+	vaddpd	(%rdx,%rax), %ymm6, %ymm2
+	vmovupd	%ymm1, 32(%r8,%rax)
+	vmovupd	%ymm2, (%r8,%rax)
+	vmovupd	%ymm0, 64(%r8,%rax)
+	addq	$96, %rax
+	cmpq	%rcx, %rax
+	jne	.L128
+	testb	$3, %dil
+	je	.L158
+	movq	%rdi, %rax
+	andq	$-4, %rax
+	subq	%rax, %rdi
+	cmpq	$1, %rdi
+	je	.L161
+	vzeroupper
+.L127:
+	leaq	(%rax,%rax,2), %rcx
+	salq	$3, %rcx
+	leaq	(%rsi,%rcx), %r9
+	leaq	(%rdx,%rcx), %r10
+	addq	%r8, %rcx
+	vmovupd	16(%r9), %xmm7
+	vmovupd	(%r10), %xmm2
+	vaddpd	16(%r10), %xmm7, %xmm1
+	vaddpd	(%r9), %xmm2, %xmm2
+	vmovupd	32(%r9), %xmm7
+	vaddpd	32(%r10), %xmm7, %xmm0
+	vmovupd	%xmm2, (%rcx)
+	vmovupd	%xmm1, 16(%rcx)
+	vmovupd	%xmm0, 32(%rcx)
+	testb	$1, %dil
+	je	.L160
+	andq	$-2, %rdi
+	addq	%rdi, %rax
+.L130:
+	leaq	(%rax,%rax,2), %rax
+	salq	$3, %rax
+	addq	%rax, %rsi
+	addq	%rax, %rdx
+	addq	%r8, %rax
+	vmovsd	16(%rsi), %xmm0
+	vmovupd	(%rsi), %xmm1
+	vaddsd	16(%rdx), %xmm0, %xmm0
+	vaddpd	(%rdx), %xmm1, %xmm1
+	vmovsd	%xmm0, 16(%rax)
+	vmovupd	%xmm1, (%rax)
+	ret
+.L158:
+	vzeroupper
+.L160:
+	ret
+	.p2align 4,,10
+	.p2align 3
+.L126:
+	leaq	(%rdi,%rdi,2), %rcx
+	xorl	%eax, %eax
+	salq	$3, %rcx
+	.p2align 4,,10
+	.p2align 3
+.L132:
+	vmovsd	16(%rsi,%rax), %xmm0
+	vmovupd	(%rsi,%rax), %xmm3
+	vaddsd	16(%rdx,%rax), %xmm0, %xmm0
+	vaddpd	(%rdx,%rax), %xmm3, %xmm1
+	vmovsd	%xmm0, 16(%r8,%rax)
+	vmovupd	%xmm1, (%r8,%rax)
+	addq	$24, %rax
+	cmpq	%rcx, %rax
+	jne	.L132
+	ret
+.L134:
+	xorl	%eax, %eax
+	jmp	.L127
+.L161:
+	vzeroupper
+	jmp	.L130
+	.cfi_endproc
+.LFE1490:
+	.size	_Z19raw_loop_p_plus_d_3mPKSt5arrayIdLm3EES2_PS0_, .-_Z19raw_loop_p_plus_d_3mPKSt5arrayIdLm3EES2_PS0_
+	.section	.rodata.cst8,"aM",@progbits,8
+	.align 8
+.LC1:
+	.long	0
+	.long	-2147483648
+	.ident	"GCC: (Debian 12.2.0-14+deb12u1) 12.2.0"
+	.section	.note.GNU-stack,"",@progbits
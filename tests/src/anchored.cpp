@@ -0,0 +1,192 @@
+
+# include <vector_space.h>
+# include <anchored.h>
+# include <half.h>
+# include <kernels.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <cstddef>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using anchored3 = affine::anchored_point<point3>;
+   using array3 = affine::anchored_array<point3>;
+
+   static_assert( std::same_as<anchored3::local_point_type::value_type,float> );
+   static_assert( std::same_as<decltype(anchored3{}-anchored3{}),delta3> );
+   static_assert( std::same_as<decltype(anchored3{}-point3{}),delta3> && std::same_as<decltype(point3{}-anchored3{}),delta3> );
+   static_assert( std::same_as<decltype(anchored3{}+delta3{}),anchored3> );
+   static_assert( affine::anchorable<point3> && !affine::anchorable<point<0>> );
+
+   // the local frame uses the float kernels
+   static_assert( affine::detail::flat_arithmetic<array3::local_point_type,array3::local_delta_type> );
+
+   TEST_CASE( "anchored points", "[anchored][point]" )
+  {
+      // float cannot resolve a quarter unit at 1e8, the local coordinates can
+      constexpr double far = 1e8;
+      REQUIRE( static_cast<float>(far+0.25)==static_cast<float>(far) );
+
+      const anchored3 p{ point3{{far,far,0}},   {{{0.25f,-0.5f,1.f}}} };
+      const anchored3 q{ point3{{far+2,far,0}}, {{{-0.5f,0.25f,1.f}}} };
+
+      SECTION( "difference across anchors is exact" )
+     {
+         const delta3 d = p-q;
+         REQUIRE( d[0]==-2+0.75 );
+         REQUIRE( d[1]==-0.75 );
+         REQUIRE( d[2]==0 );
+
+         REQUIRE( (p-q).element==(-(q-p)).element );
+         REQUIRE( (p-q.value()).element==d.element );
+         REQUIRE( (p.value()-q).element==d.element );
+     }
+
+      SECTION( "value is rounded once" )
+     {
+         const point3 x = p.value();
+         REQUIRE( x[0]==far+0.25 );
+         REQUIRE( x[1]==far-0.5 );
+         REQUIRE( x[2]==1 );
+     }
+
+      SECTION( "arithmetic moves the local coordinates" )
+     {
+         const anchored3 r = p+delta3{{1,2,-1}};
+         REQUIRE( r.anchor.element==p.anchor.element );
+         REQUIRE( r.local[0]==1.25f );
+         REQUIRE( (r-p).element==delta3{{1,2,-1}}.element );
+
+         anchored3 s = r;
+         s-=delta3{{1,2,-1}};
+         REQUIRE( s.value().element==p.value().element );
+     }
+
+      SECTION( "reanchor keeps the position" )
+     {
+         anchored3 r = p;
+         r.reanchor( point3{{far-64,far+64,32}} );
+         REQUIRE( r.local[0]==64.25f );
+         REQUIRE( r.local[1]==-64.5f );
+         REQUIRE( r.local[2]==-31.f );
+         REQUIRE( r.value().element==p.value().element );
+         REQUIRE( (r-p).element==delta3{}.element );
+     }
+  }
+
+   TEST_CASE( "anchored array", "[anchored][point_array]" )
+  {
+      constexpr double far = 1e7;
+      constexpr std::size_t n = 1000;
+      const std::size_t tile = GENERATE( 1, 16, 100, affine::anchor_tile );
+
+      std::vector<point3> ps(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const auto x = static_cast<double>(k);
+         ps[k] = point3{{far+x/1024, -far+x/64, x/8}};
+     }
+
+      const array3 a( std::span<const point3>(ps), tile );
+
+      REQUIRE( a.size()==n );
+      REQUIRE( a.tiles()==(n+tile-1)/tile );
+      REQUIRE( a.tile_end(a.tiles()-1)==n );
+
+      // each tile spans at most 1000/8 units, so the float local coordinates resolve better than 1e-5
+      for( std::size_t t=0; t<a.tiles(); ++t )
+     {
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( a.anchor(t)[c]==std::round(a.anchor(t)[c]) ); }
+     }
+      for( std::size_t k=0; k<n; ++k )
+     {
+         INFO( "k " << k );
+         const delta3 e = a.value(k)-ps[k];
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( std::abs(e[c])<1e-5 ); }
+     }
+
+      SECTION( "difference" )
+     {
+         // a second array with different tiles, so the anchors change in the middle of a tile of a
+         array3 b(7);
+         for( std::size_t k=0; k<n; ++k ){ b.push_back( ps[n-1-k] ); }
+
+         affine::delta_array<delta3> ds;
+         affine::difference( a, b, ds );
+         REQUIRE( ds.size()==n );
+
+         for( std::size_t k=0; k<n; ++k )
+        {
+            INFO( "k " << k );
+            REQUIRE( ds[k].value().element==(a[k]-b[k]).element );
+
+            const delta3 e = ds[k]-(ps[k]-ps[n-1-k]);
+            for( std::size_t c=0; c<3; ++c ){ REQUIRE( std::abs(e[c])<2e-5 ); }
+        }
+     }
+
+      SECTION( "advance and reanchor" )
+     {
+         array3 b = a;
+
+         // move every point 1000 units, far from the anchor of its tile
+         affine::delta_array<array3::local_delta_type> vs(n);
+         for( std::size_t k=0; k<n; ++k ){ vs[k] = array3::local_delta_type{{{1,-2,0.5f}}}; }
+
+         const std::size_t steps = 100;
+         for( std::size_t s=0; s<steps; ++s ){ affine::advance( b, 10.f, vs ); }
+
+         const point3 before = b.value(0);
+         b.reanchor();
+         REQUIRE( b.tiles()==a.tiles() );
+
+         for( std::size_t k=0; k<n; ++k )
+        {
+            INFO( "k " << k );
+            const delta3 e = (b[k]-a[k])-delta3{{1000,-2000,500}};
+            for( std::size_t c=0; c<3; ++c ){ REQUIRE( std::abs(e[c])<1e-2 ); }
+        }
+
+         // the local coordinates are small again after re-anchoring, and the positions did not move
+         const delta3 moved = b.value(0)-before;
+         for( std::size_t c=0; c<3; ++c )
+        {
+            REQUIRE( std::abs(moved[c])<1e-4 );
+            REQUIRE( std::abs(b.locals()[0][c])<=64 );
+        }
+     }
+
+      SECTION( "assign and push_back" )
+     {
+         array3 b(16,0.5);
+         REQUIRE( b.empty() );
+         b.push_back( point3{{far+0.3,0.7,-0.2}} );
+         REQUIRE( b.anchor(0).element==point3{{far+0.5,0.5,0}}.element );
+         REQUIRE( std::abs(b.value(0)[0]-(far+0.3))<1e-7 );
+
+         b.assign( 0, point3{{far,0,0}} );
+         REQUIRE( b.value(0).element==point3{{far,0,0}}.element );
+     }
+  }
+
+   TEST_CASE( "anchored half precision", "[anchored][half]" )
+  {
+      using array16 = affine::anchored_array<point3,affine::float16>;
+
+      std::vector<point3> ps;
+      for( std::size_t k=0; k<64; ++k ){ ps.push_back( point3{{1e9+static_cast<double>(k)/16,1e9,-1e9}} ); }
+
+      const array16 a( std::span<const point3>(ps), 64 );
+      REQUIRE( sizeof(a.locals()[0].value())==6 );
+
+      for( std::size_t k=0; k<ps.size(); ++k )
+     {
+         REQUIRE( a.value(k).element==ps[k].element );
+         REQUIRE( (a[k]-a[0]).element==(ps[k]-ps[0]).element );
+     }
+  }
@@ -0,0 +1,176 @@
+
+# include <vector_space.h>
+# include <exact_space.h>
+# include <fixed.h>
+# include <point_array.h>
+# include <combination.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <array>
+# include <cstdint>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using value_type = point3::value_type;
+
+   constexpr static auto eps = 64*std::numeric_limits<value_type>::epsilon();
+
+   static point3 make_point( const std::size_t i )
+  {
+      const auto x = static_cast<value_type>(i%101);
+      return {{1000+x,-x/4,3*x-2}};
+  }
+
+   // centroid of the first n make_point(i), computed from the coordinates
+   static std::array<value_type,3> expected_centroid( const std::size_t n )
+  {
+      std::array<value_type,3> sum{};
+      for( std::size_t i=0; i<n; ++i )
+     {
+         for( std::size_t c=0; c<3; ++c ){ sum[c]+=make_point(i)[c]; }
+     }
+      for( auto& s : sum ){ s/=static_cast<value_type>(n); }
+      return sum;
+  }
+
+   template<typename lhs_t, typename rhs_t>
+   concept combinable = requires( lhs_t w, rhs_t p ){ affine::combine(w,p); };
+
+   static_assert( !combinable<std::vector<value_type>,std::vector<delta3>> );
+   static_assert( std::same_as<decltype(affine::centroid(std::declval<std::vector<point3>>())),point3> );
+
+   using int_point = exact_point<2,std::int32_t,std::int64_t>;
+   using fixed_point = exact_point<2,affine::fixed<std::int32_t,16>,affine::fixed<std::int64_t,16>>;
+
+   // exact points are only combined with weights that scale their deltas, so fractional weights cannot truncate to 0
+   static_assert( combinable<std::vector<int>,std::vector<int_point>> && !combinable<std::vector<double>,std::vector<int_point>> );
+   static_assert( combinable<std::vector<affine::fixed<std::int64_t,16>>,std::vector<fixed_point>> );
+   static_assert( !combinable<std::vector<double>,std::vector<fixed_point>> );
+
+   TEST_CASE( "affine combination", "[combination][point]" )
+  {
+      const std::array ps{ point3{{1,2,3}}, point3{{5,-2,0}}, point3{{-1,4,9}} };
+      const std::array<value_type,3> w{0.25,0.25,0.5};
+
+      SECTION( "barycentric combination", "[combination][point]" )
+     {
+         const point3 p = affine::combine( w, ps );
+
+         for( std::size_t c=0; c<3; ++c )
+        {
+            REQUIRE( p[c] == Approx( w[0]*ps[0][c]+w[1]*ps[1][c]+w[2]*ps[2][c] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "vertex weights", "[combination][point]" )
+     {
+         const point3 p = affine::combine( std::array<value_type,3>{0,1,0}, ps );
+
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == ps[1][c] ); }
+     }
+
+      SECTION( "centroid of a single point", "[combination][point]" )
+     {
+         const point3 p = affine::centroid( std::span(ps).first(1) );
+
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == ps[0][c] ); }
+     }
+
+      SECTION( "scalar space centroid", "[combination][scalar]" )
+     {
+         const std::array ss{ point<0>{{2}}, point<0>{{6}} };
+
+         REQUIRE( affine::centroid( ss ).element == Approx( 4 ).epsilon( eps ) );
+     }
+  }
+
+   TEST_CASE( "exact combination", "[combination][exact]" )
+  {
+      SECTION( "integer weights", "[combination][exact]" )
+     {
+         const std::array ps{ int_point{{std::numeric_limits<std::int32_t>::max(),5}}, int_point{{std::numeric_limits<std::int32_t>::min(),-7}} };
+         const int_point p = affine::combine( std::array{2,-1}, ps );
+         REQUIRE( ( p[0]==std::int32_t(std::int64_t(2)*ps[0][0]-ps[1][0]) && p[1]==17 ) );
+     }
+
+      SECTION( "the integer centroid is rounded towards the first point", "[combination][exact]" )
+     {
+         const std::array ps{ int_point{{0,0}}, int_point{{1,-1}}, int_point{{1,-1}} };
+         const int_point c = affine::centroid( ps );
+         REQUIRE( ( c[0]==0 && c[1]==0 ) );
+
+         const std::array qs{ int_point{{1,-1}}, int_point{{0,0}}, int_point{{0,0}} };
+         const int_point d = affine::centroid( qs );
+         REQUIRE( ( d[0]==1 && d[1]==-1 ) );
+     }
+
+      SECTION( "fixed point centroid of more points than the coordinates can count", "[combination][exact]" )
+     {
+         using coordinate = fixed_point::value_type;
+         std::vector<fixed_point> ps( 40000, fixed_point{{coordinate(3),coordinate(-2)}} );
+         for( std::size_t i=1; i<ps.size(); i+=2 ){ ps[i][0]=coordinate(4); }
+
+         const fixed_point c = affine::centroid( affine::execution::par, ps );
+         REQUIRE( ( c[0]==coordinate(3.5) && c[1]==coordinate(-2) ) );
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "parallel centroid", "[combination][point]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::unsequenced_policy,
+                       affine::execution::parallel_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      // large enough to be split into several chunks, and not a multiple of the lanes or chunks
+      const std::size_t n = GENERATE( as<std::size_t>{}, 1, 7, 3*affine::detail::parallel_grain+13 );
+      const auto cloud = make_cloud<point3>( n, make_point );
+      const auto expected = expected_centroid(n);
+
+      SECTION( "centroid", "[combination][point]" )
+     {
+         const point3 p = affine::centroid( policy, cloud );
+
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == Approx( expected[c] ).epsilon( eps ).margin( eps ) ); }
+     }
+
+      SECTION( "uniform weights", "[combination][point]" )
+     {
+         const std::vector<value_type> w( n, value_type(1)/static_cast<value_type>(n) );
+         const point3 p = affine::combine( policy, w, cloud );
+
+         // the rounding error of the weights grows with n
+         const value_type tol = static_cast<value_type>(n)*eps;
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == Approx( expected[c] ).epsilon( tol ).margin( tol ) ); }
+     }
+
+      SECTION( "point_array centroid", "[combination][point_array]" )
+     {
+         const affine::point_array<point3> pa(cloud);
+         const point3 p = affine::centroid( policy, pa );
+
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == Approx( expected[c] ).epsilon( eps ).margin( eps ) ); }
+     }
+  }
+
+   TEST_CASE( "tree reduction", "[parallel]" )
+  {
+      for( std::size_t n=1; n<20; ++n )
+     {
+         std::vector<int> v(n);
+         for( std::size_t i=0; i<n; ++i ){ v[i]=static_cast<int>(i+1); }
+
+         REQUIRE( affine::detail::tree_reduce( std::span(v), std::plus{} ) == static_cast<int>(n*(n+1)/2) );
+     }
+
+      std::vector<int> hits(100000,0);
+      affine::detail::parallel_for( affine::execution::par, hits.size(),
+                                    [&]( std::size_t b, std::size_t e ){ for( ; b<e; ++b ){ ++hits[b]; } },
+                                    1000 );
+      REQUIRE( std::count( hits.begin(), hits.end(), 1 ) == 100000 );
+  }
@@ -0,0 +1,254 @@
+
+# include <vector_space.h>
+# include <mixed_space.h>
+# include <compensated.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <cstddef>
+# include <span>
+# include <utility>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using compensated3 = affine::compensated_point<point3>;
+
+   static_assert( affine::compensable<point3> && !affine::compensable<point<0>> );
+   static_assert( std::same_as<decltype(compensated3{}-compensated3{}),delta3> );
+   static_assert( std::same_as<decltype(compensated3{}+delta3{}),compensated3> );
+
+   TEST_CASE( "compensated point", "[compensated][point]" )
+  {
+      // each step is less than half an ulp of the point, so p+=d never moves it
+      const point3 p0{{1e8,-1e8,1}};
+      const delta3 d{{1e-9,2e-9,-1e-17}};
+      constexpr std::size_t n = 100000;
+
+      point3 p = p0;
+      compensated3 x{p0};
+      for( std::size_t k=0; k<n; ++k ){ p+=d; x+=d; }
+
+      REQUIRE( p.element==p0.element );
+      REQUIRE( x.value()[0]==1e8+1e-4 );
+      REQUIRE( x.value()[1]==-1e8+2e-4 );
+      REQUIRE( x.value()[2]==1-1e-12 );
+
+      SECTION( "differences use the errors" )
+     {
+         const delta3 e = x-compensated3{p0};
+         REQUIRE( e[0]==Approx(1e-4).epsilon(1e-9) );
+         REQUIRE( e[1]==Approx(2e-4).epsilon(1e-9) );
+         REQUIRE( e[2]==Approx(-1e-12).epsilon(1e-9) );
+         REQUIRE( (x-p0).element==e.element );
+         REQUIRE( (p0-x).element==(-e).element );
+     }
+
+      SECTION( "subtraction undoes addition" )
+     {
+         for( std::size_t k=0; k<n; ++k ){ x-=d; }
+         REQUIRE( x.value().element==p0.element );
+     }
+
+      SECTION( "renormalize keeps the value" )
+     {
+         const point3 before = x.value();
+         x.renormalize();
+         REQUIRE( x.value().element==before.element );
+         REQUIRE( x.sum.element==before.element );
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "compensated kernels", "[compensated][kernels]",
+                       ( std::pair<double,double> ), ( std::pair<float,float> ), ( std::pair<double,float> ) )
+  {
+      using num_t  = typename TestType::first_type;
+      using dnum_t = typename TestType::second_type;
+
+      const std::size_t n = 67;
+      std::vector<num_t> y0(n), c0(n);
+      std::vector<dnum_t> x(n);
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const auto t = static_cast<num_t>(i);
+         y0[i] = num_t(1000)*std::sin(t)+num_t(1e4);
+         x[i]  = static_cast<dnum_t>( std::cos(t)/num_t(3) );
+     }
+
+      const num_t a = num_t(0.1);
+
+      std::vector<num_t> expected_y = y0, expected_c = c0;
+      affine::detail::scalar::compensated_axpy( n, a, x.data(), expected_y.data(), expected_c.data() );
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      // axpy is identical on every instruction set, and sum+error is a*x+y to within rounding of the result
+      std::vector<num_t> y = y0, c = c0;
+      affine::detail::flat_compensated_axpy( n, a, x.data(), y.data(), c.data() );
+      REQUIRE( y==expected_y );
+      REQUIRE( c==expected_c );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const long double exact = static_cast<long double>(y0[i])+static_cast<long double>(a)*static_cast<long double>(x[i]);
+         REQUIRE( std::abs( static_cast<long double>(y[i])+static_cast<long double>(c[i])-exact )<=std::abs(exact)*static_cast<long double>(std::numeric_limits<num_t>::epsilon()) );
+     }
+
+      // the sum of many values around an origin far from zero
+      std::vector<num_t> z(1001);
+      long double exact = 0;
+      for( std::size_t i=0; i<z.size(); ++i )
+     {
+         z[i] = num_t(1e6)+static_cast<num_t>( std::sin(static_cast<double>(i)) )/num_t(7);
+         exact += static_cast<long double>(z[i])-1e6l;
+     }
+      num_t s = 0, e = 0;
+      affine::detail::flat_compensated_sum( z.size(), num_t(1e6), z.data(), &s, &e );
+      REQUIRE( std::abs( static_cast<long double>(s)+static_cast<long double>(e)-exact )<=4*static_cast<long double>(std::numeric_limits<num_t>::epsilon()) );
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEST_CASE( "compensated array", "[compensated][point_array]" )
+  {
+      const std::size_t n = GENERATE( 0, 1, 37 );
+
+      std::vector<point3> ps(n);
+      affine::delta_array<delta3> vs(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const auto t = static_cast<double>(k);
+         ps[k] = point3{{1e9+t, -1e9, t/3}};
+         vs[k] = delta3{{1e-8*std::sin(t), 3e-8, -1e-8}};
+     }
+
+      affine::compensated_array<point3> x( (std::span<const point3>(ps)) );
+      std::vector<compensated3> y( n );
+      for( std::size_t k=0; k<n; ++k ){ y[k] = compensated3{ps[k]}; }
+      REQUIRE( x.size()==n );
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      // 10^4 steps of less than an ulp of the coordinates
+      const std::size_t steps = 10000;
+      std::vector<delta3> ds(n);
+      for( std::size_t k=0; k<n; ++k ){ ds[k] = vs[k].value(); }
+      for( std::size_t s=0; s<steps; ++s )
+     {
+         affine::advance( x, 0.5, vs );
+         affine::advance( std::span(y), 0.5, std::span<const delta3>(ds) );
+     }
+
+      affine::point_array<point3> values;
+      x.values( values );
+      for( std::size_t k=0; k<n; ++k )
+     {
+         INFO( "k " << k );
+         for( std::size_t c=0; c<3; ++c )
+        {
+            const long double exact = static_cast<long double>(ps[k][c])+0.5l*static_cast<long double>(steps)*static_cast<long double>(ds[k][c]);
+            REQUIRE( std::abs( static_cast<long double>(values[k][c])-exact )<=std::abs(exact)*0x1p-52l );
+        }
+
+         // the span and SoA versions are identical
+         REQUIRE( x[k].sum.element==y[k].sum.element );
+         REQUIRE( x[k].error==y[k].error );
+         REQUIRE( x.value(k).element==values[k].value().element );
+     }
+
+      SECTION( "renormalize" )
+     {
+         x.renormalize();
+         for( std::size_t k=0; k<n; ++k ){ REQUIRE( x.value(k).element==values[k].value().element ); }
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEMPLATE_TEST_CASE( "compensated reductions", "[compensated][combination]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = GENERATE( as<std::size_t>{}, 1, 7, 3*affine::detail::parallel_grain+13 );
+
+      // points far from the origin, spread much less than their magnitude
+      std::vector<point3> ps(n);
+      std::vector<delta3> ds(n);
+      // references summed in long double, with compensation
+      long double exact_sum[3] = {0,0,0}, sum_error[3] = {0,0,0};
+      long double exact_centroid[3] = {0,0,0}, centroid_error[3] = {0,0,0};
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const auto t = static_cast<double>(k);
+         ps[k] = point3{{1e12+std::sin(t), 1e-3*std::cos(t), -5e8+t/3}};
+         ds[k] = delta3{{0.1, std::sin(t)*1e-6, 1e8*std::cos(t)}};
+         for( std::size_t c=0; c<3; ++c )
+        {
+            affine::detail::neumaier_add( exact_sum[c], sum_error[c], static_cast<long double>(ds[k][c]) );
+            affine::detail::neumaier_add( exact_centroid[c], centroid_error[c], static_cast<long double>(ps[k][c])-static_cast<long double>(ps[0][c]) );
+        }
+     }
+      for( std::size_t c=0; c<3; ++c )
+     {
+         exact_sum[c] += sum_error[c];
+         exact_centroid[c] = static_cast<long double>(ps[0][c])+(exact_centroid[c]+centroid_error[c])/static_cast<long double>(n);
+     }
+
+      // within an ulp or two of the result, and of the largest term for sums which cancel
+      const auto close = [&]( const double x, const long double exact, const long double scale )
+     {
+         return std::abs( static_cast<long double>(x)-exact )<=2*0x1p-52l*( std::abs(exact)+scale );
+     };
+
+      SECTION( "sum" )
+     {
+         const delta3 s = affine::compensated_sum( policy, ds );
+         REQUIRE( close( s[0], exact_sum[0], 0 ) );
+         REQUIRE( close( s[1], exact_sum[1], 1e-6l ) );
+         REQUIRE( close( s[2], exact_sum[2], 1e8l ) );
+
+         const affine::delta_array<delta3> da( (std::span<const delta3>(ds)) );
+         const delta3 t = affine::compensated_sum( policy, da );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( t[c]==Approx(s[c]).epsilon(1e-15).margin(1e-6) ); }
+     }
+
+      SECTION( "centroid" )
+     {
+         const point3 p = affine::compensated_centroid( policy, ps );
+         REQUIRE( close( p[0], exact_centroid[0], 0 ) );
+         REQUIRE( close( p[1], exact_centroid[1], 1e-3l ) );
+         REQUIRE( close( p[2], exact_centroid[2], 0 ) );
+
+         const affine::point_array<point3> pa( ps );
+         const point3 q = affine::compensated_centroid( policy, pa );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( close( q[c], exact_centroid[c], c==1 ? 1e-3l : 0 ) ); }
+     }
+  }
+
+   TEST_CASE( "compensated mixed precision", "[compensated][mixed]" )
+  {
+      using mpoint = mixed_point<2>;
+      using mdelta = mixed_delta<2>;
+
+      affine::compensated_array<mpoint> x( std::vector<mpoint>( 20, mpoint{{1e10,0}} ) );
+      const affine::delta_array<mdelta> v( std::vector<mdelta>( 20, mdelta{{1e-7f,1.f}} ) );
+
+      for( std::size_t s=0; s<1000; ++s ){ affine::advance( x, 1.0, v ); }
+
+      const long double exact = 1e10l+1000*static_cast<long double>(1e-7f);
+      for( std::size_t k=0; k<x.size(); ++k )
+     {
+         REQUIRE( std::abs( static_cast<long double>(x.value(k)[0])-exact )<=1e10l*0x1p-52l );
+         REQUIRE( x.value(k)[1]==1000 );
+     }
+  }
@@ -0,0 +1,210 @@
+
+# include <vector_space.h>
+# include <curve.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <supported_isas.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <algorithm>
+# include <array>
+# include <cstddef>
+# include <cstdint>
+# include <numeric>
+# include <random>
+# include <span>
+# include <vector>
+
+   using point2 = point<2>;
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   static_assert( affine::curve_point<point2> && affine::curve_point<point3> );
+   static_assert( !affine::curve_point<point<0>> && !affine::curve_point<point<4>> );
+
+   // the key, one bit at a time
+   template<std::size_t ndim>
+   static std::uint64_t naive_interleave( const std::array<std::uint32_t,ndim>& x )
+  {
+      std::uint64_t key = 0;
+      for( unsigned bit=0; bit<affine::detail::curve_bits<ndim>; ++bit )
+     {
+         for( std::size_t c=0; c<ndim; ++c ){ key |= std::uint64_t( (x[c]>>bit)&1 )<<(ndim*bit+ndim-1-c); }
+     }
+      return key;
+  }
+
+   TEMPLATE_TEST_CASE( "bit interleaving", "[curve][kernels]", point2, point3 )
+  {
+      constexpr std::size_t ndim = TestType::size();
+      constexpr std::size_t n = 1000;
+
+      std::mt19937 generator(3);
+      std::vector<std::array<std::uint32_t,ndim>> cells(n);
+      for( auto& x : cells ){ for( auto& c : x ){ c = static_cast<std::uint32_t>( generator()>>(32-affine::detail::curve_bits<ndim>) ); } }
+      cells[0].fill(0);
+      cells[1].fill( static_cast<std::uint32_t>( (std::uint64_t(1)<<affine::detail::curve_bits<ndim>)-1 ) );
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      std::vector<std::uint64_t> keys(n);
+      affine::detail::flat_interleave<ndim>( 0, n, [&]( const std::size_t i ){ return cells[i]; }, keys.data() );
+      for( std::size_t i=0; i<n; ++i ){ REQUIRE( keys[i]==naive_interleave<ndim>(cells[i]) ); }
+      REQUIRE( keys[1]==( ndim==2 ? ~std::uint64_t(0) : ~std::uint64_t(0)>>1 ) );
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEMPLATE_TEST_CASE( "hilbert curve is continuous", "[curve]", point2, point3 )
+  {
+      constexpr std::size_t ndim = TestType::size();
+      const unsigned bits = GENERATE( 1u, 2u, 3u, 5u );
+      const std::size_t side = std::size_t(1)<<bits;
+      const std::size_t cells = ndim==2 ? side*side : side*side*side;
+
+      // the cell of each index of the curve
+      std::vector<std::array<std::uint32_t,ndim>> at(cells);
+      std::vector<bool> seen(cells,false);
+      for( std::size_t i=0; i<cells; ++i )
+     {
+         std::array<std::uint32_t,ndim> x;
+         for( std::size_t c=0, j=i; c<ndim; ++c, j/=side ){ x[c] = static_cast<std::uint32_t>(j%side); }
+
+         const std::uint64_t key = affine::detail::hilbert_index<ndim>( naive_interleave<ndim>(x), bits );
+
+         REQUIRE( key<cells );
+         REQUIRE( !seen[key] );
+         seen[key] = true;
+         at[key] = x;
+     }
+
+      // consecutive cells of the curve are neighbours
+      for( std::size_t i=1; i<cells; ++i )
+     {
+         std::uint32_t steps = 0;
+         for( std::size_t c=0; c<ndim; ++c ){ steps += at[i][c]>at[i-1][c] ? at[i][c]-at[i-1][c] : at[i-1][c]-at[i][c]; }
+         REQUIRE( steps==1 );
+     }
+  }
+
+   TEST_CASE( "curve keys", "[curve][point]" )
+  {
+      const affine::bounding_box<point2> box{ point2{{-1,2}}, point2{{3,4}} };
+      const std::vector<point2> ps{ point2{{-1,2}}, point2{{3,4}}, point2{{-5,10}}, point2{{1,3}}, point2{{-1+4*0x1p-32,2}} };
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      std::vector<std::uint64_t> keys(ps.size());
+      affine::curve_keys( affine::curve::morton, ps, box, std::span(keys) );
+
+      // the corners of the box are the first and last cells, points outside are clamped
+      REQUIRE( keys[0]==0 );
+      REQUIRE( keys[1]==~std::uint64_t(0) );
+      REQUIRE( keys[2]==naive_interleave<2>( {0,0xffffffff} ) );
+      REQUIRE( keys[3]==naive_interleave<2>( {0x80000000,0x80000000} ) );
+      REQUIRE( keys[4]==naive_interleave<2>( {1,0} ) );
+
+      std::vector<std::uint64_t> hilbert(ps.size());
+      affine::curve_keys( affine::execution::par, affine::curve::hilbert, ps, box, std::span(hilbert) );
+      REQUIRE( hilbert[0]==0 );
+      for( std::size_t i=0; i<ps.size(); ++i ){ REQUIRE( hilbert[i]==affine::detail::hilbert_index<2>(keys[i]) ); }
+
+      SECTION( "bounds" )
+     {
+         const auto cloud = make_cloud<point3>( 3*affine::detail::parallel_grain+5, 7, 0, 10 );
+         const affine::point_array<point3> pa(cloud);
+         const auto b = affine::bounds( affine::execution::par, pa );
+         for( std::size_t c=0; c<3; ++c )
+        {
+            REQUIRE( b.lo[c]==std::ranges::min( cloud, {}, [c]( const point3& p ){ return p[c]; } )[c] );
+            REQUIRE( b.hi[c]==std::ranges::max( cloud, {}, [c]( const point3& p ){ return p[c]; } )[c] );
+        }
+
+         // the keys do not depend on the policy or the container
+         REQUIRE( affine::curve_keys( affine::execution::par_unseq, affine::curve::hilbert, pa )==affine::curve_keys( affine::curve::hilbert, cloud ) );
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEMPLATE_TEST_CASE( "key order", "[curve][parallel]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::unsequenced_policy,
+                       affine::execution::parallel_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = GENERATE( as<std::size_t>{}, 0, 1, 300, 3*affine::detail::parallel_grain+13 );
+      const std::uint64_t mask = GENERATE( as<std::uint64_t>{}, 0, 0xff, 0xf0000000000000ff, ~std::uint64_t(0) );
+
+      // few distinct keys, so the order of equal keys is checked
+      std::mt19937_64 generator(5);
+      std::vector<std::uint64_t> keys(n);
+      for( auto& k : keys ){ k = generator()&mask&0xf00000000000f00f; }
+
+      std::vector<std::size_t> expected(n);
+      std::iota( expected.begin(), expected.end(), std::size_t(0) );
+      std::ranges::stable_sort( expected, {}, [&]( const std::size_t i ){ return keys[i]; } );
+
+      INFO( "n " << n << ", mask " << mask );
+      REQUIRE( affine::key_order( policy, std::span<const std::uint64_t>(keys) )==expected );
+  }
+
+   TEMPLATE_TEST_CASE( "curve sort", "[curve][point_array]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = GENERATE( as<std::size_t>{}, 1, 2, 1000 );
+      const auto c = GENERATE( affine::curve::morton, affine::curve::hilbert );
+      const auto cloud = make_cloud<point3>( n, 7, 0, 10 );
+
+      std::vector<delta3> vs(n);
+      std::vector<int> ids(n);
+      for( std::size_t i=0; i<n; ++i ){ vs[i] = cloud[i]-point3{}; ids[i] = static_cast<int>(i); }
+
+      SECTION( "vectors" )
+     {
+         std::vector<point3> ps = cloud;
+         const auto order = affine::curve_sort( policy, c, ps, vs, ids );
+
+         REQUIRE( order.size()==n );
+         for( std::size_t i=0; i<n; ++i )
+        {
+            REQUIRE( ps[i].element==cloud[order[i]].element );
+            REQUIRE( (ps[i]-point3{}).element==vs[i].element );
+            REQUIRE( ids[i]==static_cast<int>(order[i]) );
+        }
+
+         const auto keys = affine::curve_keys( c, ps );
+         REQUIRE( std::ranges::is_sorted( keys ) );
+     }
+
+      SECTION( "columns" )
+     {
+         affine::point_array<point3> ps(cloud);
+         affine::delta_array<delta3> ds(vs);
+         const auto order = affine::curve_sort( policy, c, ps, ds );
+
+         std::vector<point3> qs = cloud;
+         REQUIRE( affine::curve_sort( c, qs )==order );
+
+         for( std::size_t i=0; i<n; ++i )
+        {
+            REQUIRE( ps[i].value().element==qs[i].element );
+            REQUIRE( ds[i].value().element==vs[order[i]].element );
+        }
+
+         // other arrays are reordered with the returned order
+         affine::permute( policy, std::span<const std::size_t>(order), ids );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( ids[i]==static_cast<int>(order[i]) ); }
+     }
+  }
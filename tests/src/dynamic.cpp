@@ -0,0 +1,213 @@
+
+# include <dynamic_space.h>
+# include <combination.h>
+
+# include <catch.hpp>
+
+# include <concepts>
+# include <utility>
+# include <vector>
+
+   using value_type = dynamic_point::value_type;
+
+   constexpr static auto eps = std::numeric_limits<value_type>::epsilon();
+
+   constexpr static std::size_t inline_capacity = affine::dynamic_inline_capacity<value_type>;
+
+   static dynamic_point make_point( const std::size_t n, const value_type offset )
+  {
+      dynamic_point p;
+      p.resize(n);
+      for( std::size_t i=0; i<n; ++i ){ p[i]=offset+static_cast<value_type>(i); }
+      return p;
+  }
+
+   static dynamic_delta make_delta( const std::size_t n, const value_type scale )
+  {
+      dynamic_delta d;
+      d.resize(n);
+      for( std::size_t i=0; i<n; ++i ){ d[i]=scale*static_cast<value_type>(i+1); }
+      return d;
+  }
+
+   static_assert( dynamic_point::dynamic && dynamic_delta::dynamic );
+   static_assert( std::same_as<dynamic_point::element_type,dynamic_delta::element_type> );
+
+   TEST_CASE( "dynamic storage", "[dynamic][point][delta]" )
+  {
+      SECTION( "inline storage", "[dynamic][point]" )
+     {
+         const dynamic_point p = make_point( inline_capacity, 0 );
+
+         REQUIRE( p.size() == inline_capacity );
+         REQUIRE( !p.element.on_heap() );
+     }
+
+      SECTION( "heap storage", "[dynamic][point]" )
+     {
+         const dynamic_point p = make_point( inline_capacity+1, 0 );
+
+         REQUIRE( p.size() == inline_capacity+1 );
+         REQUIRE( p.element.on_heap() );
+     }
+
+      SECTION( "brace initialisation", "[dynamic][delta]" )
+     {
+         const dynamic_delta d{{{1,2,3}}};
+
+         REQUIRE( d.size() == 3 );
+         REQUIRE( d[2] == 3 );
+     }
+
+      SECTION( "resize keeps coordinates", "[dynamic][delta]" )
+     {
+         dynamic_delta d = make_delta( 3, 1 );
+         d.resize( 4*inline_capacity );
+
+         REQUIRE( d[2] == 3 );
+         REQUIRE( d[3] == 0 );
+         REQUIRE( d[4*inline_capacity-1] == 0 );
+     }
+
+      SECTION( "copy reuses capacity", "[dynamic][delta]" )
+     {
+         const std::size_t n = 4*inline_capacity;
+         const dynamic_delta d0 = make_delta( n, 1 );
+         dynamic_delta d1 = make_delta( n, 2 );
+         const auto* buffer = d1.element.data();
+
+         d1 = d0;
+
+         REQUIRE( d1.element.data() == buffer );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( d1[i] == d0[i] ); }
+     }
+  }
+
+   TEST_CASE( "dynamic arithmetic", "[dynamic][point][delta]" )
+  {
+      // one inline and one heap allocated dimension
+      const std::size_t n = GENERATE( as<std::size_t>{}, 3, 4*inline_capacity+1 );
+
+      const dynamic_point p = make_point( n, 10 );
+      const dynamic_point q = make_point( n, -3 );
+      const dynamic_delta d = make_delta( n, 1 );
+      const dynamic_delta e = make_delta( n, -0.5 );
+      constexpr value_type a{3};
+
+      SECTION( "point in-place arithmetic", "[dynamic][point]" )
+     {
+         dynamic_point r = p;
+         r+=d;
+         r-=e;
+
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( r[i] == Approx( p[i]+d[i]-e[i] ).epsilon( eps ) ); }
+     }
+
+      SECTION( "delta in-place arithmetic", "[dynamic][delta]" )
+     {
+         dynamic_delta r = d;
+         r+=e;
+         r*=a;
+         r/=a;
+         r-=e;
+
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( r[i] == Approx( d[i] ).epsilon( 4*eps ) ); }
+     }
+
+      SECTION( "free operators", "[dynamic][point][delta]" )
+     {
+         const dynamic_delta pq = p-q;
+         const dynamic_point pd = p+d;
+         const dynamic_point md = p-d;
+         const dynamic_delta de = d+e;
+         const dynamic_delta ed = d-e;
+         const dynamic_delta ad = a*d;
+         const dynamic_delta da = d*a;
+         const dynamic_delta dd = d/a;
+         const dynamic_delta nd = -d;
+
+         for( std::size_t i=0; i<n; ++i )
+        {
+            REQUIRE( pq[i] == Approx( p[i]-q[i] ).epsilon( eps ) );
+            REQUIRE( pd[i] == Approx( p[i]+d[i] ).epsilon( eps ) );
+            REQUIRE( md[i] == Approx( p[i]-d[i] ).epsilon( eps ) );
+            REQUIRE( de[i] == Approx( d[i]+e[i] ).epsilon( eps ) );
+            REQUIRE( ed[i] == Approx( d[i]-e[i] ).epsilon( eps ) );
+            REQUIRE( ad[i] == Approx( a*d[i] ).epsilon( eps ) );
+            REQUIRE( da[i] == Approx( a*d[i] ).epsilon( eps ) );
+            REQUIRE( dd[i] == Approx( d[i]/a ).epsilon( eps ) );
+            REQUIRE( nd[i] == -d[i] );
+        }
+     }
+
+      SECTION( "rvalue operators", "[dynamic][point][delta]" )
+     {
+         for( std::size_t i=0; i<n; ++i )
+        {
+            REQUIRE( ( dynamic_point(p)-q )[i]             == ( p-q )[i] );
+            REQUIRE( ( p-dynamic_point(q) )[i]             == ( p-q )[i] );
+            REQUIRE( ( dynamic_point(p)-dynamic_point(q) )[i] == ( p-q )[i] );
+            REQUIRE( ( dynamic_point(p)+d )[i]             == ( p+d )[i] );
+            REQUIRE( ( p+dynamic_delta(d) )[i]             == ( p+d )[i] );
+            REQUIRE( ( dynamic_point(p)-d )[i]             == ( p-d )[i] );
+            REQUIRE( ( p-dynamic_delta(d) )[i]             == ( p-d )[i] );
+            REQUIRE( ( dynamic_delta(d)+e )[i]             == ( d+e )[i] );
+            REQUIRE( ( d+dynamic_delta(e) )[i]             == ( d+e )[i] );
+            REQUIRE( ( dynamic_delta(d)-e )[i]             == ( d-e )[i] );
+            REQUIRE( ( d-dynamic_delta(e) )[i]             == ( d-e )[i] );
+            REQUIRE( ( dynamic_delta(d)-dynamic_delta(e) )[i] == ( d-e )[i] );
+            REQUIRE( ( a*dynamic_delta(d) )[i]             == ( a*d )[i] );
+            REQUIRE( ( dynamic_delta(d)*a )[i]             == ( d*a )[i] );
+            REQUIRE( ( dynamic_delta(d)/a )[i]             == ( d/a )[i] );
+            REQUIRE( ( -dynamic_delta(d) )[i]              == ( -d )[i] );
+        }
+     }
+
+      SECTION( "centroid", "[dynamic][combination]" )
+     {
+         const std::vector<dynamic_point> ps{ p, q };
+         const dynamic_point c = affine::centroid( ps );
+
+         REQUIRE( c.size() == n );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( c[i] == Approx( (p[i]+q[i])/2 ).epsilon( eps ) ); }
+     }
+  }
+
+   TEST_CASE( "dynamic rvalue storage reuse", "[dynamic][point][delta]" )
+  {
+      const std::size_t n = 4*inline_capacity;
+
+      const dynamic_point p = make_point( n, 1 );
+      const dynamic_delta d1 = make_delta( n, 2 );
+      const dynamic_delta d2 = make_delta( n, 3 );
+
+      SECTION( "delta chain", "[dynamic][delta]" )
+     {
+         dynamic_delta d0 = make_delta( n, 1 );
+         const auto* buffer = d0.element.data();
+
+         const dynamic_delta r = 2*( std::move(d0)+d1-d2 )/4;
+
+         REQUIRE( r.element.data() == buffer );
+     }
+
+      SECTION( "point minus point", "[dynamic][point]" )
+     {
+         dynamic_point q = make_point( n, 5 );
+         const auto* buffer = q.element.data();
+
+         const dynamic_delta r = std::move(q)-p;
+
+         REQUIRE( r.element.data() == buffer );
+     }
+
+      SECTION( "point plus delta", "[dynamic][point]" )
+     {
+         dynamic_delta d = make_delta( n, 5 );
+         const auto* buffer = d.element.data();
+
+         const dynamic_point r = p+std::move(d)*2;
+
+         REQUIRE( r.element.data() == buffer );
+     }
+  }
@@ -0,0 +1,332 @@
+
+# include <exact_space.h>
+# include <expression.h>
+# include <fixed.h>
+# include <kernels.h>
+# include <metric.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <cstddef>
+# include <cstdint>
+# include <limits>
+# include <span>
+# include <vector>
+
+   using affine::fixed;
+
+   using index_point = exact_point<2,std::size_t,std::ptrdiff_t>;
+   using index_delta = exact_delta<2,std::size_t,std::ptrdiff_t>;
+
+   using int_point = exact_point<3,std::int32_t,std::int64_t>;
+   using int_delta = exact_delta<3,std::int32_t,std::int64_t>;
+
+   using short_point = exact_point<2,std::int16_t>;
+   using short_delta = exact_delta<2,std::int16_t>;
+
+   using q16  = fixed<std::int32_t,16>;
+   using q16w = fixed<std::int64_t,16>;
+
+   using fixed_point = exact_point<2,q16,q16w>;
+   using fixed_delta = exact_delta<2,q16,q16w>;
+
+   template<typename delta_t, typename T>
+   concept scalable = requires( delta_t d, T a ){ a*d; d*a; d/a; d*=a; d/=a; };
+
+   static_assert( affine::numeric<std::int16_t> && affine::numeric<std::size_t> && affine::numeric<q16> );
+   static_assert( !affine::numeric<bool> );
+   static_assert( affine::exact_numeric<int> && affine::exact_numeric<q16> && !affine::exact_numeric<double> );
+
+   // exact deltas are only scaled by exact numbers, so 0.5*d cannot silently truncate
+   static_assert( scalable<int_delta,int> && !scalable<int_delta,double> && !scalable<int_delta,float> );
+   static_assert( scalable<fixed_delta,int> && scalable<fixed_delta,q16w> && !scalable<fixed_delta,double> );
+   static_assert( scalable<exact_delta<2,double>,int> && scalable<exact_delta<2,double>,float> );
+
+   static_assert( std::same_as<int_point::value_type,std::int32_t> && std::same_as<int_delta::value_type,std::int64_t> );
+   static_assert( std::same_as<std::common_type_t<q16,q16w>,q16w> );
+
+   // integer coordinates do not overflow in the wider delta, and wider deltas are narrowed back to the point
+   static_assert( (int_point{{std::numeric_limits<std::int32_t>::max(),0,0}}-int_point{{std::numeric_limits<std::int32_t>::min(),0,0}})[0]==(std::int64_t(1)<<32)-1 );
+   static_assert( (int_point{{-5,0,0}}+int_delta{{std::int64_t(1)<<32,0,0}})[0]==-5 );
+
+   TEST_CASE( "index coordinates", "[exact][point][delta]" )
+  {
+      const index_point p{{3,10}};
+      const index_point q{{7,4}};
+
+      const index_delta d = p-q;
+      REQUIRE( ( d[0]==-4 && d[1]==6 ) );
+
+      const index_point r = q+d;
+      REQUIRE( ( r[0]==3 && r[1]==10 ) );
+
+      const index_point s = p-d;
+      REQUIRE( ( s[0]==7 && s[1]==4 ) );
+
+      index_point t = p;
+      t-=2*d;
+      REQUIRE( ( t[0]==11 && t[1]==std::size_t(-2) ) );
+  }
+
+   TEST_CASE( "integer coordinates", "[exact][point][delta]" )
+  {
+      const int_point p{{std::numeric_limits<std::int32_t>::max(),-3,100}};
+      const int_point q{{std::numeric_limits<std::int32_t>::min(),4,-100}};
+
+      const int_delta d = p-q;
+      REQUIRE( d[0]==std::int64_t(std::numeric_limits<std::uint32_t>::max()) );
+      REQUIRE( ( d[1]==-7 && d[2]==200 ) );
+
+      SECTION( "division truncates towards zero", "[exact][delta]" )
+     {
+         const int_delta e{{7,-7,6}};
+         const int_delta h = e/2;
+         REQUIRE( ( h[0]==3 && h[1]==-3 && h[2]==3 ) );
+
+         int_delta f = e;
+         f/=-3;
+         REQUIRE( ( f[0]==-2 && f[1]==2 && f[2]==-2 ) );
+     }
+
+      SECTION( "midpoint", "[exact][point]" )
+     {
+         const int_point m = q+d/2;
+         REQUIRE( ( m[0]==-1 && m[1]==1 && m[2]==0 ) );
+     }
+
+      SECTION( "lazy expressions match the eager operators", "[exact][expression]" )
+     {
+         using affine::lazy;
+
+         const int_delta e = lazy(p)-lazy(q);
+         REQUIRE( e[0]==d[0] );
+
+         const int_delta f = lazy(q)-lazy(p)+lazy(d);
+         REQUIRE( ( f[0]==0 && f[1]==0 && f[2]==0 ) );
+
+         const int_point r = lazy(q)+(lazy(p)-q);
+         const int_point s = lazy(p)-(lazy(p)-q);
+         const int_point t = lazy(p)-2*lazy(d)+d;
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( r[i]==p[i] );
+            REQUIRE( s[i]==q[i] );
+            REQUIRE( t[i]==q[i] );
+        }
+     }
+
+      SECTION( "distances in the delta coordinates", "[exact][metric]" )
+     {
+         const int_point a{{100000,0,0}};
+         const int_point b{{0,0,0}};
+         static_assert( std::same_as<decltype(affine::distance2(a,b)),std::int64_t> );
+         REQUIRE( affine::distance2(a,b)==std::int64_t(10000000000) );
+         REQUIRE( affine::distance2(a,b)==affine::norm2(a-b) );
+     }
+
+      SECTION( "narrow coordinates", "[exact][point]" )
+     {
+         short_point a{{300,-300}};
+         const short_delta e{{20,-20}};
+         a+=e*3;
+         REQUIRE( ( a[0]==360 && a[1]==-360 ) );
+         REQUIRE( ( (a-short_point{})[0]==360 && (-e)[1]==20 ) );
+     }
+
+      SECTION( "SoA containers", "[exact][point_array]" )
+     {
+         affine::delta_array<int_delta> ds;
+         ds.push_back( int_delta{{7,-7,9}} );
+         ds.push_back( int_delta{{-1,1,100}} );
+
+         ds/=2;
+         REQUIRE( ( ds[0][0]==3 && ds[0][1]==-3 && ds[0][2]==4 ) );
+         REQUIRE( ( ds[1][0]==0 && ds[1][1]==0 && ds[1][2]==50 ) );
+
+         ds[1]/=-25;
+         REQUIRE( ds[1][2]==-2 );
+     }
+
+      SECTION( "narrow SoA containers", "[exact][point_array]" )
+     {
+         affine::point_array<short_point> ps;
+         ps.push_back( short_point{{300,-300}} );
+         affine::delta_array<short_delta> ds;
+         ds.push_back( short_delta{{2,-2}} );
+
+         ds*=3;
+         affine::axpy( std::int16_t(2), ds, ds );
+         ps+=ds;
+         REQUIRE( ( ps[0][0]==318 && ps[0][1]==-318 ) );
+
+         std::vector<std::int16_t> r(1);
+         affine::norm2( ds, std::span(r) );
+         REQUIRE( r[0]==2*18*18 );
+     }
+  }
+
+   TEST_CASE( "fixed point numbers", "[exact][fixed]" )
+  {
+      constexpr q16 half = q16(1)/q16(2);
+      static_assert( half.to_bits()==1<<15 );
+      static_assert( q16(0.25).to_bits()==1<<14 && q16(-0.25).to_bits()==-(1<<14) );
+      static_assert( double(q16(3)*half)==1.5 && int(q16(-7)/q16(2))==-3 );
+
+      // multiplication rounds to nearest
+      const q16 lsb = q16::from_bits(1);
+      REQUIRE( (lsb*half).to_bits()==1 );
+      REQUIRE( (lsb*q16(0.25)).to_bits()==0 );
+      REQUIRE( (q16(1.5)*q16(-2.5)).to_bits()==q16(-3.75).to_bits() );
+
+      // division truncates towards zero
+      REQUIRE( (q16(1)/q16(3)).to_bits()==21845 );
+      REQUIRE( (q16(-1)/q16(3)).to_bits()==-21845 );
+
+      // addition wraps
+      const q16 top = q16::from_bits( std::numeric_limits<std::int32_t>::max() );
+      REQUIRE( (top+lsb).to_bits()==std::numeric_limits<std::int32_t>::min() );
+
+      // widening is implicit and exact
+      const q16w w = top;
+      REQUIRE( (w+lsb).to_bits()==std::int64_t(1)<<31 );
+      REQUIRE( q16(w-q16w(1)).to_bits()==top.to_bits()-(1<<16) );
+
+      REQUIRE( ( q16(2)<q16(2.5) && q16(-1)<q16(0) && q16(3)==q16(3.0) ) );
+
+      // square roots truncate towards zero
+      static_assert( sqrt(q16(2.25))==q16(1.5) && sqrt(q16(-1))==q16(0) );
+      REQUIRE( sqrt(q16(2)).to_bits()==92681 );
+      REQUIRE( sqrt(lsb).to_bits()==256 );
+      REQUIRE( sqrt(q16w(1000000000)).to_bits()==2072430287 );
+      static_assert( affine::detail::integer_sqrt( std::numeric_limits<std::int64_t>::max() )==3037000499 );
+  }
+
+   TEST_CASE( "fixed point coordinates", "[exact][fixed][point][delta]" )
+  {
+      const fixed_point p{{q16(30000),q16(-0.5)}};
+      const fixed_point q{{q16(-30000),q16(1.25)}};
+
+      const fixed_delta d = p-q;
+      REQUIRE( ( d[0]==q16w(60000) && d[1]==q16w(-1.75) ) );
+
+      const fixed_point m = q+d/2;
+      REQUIRE( ( m[0]==q16(0) && m[1]==q16(0.375) ) );
+
+      const fixed_point r = q+d;
+      REQUIRE( ( r[0]==p[0] && r[1]==p[1] ) );
+
+      fixed_point s = q;
+      s+=d*q16w(0.5);
+      REQUIRE( ( s[0]==m[0] && s[1]==m[1] ) );
+  }
+
+   using point3i = exact_point<3,std::int32_t>;
+   using delta3i = exact_delta<3,std::int32_t>;
+
+   static_assert( affine::detail::flat_arithmetic<point3i,delta3i> && !affine::detail::flat_arithmetic<int_point,int_delta> );
+
+   TEST_CASE( "integer span kernels", "[exact][kernels]" )
+  {
+      const std::size_t n = GENERATE( std::size_t(1), std::size_t(7), std::size_t(33), std::size_t(100) );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", n " << n );
+
+      std::vector<point3i> ps(n), qs(n);
+      std::vector<delta3i> ds(n);
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const auto k = static_cast<std::int32_t>(i);
+         ps[i] = point3i{{k,-2*k,k*k}};
+         qs[i] = point3i{{3-k,k,-k}};
+         ds[i] = delta3i{{1-k,k+5,-3*k}};
+     }
+
+      std::vector<delta3i> es(n);
+      affine::difference( std::span<const point3i>(ps), std::span<const point3i>(qs), std::span(es) );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const delta3i e = ps[i]-qs[i];
+         REQUIRE( ( es[i][0]==e[0] && es[i][1]==e[1] && es[i][2]==e[2] ) );
+     }
+
+      auto ys = es;
+      affine::axpy( -3, std::span<const delta3i>(ds), std::span(ys) );
+      affine::scale( 5, std::span(ys) );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const delta3i y = 5*(es[i]-3*ds[i]);
+         REQUIRE( ( ys[i][0]==y[0] && ys[i][1]==y[1] && ys[i][2]==y[2] ) );
+     }
+
+      auto rs = ps;
+      affine::advance( std::span(rs), 7, std::span<const delta3i>(ds) );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const point3i r = ps[i]+7*ds[i];
+         REQUIRE( ( rs[i][0]==r[0] && rs[i][1]==r[1] && rs[i][2]==r[2] ) );
+     }
+
+      // overflow wraps with every instruction set
+      constexpr std::int32_t top = std::numeric_limits<std::int32_t>::max();
+      std::vector<delta3i> big( n, delta3i{{top,top,-top}} );
+      affine::scale( 2, std::span(big) );
+      affine::axpy( 3, std::span<const delta3i>(ds), std::span(big) );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         REQUIRE( ( big[i][0]==3*ds[i][0]-2 && big[i][1]==3*ds[i][1]-2 && big[i][2]==3*ds[i][2]+2 ) );
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEST_CASE( "integer and fixed point norms of SoA containers", "[exact][kernels][point_array]" )
+  {
+      SECTION( "int32 coordinates" )
+     {
+         affine::point_array<point3i> ps;
+         ps.push_back( point3i{{3,4,0}} );
+         ps.push_back( point3i{{-1,2,2}} );
+         ps.push_back( point3i{{1,1,1}} );
+         const point3i q{{1,1,1}};
+
+         std::vector<std::int32_t> r(3);
+         affine::distance2( ps, q, std::span(r) );
+         REQUIRE( ( r[0]==14 && r[1]==6 && r[2]==0 ) );
+
+         affine::delta_array<delta3i> ds;
+         ds.push_back( delta3i{{30,40,0}} );
+         ds.push_back( delta3i{{0,-7,0}} );
+         ds.push_back( delta3i{{0,0,0}} );
+         affine::norm2( ds, std::span(r) );
+         REQUIRE( ( r[0]==2500 && r[1]==49 && r[2]==0 ) );
+
+         // the length and the quotients truncate towards zero
+         affine::normalize( ds );
+         REQUIRE( ( ds[0][0]==0 && ds[0][1]==0 && ds[1][1]==-1 && ds[2][0]==0 ) );
+     }
+
+      SECTION( "fixed point coordinates" )
+     {
+         affine::point_array<fixed_point> ps;
+         ps.push_back( fixed_point{{q16(3.5),q16(-4)}} );
+         ps.push_back( fixed_point{{q16(0.5),q16(0)}} );
+         const fixed_point q{{q16(0.5),q16(0)}};
+
+         std::vector<q16w> r(2);
+         affine::distance2( ps, q, std::span(r) );
+         REQUIRE( ( r[0]==q16w(25) && r[1]==q16w(0) ) );
+
+         affine::delta_array<fixed_delta> ds;
+         ds.push_back( fixed_delta{{q16w(-3),q16w(4)}} );
+         ds.push_back( fixed_delta{{q16w(0),q16w(0)}} );
+         affine::norm2( ds, std::span(r) );
+         REQUIRE( ( r[0]==q16w(25) && r[1]==q16w(0) ) );
+
+         affine::normalize( ds );
+         REQUIRE( ( ds[0][0]==q16w(-3)/q16w(5) && ds[0][1]==q16w(4)/q16w(5) && ds[1][0]==q16w(0) ) );
+     }
+  }
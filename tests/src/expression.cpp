@@ -0,0 +1,164 @@
+
+# include <vector_space.h>
+# include <expression.h>
+
+# include <catch.hpp>
+
+# include <concepts>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using point_array3 = affine::point_array<point3>;
+   using delta_array3 = affine::delta_array<delta3>;
+
+   using value_type = point3::value_type;
+
+   constexpr static auto eps = 4*std::numeric_limits<value_type>::epsilon();
+
+   using affine::lazy;
+
+   TEST_CASE( "expression type rules", "[expression][point][delta]" )
+  {
+      const point3 p{{1,2,3}};
+      const delta3 d{{4,5,6}};
+
+      STATIC_REQUIRE( std::same_as<decltype(lazy(p)-p)::result_type,delta3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(p)+d)::result_type,point3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(p)-d)::result_type,point3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(d)+d)::result_type,delta3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(d)-d)::result_type,delta3> );
+      STATIC_REQUIRE( std::same_as<decltype(2*lazy(d))::result_type,delta3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(d)/2)::result_type,delta3> );
+      STATIC_REQUIRE( std::same_as<decltype(lazy(p)+2*lazy(d))::result_type,point3> );
+  }
+
+   template<typename lhs_t, typename rhs_t>
+   concept addable = requires( lhs_t lhs, rhs_t rhs ){ lhs+rhs; };
+
+   template<typename lhs_t, typename rhs_t>
+   concept subtractable = requires( lhs_t lhs, rhs_t rhs ){ lhs-rhs; };
+
+   template<typename lhs_t, typename rhs_t>
+   concept multipliable = requires( lhs_t lhs, rhs_t rhs ){ lhs*rhs; };
+
+   using point_leaf = decltype(lazy(std::declval<const point3&>()));
+   using delta_leaf = decltype(lazy(std::declval<const delta3&>()));
+
+   static_assert( !addable<point_leaf,point3> );
+   static_assert( !addable<delta_leaf,point3> );
+   static_assert( !subtractable<delta_leaf,point3> );
+   static_assert( !multipliable<value_type,point_leaf> );
+   static_assert( !addable<point_leaf,decltype(lazy(std::declval<const point<2>&>()))> );
+
+   TEST_CASE( "single element expressions", "[expression][point][delta]" )
+  {
+      const point3 p0{{1,2,3}};
+      const point3 q {{4,-5,6}};
+      const point3 r {{7,8,-9}};
+      const delta3 d {{10,11,12}};
+
+      constexpr value_type a{2};
+      constexpr value_type b{-3};
+
+      SECTION( "fused point expression", "[expression][point][delta]" )
+     {
+         const point3 expected = p0+a*(q-r)+b*d;
+         const point3 p1 = lazy(p0)+a*(lazy(q)-r)+b*lazy(d);
+
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( p1[i] == Approx( expected[i] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "fused delta expression", "[expression][delta]" )
+     {
+         const delta3 expected = (q-r)/a-d*b;
+         const delta3 e = (lazy(q)-r)/a-lazy(d)*b;
+
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( e[i] == Approx( expected[i] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "negated expression", "[expression][delta]" )
+     {
+         const delta3 e = -(lazy(q)-p0);
+
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( e[i] == Approx( p0[i]-q[i] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "in-place assignment", "[expression][point][delta]" )
+     {
+         point3 p = p0;
+         affine::assign( p, lazy(p)+a*lazy(d) );
+
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( p[i] == Approx( p0[i]+a*d[i] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "scalar space expression", "[expression][scalar]" )
+     {
+         const point<0> s0{{2}};
+         const delta<0> t0{{3}};
+         const point<0> s1 = lazy(s0)+a*lazy(t0);
+
+         REQUIRE( s1.element == Approx( 2+a*3 ).epsilon( eps ) );
+     }
+  }
+
+   TEST_CASE( "bulk expressions", "[expression][point_array][point][delta]" )
+  {
+      constexpr std::size_t length = 29;
+      constexpr value_type a{3};
+
+      point_array3 xs(length),ys(length);
+      delta_array3 vs(length);
+
+      for( std::size_t i=0; i<length; ++i )
+     {
+         const auto x = static_cast<value_type>(i);
+         xs[i]=point3{{x,-x,2*x}};
+         ys[i]=point3{{x*x,1,x/3}};
+         vs[i]=delta3{{1-x,x,5}};
+     }
+
+      const delta3 d{{1,2,3}};
+
+      SECTION( "array expression with broadcast delta", "[expression][point_array]" )
+     {
+         const point_array3 zs = lazy(xs)+a*(lazy(ys)-xs)+lazy(vs)/a-d;
+
+         REQUIRE( zs.size() == length );
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const point3 expected = xs[i]+a*(ys[i]-xs[i])+vs[i]/a-d;
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( zs[i][c] == Approx( expected[c] ).epsilon( eps ) );
+           }
+        }
+     }
+
+      SECTION( "array in-place update", "[expression][point_array]" )
+     {
+         const point_array3 x0 = xs;
+         affine::assign( xs, lazy(xs)+a*lazy(vs) );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( xs[i][c] == Approx( x0[i][c]+a*vs[i][c] ).epsilon( eps ) );
+           }
+        }
+     }
+  }
+
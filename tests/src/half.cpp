@@ -0,0 +1,189 @@
+
+# include <simd_space.h>
+# include <half.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <bit>
+# include <cmath>
+# include <cstdint>
+# include <limits>
+# include <random>
+# include <span>
+# include <vector>
+
+   using affine::float16;
+   using affine::bfloat16;
+
+   static_assert( sizeof(float16)==2 && sizeof(bfloat16)==2 );
+   static_assert( affine::numeric<float16> && affine::numeric<bfloat16> && !affine::exact_numeric<float16> );
+   static_assert( sizeof(simd_point<3,float16>)==6 && sizeof(simd_delta<3,bfloat16>)==6 );
+   static_assert( affine::detail::flat_arithmetic<simd_point<3,float16>,simd_delta<3,float16>> );
+   static_assert( std::same_as<affine::detail::compute_t<bfloat16>,float> && std::same_as<affine::detail::compute_t<double>,double> );
+
+   // exact values round trip, and the limits are the usual ones
+   static_assert( float(float16(0.5))==0.5f && float(bfloat16(-3))==-3.f );
+   static_assert( float(std::numeric_limits<float16>::max())==65504.f );
+   static_assert( float(std::numeric_limits<float16>::epsilon())==0x1p-10f && float(std::numeric_limits<bfloat16>::epsilon())==0x1p-7f );
+   static_assert( float(std::numeric_limits<float16>::denorm_min())==0x1p-24f && float(std::numeric_limits<float16>::min())==0x1p-14f );
+
+   static bool same_bits( const float16 a, const float16 b ){ return a.to_bits()==b.to_bits(); }
+   static bool same_bits( const bfloat16 a, const bfloat16 b ){ return a.to_bits()==b.to_bits(); }
+
+   TEST_CASE( "float16 rounding", "[half][scalar]" )
+  {
+      // ties round to even
+      REQUIRE( float(float16(1+0x1p-11f))==1.f );
+      REQUIRE( float(float16(1+3*0x1p-11f))==1+0x1p-9f );
+      REQUIRE( float(float16(-(1+0x1p-11f)))==-1.f );
+
+      // doubles are rounded once, not through float
+      REQUIRE( float(float16(1+0x1p-11+0x1p-40))==1+0x1p-10f );
+      REQUIRE( float(float16(1+0x1p-11-0x1p-40))==1.f );
+
+      // overflow and subnormals
+      REQUIRE( float(float16(65519.f))==65504.f );
+      REQUIRE( std::isinf( float(float16(65520.f)) ) );
+      REQUIRE( float(float16(0x1p-24f))==0x1p-24f );
+      REQUIRE( float(float16(0x1p-25f))==0.f );
+      REQUIRE( float(float16(0x1.8p-25f))==0x1p-24f );
+      REQUIRE( std::signbit( float(float16(-0.f)) ) );
+      REQUIRE( std::isnan( float(float16(std::numeric_limits<float>::quiet_NaN())) ) );
+
+      // every finite value round trips
+      for( std::uint32_t b=0; b<0x10000; ++b )
+     {
+         const auto h = float16::from_bits( static_cast<std::uint16_t>(b) );
+         if( (b&0x7c00u)!=0x7c00u ){ REQUIRE( float16(float(h)).to_bits()==b ); }
+     }
+
+# if defined(__FLT16_MAX__)
+      SECTION( "matches the compiler", "[half][scalar]" )
+     {
+         std::mt19937 generator(3);
+         std::uniform_int_distribution<std::uint32_t> bits;
+         for( std::size_t k=0; k<100000; ++k )
+        {
+            const float x = std::bit_cast<float>( bits(generator) );
+            if( x!=x ){ continue; }
+            const auto expected = std::bit_cast<std::uint16_t>( static_cast<_Float16>(x) );
+            REQUIRE( float16(x).to_bits()==expected );
+        }
+     }
+# endif
+  }
+
+   TEST_CASE( "bfloat16 rounding", "[half][scalar]" )
+  {
+      REQUIRE( float(bfloat16(1+0x1p-8f))==1.f );
+      REQUIRE( float(bfloat16(1+3*0x1p-8f))==1+0x1p-6f );
+      REQUIRE( float(bfloat16(1+0x1p-8+0x1p-40))==1+0x1p-7f );
+      REQUIRE( std::isinf( float(bfloat16(std::numeric_limits<float>::max())) ) );
+      REQUIRE( std::isnan( float(bfloat16(std::numeric_limits<float>::quiet_NaN())) ) );
+
+      // signalling nans stay nans, rather than rounding to infinity
+      REQUIRE( std::isnan( float(bfloat16(std::bit_cast<float>(0x7f800001u))) ) );
+
+      for( std::uint32_t b=0; b<0x10000; ++b )
+     {
+         const auto h = bfloat16::from_bits( static_cast<std::uint16_t>(b) );
+         if( (b&0x7f80u)!=0x7f80u ){ REQUIRE( bfloat16(float(h)).to_bits()==b ); }
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "compressed coordinates", "[half][point][delta]", float16, bfloat16 )
+  {
+      using point3 = simd_point<3,TestType>;
+      using delta3 = simd_delta<3,TestType>;
+
+      // half an ulp
+      const double tolerance = std::ldexp( 1., -std::numeric_limits<TestType>::digits );
+
+      std::mt19937 generator(7);
+      std::uniform_real_distribution<double> uniform(-100,100);
+
+      for( std::size_t k=0; k<1000; ++k )
+     {
+         const point3 p{{uniform(generator),uniform(generator),uniform(generator)}};
+         const point3 q{{uniform(generator),uniform(generator),uniform(generator)}};
+         const delta3 d{{uniform(generator),uniform(generator),uniform(generator)}};
+
+         // each operator computes in float and rounds each coordinate once
+         const delta3 e = p-q;
+         const point3 r = p+d;
+         const delta3 f = d*TestType(0.75);
+         for( std::size_t i=0; i<3; ++i )
+        {
+            const double exact_e = double(p[i])-double(q[i]);
+            const double exact_r = double(p[i])+double(d[i]);
+            REQUIRE( std::abs(double(e[i])-exact_e)<=tolerance*std::abs(exact_e) );
+            REQUIRE( std::abs(double(r[i])-exact_r)<=tolerance*std::abs(exact_r) );
+            REQUIRE( double(f[i])==Approx( 0.75*double(d[i]) ).epsilon( 2*tolerance ) );
+        }
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "compressed span kernels", "[half][kernels]", float16, bfloat16 )
+  {
+      using point1 = simd_point<1,TestType>;
+      using delta1 = simd_delta<1,TestType>;
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      // every bit pattern, so the vector conversions are checked against format_t::encode/decode for all inputs
+      // including subnormals, infinities and nans
+      constexpr std::size_t n = 0x10000;
+      std::vector<point1> ps(n), qs(n);
+      std::vector<delta1> ds(n);
+      for( std::size_t b=0; b<n; ++b )
+     {
+         ps[b][0] = TestType::from_bits( static_cast<std::uint16_t>(b) );
+         qs[b][0] = TestType::from_bits( static_cast<std::uint16_t>((b*40503u)&0xffffu) );
+         ds[b][0] = TestType::from_bits( static_cast<std::uint16_t>((b*12345u+7u)&0xffffu) );
+     }
+
+      // the kernels compute in float with a kept in float, and round once per coordinate
+      // axpy is fused with avx2 and avx512, as for float coordinates
+      const float a = 1.37f;
+      const auto muladd = [fused=(isa>=affine::isa::avx2)]( const float x, const float y, const float z ){ return fused ? std::fma(x,y,z) : x*y+z; };
+      const auto expect = [&]( const TestType result, const float exact )
+     {
+         const TestType expected(exact);
+         return same_bits(result,expected) || ( std::isnan(float(result)) && std::isnan(exact) );
+     };
+
+      SECTION( "difference" )
+     {
+         std::vector<delta1> es(n);
+         affine::difference( std::span<const point1>(ps), std::span<const point1>(qs), std::span(es) );
+         for( std::size_t b=0; b<n; ++b ){ REQUIRE( expect( es[b][0], float(ps[b][0])-float(qs[b][0]) ) ); }
+     }
+
+      SECTION( "scale" )
+     {
+         auto es = ds;
+         affine::scale( a, std::span(es) );
+         for( std::size_t b=0; b<n; ++b ){ REQUIRE( expect( es[b][0], a*float(ds[b][0]) ) ); }
+     }
+
+      SECTION( "advance" )
+     {
+         auto rs = ps;
+         affine::advance( std::span(rs), a, std::span<const delta1>(ds) );
+         for( std::size_t b=0; b<n; ++b ){ REQUIRE( expect( rs[b][0], muladd( a, float(ds[b][0]), float(ps[b][0]) ) ) ); }
+     }
+
+      SECTION( "SoA containers", "[point_array]" )
+     {
+         affine::delta_array<delta1> xs(ds), ys(ds);
+         affine::axpy( -a, xs, ys );
+         for( std::size_t b=0; b<n; ++b ){ REQUIRE( expect( ys[b][0], muladd( -a, float(ds[b][0]), float(ds[b][0]) ) ) ); }
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
@@ -0,0 +1,230 @@
+
+# include <vector_space.h>
+# include <hash_grid.h>
+# include <point_array.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <algorithm>
+# include <cstddef>
+# include <limits>
+# include <mutex>
+# include <random>
+# include <utility>
+# include <vector>
+
+   using point2 = point<2>;
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using value_type = point3::value_type;
+
+   using grid3 = affine::hash_grid<point3>;
+   using neighbour = grid3::neighbour;
+
+   template<typename point_t>
+   static value_type squared_distance( const point_t& p, const point_t& q )
+  {
+      const auto d = p-q;
+      value_type sum = 0;
+      for( std::size_t c=0; c<point_t::size(); ++c ){ sum+=d[c]*d[c]; }
+      return sum;
+  }
+
+   template<typename point_t>
+   static std::vector<std::size_t> brute_force( const std::vector<point_t>& ps, const point_t& q, const value_type radius )
+  {
+      std::vector<std::size_t> result;
+      for( std::size_t i=0; i<ps.size(); ++i ){ if( squared_distance(ps[i],q)<=radius*radius ){ result.push_back(i); } }
+      return result;
+  }
+
+   template<typename neighbour_t>
+   static std::vector<std::size_t> indices( const std::vector<neighbour_t>& found )
+  {
+      std::vector<std::size_t> result;
+      for( const auto& f : found ){ result.push_back(f.index); }
+      std::sort( result.begin(), result.end() );
+      return result;
+  }
+
+   // every point is in exactly one slot, in the bucket of its cell
+   template<typename grid_t, typename point_t>
+   static void check_slots( const grid_t& grid, const std::vector<point_t>& ps )
+  {
+      REQUIRE( grid.size()==ps.size() );
+      REQUIRE( grid.bucket_end(grid.buckets()-1)==ps.size() );
+
+      std::vector<bool> seen(ps.size(),false);
+      for( std::size_t b=0; b<grid.buckets(); ++b )
+     {
+         for( std::size_t s=grid.bucket_begin(b); s<grid.bucket_end(b); ++s )
+        {
+            const std::size_t i = grid.index(s);
+            REQUIRE( !seen[i] );
+            seen[i] = true;
+            REQUIRE( grid.points()[s].value().element==ps[i].element );
+            REQUIRE( grid.bucket_of(ps[i])==b );
+        }
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "hash grid construction", "[hash_grid][point]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = GENERATE( as<std::size_t>{}, 0, 1, 10, 3*affine::detail::parallel_grain+7 );
+      const auto ps = make_cloud<point3>( n, 1 );
+
+      const grid3 grid( policy, ps, 0.1 );
+      REQUIRE( grid.empty()==(n==0) );
+      REQUIRE( grid.buckets()>=n );
+      REQUIRE( grid.cell_size()==0.1 );
+      check_slots( grid, ps );
+
+      // the slots do not depend on the policy
+      const grid3 seq( ps, 0.1 );
+      for( std::size_t s=0; s<n; ++s ){ REQUIRE( grid.index(s)==seq.index(s) ); }
+  }
+
+   TEMPLATE_TEST_CASE( "hash grid radius queries", "[hash_grid][point]", point2, point3 )
+  {
+      const std::size_t n = 2000;
+      const auto ps = make_cloud<TestType>( n, 2 );
+      const auto qs = make_cloud<TestType>( 50, 3 );
+
+      const value_type cell = GENERATE( 0.05, 0.2, 3.0 );
+      const affine::hash_grid<TestType> grid( affine::execution::par, ps, cell );
+
+      // radii larger than the cell visit a larger box of cells, or every point
+      const value_type radius = GENERATE_COPY( cell, cell/3, value_type(0), 2.5*cell, 100*cell );
+      INFO( "cell " << cell << ", radius " << radius );
+
+      for( const auto& q : qs )
+     {
+         const auto found = grid.within_radius( q, radius );
+         REQUIRE( indices(found)==brute_force(ps,q,radius) );
+
+         for( const auto& f : found )
+        {
+            const auto d = ps[f.index]-q;
+            REQUIRE( f.offset.element==d.element );
+            REQUIRE( f.distance2==Approx( squared_distance(ps[f.index],q) ) );
+        }
+     }
+
+      // the points themselves, and the batch queries
+      REQUIRE( indices( grid.within_radius( ps[7], 0 ) )==brute_force(ps,ps[7],0) );
+
+      const auto batch = grid.within_radius( affine::execution::par, qs, radius );
+      REQUIRE( batch.size()==qs.size() );
+      for( std::size_t j=0; j<qs.size(); ++j ){ REQUIRE( indices(batch[j])==brute_force(ps,qs[j],radius) ); }
+  }
+
+   TEMPLATE_TEST_CASE( "hash grid pairs", "[hash_grid][point]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::parallel_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = 1500;
+      const auto ps = make_cloud<point3>( n, 4 );
+      const value_type radius = 0.15;
+      const grid3 grid( ps, radius );
+
+      std::vector<std::pair<std::size_t,std::size_t>> expected;
+      for( std::size_t i=0; i<n; ++i )
+     {
+         for( std::size_t j=i+1; j<n; ++j ){ if( squared_distance(ps[i],ps[j])<=radius*radius ){ expected.emplace_back(i,j); } }
+     }
+
+      std::mutex lock;
+      std::vector<std::pair<std::size_t,std::size_t>> found;
+      grid.for_each_pair( policy, radius,
+                          [&]( const std::size_t i, const std::size_t j, const delta3& d )
+                         {
+                             const std::scoped_lock guard(lock);
+                             REQUIRE( d.element==(ps[j]-ps[i]).element );
+                             found.emplace_back( std::min(i,j), std::max(i,j) );
+                         } );
+
+      std::sort( found.begin(), found.end() );
+      REQUIRE( !expected.empty() );
+      REQUIRE( found==expected );
+  }
+
+   TEST_CASE( "hash grid pairs beyond the cell size", "[hash_grid][point]" )
+  {
+      const std::size_t n = 800;
+      const auto ps = make_cloud<point3>( n, 6 );
+      const grid3 grid( affine::execution::par, ps, 0.05 );
+
+      const value_type radius = GENERATE( 0.18, 10.0 );
+      INFO( "radius " << radius );
+
+      std::size_t expected = 0;
+      for( std::size_t i=0; i<n; ++i )
+     {
+         for( std::size_t j=i+1; j<n; ++j ){ if( squared_distance(ps[i],ps[j])<=radius*radius ){ ++expected; } }
+     }
+
+      std::vector<std::pair<std::size_t,std::size_t>> found;
+      grid.for_each_pair( radius, [&]( const std::size_t i, const std::size_t j, const delta3& ){ found.emplace_back( std::min(i,j), std::max(i,j) ); } );
+      std::sort( found.begin(), found.end() );
+      REQUIRE( std::adjacent_find( found.begin(), found.end() )==found.end() );
+      REQUIRE( found.size()==expected );
+
+      // nothing is within a negative or NaN radius
+      REQUIRE( grid.within_radius( ps[0], value_type(-1) ).empty() );
+      REQUIRE( grid.within_radius( ps[0], std::numeric_limits<value_type>::quiet_NaN() ).empty() );
+      REQUIRE( grid.within_radius( ps[0], std::numeric_limits<value_type>::infinity() ).size()==n );
+  }
+
+   TEST_CASE( "hash grid update", "[hash_grid][point]" )
+  {
+      const std::size_t n = 3000;
+      auto ps = make_cloud<point3>( n, 5 );
+      const value_type cell = 0.1;
+      grid3 grid( affine::execution::par, ps, cell );
+
+      SECTION( "within the cells" )
+     {
+         // halfway to the centre of its cell, the cells are relative to the first point
+         const point3 origin = ps[0];
+         for( auto& p : ps )
+        {
+            const auto x = grid.cell_of(p);
+            const point3 centre = origin+delta3{{ (static_cast<value_type>(x[0])+0.5)*cell,
+                                                  (static_cast<value_type>(x[1])+0.5)*cell,
+                                                  (static_cast<value_type>(x[2])+0.5)*cell }};
+            p += 0.5*(centre-p);
+        }
+         REQUIRE( !grid.update( affine::execution::par, ps ) );
+         check_slots( grid, ps );
+     }
+
+      SECTION( "across buckets" )
+     {
+         std::mt19937 rng(6);
+         std::uniform_real_distribution<value_type> step(-0.05,0.05);
+         for( std::size_t k=0; k<5; ++k )
+        {
+            for( auto& p : ps ){ p += delta3{{ step(rng), step(rng), step(rng) }}; }
+            REQUIRE( grid.update( affine::execution::par, ps ) );
+            check_slots( grid, ps );
+        }
+     }
+
+      grid.update( ps );
+      check_slots( grid, ps );
+
+      // the same queries as a new grid
+      const grid3 fresh( ps, cell );
+      for( std::size_t i=0; i<n; i+=97 )
+     {
+         REQUIRE( indices( grid.within_radius( ps[i], cell ) )==indices( fresh.within_radius( ps[i], cell ) ) );
+     }
+  }
@@ -0,0 +1,91 @@
+
+# include <homogeneous_space.h>
+# include <map.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <random>
+# include <span>
+# include <vector>
+
+   using hpoint = homogeneous_point<double>;
+   using hdelta = homogeneous_delta<double>;
+
+   // 3 coordinates and w fill one vector register, and are never split by a cache line
+   static_assert( sizeof(hpoint)==32 && alignof(hpoint)==32 );
+   static_assert( sizeof(hdelta)==32 && alignof(hdelta)==32 );
+   static_assert( sizeof(homogeneous_point<float>)==16 && alignof(homogeneous_point<float>)==16 );
+   static_assert( hpoint::size()==3 );
+
+   static_assert( affine::detail::homogeneous_layout<hpoint> && affine::detail::homogeneous_layout<homogeneous_delta<float>> );
+   static_assert( !affine::detail::flat_layout<hpoint> );
+
+   // the homogeneous coordinate is set by aggregate initialisation and kept by the operators
+   static_assert( hpoint{{1,2,3}}.element.w==1 && hdelta{{1,2,3}}.element.w==0 );
+   static_assert( (hpoint{{1,2,3}}-hpoint{{3,2,1}}).element.w==0 );
+   static_assert( (hpoint{{1,2,3}}+2*hdelta{{3,2,1}}).element.w==1 );
+   static_assert( (hpoint{{1,2,3}}+2*hdelta{{3,2,1}})[0]==7 );
+
+   TEST_CASE( "homogeneous storage", "[homogeneous][point][delta]" )
+  {
+      hpoint p{{1,2,3}};
+      hdelta d{{0.5,-1,2}};
+
+      p+=d;
+      d*=2;
+      REQUIRE( ( p[0]==1.5 && p[1]==1 && p[2]==5 && p.element.w==1 ) );
+      REQUIRE( ( d[0]==1 && d[1]==-2 && d[2]==4 && d.element.w==0 ) );
+
+      const hpoint q{};
+      REQUIRE( q.element.w==1 );
+
+      SECTION( "SoA containers", "[homogeneous][point_array]" )
+     {
+         affine::point_array<hpoint> ps(3);
+         ps[1]=p;
+         const hpoint r = ps[1];
+         REQUIRE( ( r[0]==1.5 && r[2]==5 && r.element.w==1 ) );
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "homogeneous transform kernel", "[homogeneous][map][kernels]",
+                       homogeneous_point<float>, homogeneous_delta<float>, homogeneous_point<double>, homogeneous_delta<double> )
+  {
+      using T = TestType;
+      using num_t = typename T::value_type;
+
+      const std::size_t n = GENERATE( 0, 1, 3, 37 );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", n " << n );
+
+      const affine::affine_map<3,3,num_t> f{ {{{ {1,2,0}, {0,1,-1}, {3,0,1} }}}, {10,20,30} };
+
+      std::mt19937 rng(7);
+      std::uniform_real_distribution<num_t> uniform(-1,1);
+      std::vector<T> xs(n);
+      for( auto& x : xs ){ x = T{{uniform(rng),uniform(rng),uniform(rng)}}; }
+
+      std::vector<T> ys(n);
+      affine::apply( f, std::span<const T>(xs), std::span(ys) );
+
+      const auto tol = 16*std::numeric_limits<num_t>::epsilon();
+      for( std::size_t i=0; i<n; ++i )
+     {
+         // points are translated, deltas are not
+         const T r = affine::apply<T>( f, xs[i] );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( ys[i][c] == Approx( r[c] ).epsilon( tol ).margin( tol ) ); }
+         REQUIRE( ys[i].element.w == xs[i].element.w );
+     }
+
+      affine::apply( f, std::span(xs) );
+      for( std::size_t i=0; i<n; ++i )
+     {
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( xs[i][c] == ys[i][c] ); }
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
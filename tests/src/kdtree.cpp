@@ -0,0 +1,197 @@
+
+# include <vector_space.h>
+# include <kdtree.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <algorithm>
+# include <vector>
+
+   using point2 = point<2>;
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using value_type = point3::value_type;
+
+   using tree3 = affine::kdtree<point3>;
+   using neighbour = tree3::neighbour;
+
+   static value_type squared_distance( const point3& p, const point3& q )
+  {
+      const delta3 d = p-q;
+      return d[0]*d[0]+d[1]*d[1]+d[2]*d[2];
+  }
+
+   static std::vector<std::size_t> indices( std::vector<neighbour> found )
+  {
+      std::vector<std::size_t> result;
+      for( const auto& f : found ){ result.push_back(f.index); }
+      std::sort( result.begin(), result.end() );
+      return result;
+  }
+
+   // every offset must be point-query, and every distance its squared length
+   static void check_offsets( const std::vector<point3>& ps, const point3& q, const std::vector<neighbour>& found )
+  {
+      for( const auto& f : found )
+     {
+         const delta3 d = ps[f.index]-q;
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( f.offset[c] == d[c] ); }
+         REQUIRE( f.distance2 == Approx( squared_distance(ps[f.index],q) ) );
+     }
+  }
+
+   template<typename tree_t>
+   concept queryable_with_delta = requires( tree_t t, typename tree_t::delta_type d ){ t.nearest(d,1); };
+
+   static_assert( !queryable_with_delta<tree3> );
+
+   TEST_CASE( "kdtree construction", "[kdtree][point]" )
+  {
+      // empty, a single leaf, and several levels
+      const std::size_t n = GENERATE( as<std::size_t>{}, 0, 1, 10, 1000 );
+      const std::vector<point3> ps = make_cloud<point3>( n, 1 );
+
+      const tree3 tree(ps);
+
+      REQUIRE( tree.size() == n );
+      REQUIRE( tree.empty() == (n==0) );
+
+      SECTION( "permutation", "[kdtree][point]" )
+     {
+         std::vector<std::size_t> order(n);
+         for( std::size_t i=0; i<n; ++i )
+        {
+            order[i]=tree.index(i);
+            const point3 p = tree.points()[i];
+            for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c] == ps[order[i]][c] ); }
+        }
+         std::sort( order.begin(), order.end() );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( order[i] == i ); }
+     }
+
+      SECTION( "parallel build is identical", "[kdtree][point][parallel]" )
+     {
+         const tree3 ptree( affine::execution::par, ps );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( ptree.index(i) == tree.index(i) ); }
+     }
+
+      SECTION( "queries on the input points", "[kdtree][point]" )
+     {
+         for( std::size_t i=0; i<n; ++i )
+        {
+            const auto found = tree.nearest( ps[i], 1 );
+            REQUIRE( found.size() == 1 );
+            REQUIRE( found[0].distance2 == 0 );
+        }
+     }
+  }
+
+   TEST_CASE( "kdtree queries", "[kdtree][point][delta]" )
+  {
+      const std::size_t n = 2000;
+      const std::vector<point3> ps = make_cloud<point3>( n, 2 );
+      const std::vector<point3> qs = make_cloud<point3>( 50, 3 );
+
+      const tree3 tree( affine::execution::par, ps );
+
+      SECTION( "nearest", "[kdtree][point]" )
+     {
+         const std::size_t k = GENERATE( as<std::size_t>{}, 1, 7, 40 );
+
+         for( const auto& q : qs )
+        {
+            const auto found = tree.nearest( q, k );
+            REQUIRE( found.size() == k );
+            check_offsets( ps, q, found );
+
+            std::vector<std::pair<value_type,std::size_t>> brute;
+            for( std::size_t i=0; i<n; ++i ){ brute.emplace_back( squared_distance(ps[i],q), i ); }
+            std::sort( brute.begin(), brute.end() );
+
+            for( std::size_t j=0; j<k; ++j ){ REQUIRE( found[j].index == brute[j].second ); }
+        }
+     }
+
+      SECTION( "more neighbours than points", "[kdtree][point]" )
+     {
+         const auto found = tree.nearest( qs[0], n+5 );
+         REQUIRE( found.size() == n );
+         REQUIRE( std::is_sorted( found.begin(), found.end(), []( const auto& a, const auto& b ){ return a.distance2<b.distance2; } ) );
+     }
+
+      SECTION( "within radius", "[kdtree][point]" )
+     {
+         const value_type r = 0.3;
+         for( const auto& q : qs )
+        {
+            const auto found = tree.within_radius( q, r );
+            check_offsets( ps, q, found );
+
+            std::vector<std::size_t> brute;
+            for( std::size_t i=0; i<n; ++i ){ if( squared_distance(ps[i],q)<=r*r ){ brute.push_back(i); } }
+
+            REQUIRE( indices(found) == brute );
+        }
+     }
+
+      SECTION( "within box", "[kdtree][point][delta]" )
+     {
+         const delta3 h{{0.1,0.4,0.2}};
+         for( const auto& q : qs )
+        {
+            const auto found = tree.within_box( q, h );
+            check_offsets( ps, q, found );
+
+            std::vector<std::size_t> brute;
+            for( std::size_t i=0; i<n; ++i )
+           {
+               const delta3 d = ps[i]-q;
+               if( std::abs(d[0])<=h[0] && std::abs(d[1])<=h[1] && std::abs(d[2])<=h[2] ){ brute.push_back(i); }
+           }
+
+            REQUIRE( indices(found) == brute );
+        }
+     }
+
+      SECTION( "batch queries", "[kdtree][point][parallel]" )
+     {
+         const auto nearest = tree.nearest( affine::execution::par, qs, 5 );
+         const auto radius  = tree.within_radius( affine::execution::par, qs, 0.2 );
+         const auto box     = tree.within_box( affine::execution::seq, qs, delta3{{0.2,0.2,0.2}} );
+
+         REQUIRE( nearest.size() == qs.size() );
+         for( std::size_t j=0; j<qs.size(); ++j )
+        {
+            REQUIRE( indices(nearest[j]) == indices(tree.nearest(qs[j],5)) );
+            REQUIRE( indices(radius[j]) == indices(tree.within_radius(qs[j],0.2)) );
+            REQUIRE( indices(box[j]) == indices(tree.within_box(qs[j],delta3{{0.2,0.2,0.2}})) );
+        }
+     }
+  }
+
+   TEST_CASE( "kdtree in two dimensions", "[kdtree][point]" )
+  {
+      // many duplicate coordinates, so that medians have ties
+      std::vector<point2> ps;
+      for( std::size_t i=0; i<40; ++i )
+     {
+         for( std::size_t j=0; j<40; ++j ){ ps.push_back( point2{{static_cast<value_type>(i/4),static_cast<value_type>(j%3)}} ); }
+     }
+
+      const affine::kdtree<point2> tree( affine::execution::par, affine::point_array<point2>(ps) );
+
+      const point2 q{{4.4,1.1}};
+      const auto found = tree.within_radius( q, 1 );
+
+      std::size_t brute=0;
+      for( const auto& p : ps )
+     {
+         const delta<2> d = p-q;
+         if( d[0]*d[0]+d[1]*d[1]<=1 ){ ++brute; }
+     }
+
+      REQUIRE( found.size() == brute );
+      REQUIRE( tree.nearest( q, 1 )[0].distance2 == Approx( 0.4*0.4+0.1*0.1 ) );
+  }
@@ -0,0 +1,280 @@
+
+# include <simd_space.h>
+# include <kernels.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <span>
+# include <vector>
+
+   template<typename num_t>
+   static num_t value( const std::size_t i, const std::size_t c )
+  {
+      return static_cast<num_t>( (7*i+3*c)%23 )/num_t(4) - num_t(2);
+  }
+
+   template<typename T>
+   static std::vector<T> make_elements( const std::size_t length, const std::size_t shift )
+  {
+      using num_t = typename T::value_type;
+      std::vector<T> xs(length);
+      for( std::size_t i=0; i<length; ++i )
+     {
+         for( std::size_t c=0; c<T::size(); ++c ){ xs[i][c]=value<num_t>(i+shift,c); }
+     }
+      return xs;
+  }
+
+   TEST_CASE( "kernel instruction set selection", "[kernels]" )
+  {
+      const auto best = affine::detect_isa();
+
+      REQUIRE( affine::kernel_isa() <= best );
+      REQUIRE( affine::set_kernel_isa( affine::isa::scalar ) == affine::isa::scalar );
+      REQUIRE( affine::set_kernel_isa( affine::isa::avx512 ) == best );
+      REQUIRE( std::string( affine::isa_name( affine::isa::avx2 ) ) == "avx2" );
+  }
+
+   TEMPLATE_TEST_CASE( "span kernels", "[kernels][point][delta]", float, double )
+  {
+      using num_t = TestType;
+      using point_t = simd_point<3,num_t>;
+      using delta_t = simd_delta<3,num_t>;
+
+      constexpr auto eps = 4*std::numeric_limits<num_t>::epsilon();
+      constexpr num_t a{num_t(-1.5)};
+
+      // lengths and offsets that exercise unaligned heads, vector bodies and tails
+      const auto length = GENERATE( as<std::size_t>{}, 0, 1, 2, 5, 16, 41 );
+      const auto offset = GENERATE( as<std::size_t>{}, 0, 1, 3 );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", length " << length << ", offset " << offset );
+
+      auto ps = make_elements<point_t>(length+offset,0);
+      auto qs = make_elements<point_t>(length+offset,5);
+      auto ds = make_elements<delta_t>(length+offset,9);
+      auto es = make_elements<delta_t>(length+offset,2);
+
+      const std::span p = std::span(ps).subspan(offset);
+      const std::span q = std::span(qs).subspan(offset);
+      const std::span d = std::span(ds).subspan(offset);
+      const std::span e = std::span(es).subspan(offset);
+
+      SECTION( "axpy", "[kernels][delta]" )
+     {
+         const std::vector<delta_t> e0(e.begin(),e.end());
+         affine::axpy( a, d, e );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( e[i][c] == Approx( e0[i][c]+a*d[i][c] ).epsilon( eps ).margin( eps ) );
+           }
+        }
+     }
+
+      SECTION( "advance", "[kernels][point][delta]" )
+     {
+         const std::vector<point_t> p0(p.begin(),p.end());
+         affine::advance( p, a, d );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( p[i][c] == Approx( p0[i][c]+a*d[i][c] ).epsilon( eps ).margin( eps ) );
+           }
+        }
+     }
+
+      SECTION( "scale", "[kernels][delta]" )
+     {
+         const std::vector<delta_t> d0(d.begin(),d.end());
+         affine::scale( a, d );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( d[i][c] == a*d0[i][c] );
+           }
+        }
+     }
+
+      SECTION( "difference", "[kernels][point][delta]" )
+     {
+         affine::difference( p, q, e );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( e[i][c] == p[i][c]-q[i][c] );
+           }
+        }
+     }
+
+      SECTION( "norm2", "[kernels][delta]" )
+     {
+         std::vector<num_t> r(length);
+         affine::norm2( d, std::span(r) );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            REQUIRE( r[i] == Approx( d[i][0]*d[i][0]+d[i][1]*d[i][1]+d[i][2]*d[i][2] ).epsilon( eps ).margin( eps ) );
+        }
+     }
+
+      SECTION( "distance2", "[kernels][point]" )
+     {
+         const point_t o{{num_t(0.5),num_t(-1),num_t(2)}};
+         std::vector<num_t> r(length);
+         affine::distance2( std::span<const point_t>(p), o, std::span(r) );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta_t x = p[i]-o;
+            REQUIRE( r[i] == Approx( x[0]*x[0]+x[1]*x[1]+x[2]*x[2] ).epsilon( eps ).margin( eps ) );
+        }
+     }
+
+      SECTION( "normalize", "[kernels][delta]" )
+     {
+         if( length>0 ){ d[0]=delta_t{}; }
+         const std::vector<delta_t> d0(d.begin(),d.end());
+         affine::normalize( d );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const num_t l = std::sqrt( d0[i][0]*d0[i][0]+d0[i][1]*d0[i][1]+d0[i][2]*d0[i][2] );
+            for( std::size_t c=0; c<3; ++c )
+           {
+               REQUIRE( d[i][c] == Approx( l>0 ? d0[i][c]/l : 0 ).epsilon( eps ).margin( eps ) );
+           }
+        }
+     }
+
+      SECTION( "elements outside the span are untouched", "[kernels]" )
+     {
+         affine::axpy( a, d, e );
+         affine::scale( a, d );
+
+         for( std::size_t i=0; i<offset; ++i )
+        {
+            REQUIRE( es[i][0] == value<num_t>(i+2,0) );
+            REQUIRE( ds[i][2] == value<num_t>(i+9,2) );
+        }
+     }
+
+      affine::set_kernel_isa( affine::isa::avx512 );
+  }
+
+   TEMPLATE_TEST_CASE( "normalize at the exponent extremes", "[kernels][delta]", float, double )
+  {
+      using num_t = TestType;
+      using delta_t = simd_delta<3,num_t>;
+
+      constexpr auto eps = 4*std::numeric_limits<num_t>::epsilon();
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+
+      // |d|² is subnormal (or zero) for the small scales, and infinite for the largest
+      const auto scale = GENERATE( as<num_t>{}, std::numeric_limits<num_t>::denorm_min(),
+                                                std::sqrt( std::numeric_limits<num_t>::min() )/num_t(8),
+                                                std::sqrt( std::numeric_limits<num_t>::min() ),
+                                                std::sqrt( std::numeric_limits<num_t>::max() ),
+                                                std::numeric_limits<num_t>::max()/num_t(4) );
+
+      // more elements than a vector, so every isa takes its vector path
+      std::vector<delta_t> d(19);
+      for( std::size_t i=0; i<d.size(); ++i ){ d[i]=delta_t{{scale,-scale,num_t(i%3)*scale}}; }
+      d[5]=delta_t{};
+
+      affine::normalize( std::span(d) );
+
+      for( std::size_t i=0; i<d.size(); ++i )
+     {
+         const num_t l = i==5 ? num_t(0) : std::sqrt( num_t(2)+num_t(i%3)*num_t(i%3) );
+         for( std::size_t c=0; c<2; ++c )
+        {
+            REQUIRE( std::isfinite( d[i][c] ) );
+            REQUIRE( std::abs( d[i][c] ) == Approx( l>0 ? 1/l : 0 ).epsilon( eps ).margin( eps ) );
+        }
+         REQUIRE( d[i][2] == Approx( l>0 ? num_t(i%3)/l : 0 ).epsilon( eps ).margin( eps ) );
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEST_CASE( "kernels on other value types", "[kernels][simd]" )
+  {
+      using point_t = simd_point<2,affine::simd<double,4>>;
+      using delta_t = simd_delta<2,affine::simd<double,4>>;
+
+      STATIC_REQUIRE( !affine::detail::flat_layout<point_t> );
+
+      std::vector<point_t> ps(3);
+      std::vector<delta_t> ds(3);
+      for( std::size_t i=0; i<3; ++i ){ ds[i][0]=double(i); ds[i][1]=1.0; }
+
+      affine::advance( std::span(ps), 2.0, std::span(ds) );
+
+      REQUIRE( ps[2][0][3] == 4.0 );
+      REQUIRE( ps[1][1][0] == 2.0 );
+  }
+
+   TEST_CASE( "point_array kernels", "[kernels][point_array]" )
+  {
+      using point_t = simd_point<3,double>;
+      using delta_t = simd_delta<3,double>;
+
+      constexpr std::size_t length = 37;
+      constexpr double a{0.5};
+
+      const auto pv = make_elements<point_t>(length,0);
+      const auto qv = make_elements<point_t>(length,4);
+      const auto dv = make_elements<delta_t>(length,8);
+
+      affine::point_array<point_t> ps(pv),qs(qv);
+      affine::delta_array<delta_t> ds(dv),es;
+
+      SECTION( "norms", "[kernels][point_array]" )
+     {
+         const point_t o{{1,2,3}};
+         std::vector<double> r(length), s(length);
+         affine::delta_array<delta_t> ns(dv);
+
+         affine::distance2( ps, o, std::span(r) );
+         affine::normalize( ns );
+         affine::norm2( ns, std::span(s) );
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta_t x = pv[i]-o;
+            REQUIRE( r[i] == Approx( x[0]*x[0]+x[1]*x[1]+x[2]*x[2] ).epsilon( 1e-15 ) );
+            REQUIRE( s[i] == Approx( 1 ).epsilon( 1e-15 ) );
+        }
+     }
+
+      affine::advance( ps, a, ds );
+      affine::difference( ps, qs, es );
+      affine::scale( a, es );
+      affine::axpy( a, ds, es );
+
+      REQUIRE( es.size() == length );
+      for( std::size_t i=0; i<length; ++i )
+     {
+         for( std::size_t c=0; c<3; ++c )
+        {
+            const double expected = a*(pv[i][c]+a*dv[i][c]-qv[i][c])+a*dv[i][c];
+            REQUIRE( es[i][c] == Approx( expected ).epsilon( 1e-15 ).margin( 1e-15 ) );
+        }
+     }
+  }
+
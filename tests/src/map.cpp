@@ -0,0 +1,187 @@
+
+# include <simd_space.h>
+# include <vector_space.h>
+# include <map.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <random>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+   using point2 = point<2>;
+   using delta2 = delta<2>;
+
+   using affine::linear_map;
+   using affine::affine_map;
+
+   // quarter turn about z, and a shear
+   constexpr linear_map<3,3> rotate{{{ {0,-1,0}, {1,0,0}, {0,0,1} }}};
+   constexpr linear_map<3,3> shear{{{ {1,2,0}, {0,1,0}, {0,0,1} }}};
+   constexpr affine_map<3,3> shift{ linear_map<3,3>::identity(), {1,2,3} };
+
+   // compile time composition and inversion
+   static_assert( rotate*rotate.inverse() == linear_map<3,3>::identity() );
+   static_assert( (shear*rotate)[0] == std::array<double,3>{2,-1,0} );
+   static_assert( shear.inverse()[0] == std::array<double,3>{1,-2,0} );
+   static_assert( rotate.determinant() == 1 && shear.determinant() == 1 );
+   static_assert( linear_map<2,2>{{{ {1,2}, {2,4} }}}.determinant() == 0 );
+   static_assert( rotate.transpose() == rotate.inverse() );
+
+   constexpr affine_map<3,3> rotate_then_shift = shift*affine_map<3,3>{ rotate, {} };
+   static_assert( rotate_then_shift.inverse()*rotate_then_shift == affine_map<3,3>::identity() );
+   static_assert( rotate_then_shift.inverse().translation == std::array<double,3>{-2,1,-3} );
+
+   // compositions only compile if the dimensions agree
+   template<typename F, typename G>
+   concept composable = requires( F f, G g ){ g*f; };
+
+   static_assert(  composable<linear_map<3,2>,linear_map<2,4>> );
+   static_assert( !composable<linear_map<3,2>,linear_map<3,4>> );
+
+   // points are only mapped by affine maps
+   template<typename F, typename T>
+   concept maps = requires( F f, T x ){ f(x); };
+
+   static_assert(  maps<affine_map<3,3>,point3> &&  maps<affine_map<3,3>,delta3> );
+   static_assert( !maps<linear_map<3,3>,point3> &&  maps<linear_map<3,3>,delta3> );
+   static_assert( !maps<affine_map<3,3>,delta2> );
+
+   // points and deltas have no equality, compare coordinates
+   template<typename T>
+   static bool same( const T& x, const T& y )
+  {
+      for( std::size_t c=0; c<T::size(); ++c ){ if( x[c]!=y[c] ){ return false; } }
+      return true;
+  }
+
+   TEST_CASE( "single elements", "[map][point][delta]" )
+  {
+      const point3 p{{1,2,3}};
+      const point3 q{{-1,0,5}};
+
+      const auto f = rotate_then_shift;
+
+      REQUIRE( same( f(p), point3{{-1,3,6}} ) );
+      REQUIRE( same( f(p-q), rotate(p-q) ) );
+      REQUIRE( same( f(p)-f(q), f(p-q) ) );
+      REQUIRE( same( f.inverse()(f(p)), p ) );
+
+      SECTION( "non-square maps", "[map]" )
+     {
+         // projection onto the xy plane, then shifted
+         const affine_map<3,2> project{ {{{ {1,0,0}, {0,1,0} }}}, {10,20} };
+
+         REQUIRE( same( affine::apply<point2>(project,p), point2{{11,22}} ) );
+         REQUIRE( same( affine::apply<delta2>(project,p-q), delta2{{2,2}} ) );
+
+         const linear_map<2,3> embed{{{ {1,0}, {0,1}, {0,0} }}};
+         REQUIRE( (embed*project.linear).determinant() == 0 );
+     }
+  }
+
+   template<typename T>
+   static std::vector<T> make_elements( const std::size_t n, const unsigned seed )
+  {
+      using num_t = typename T::value_type;
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> uniform(-1,1);
+
+      std::vector<T> xs(n);
+      for( auto& x : xs )
+     {
+         for( std::size_t c=0; c<T::size(); ++c ){ x[c]=static_cast<num_t>(uniform(rng)); }
+     }
+      return xs;
+  }
+
+   using point3f = simd_point<3,float>;
+   using delta3f = simd_delta<3,float>;
+   using point4d = simd_point<4,double>;
+   using delta4d = simd_delta<4,double>;
+
+   TEMPLATE_TEST_CASE( "batches", "[map][kernels]", point3f, delta3f, point4d, delta4d )
+  {
+      using T = TestType;
+      using num_t = typename T::value_type;
+      constexpr std::size_t N = T::size();
+
+      // empty, less than one vector, several vectors with a tail, several blocks
+      const std::size_t n = GENERATE( 0, 3, 37, 600 );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", n " << n );
+
+      affine_map<N,N,num_t> f{};
+      for( std::size_t r=0; r<N; ++r )
+     {
+         for( std::size_t c=0; c<N; ++c ){ f.linear[r][c]=num_t(r+1)-num_t(c)/num_t(2); }
+         f.translation[r]=num_t(1)+num_t(r);
+     }
+
+      const auto xs = make_elements<T>( n, 3 );
+      std::vector<T> expected(n);
+      for( std::size_t i=0; i<n; ++i ){ expected[i]=f(xs[i]); }
+
+      const auto tol = 16*std::numeric_limits<num_t>::epsilon();
+
+      const auto check = [&]( const auto& ys )
+     {
+         REQUIRE( ys.size() == n );
+         for( std::size_t i=0; i<n; ++i )
+        {
+            for( std::size_t c=0; c<N; ++c ){ REQUIRE( ys[i][c] == Approx( expected[i][c] ).epsilon( tol ).margin( tol ) ); }
+        }
+     };
+
+      SECTION( "spans", "[map]" )
+     {
+         std::vector<T> ys(n);
+         affine::apply( f, std::span<const T>(xs), std::span(ys) );
+         check( ys );
+
+         auto zs = xs;
+         affine::apply( f, std::span(zs) );
+         check( zs );
+     }
+
+      SECTION( "SoA containers", "[map][point_array]" )
+     {
+         using array_t = std::conditional_t<affine::detail::point_like<T>,affine::point_array<T>,affine::delta_array<T>>;
+
+         array_t as;
+         as.resize(n);
+         for( std::size_t i=0; i<n; ++i ){ as[i]=xs[i]; }
+
+         array_t bs;
+         affine::apply( f, as, bs );
+
+         std::vector<T> ys(n);
+         for( std::size_t i=0; i<n; ++i ){ ys[i]=bs[i].value(); }
+         check( ys );
+
+         affine::apply( f, as );
+         for( std::size_t i=0; i<n; ++i ){ ys[i]=as[i].value(); }
+         check( ys );
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEST_CASE( "non-square batches", "[map][kernels]" )
+  {
+      const affine_map<3,2> project{ {{{ {1,0,0}, {0,1,0} }}}, {10,20} };
+
+      const auto ps = make_elements<point3>( 100, 4 );
+      std::vector<point2> qs(ps.size());
+      affine::apply( project, std::span<const point3>(ps), std::span(qs) );
+
+      for( std::size_t i=0; i<ps.size(); ++i )
+     {
+         REQUIRE( same( qs[i], point2{{ps[i][0]+10,ps[i][1]+20}} ) );
+     }
+  }
@@ -0,0 +1,117 @@
+
+# include <vector_space.h>
+# include <metric.h>
+# include <kernels.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using value_type = point3::value_type;
+
+   constexpr static auto eps = 4*std::numeric_limits<value_type>::epsilon();
+
+   // a 2D space in an oblique basis, with the basis vectors at 60 degrees
+   struct oblique_point;
+   struct oblique_delta;
+
+   struct oblique_point :
+      affine::point_base<2,oblique_point,oblique_delta,double> {};
+
+   struct oblique_delta :
+      affine::delta_base<2,oblique_point,oblique_delta,double> {};
+
+   struct oblique_metric
+  {
+      double inner( const oblique_delta& d, const oblique_delta& e ) const
+     {
+         return d[0]*e[0] + d[1]*e[1] + 0.5*(d[0]*e[1]+d[1]*e[0]);
+     }
+  };
+
+   template<>
+   struct affine::metric_traits<oblique_delta> { using type = oblique_metric; };
+
+   template<typename T>
+   concept has_norm = requires( T x ){ affine::norm(x); };
+
+   template<typename T>
+   concept has_distance = requires( T x ){ affine::distance(x,x); };
+
+   static_assert( has_norm<delta3> && !has_norm<point3> );
+   static_assert( has_distance<point3> && !has_distance<delta3> );
+   static_assert( affine::metric<oblique_metric,oblique_delta> );
+   static_assert( std::same_as<affine::default_metric<delta3>,affine::euclidean_metric> );
+
+   TEST_CASE( "euclidean metric", "[metric][delta]" )
+  {
+      const delta3 d{{3,-4,12}};
+      const delta3 e{{1,2,-0.5}};
+
+      REQUIRE( affine::dot(d,e) == 3-8-6 );
+      REQUIRE( affine::dot(d,e) == affine::dot(e,d) );
+      REQUIRE( affine::norm2(d) == 169 );
+      REQUIRE( affine::norm(d) == 13 );
+
+      const point3 p{{1,1,1}};
+      REQUIRE( affine::distance2(p+d,p) == 169 );
+      REQUIRE( affine::distance(p,p-d) == 13 );
+
+      SECTION( "scalar space", "[metric][scalar]" )
+     {
+         const delta<0> s{{-2.5}};
+         REQUIRE( affine::norm(s) == 2.5 );
+     }
+
+      SECTION( "dynamic extent", "[metric][dynamic]" )
+     {
+         delta<affine::dynamic_extent> x;
+         x.resize(4);
+         x[0]=1; x[1]=1; x[2]=1; x[3]=1;
+         REQUIRE( affine::norm(x) == 2 );
+     }
+  }
+
+   TEST_CASE( "weighted metric", "[metric][delta]" )
+  {
+      const affine::weighted_metric<double,3> m{{1,4,0.25}};
+      const delta3 d{{1,1,2}};
+      const delta3 e{{2,-1,4}};
+
+      REQUIRE( affine::dot(m,d,e) == 2-4+2 );
+      REQUIRE( affine::norm2(m,d) == 1+4+1 );
+      REQUIRE( affine::norm(m,d) == Approx( std::sqrt(6.) ).epsilon( eps ) );
+
+      const point3 p{{0,0,0}};
+      REQUIRE( affine::distance2(m,p+e,p) == 4+4+4 );
+  }
+
+   TEST_CASE( "user defined default metric", "[metric][delta]" )
+  {
+      const oblique_delta u{{1,0}};
+      const oblique_delta v{{0,1}};
+
+      // unit basis vectors at 60 degrees
+      REQUIRE( affine::norm(u) == 1 );
+      REQUIRE( affine::dot(u,v) == 0.5 );
+      REQUIRE( affine::norm(u-v) == Approx( 1 ).epsilon( eps ) );
+      REQUIRE( affine::norm(affine::euclidean_metric{},u+v) == Approx( std::sqrt(2.) ).epsilon( eps ) );
+
+      SECTION( "batch kernels use the default metric", "[metric][kernels]" )
+     {
+         std::vector<oblique_delta> ds{ u, v, u+v, oblique_delta{} };
+         std::vector<double> r(ds.size());
+
+         affine::norm2( std::span(ds), std::span(r) );
+         REQUIRE( r[2] == Approx( 3 ).epsilon( eps ) );
+
+         affine::normalize( std::span(ds) );
+         REQUIRE( affine::norm(ds[2]) == Approx( 1 ).epsilon( eps ) );
+         REQUIRE( ds[3][0] == 0 );
+     }
+  }
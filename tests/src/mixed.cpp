@@ -0,0 +1,177 @@
+
+# include <mixed_space.h>
+# include <expression.h>
+# include <half.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <cstddef>
+# include <span>
+# include <vector>
+
+   using point3 = mixed_point<3>;
+   using delta3 = mixed_delta<3>;
+
+   using hpoint3 = mixed_point<3,float,affine::float16>;
+   using hdelta3 = mixed_delta<3,float,affine::float16>;
+
+   static_assert( sizeof(point3)==24 && sizeof(delta3)==12 );
+   static_assert( std::same_as<point3::value_type,double> && std::same_as<delta3::value_type,float> );
+   static_assert( std::same_as<std::common_type_t<float,affine::float16>,float> && std::same_as<std::common_type_t<affine::bfloat16,double>,double> );
+
+   // the type rules are unchanged
+   template<typename T, typename U>
+   concept addable = requires( T x, U y ){ x+y; };
+
+   template<typename T, typename U>
+   concept assignable = requires( T x, U y ){ x=y; };
+
+   static_assert( addable<point3,delta3> && addable<delta3,delta3> && !addable<point3,point3> );
+   static_assert( !assignable<point3&,delta3> && !assignable<delta3&,point3> );
+   static_assert( std::same_as<decltype(point3{}-point3{}),delta3> && std::same_as<decltype(point3{}+delta3{}),point3> );
+
+   static_assert( affine::detail::flat_mixed_arithmetic<point3,delta3> && affine::detail::flat_mixed_arithmetic<hpoint3,hdelta3> );
+   static_assert( !affine::detail::flat_arithmetic<point3,delta3> );
+
+   TEST_CASE( "mixed precision operators", "[mixed][point][delta]" )
+  {
+      // far from the origin, the difference is only representable because it is taken before rounding to float
+      const point3 p{{1e6+0.125,-1e6,3}};
+      const point3 q{{1e6,-1e6-0.25,0}};
+
+      const delta3 d = p-q;
+      REQUIRE( ( d[0]==0.125f && d[1]==0.25f && d[2]==3.f ) );
+
+      // the offset is exact in double
+      const delta3 e{{0.1f,-0.1f,0.5f}};
+      const point3 r = q+e;
+      REQUIRE( ( r[0]==1e6+double(0.1f) && r[1]==-1e6-0.25-double(0.1f) && r[2]==0.5 ) );
+
+      point3 s = r;
+      s-=e;
+      REQUIRE( ( s[0]==q[0] && s[1]==q[1] && s[2]==q[2] ) );
+
+      // delta arithmetic stays in float
+      const delta3 f = 2*d+e;
+      REQUIRE( ( f[0]==0.25f+0.1f && f[1]==0.5f-0.1f ) );
+
+      SECTION( "lazy expressions", "[mixed][expression]" )
+     {
+         using affine::lazy;
+
+         // the scaled delta is added in the point coordinates, as by the eager operators
+         const point3 a = lazy(q)+0.5f*lazy(e);
+         const point3 b = q+0.5f*e;
+         const point3 c = lazy(p)-2*(lazy(p)-q);
+         const point3 g = p-2*(p-q);
+         for( std::size_t i=0; i<3; ++i )
+        {
+            REQUIRE( a[i]==b[i] );
+            REQUIRE( c[i]==g[i] );
+        }
+
+         const delta3 h = lazy(p)-lazy(q)+2*lazy(e);
+         REQUIRE( ( h[0]==d[0]+2*e[0] && h[1]==d[1]+2*e[1] ) );
+     }
+
+      SECTION( "compressed deltas", "[mixed][half]" )
+     {
+         const hpoint3 a{{1000.f,-2.5f,0.f}};
+         const hpoint3 b{{999.f,2.5f,0.25f}};
+         const hdelta3 g = a-b;
+         REQUIRE( ( float(g[0])==1.f && float(g[1])==-5.f && float(g[2])==-0.25f ) );
+
+         const hpoint3 c = b+g;
+         REQUIRE( ( c[0]==a[0] && c[1]==a[1] && c[2]==a[2] ) );
+     }
+
+      SECTION( "SoA containers", "[mixed][point_array]" )
+     {
+         affine::point_array<point3> ps{ p, q };
+         affine::point_array<point3> qs{ q, p };
+         affine::delta_array<delta3> ds = ps-qs;
+         REQUIRE( ( ds[0][0]==0.125f && ds[1][0]==-0.125f ) );
+
+         ps+=ds;
+         REQUIRE( ( ps[0][0]==1e6+0.25 && ps[1][0]==1e6-0.125 ) );
+
+         const affine::point_array<point3> ts = qs+ds;
+         REQUIRE( ( ts[0][0]==p[0] && ts[1][0]==q[0] ) );
+
+         ps[0]-=d;
+         REQUIRE( ps[0][0]==1e6+0.125 );
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "mixed precision kernels", "[mixed][kernels]", ( std::pair<point3,delta3> ), ( std::pair<hpoint3,hdelta3> ) )
+  {
+      using point_t = typename TestType::first_type;
+      using delta_t = typename TestType::second_type;
+      using num_t = typename point_t::value_type;
+      using dnum_t = typename delta_t::value_type;
+
+      const std::size_t n = GENERATE( std::size_t(1), std::size_t(7), std::size_t(33), std::size_t(100) );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", n " << n );
+
+      std::vector<point_t> ps(n), qs(n);
+      std::vector<delta_t> ds(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         for( std::size_t i=0; i<3; ++i )
+        {
+            const auto x = static_cast<num_t>(k*3+i);
+            ps[k][i] = num_t(1000)+x/num_t(7);
+            qs[k][i] = num_t(1000)-x/num_t(3);
+            ds[k][i] = dnum_t( x/num_t(11)-num_t(2) );
+        }
+     }
+
+      // computed in the point number type, and rounded once to the delta number type
+      // advance is fused with avx2 and avx512, as for a single number type
+      const num_t a = num_t(0.375);
+      const auto muladd = [fused=(isa>=affine::isa::avx2)]( const num_t x, const num_t y, const num_t z ){ return fused ? std::fma(x,y,z) : x*y+z; };
+
+      SECTION( "spans" )
+     {
+         std::vector<delta_t> es(n);
+         affine::difference( std::span<const point_t>(ps), std::span<const point_t>(qs), std::span(es) );
+
+         auto rs = ps;
+         affine::advance( std::span(rs), a, std::span<const delta_t>(ds) );
+
+         for( std::size_t k=0; k<n; ++k )
+        {
+            for( std::size_t i=0; i<3; ++i )
+           {
+               REQUIRE( num_t(es[k][i])==num_t( dnum_t(ps[k][i]-qs[k][i]) ) );
+               REQUIRE( rs[k][i]==muladd( a, num_t(ds[k][i]), ps[k][i] ) );
+           }
+        }
+     }
+
+      SECTION( "SoA containers", "[point_array]" )
+     {
+         affine::point_array<point_t> pa(ps), qa(qs);
+         affine::delta_array<delta_t> da(ds), ea;
+         affine::difference( pa, qa, ea );
+         affine::advance( pa, a, da );
+
+         for( std::size_t k=0; k<n; ++k )
+        {
+            for( std::size_t i=0; i<3; ++i )
+           {
+               REQUIRE( num_t(ea[k][i])==num_t( dnum_t(ps[k][i]-qs[k][i]) ) );
+               REQUIRE( pa[k][i]==muladd( a, num_t(ds[k][i]), ps[k][i] ) );
+           }
+        }
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
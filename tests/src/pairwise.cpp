@@ -0,0 +1,214 @@
+
+# include <exact_space.h>
+# include <simd_space.h>
+# include <vector_space.h>
+# include <fixed.h>
+# include <pairwise.h>
+# include <supported_isas.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <cstdint>
+# include <mutex>
+# include <span>
+# include <vector>
+
+   // distances computed in double from the coordinates, point by point
+   template<typename point_t>
+   static double reference_distance2( const point_t& p, const point_t& q )
+  {
+      double sum=0;
+      for( std::size_t c=0; c<point_t::size(); ++c )
+     {
+         const double v = static_cast<double>(p[c])-static_cast<double>(q[c]);
+         sum+=v*v;
+     }
+      return sum;
+  }
+
+   // differences up to 16 coordinates, expansion above
+   using point3f = simd_point<3,float>;
+   using point3d = simd_point<3,double>;
+   using point24f = simd_point<24,float>;
+   using point24d = simd_point<24,double>;
+
+   // relative error allowed by the cancellation ratio
+   template<typename point_t>
+   constexpr double tolerance = 64*(point_t::size()+2)*std::numeric_limits<typename point_t::value_type>::epsilon();
+
+   TEMPLATE_TEST_CASE( "pairwise distances", "[pairwise][point]", point3f, point3d, point24f, point24d )
+  {
+      using point_t = TestType;
+      using num_t = typename point_t::value_type;
+
+      constexpr double tol = tolerance<point_t>;
+
+      // empty, single, partial tiles, several tiles in both directions
+      const auto [na,nb] = GENERATE( table<std::size_t,std::size_t>({ {0,5}, {4,0}, {1,1}, {37,300}, {70,515} }) );
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) << ", " << na << "x" << nb );
+
+      const auto as = make_cloud<point_t>( na, 1 );
+      const auto bs = make_cloud<point_t>( nb, 2 );
+
+      std::vector<num_t> r( na*nb, num_t(-1) );
+      affine::pairwise_distance2( std::span(as), std::span(bs), std::span(r) );
+
+      for( std::size_t i=0; i<na; ++i )
+     {
+         for( std::size_t j=0; j<nb; ++j )
+        {
+            const double d2 = reference_distance2( as[i], bs[j] );
+            REQUIRE( r[i*nb+j] == Approx( d2 ).epsilon( tol ) );
+        }
+     }
+
+      SECTION( "parallel is identical", "[pairwise][parallel]" )
+     {
+         std::vector<num_t> s( na*nb );
+         affine::pairwise_distance2( affine::execution::par, std::span(as), std::span(bs), std::span(s) );
+         REQUIRE( s == r );
+     }
+
+      SECTION( "SoA containers", "[pairwise][point_array]" )
+     {
+         const affine::point_array<point_t> pa(as);
+         const affine::point_array<point_t> pb(bs);
+
+         std::vector<num_t> s( na*nb );
+         affine::pairwise_distance2( pa, pb, std::span(s) );
+
+         for( std::size_t k=0; k<s.size(); ++k ){ REQUIRE( s[k] == Approx( r[k] ).epsilon( tol ) ); }
+     }
+
+      SECTION( "streaming tiles", "[pairwise][parallel]" )
+     {
+         std::mutex lock;
+         std::vector<int> visits( na*nb, 0 );
+         std::size_t tiles=0;
+
+         affine::pairwise_distance2( affine::execution::par, std::span(as), std::span(bs),
+                                     [&]( const affine::distance_tile<num_t>& tile )
+                                    {
+                                        const std::scoped_lock guard(lock);
+                                        ++tiles;
+                                        REQUIRE( tile.rows() <= affine::pairwise_tile_rows );
+                                        REQUIRE( tile.columns() <= affine::pairwise_tile_columns );
+                                        for( std::size_t i=0; i<tile.rows(); ++i )
+                                       {
+                                           REQUIRE( tile.row(i).size() == tile.columns() );
+                                           for( std::size_t j=0; j<tile.columns(); ++j )
+                                          {
+                                              const std::size_t k = (tile.row_begin()+i)*nb+tile.column_begin()+j;
+                                              ++visits[k];
+                                              REQUIRE( tile(i,j) == r[k] );
+                                          }
+                                       }
+                                    } );
+
+         REQUIRE( std::count( visits.begin(), visits.end(), 1 ) == static_cast<std::ptrdiff_t>(na*nb) );
+         REQUIRE( tiles == (na+affine::pairwise_tile_rows-1)/affine::pairwise_tile_rows*((nb+affine::pairwise_tile_columns-1)/affine::pairwise_tile_columns) );
+     }
+
+      affine::set_kernel_isa( affine::isa::avx512 );
+  }
+
+   TEMPLATE_TEST_CASE( "pairwise distances with cancellation", "[pairwise][point]", point3f, point3d, point24f, point24d )
+  {
+      using point_t = TestType;
+      using num_t = typename point_t::value_type;
+
+      constexpr double tol = tolerance<point_t>;
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      // two clusters far from the origin and from each other, with separations much smaller than their positions
+      auto as = make_cloud<point_t>( 50, 3, 1000, 0.01 );
+      auto bs = make_cloud<point_t>( 40, 4, 1000, 0.01 );
+      const auto far = make_cloud<point_t>( 30, 5, -1000, 0.01 );
+      bs.insert( bs.end(), far.begin(), far.end() );
+
+      // coincident points
+      bs[7] = as[3];
+      bs[60] = as[45]+(as[44]-as[44]);
+
+      std::vector<num_t> r( as.size()*bs.size() );
+      affine::pairwise_distance2( std::span(as), std::span(bs), std::span(r) );
+
+      for( std::size_t i=0; i<as.size(); ++i )
+     {
+         for( std::size_t j=0; j<bs.size(); ++j )
+        {
+            const double d2 = reference_distance2( as[i], bs[j] );
+            REQUIRE( r[i*bs.size()+j] == Approx( d2 ).epsilon( tol ) );
+        }
+     }
+
+      REQUIRE( r[3*bs.size()+7] == 0 );
+      REQUIRE( r[45*bs.size()+60] == 0 );
+
+      affine::set_kernel_isa( affine::isa::avx512 );
+  }
+
+   TEST_CASE( "pairwise distances of dynamic extent points", "[pairwise][dynamic]" )
+  {
+      using point_t = point<affine::dynamic_extent>;
+
+      std::vector<point_t> as(40), bs(300);
+      for( std::size_t i=0; i<as.size(); ++i ){ as[i].resize(2); as[i][0]=static_cast<double>(i); as[i][1]=1; }
+      for( std::size_t j=0; j<bs.size(); ++j ){ bs[j].resize(2); bs[j][0]=0; bs[j][1]=static_cast<double>(j); }
+
+      std::vector<double> r( as.size()*bs.size() );
+      affine::pairwise_distance2( affine::execution::par, std::span(as), std::span(bs), std::span(r) );
+
+      for( std::size_t i=0; i<as.size(); ++i )
+     {
+         for( std::size_t j=0; j<bs.size(); ++j )
+        {
+            const double dy = 1-static_cast<double>(j);
+            REQUIRE( r[i*bs.size()+j] == static_cast<double>(i*i)+dy*dy );
+        }
+     }
+  }
+
+   TEST_CASE( "pairwise distances of integer and fixed point containers", "[pairwise][exact][point_array]" )
+  {
+      SECTION( "int32 coordinates" )
+     {
+         using point_t = exact_point<2,std::int32_t>;
+
+         affine::point_array<point_t> as, bs;
+         for( std::int32_t i=0; i<40; ++i ){ as.push_back( point_t{{i,1}} ); }
+         for( std::int32_t j=0; j<300; ++j ){ bs.push_back( point_t{{0,j}} ); }
+
+         std::vector<std::int32_t> r( as.size()*bs.size() );
+         affine::pairwise_distance2( affine::execution::par, as, bs, std::span(r) );
+
+         for( std::int32_t i=0; i<40; ++i )
+        {
+            for( std::int32_t j=0; j<300; ++j ){ REQUIRE( r[static_cast<std::size_t>(i*300+j)] == i*i+(1-j)*(1-j) ); }
+        }
+     }
+
+      SECTION( "fixed point coordinates" )
+     {
+         using q16  = affine::fixed<std::int32_t,16>;
+         using q16w = affine::fixed<std::int64_t,16>;
+         using point_t = exact_point<2,q16,q16w>;
+
+         affine::point_array<point_t> as, bs;
+         as.push_back( point_t{{q16(0.5),q16(0)}} );
+         as.push_back( point_t{{q16(-1),q16(2)}} );
+         bs.push_back( point_t{{q16(3.5),q16(-4)}} );
+
+         std::vector<q16w> r(2);
+         affine::pairwise_distance2( as, bs, std::span(r) );
+         REQUIRE( ( r[0]==q16w(25) && r[1]==q16w(q16(4.5)*q16(4.5))+q16w(36) ) );
+     }
+  }
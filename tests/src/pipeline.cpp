@@ -0,0 +1,115 @@
+
+# include <vector_space.h>
+# include <pipeline.h>
+
+# include <catch.hpp>
+
+# include <random>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+   using point2 = point<2>;
+
+   using affine::linear_map;
+   using affine::affine_map;
+
+   constexpr linear_map<3,3> rotate{{{ {0,-1,0}, {1,0,0}, {0,0,1} }}};
+   constexpr affine_map<3,3> to_world{ rotate, {1,2,3} };
+   constexpr affine_map<3,3> to_camera{ {{{ {2,0,0}, {0,2,0}, {0,0,1} }}}, {0,0,10} };
+   constexpr affine_map<2,2> to_pixels{ {{{ {100,0}, {0,-100} }}}, {320,240} };
+   constexpr affine_map<2,2> flip{ {{{ {-1,0}, {0,1} }}}, {640,0} };
+
+   struct divide
+  {
+      constexpr point2 operator()( const point3& p ) const { return point2{{p[0]/p[2],p[1]/p[2]}}; }
+  };
+
+   // maps are composed as they are added, other stages are kept
+   constexpr auto camera = affine::pipeline() | to_world | rotate | to_camera | divide{} | to_pixels | flip;
+
+   static_assert( camera.size() == 3 );
+   static_assert( camera.stage_count() == 6 );
+   static_assert( camera.passes_saved() == 5 );
+   static_assert( std::get<0>(camera.stage_tuple()) == to_camera*affine_map<3,3>{rotate,{}}*to_world );
+   static_assert( std::get<2>(camera.stage_tuple()) == flip*to_pixels );
+
+   static_assert( affine::pipeline().passes_saved() == 0 );
+   static_assert( (affine::pipeline() | divide{}).passes_saved() == 0 );
+
+   // linear maps stay linear, so still only apply to deltas
+   static_assert( std::same_as<std::tuple_element_t<0,std::remove_cvref_t<decltype((affine::pipeline()|rotate|rotate).stage_tuple())>>,linear_map<3,3>> );
+
+   static std::vector<point3> make_points( const std::size_t n )
+  {
+      std::mt19937 rng(5);
+      std::uniform_real_distribution<double> uniform(-1,1);
+
+      std::vector<point3> ps(n);
+      for( auto& p : ps ){ p = point3{{uniform(rng),uniform(rng),uniform(rng)}}; }
+      return ps;
+  }
+
+   // each stage applied separately, one pass per stage
+   static point2 stage_by_stage( const point3& p )
+  {
+      return flip(to_pixels(divide{}(to_camera(affine::apply<point3>(affine_map<3,3>{rotate,{}},to_world(p))))));
+  }
+
+   TEST_CASE( "fused pipeline", "[pipeline][map]" )
+  {
+      // empty, partial tile, several tiles, several chunks under par
+      const std::size_t n = GENERATE( std::size_t(0), std::size_t(5), std::size_t(1000), 3*affine::detail::parallel_grain+17 );
+      const auto ps = make_points( n );
+
+      std::vector<point2> qs(n);
+      camera( std::span<const point3>(ps), std::span(qs) );
+
+      for( std::size_t i=0; i<n; ++i )
+     {
+         const point2 r = stage_by_stage( ps[i] );
+         REQUIRE( qs[i][0] == Approx( r[0] ).epsilon( 1e-12 ) );
+         REQUIRE( qs[i][1] == Approx( r[1] ).epsilon( 1e-12 ) );
+     }
+
+      SECTION( "parallel policies give identical results", "[pipeline][parallel]" )
+     {
+         std::vector<point2> rs(n);
+         camera( affine::execution::par, std::span<const point3>(ps), std::span(rs) );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( ( rs[i][0]==qs[i][0] && rs[i][1]==qs[i][1] ) ); }
+     }
+
+      SECTION( "single elements", "[pipeline]" )
+     {
+         for( std::size_t i=0; i<std::min<std::size_t>(n,10); ++i )
+        {
+            const point2 r = camera( ps[i] );
+            REQUIRE( ( r[0]==qs[i][0] && r[1]==qs[i][1] ) );
+        }
+     }
+  }
+
+   TEST_CASE( "in place pipeline", "[pipeline][map]" )
+  {
+      const auto twice = affine::pipeline() | to_world | to_world;
+      const auto once  = to_world*to_world;
+
+      auto ps = make_points( 700 );
+      const auto qs = ps;
+      twice( affine::execution::par, std::span(ps) );
+
+      for( std::size_t i=0; i<ps.size(); ++i )
+     {
+         const point3 r = once( qs[i] );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( ps[i][c] == Approx( r[c] ).epsilon( 1e-12 ) ); }
+     }
+
+      SECTION( "deltas only see the linear part", "[pipeline][delta]" )
+     {
+         std::vector<delta3> ds{ delta3{{1,0,0}}, delta3{{0,1,0}} };
+         twice( std::span(ds) );
+         REQUIRE( ( ds[0][0]==-1 && ds[0][1]==0 && ds[0][2]==0 ) );
+         REQUIRE( ( ds[1][0]==0 && ds[1][1]==-1 && ds[1][2]==0 ) );
+     }
+  }
@@ -0,0 +1,306 @@
+
+# include <vector_space.h>
+# include <point_array.h>
+
+# include <catch.hpp>
+
+# include <concepts>
+# include <cstdint>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using point_array3 = affine::point_array<point3>;
+   using delta_array3 = affine::delta_array<delta3>;
+
+   using value_type = point3::value_type;
+
+   constexpr static auto eps = std::numeric_limits<value_type>::epsilon();
+
+   // odd length, so that the vectorised loops also have a remainder
+   constexpr static std::size_t length = 37;
+
+   static point3 make_point( const std::size_t i )
+  {
+      const auto x = static_cast<value_type>(i);
+      return {{x,2*x+1,3*x-2}};
+  }
+
+   static delta3 make_delta( const std::size_t i )
+  {
+      const auto x = static_cast<value_type>(i);
+      return {{x-5,x/2,4-x}};
+  }
+
+   TEST_CASE( "point_array storage", "[point_array][point][delta]" )
+  {
+      point_array3 ps(length);
+
+      REQUIRE( ps.size() == length );
+      REQUIRE( point_array3::columns() == 3 );
+      REQUIRE( ps.capacity() >= length );
+
+      SECTION( "columns are aligned", "[point_array]" )
+     {
+         for( std::size_t c=0; c<ps.columns(); ++c )
+        {
+            REQUIRE( reinterpret_cast<std::uintptr_t>(ps.data(c)) % affine::column_alignment == 0 );
+        }
+     }
+
+      SECTION( "elements are value initialised", "[point_array]" )
+     {
+         for( std::size_t i=0; i<length; ++i )
+        {
+            REQUIRE( ps[i][0] == 0 );
+            REQUIRE( ps[i][1] == 0 );
+            REQUIRE( ps[i][2] == 0 );
+        }
+     }
+
+      SECTION( "proxies write through to columns", "[point_array]" )
+     {
+         ps[4]=make_point(4);
+
+         REQUIRE( ps.column(0)[4] == Approx( make_point(4)[0] ).epsilon( eps ) );
+         REQUIRE( ps.column(1)[4] == Approx( make_point(4)[1] ).epsilon( eps ) );
+         REQUIRE( ps.column(2)[4] == Approx( make_point(4)[2] ).epsilon( eps ) );
+     }
+
+      SECTION( "push_back preserves contents", "[point_array]" )
+     {
+         point_array3 qs;
+         for( std::size_t i=0; i<length; ++i ){ qs.push_back( make_point(i) ); }
+
+         REQUIRE( qs.size() == length );
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const point3 q = qs[i];
+            REQUIRE( q[0] == Approx( make_point(i)[0] ).epsilon( eps ) );
+            REQUIRE( q[1] == Approx( make_point(i)[1] ).epsilon( eps ) );
+            REQUIRE( q[2] == Approx( make_point(i)[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "construction from a span of points", "[point_array]" )
+     {
+         std::vector<point3> aos;
+         for( std::size_t i=0; i<length; ++i ){ aos.push_back( make_point(i) ); }
+
+         const point_array3 qs(aos);
+
+         std::size_t i=0;
+         for( const point3 q : qs )
+        {
+            REQUIRE( q[1] == Approx( aos[i][1] ).epsilon( eps ) );
+            ++i;
+        }
+         REQUIRE( i == length );
+     }
+  }
+
+   TEST_CASE( "point_array proxy arithmetic", "[point_array][point][delta]" )
+  {
+      point_array3 ps{ make_point(1), make_point(2) };
+      delta_array3 ds{ make_delta(3), make_delta(4) };
+
+      SECTION( "point proxy in-place addition", "[point_array][point]" )
+     {
+         ps[0]+=make_delta(3);
+
+         REQUIRE( ps[0][0] == Approx( make_point(1)[0]+make_delta(3)[0] ).epsilon( eps ) );
+         REQUIRE( ps[0][2] == Approx( make_point(1)[2]+make_delta(3)[2] ).epsilon( eps ) );
+     }
+
+      SECTION( "point proxy-proxy subtraction", "[point_array][point][delta]" )
+     {
+         const delta3 d = ps[1]-ps[0];
+
+         REQUIRE( d[0] == Approx( make_point(2)[0]-make_point(1)[0] ).epsilon( eps ) );
+         REQUIRE( d[1] == Approx( make_point(2)[1]-make_point(1)[1] ).epsilon( eps ) );
+     }
+
+      SECTION( "point proxy+delta proxy addition", "[point_array][point][delta]" )
+     {
+         const point3 p = ps[0]+ds[1];
+
+         REQUIRE( p[0] == Approx( make_point(1)[0]+make_delta(4)[0] ).epsilon( eps ) );
+         REQUIRE( p[2] == Approx( make_point(1)[2]+make_delta(4)[2] ).epsilon( eps ) );
+     }
+
+      SECTION( "point-point proxy subtraction", "[point_array][point][delta]" )
+     {
+         const delta3 d = make_point(5)-ps[1];
+
+         REQUIRE( d[0] == Approx( make_point(5)[0]-make_point(2)[0] ).epsilon( eps ) );
+     }
+
+      SECTION( "num*delta proxy multiplication", "[point_array][delta]" )
+     {
+         const delta3 d = value_type(3)*ds[0];
+
+         REQUIRE( d[0] == Approx( 3*make_delta(3)[0] ).epsilon( eps ) );
+         REQUIRE( d[1] == Approx( 3*make_delta(3)[1] ).epsilon( eps ) );
+     }
+
+      SECTION( "delta proxy in-place division", "[point_array][delta]" )
+     {
+         ds[1]/=value_type(2);
+
+         REQUIRE( ds[1][0] == Approx( make_delta(4)[0]/2 ).epsilon( eps ) );
+         REQUIRE( ds[0][0] == Approx( make_delta(3)[0]   ).epsilon( eps ) );
+     }
+
+      SECTION( "proxy copy assigns values", "[point_array][point]" )
+     {
+         ps[0]=ps[1];
+
+         REQUIRE( ps[0][1] == Approx( make_point(2)[1] ).epsilon( eps ) );
+         REQUIRE( ps[1][1] == Approx( make_point(2)[1] ).epsilon( eps ) );
+     }
+  }
+
+   TEST_CASE( "point_array arithmetic", "[point_array][point][delta]" )
+  {
+      constexpr value_type coeff{3};
+
+      point_array3 p0(length),p1(length);
+      delta_array3 d0(length),d1(length);
+
+      for( std::size_t i=0; i<length; ++i )
+     {
+         p0[i]=make_point(i);
+         p1[i]=make_point(2*i+1);
+         d0[i]=make_delta(i);
+         d1[i]=make_delta(3*i);
+     }
+
+      SECTION( "point_array-point_array subtraction", "[point_array][point][delta]" )
+     {
+         const delta_array3 d = p1-p0;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta3 expected = make_point(2*i+1)-make_point(i);
+            REQUIRE( d[i][0] == Approx( expected[0] ).epsilon( eps ) );
+            REQUIRE( d[i][1] == Approx( expected[1] ).epsilon( eps ) );
+            REQUIRE( d[i][2] == Approx( expected[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "point_array+delta_array addition", "[point_array][point][delta]" )
+     {
+         const point_array3 p = p0+d0;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const point3 expected = make_point(i)+make_delta(i);
+            REQUIRE( p[i][0] == Approx( expected[0] ).epsilon( eps ) );
+            REQUIRE( p[i][2] == Approx( expected[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "point_array-delta_array subtraction", "[point_array][point][delta]" )
+     {
+         const point_array3 p = p0-d0;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const point3 expected = make_point(i)-make_delta(i);
+            REQUIRE( p[i][1] == Approx( expected[1] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "point_array in-place addition", "[point_array][point][delta]" )
+     {
+         p0+=d0;
+         p0-=d1;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const point3 expected = make_point(i)+make_delta(i)-make_delta(3*i);
+            REQUIRE( p0[i][0] == Approx( expected[0] ).epsilon( eps ) );
+            REQUIRE( p0[i][2] == Approx( expected[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "delta_array+delta_array addition", "[point_array][delta]" )
+     {
+         const delta_array3 d = d0+d1;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta3 expected = make_delta(i)+make_delta(3*i);
+            REQUIRE( d[i][1] == Approx( expected[1] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "delta_array-delta_array subtraction", "[point_array][delta]" )
+     {
+         const delta_array3 d = d0-d1;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta3 expected = make_delta(i)-make_delta(3*i);
+            REQUIRE( d[i][2] == Approx( expected[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "num*delta_array multiplication", "[point_array][delta]" )
+     {
+         const delta_array3 d = coeff*d0;
+         const delta_array3 e = d0*coeff;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            REQUIRE( d[i][0] == Approx( coeff*make_delta(i)[0] ).epsilon( eps ) );
+            REQUIRE( e[i][0] == Approx( coeff*make_delta(i)[0] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "delta_array/num division", "[point_array][delta]" )
+     {
+         const delta_array3 d = d0/coeff;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            REQUIRE( d[i][1] == Approx( make_delta(i)[1]/coeff ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "delta_array in-place arithmetic", "[point_array][delta]" )
+     {
+         d0+=d1;
+         d0*=coeff;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            const delta3 expected = coeff*(make_delta(i)+make_delta(3*i));
+            REQUIRE( d0[i][0] == Approx( expected[0] ).epsilon( eps ) );
+            REQUIRE( d0[i][2] == Approx( expected[2] ).epsilon( eps ) );
+        }
+     }
+
+      SECTION( "delta_array negation", "[point_array][delta]" )
+     {
+         const delta_array3 d = -d0;
+
+         for( std::size_t i=0; i<length; ++i )
+        {
+            REQUIRE( d[i][1] == Approx( -make_delta(i)[1] ).epsilon( eps ) );
+        }
+     }
+  }
+
+   template<typename lhs_t, typename rhs_t>
+   concept addable = requires( lhs_t lhs, rhs_t rhs ){ lhs+rhs; };
+
+   template<typename lhs_t, typename rhs_t>
+   concept multipliable = requires( lhs_t lhs, rhs_t rhs ){ lhs*rhs; };
+
+   static_assert( !addable<point_array3,point_array3> );
+   static_assert( !multipliable<value_type,point_array3> );
+   static_assert( !addable<point_array3::reference,point_array3::reference> );
+   static_assert(  addable<point_array3::reference,delta_array3::const_reference> );
+
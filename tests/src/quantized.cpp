@@ -0,0 +1,175 @@
+
+# include <vector_space.h>
+# include <quantized.h>
+# include <kernels.h>
+# include <point_array.h>
+# include <supported_isas.h>
+
+# include <catch.hpp>
+
+# include <algorithm>
+# include <cmath>
+# include <cstddef>
+# include <cstdint>
+# include <iterator>
+# include <limits>
+# include <span>
+# include <utility>
+# include <vector>
+
+   template<std::size_t N> struct fpoint;
+   template<std::size_t N> struct fdelta;
+
+   template<std::size_t N>
+   struct fpoint : affine::point_base<N,fpoint<N>,fdelta<N>,float> {};
+
+   template<std::size_t N>
+   struct fdelta : affine::delta_base<N,fpoint<N>,fdelta<N>,float> {};
+
+   static_assert( std::random_access_iterator<affine::quantized_array<point<3>>::const_iterator> );
+   static_assert( std::same_as<affine::quantized_array<point<3>>::array_type,affine::point_array<point<3>>> );
+   static_assert( std::same_as<affine::quantized_array<delta<3>>::array_type,affine::delta_array<delta<3>>> );
+   static_assert( affine::quantizable<point<3>> && !affine::quantizable<point<0>> );
+
+   TEMPLATE_TEST_CASE( "quantize and dequantize kernels", "[quantized][kernels]",
+                       ( std::pair<double,std::uint16_t> ), ( std::pair<double,std::int16_t> ),
+                       ( std::pair<float,std::uint16_t> ),  ( std::pair<float,std::int16_t> ) )
+  {
+      using num_t  = typename TestType::first_type;
+      using code_t = typename TestType::second_type;
+
+      constexpr auto lo = std::numeric_limits<code_t>::min();
+      constexpr auto hi = std::numeric_limits<code_t>::max();
+
+      // values either side of the range of the codes, and ties between codes
+      const std::size_t n = 67;
+      std::vector<num_t> y(n);
+      for( std::size_t i=0; i<n; ++i ){ y[i] = static_cast<num_t>(lo)-num_t(2)+static_cast<num_t>(i)*(static_cast<num_t>(hi)-static_cast<num_t>(lo)+num_t(4))/num_t(66); }
+      y[5]  = static_cast<num_t>(lo)+num_t(2.5);
+      y[6]  = static_cast<num_t>(lo)+num_t(3.5);
+      y[7]  = std::numeric_limits<num_t>::quiet_NaN();
+      y[8]  = std::numeric_limits<num_t>::infinity();
+      y[9]  = -std::numeric_limits<num_t>::infinity();
+
+      std::vector<code_t> expected(n);
+      affine::detail::scalar::quantize( n, num_t(0), num_t(1), y.data(), expected.data() );
+
+      REQUIRE( expected[0]==lo );
+      REQUIRE( expected[n-1]==hi );
+      REQUIRE( expected[5]==lo+2 );
+      REQUIRE( expected[6]==lo+4 );
+      REQUIRE( expected[7]==lo );
+      REQUIRE( expected[8]==hi );
+      REQUIRE( expected[9]==lo );
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      // the codes are identical on every instruction set
+      std::vector<code_t> codes(n);
+      affine::detail::flat_quantize( n, num_t(0), num_t(1), y.data(), codes.data() );
+      REQUIRE( codes==expected );
+
+      // NaN is ignored, and the bounds of the increasing values after the infinities are the first and last
+      num_t lo_all = y[0], hi_all = y[0];
+      affine::detail::flat_bounds( n, y.data(), &lo_all, &hi_all );
+      REQUIRE( lo_all==-std::numeric_limits<num_t>::infinity() );
+      REQUIRE( hi_all==std::numeric_limits<num_t>::infinity() );
+
+      num_t lo_tail = y[n-1], hi_tail = y[10];
+      affine::detail::flat_bounds( n-10, y.data()+10, &lo_tail, &hi_tail );
+      REQUIRE( lo_tail==y[10] );
+      REQUIRE( hi_tail==y[n-1] );
+
+      std::vector<num_t> z(n);
+      affine::detail::flat_dequantize( n, num_t(-1), num_t(0.5), codes.data(), z.data() );
+      for( std::size_t i=0; i<n; ++i ){ REQUIRE( z[i]==num_t(-1)+num_t(0.5)*static_cast<num_t>(codes[i]) ); }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEMPLATE_TEST_CASE( "quantized array", "[quantized][point_array]",
+                       ( std::pair<point<3>,std::uint16_t> ), ( std::pair<point<3>,std::int16_t> ),
+                       ( std::pair<fpoint<3>,std::uint16_t> ), ( std::pair<delta<2>,std::uint16_t> ) )
+  {
+      using T = typename TestType::first_type;
+      using code_t = typename TestType::second_type;
+      using num_t = typename T::value_type;
+      constexpr std::size_t ndim = T::size();
+
+      const std::size_t n = GENERATE( 0, 1, 100, 1031 );
+      const std::size_t block = GENERATE( 1, 64, affine::quantized_block );
+
+      std::vector<T> xs(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const auto x = static_cast<num_t>(k);
+            xs[k][c] = num_t(1000)*std::sin( x*num_t(0.37)+static_cast<num_t>(c) )+num_t(100)*static_cast<num_t>(c);
+        }
+     }
+
+      const affine::quantized_array<T,code_t> q( std::span<const T>(xs), block );
+      REQUIRE( q.size()==n );
+      REQUIRE( q.blocks()==(n+block-1)/block );
+
+      // every coordinate is within half a step (and the rounding of the decode) of its value
+      const auto check = [&]( const std::size_t k, const T& y )
+     {
+         INFO( "n " << n << ", block " << block << ", k " << k );
+         const std::size_t b = q.block(k);
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            const num_t tolerance = q.step(b)[c]/2+8*std::numeric_limits<num_t>::epsilon()*num_t(2000);
+            REQUIRE( std::abs(y[c]-xs[k][c])<=tolerance );
+            REQUIRE( q.step(b)[c]<=num_t(2100)/num_t(65535) );
+        }
+     };
+
+      for( std::size_t k=0; k<n; ++k ){ check( k, q[k] ); }
+
+      // iterators decode the element they point to
+      std::size_t k=0;
+      for( const T y : q ){ REQUIRE( y.element==q[k++].element ); }
+      REQUIRE( k==n );
+      REQUIRE( static_cast<std::size_t>( std::distance(q.begin(),q.end()) )==n );
+
+      const auto isa = GENERATE_REF( from_range( supported_isas() ) );
+      affine::set_kernel_isa( isa );
+      INFO( "isa " << affine::isa_name(isa) );
+
+      SECTION( "decode" )
+     {
+         std::vector<T> ys(n);
+         q.decode( std::span(ys) );
+         for( std::size_t i=0; i<n; ++i ){ check( i, ys[i] ); }
+
+         typename affine::quantized_array<T,code_t>::array_type zs;
+         q.decode( zs );
+         REQUIRE( zs.size()==n );
+         for( std::size_t i=0; i<n; ++i ){ check( i, zs[i].value() ); }
+     }
+
+      SECTION( "encode from SoA gives the same codes" )
+     {
+         const typename affine::quantized_array<T,code_t>::array_type soa( (std::span<const T>(xs)) );
+         const affine::quantized_array<T,code_t> r( soa, block );
+         for( std::size_t c=0; c<ndim; ++c )
+        {
+            REQUIRE( std::ranges::equal( r.code(c), q.code(c) ) );
+        }
+     }
+
+      affine::set_kernel_isa( affine::detect_isa() );
+  }
+
+   TEST_CASE( "quantized array of equal points", "[quantized][point_array]" )
+  {
+      const std::vector<point<2>> xs( 10, point<2>{{-3.25,1e10}} );
+      const affine::quantized_array<point<2>,std::int16_t> q( (std::span<const point<2>>(xs)) );
+
+      REQUIRE( q.step(0)[0]==0 );
+      for( const auto x : q ){ REQUIRE( x.element==xs[0].element ); }
+  }
@@ -0,0 +1,171 @@
+
+# include <vector_space.h>
+# include <dynamic_space.h>
+# include <exact_space.h>
+# include <fixed.h>
+# include <point_array.h>
+# include <reproducible.h>
+# include <point_cloud.h>
+
+# include <catch.hpp>
+
+# include <algorithm>
+# include <array>
+# include <cmath>
+# include <cstddef>
+# include <cstdint>
+# include <functional>
+# include <numeric>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   // values of very different magnitudes, so the rounding of the sum depends on the order of the additions
+   static double wild( const std::size_t i )
+  {
+      const double x = static_cast<double>(i);
+      return std::sin(x)*std::pow( 10., static_cast<double>(i%17)-8 );
+  }
+
+   static point3 wild_point( const std::size_t i )
+  {
+      return point3{{1e6+wild(i),-wild(3*i+1),wild(7*i+2)}};
+  }
+
+   static std::vector<delta3> make_deltas( const std::size_t n, const std::size_t seed )
+  {
+      std::vector<delta3> ds(n);
+      for( std::size_t i=0; i<n; ++i ){ ds[i] = delta3{{wild(i+seed),wild(2*i+seed),-wild(5*i+seed)}}; }
+      return ds;
+  }
+
+   TEST_CASE( "blocked reduction", "[reproducible][parallel]" )
+  {
+      const std::size_t n = GENERATE( as<std::size_t>{}, 0, 1, 100, affine::detail::reduction_block+1, 5*affine::detail::parallel_grain+13 );
+      const std::size_t block = GENERATE( as<std::size_t>{}, 7, affine::detail::reduction_block );
+
+      std::vector<double> x(n);
+      for( std::size_t i=0; i<n; ++i ){ x[i]=wild(i); }
+
+      const auto reduce_block = [&]( const std::size_t b, const std::size_t e ){ return std::accumulate( x.begin()+b, x.begin()+e, 0. ); };
+
+      // the blocks, summed in order, then reduced pairwise
+      std::vector<double> partial;
+      for( std::size_t b=0; b<n; b+=block ){ partial.push_back( reduce_block( b, std::min(b+block,n) ) ); }
+      if( partial.empty() ){ partial.push_back(0); }
+      const double expected = affine::detail::tree_reduce( std::span(partial), std::plus{} );
+
+      INFO( "n " << n << ", block " << block );
+      REQUIRE( affine::detail::blocked_reduce( affine::execution::seq,       n, 0., reduce_block, std::plus{}, block )==expected );
+      REQUIRE( affine::detail::blocked_reduce( affine::execution::unseq,     n, 0., reduce_block, std::plus{}, block )==expected );
+      REQUIRE( affine::detail::blocked_reduce( affine::execution::par,       n, 0., reduce_block, std::plus{}, block )==expected );
+      REQUIRE( affine::detail::blocked_reduce( affine::execution::par_unseq, n, 0., reduce_block, std::plus{}, block )==expected );
+  }
+
+   TEMPLATE_TEST_CASE( "reproducible reductions", "[reproducible][combination]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::unsequenced_policy,
+                       affine::execution::parallel_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = GENERATE( as<std::size_t>{}, 1, 7, 3*affine::detail::parallel_grain+13 );
+      const auto cloud = make_cloud<point3>( n, wild_point );
+      const auto ds = make_deltas(n,1);
+      const auto es = make_deltas(n,2);
+
+      const affine::point_array<point3> pa(cloud);
+      const affine::delta_array<delta3> da(ds);
+      const affine::delta_array<delta3> ea(es);
+
+      // bitwise identical to the sequential result, for every policy and container
+      SECTION( "sum" )
+     {
+         const delta3 s = affine::reproducible_sum( ds );
+         REQUIRE( affine::reproducible_sum( policy, ds ).element==s.element );
+         REQUIRE( affine::reproducible_sum( policy, std::span(ds) ).element==s.element );
+         REQUIRE( affine::reproducible_sum( policy, da ).element==s.element );
+
+         delta3 t{};
+         for( const delta3& d : ds ){ t+=d; }
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( s[c]==Approx( t[c] ).epsilon( 1e-12 ).margin( 1e-12 ) ); }
+     }
+
+      SECTION( "centroid" )
+     {
+         const point3 p = affine::reproducible_centroid( cloud );
+         REQUIRE( affine::reproducible_centroid( policy, cloud ).element==p.element );
+         REQUIRE( affine::reproducible_centroid( policy, pa ).element==p.element );
+
+         const point3 q = affine::centroid( cloud );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( p[c]==Approx( q[c] ).epsilon( 1e-12 ).margin( 1e-12 ) ); }
+     }
+
+      SECTION( "dot" )
+     {
+         const double d = affine::reproducible_dot( ds, es );
+         REQUIRE( affine::reproducible_dot( policy, ds, es )==d );
+         REQUIRE( affine::reproducible_dot( policy, da, ea )==d );
+
+         double e = 0;
+         for( std::size_t i=0; i<n; ++i ){ e+=affine::dot( ds[i], es[i] ); }
+         REQUIRE( d==Approx( e ).epsilon( 1e-12 ).margin( 1e-12 ) );
+
+         const affine::weighted_metric<double,3> m{{1,4,0.25}};
+         const double w = affine::reproducible_dot( m, ds, es );
+         REQUIRE( affine::reproducible_dot( policy, m, da, ea )==w );
+
+         double v = 0;
+         for( std::size_t i=0; i<n; ++i ){ v+=affine::dot( m, ds[i], es[i] ); }
+         REQUIRE( w==Approx( v ).epsilon( 1e-12 ).margin( 1e-12 ) );
+     }
+  }
+
+   TEST_CASE( "reproducible reductions of other spaces", "[reproducible][dynamic][scalar][exact]" )
+  {
+      SECTION( "scalar" )
+     {
+         const std::array ps{ point<0>{{2}}, point<0>{{6}}, point<0>{{7}} };
+         const std::array ds{ delta<0>{{2}}, delta<0>{{-6}} };
+
+         REQUIRE( affine::reproducible_centroid( affine::execution::par, ps ).element==5 );
+         REQUIRE( affine::reproducible_sum( affine::execution::par, ds ).element==-4 );
+         REQUIRE( affine::reproducible_dot( affine::execution::par, ds, ds )==40 );
+     }
+
+      SECTION( "exact" )
+     {
+         // the division truncates towards the first point
+         using int_point = exact_point<2,std::int32_t,std::int64_t>;
+         const std::array ps{ int_point{{1,-1}}, int_point{{0,0}}, int_point{{0,0}} };
+         const int_point c = affine::reproducible_centroid( affine::execution::par, ps );
+         REQUIRE( ( c[0]==1 && c[1]==-1 ) );
+
+         // more points than the fixed point coordinates can count
+         using coordinate = affine::fixed<std::int32_t,16>;
+         using fixed_point = exact_point<1,coordinate,affine::fixed<std::int64_t,16>>;
+         std::vector<fixed_point> qs( 40000, fixed_point{{coordinate(3)}} );
+         for( std::size_t i=1; i<qs.size(); i+=2 ){ qs[i][0]=coordinate(4); }
+         REQUIRE( affine::reproducible_centroid( affine::execution::par, qs )[0]==coordinate(3.5) );
+     }
+
+      SECTION( "dynamic extent" )
+     {
+         std::vector<dynamic_delta> ds(3);
+         for( std::size_t i=0; i<ds.size(); ++i )
+        {
+            ds[i].resize(4);
+            for( std::size_t c=0; c<4; ++c ){ ds[i][c]=static_cast<double>(i+c); }
+        }
+
+         const dynamic_delta s = affine::reproducible_sum( affine::execution::par, ds );
+         REQUIRE( s.size()==4 );
+         for( std::size_t c=0; c<4; ++c ){ REQUIRE( s[c]==static_cast<double>(3+3*c) ); }
+
+         REQUIRE( affine::reproducible_dot( ds, ds )==affine::dot(ds[0],ds[0])+affine::dot(ds[1],ds[1])+affine::dot(ds[2],ds[2]) );
+         REQUIRE( affine::reproducible_sum( std::vector<dynamic_delta>{} ).size()==0 );
+     }
+  }
@@ -0,0 +1,135 @@
+
+# include <simd_space.h>
+
+# include <catch.hpp>
+
+# include <array>
+# include <concepts>
+
+   static_assert( affine::numeric<affine::simd_double> );
+   static_assert( affine::numeric<affine::simd_float> );
+   static_assert( affine::numeric<affine::simd<double,3>> );
+   static_assert( !affine::numeric<int*> );
+
+   // lane l of component c
+   template<typename T>
+   static T value( const std::size_t c, const std::size_t l )
+  {
+      return static_cast<T>( 10*c+l+1 );
+  }
+
+   template<typename pack_t>
+   static pack_t make_pack( const std::size_t c, const std::size_t shift )
+  {
+      using T = typename pack_t::value_type;
+      std::array<T,pack_t::size()> lanes;
+      for( std::size_t l=0; l<pack_t::size(); ++l ){ lanes[l]=value<T>(c,l+shift); }
+      return pack_t::load(lanes.data());
+  }
+
+   TEMPLATE_TEST_CASE( "simd pack arithmetic", "[simd]",
+                       affine::simd_double,
+                       affine::simd_float,
+                       ( affine::simd<double,3> ) )
+  {
+      using pack_t = TestType;
+      using T = typename pack_t::value_type;
+
+      const pack_t a = make_pack<pack_t>(0,0);
+      const pack_t b = make_pack<pack_t>(1,0);
+
+      const pack_t sum  = a+b;
+      const pack_t diff = a-b;
+      const pack_t prod = a*b;
+      const pack_t quot = a/b;
+      const pack_t neg  = -a;
+      const pack_t bcast = T(2)*a;
+
+      for( std::size_t l=0; l<pack_t::size(); ++l )
+     {
+         REQUIRE( sum[l]   == Approx( a[l]+b[l] ) );
+         REQUIRE( diff[l]  == Approx( a[l]-b[l] ) );
+         REQUIRE( prod[l]  == Approx( a[l]*b[l] ) );
+         REQUIRE( quot[l]  == Approx( a[l]/b[l] ) );
+         REQUIRE( neg[l]   == Approx( -a[l] ) );
+         REQUIRE( bcast[l] == Approx( 2*a[l] ) );
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "simd point/delta arithmetic", "[simd][point][delta]",
+                       affine::simd_double,
+                       affine::simd_float )
+  {
+      using pack_t = TestType;
+      using T = typename pack_t::value_type;
+      using point3 = simd_point<3,pack_t>;
+      using delta3 = simd_delta<3,pack_t>;
+
+      constexpr T coeff{3};
+
+      point3 p0,p1;
+      delta3 d0;
+      for( std::size_t c=0; c<3; ++c )
+     {
+         p0[c] = make_pack<pack_t>(c,0);
+         p1[c] = make_pack<pack_t>(c,5);
+         d0[c] = make_pack<pack_t>(c,2);
+     }
+
+      SECTION( "simd point in-place addition", "[simd][point]" )
+     {
+         point3 p = p0;
+         p+=coeff*d0;
+
+         for( std::size_t c=0; c<3; ++c )
+        {
+            for( std::size_t l=0; l<pack_t::size(); ++l )
+           {
+               REQUIRE( p[c][l] == Approx( value<T>(c,l)+coeff*value<T>(c,l+2) ) );
+           }
+        }
+     }
+
+      SECTION( "simd point-point subtraction", "[simd][point][delta]" )
+     {
+         const delta3 d = p1-p0;
+
+         for( std::size_t c=0; c<3; ++c )
+        {
+            for( std::size_t l=0; l<pack_t::size(); ++l )
+           {
+               REQUIRE( d[c][l] == Approx( value<T>(c,l+5)-value<T>(c,l) ) );
+           }
+        }
+     }
+
+      SECTION( "simd delta division and negation", "[simd][delta]" )
+     {
+         const delta3 d = -(d0/coeff);
+
+         for( std::size_t c=0; c<3; ++c )
+        {
+            for( std::size_t l=0; l<pack_t::size(); ++l )
+           {
+               REQUIRE( d[c][l] == Approx( -value<T>(c,l+2)/coeff ) );
+           }
+        }
+     }
+  }
+
+   TEST_CASE( "simd scalar space", "[simd][scalar]" )
+  {
+      using pack_t = affine::simd_double;
+      using point0 = simd_point<0,pack_t>;
+      using delta0 = simd_delta<0,pack_t>;
+
+      const point0 p{{make_pack<pack_t>(0,0)}};
+      const delta0 d{{make_pack<pack_t>(0,1)}};
+
+      const point0 q = p+2.0*d;
+
+      for( std::size_t l=0; l<pack_t::size(); ++l )
+     {
+         REQUIRE( q.element[l] == Approx( value<double>(0,l)+2*value<double>(0,l+1) ) );
+     }
+  }
@@ -0,0 +1,203 @@
+
+# include <vector_space.h>
+# include <exact_space.h>
+# include <mixed_space.h>
+# include <trajectory.h>
+# include <half.h>
+# include <point_array.h>
+
+# include <catch.hpp>
+
+# include <cmath>
+# include <cstddef>
+# include <cstdint>
+# include <span>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   static_assert( affine::integrable<point3> && affine::integrable<point<0>> && !affine::integrable<delta3> );
+
+   // a track with small steps far from the origin
+   static std::vector<point3> make_track( const std::size_t n )
+  {
+      std::vector<point3> xs(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const auto t = static_cast<double>(k);
+         xs[k] = point3{{1e6+std::cos(t/100), -1e6+t/8, std::sin(t/7)}};
+     }
+      return xs;
+  }
+
+   TEMPLATE_TEST_CASE( "integrate exact deltas", "[trajectory][exact]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::unsequenced_policy,
+                       affine::execution::parallel_policy,
+                       affine::execution::parallel_unsequenced_policy )
+  {
+      using ipoint = exact_point<2,std::int64_t>;
+      using idelta = exact_delta<2,std::int64_t>;
+
+      const TestType policy{};
+
+      // large enough to be split into several chunks
+      const std::size_t n = GENERATE( as<std::size_t>{}, 0, 1, 7, 3*affine::detail::parallel_grain+13 );
+
+      std::vector<idelta> d(n);
+      for( std::size_t k=0; k<n; ++k )
+     {
+         const auto i = static_cast<std::int64_t>(k);
+         d[k] = idelta{{i%7-3, (i*i)%11-5}};
+     }
+
+      const ipoint p0{{1000000000000,-7}};
+      const std::vector<ipoint> xs = affine::integrate( policy, p0, d );
+      REQUIRE( xs.size()==n );
+
+      // the integer sums are identical in any order
+      ipoint x = p0;
+      for( std::size_t k=0; k<n; ++k ){ REQUIRE( xs[k].element==(x+=d[k]).element ); }
+
+      // whatever the number of chunks, which is 1 on a single core
+      for( const std::size_t k : { 2, 3, 17 } )
+     {
+         std::vector<ipoint> ys(n);
+         affine::detail::chunked_integrate( policy, k, p0, std::span<const idelta>(d), std::span(ys) );
+         for( std::size_t i=0; i<n; ++i ){ REQUIRE( ys[i].element==xs[i].element ); }
+     }
+
+      // and adjacent_deltas inverts them exactly
+      if( n>0 )
+     {
+         const std::vector<idelta> e = affine::adjacent_deltas( policy, xs );
+         REQUIRE( e.size()==n-1 );
+         for( std::size_t k=0; k+1<n; ++k ){ REQUIRE( e[k].element==d[k+1].element ); }
+     }
+  }
+
+   TEMPLATE_TEST_CASE( "integrate floating point deltas", "[trajectory][point]",
+                       affine::execution::sequenced_policy,
+                       affine::execution::parallel_policy )
+  {
+      const TestType policy{};
+
+      const std::size_t n = 3*affine::detail::parallel_grain+13;
+      const std::vector<point3> xs = make_track(n);
+
+      const std::vector<delta3> d = affine::adjacent_deltas( policy, xs );
+      REQUIRE( d.size()==n-1 );
+      for( std::size_t k=0; k+1<n; ++k ){ REQUIRE( d[k].element==(xs[k+1]-xs[k]).element ); }
+
+      std::vector<point3> ys(n-1);
+      affine::integrate( policy, xs[0], d, std::span(ys) );
+
+      // the rounding of the sums grows at most linearly along the track
+      for( std::size_t k=0; k+1<n; ++k )
+     {
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( std::abs(ys[k][c]-xs[k+1][c])<=1e-10*static_cast<double>(k+1) ); }
+     }
+
+      SECTION( "point_array" )
+     {
+         const affine::point_array<point3> pa(xs);
+         const std::vector<delta3> e = affine::adjacent_deltas( policy, pa );
+         for( std::size_t k=0; k+1<n; ++k ){ REQUIRE( e[k].element==d[k].element ); }
+     }
+  }
+
+   TEST_CASE( "integrate mixed precision deltas", "[trajectory][mixed]" )
+  {
+      using mpoint = mixed_point<2>;
+      using mdelta = mixed_delta<2>;
+
+      // the chunk sums are kept in double, so the parallel scan matches the sequential one to double precision
+      const std::size_t n = 4*affine::detail::parallel_grain;
+      const std::vector<mdelta> d( n, mdelta{{0.1f,-0.3f}} );
+      const mpoint p0{{1e3,0}};
+
+      const std::vector<mpoint> seq = affine::integrate( p0, d );
+      std::vector<mpoint> par(n);
+      affine::detail::chunked_integrate( affine::execution::par, 8, p0, std::span<const mdelta>(d), std::span(par) );
+
+      for( std::size_t k=0; k<n; ++k )
+     {
+         for( std::size_t c=0; c<2; ++c ){ REQUIRE( std::abs(par[k][c]-seq[k][c])<1e-6 ); }
+     }
+      REQUIRE( std::abs( par[n-1][0]-(1e3+static_cast<double>(n)*static_cast<double>(0.1f)) )<1e-6 );
+  }
+
+   TEST_CASE( "integrate scalar deltas", "[trajectory][scalar]" )
+  {
+      const std::vector<delta<0>> d{ {{1}}, {{2}}, {{-4}} };
+      const std::vector<point<0>> xs = affine::integrate( point<0>{{10}}, d );
+
+      REQUIRE( xs.size()==3 );
+      REQUIRE( xs[0].element==11 );
+      REQUIRE( xs[1].element==13 );
+      REQUIRE( xs[2].element==9 );
+
+      const std::vector<delta<0>> e = affine::adjacent_deltas( xs );
+      REQUIRE( e[1].element==-4 );
+  }
+
+   TEMPLATE_TEST_CASE( "delta encoded array", "[trajectory][point_array]", float, affine::float16 )
+  {
+      using array_t = affine::delta_encoded_array<point3,TestType>;
+
+      const std::size_t n = GENERATE( 0, 1, 100, 1031 );
+      const std::size_t block = GENERATE( 1, 64, affine::delta_block );
+      const std::vector<point3> xs = make_track(n);
+
+      const array_t a( std::span<const point3>(xs), block );
+      REQUIRE( a.size()==n );
+      REQUIRE( a.blocks()==(n+block-1)/block );
+
+      // the steps are at most 1 in each coordinate, and each point is one rounded step from the decoded track
+      const double tolerance = std::is_same_v<TestType,float> ? 1e-7 : 1e-3;
+      const auto check = [&]( const std::size_t k, const point3& y )
+     {
+         INFO( "n " << n << ", block " << block << ", k " << k );
+         for( std::size_t c=0; c<3; ++c ){ REQUIRE( std::abs(y[c]-xs[k][c])<=tolerance ); }
+     };
+
+      for( std::size_t b=0; b<a.blocks(); ++b ){ REQUIRE( a.keyframe(b).element==xs[a.block_begin(b)].element ); }
+      for( std::size_t k=0; k<n; ++k ){ check( k, a[k] ); }
+      if( n>0 ){ REQUIRE( a.back().element==a[n-1].element ); }
+
+      SECTION( "decode" )
+     {
+         std::vector<point3> ys(n);
+         a.decode( affine::execution::par, std::span(ys) );
+         for( std::size_t k=0; k<n; ++k ){ REQUIRE( ys[k].element==a[k].element ); }
+
+         std::vector<point3> zs(block);
+         for( std::size_t b=0; b<a.blocks(); ++b )
+        {
+            a.decode_block( b, std::span(zs) );
+            for( std::size_t k=a.block_begin(b); k<a.block_end(b); ++k ){ REQUIRE( zs[k-a.block_begin(b)].element==ys[k].element ); }
+        }
+     }
+
+      SECTION( "push_back" )
+     {
+         array_t b(block);
+         for( const point3& x : xs ){ b.push_back(x); }
+         REQUIRE( b.size()==n );
+         for( std::size_t k=0; k<n; ++k ){ REQUIRE( b[k].element==a[k].element ); }
+     }
+  }
+
+   TEST_CASE( "delta encoded integer track", "[trajectory][exact]" )
+  {
+      using ipoint = exact_point<2,std::int32_t,std::int64_t>;
+
+      // steps which fit in 16 bits are stored exactly
+      std::vector<ipoint> xs;
+      for( std::int32_t k=0; k<500; ++k ){ xs.push_back( ipoint{{2000000000-k*k, k*(k%3==0 ? 30 : -20)}} ); }
+
+      const affine::delta_encoded_array<ipoint,std::int16_t> a( std::span<const ipoint>(xs), 128 );
+      REQUIRE( sizeof(a.step(1))==2*sizeof(std::int64_t) );
+      for( std::size_t k=0; k<xs.size(); ++k ){ REQUIRE( a[k].element==xs[k].element ); }
+  }
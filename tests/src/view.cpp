@@ -0,0 +1,239 @@
+
+# include <vector_space.h>
+# include <view.h>
+# include <combination.h>
+
+# include <catch.hpp>
+
+# include <array>
+# include <concepts>
+# include <cstdint>
+# include <iterator>
+# include <ranges>
+# include <vector>
+
+   using point3 = point<3>;
+   using delta3 = delta<3>;
+
+   using value_type = point3::value_type;
+
+   constexpr static auto eps = std::numeric_limits<value_type>::epsilon();
+
+   constexpr static std::size_t length = 37;
+
+   // coordinates as a field of a larger struct, with other data either side
+   struct particle
+  {
+      std::int64_t id;
+      value_type   position[3];
+      value_type   mass;
+      std::array<value_type,3> velocity;
+  };
+
+   static_assert( std::ranges::random_access_range<affine::point_span<point3>> );
+   static_assert( std::ranges::sized_range<affine::const_delta_span<delta3>> );
+   static_assert( std::convertible_to<affine::point_span<point3>,affine::const_point_span<point3>> );
+   static_assert( !std::convertible_to<affine::const_point_span<point3>,affine::point_span<point3>> );
+
+   static std::vector<particle> make_particles()
+  {
+      std::vector<particle> particles(length);
+      for( std::size_t k=0; k<length; ++k )
+     {
+         const auto x = static_cast<value_type>(k);
+         particles[k].id = static_cast<std::int64_t>(k);
+         particles[k].position[0] = x;
+         particles[k].position[1] = 2*x+1;
+         particles[k].position[2] = 3*x-2;
+         particles[k].mass = -1;
+         particles[k].velocity = {x-5,x/2,4-x};
+     }
+      return particles;
+  }
+
+   TEST_CASE( "single views", "[view][point][delta]" )
+  {
+      value_type xyz[3] = {1,2,3};
+      value_type uvw[3] = {4,-5,6};
+
+      const affine::point_view<point3> x(xyz);
+      const affine::delta_view<delta3> u(uvw);
+
+      SECTION( "read through", "[view][point]" )
+     {
+         const point3 p = x;
+         REQUIRE( p[0] == 1 );
+         REQUIRE( p[2] == 3 );
+         REQUIRE( &x[1] == &xyz[1] );
+     }
+
+      SECTION( "write through", "[view][point][delta]" )
+     {
+         x+=u;
+         REQUIRE( xyz[0] == 5 );
+         REQUIRE( xyz[1] == -3 );
+
+         u*=2;
+         REQUIRE( uvw[2] == 12 );
+
+         x=point3{{0,0,0}};
+         REQUIRE( xyz[2] == 0 );
+     }
+
+      SECTION( "free operators", "[view][point][delta]" )
+     {
+         const affine::const_point_view<point3> y(xyz);
+
+         const delta3 d = x-y;
+         const point3 p = y+u;
+         const delta3 e = 2*u-u;
+
+         REQUIRE( d[0] == 0 );
+         REQUIRE( p[1] == -3 );
+         REQUIRE( e[2] == 6 );
+     }
+
+      SECTION( "strided coordinates", "[view][point]" )
+     {
+         value_type columns[6] = {1,10,2,20,3,30};
+         const affine::point_view<point3> z(columns+1,2);
+
+         z+=u;
+         REQUIRE( columns[1] == 14 );
+         REQUIRE( columns[3] == 15 );
+         REQUIRE( columns[5] == 36 );
+         REQUIRE( columns[4] == 3 );
+     }
+  }
+
+   TEST_CASE( "packed spans", "[view][point][delta]" )
+  {
+      std::vector<value_type> xs(3*length), vs(3*length);
+      for( std::size_t i=0; i<3*length; ++i )
+     {
+         xs[i] = static_cast<value_type>(i);
+         vs[i] = static_cast<value_type>(i%7)-3;
+     }
+      const std::vector<value_type> x0 = xs;
+
+      const affine::point_span<point3> ps{std::span(xs)};
+      const affine::delta_span<delta3> ds{std::span(vs)};
+
+      REQUIRE( ps.size() == length );
+      REQUIRE( ps[4][1] == 13 );
+      REQUIRE( &ps[length-1][2] == &xs.back() );
+
+      SECTION( "bulk arithmetic", "[view][point][delta]" )
+     {
+         ds*=2;
+         ps+=ds;
+         ds/=2;
+         ps-=ds;
+
+         for( std::size_t i=0; i<3*length; ++i ){ REQUIRE( xs[i] == Approx( x0[i]+vs[i] ).epsilon( eps ) ); }
+     }
+
+      SECTION( "iteration", "[view][point]" )
+     {
+         std::size_t k=0;
+         for( const auto p : ps )
+        {
+            REQUIRE( p[0] == xs[3*k] );
+            ++k;
+        }
+         REQUIRE( k == length );
+         REQUIRE( std::ranges::distance( ps.begin(), ps.end() ) == static_cast<std::ptrdiff_t>(length) );
+         REQUIRE( (ps.begin()+5)[1][0] == xs[18] );
+     }
+
+      SECTION( "subspan", "[view][point]" )
+     {
+         const auto sub = ps.subspan( 10, 5 );
+         REQUIRE( sub.size() == 5 );
+         REQUIRE( &sub[0][0] == &xs[30] );
+     }
+
+      SECTION( "centroid", "[view][combination]" )
+     {
+         const affine::const_point_span<point3> cs = ps;
+         const point3 c = affine::centroid( cs );
+
+         REQUIRE( c[0] == Approx( 3*(length-1)/2. ).epsilon( length*eps ) );
+         REQUIRE( c[2] == Approx( 3*(length-1)/2.+2 ).epsilon( length*eps ) );
+     }
+  }
+
+   TEST_CASE( "struct field spans", "[view][point][delta]" )
+  {
+      std::vector<particle> particles = make_particles();
+      const std::vector<particle> initial = particles;
+
+      const auto xs = affine::make_point_span<point3>( std::span(particles), &particle::position );
+      const auto vs = affine::make_delta_span<delta3>( std::span(particles), &particle::velocity );
+
+      static_assert( std::same_as<std::remove_const_t<decltype(xs)>,affine::point_span<point3>> );
+
+      REQUIRE( xs.size() == length );
+      REQUIRE( xs.element_step() == sizeof(particle)/sizeof(value_type) );
+
+      SECTION( "element access", "[view][point][delta]" )
+     {
+         for( std::size_t k=0; k<length; ++k )
+        {
+            REQUIRE( &xs[k][0] == &particles[k].position[0] );
+            REQUIRE( &vs[k][2] == &particles[k].velocity[2] );
+        }
+     }
+
+      SECTION( "time step", "[view][point][delta]" )
+     {
+         const value_type dt = 0.25;
+
+         vs*=dt;
+         xs+=vs;
+         vs/=dt;
+
+         for( std::size_t k=0; k<length; ++k )
+        {
+            for( std::size_t i=0; i<3; ++i )
+           {
+               REQUIRE( particles[k].position[i] == Approx( initial[k].position[i]+dt*initial[k].velocity[i] ).epsilon( eps ) );
+               REQUIRE( particles[k].velocity[i] == Approx( initial[k].velocity[i] ).epsilon( eps ) );
+           }
+            REQUIRE( particles[k].id == static_cast<std::int64_t>(k) );
+            REQUIRE( particles[k].mass == -1 );
+        }
+     }
+
+      SECTION( "elementwise operators", "[view][point][delta]" )
+     {
+         const delta3 d = xs[7]-xs[3];
+         REQUIRE( d[1] == 8 );
+
+         xs[0]+=d;
+         REQUIRE( particles[0].position[1] == 9 );
+     }
+
+      SECTION( "read only", "[view][point]" )
+     {
+         const std::vector<particle>& cparticles = particles;
+         const auto cs = affine::make_point_span<point3>( std::span(cparticles), &particle::position );
+
+         static_assert( std::same_as<std::remove_const_t<decltype(cs)>,affine::const_point_span<point3>> );
+
+         const auto ds = affine::make_delta_span<delta3>( std::span(cparticles), &particle::velocity );
+         xs+=ds;
+
+         REQUIRE( particles[2].position[0] == Approx( initial[2].position[0]+initial[2].velocity[0] ).epsilon( eps ) );
+         REQUIRE( cs[2][0] == particles[2].position[0] );
+     }
+
+      SECTION( "assign", "[view][point]" )
+     {
+         std::vector<point3> ps(length,point3{{1,2,3}});
+         xs.assign(ps);
+
+         REQUIRE( particles[length-1].position[2] == 3 );
+         REQUIRE( particles[length-1].mass == -1 );
+     }
+  }